@@ -12,18 +12,31 @@
 #include "transaction.h"
 #include "blockchain.h"
 #include "mining.h"
+#include <array>
 #include <memory>
 #include <vector>
+#include <deque>
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <chrono>
 #include <optional>
 #include <atomic>
 #include <mutex>
+#include <shared_mutex>
 #include <functional>
+#include <span>
 
 namespace intcoin {
 
+namespace pool {
+struct ExportOptions;
+struct PoolMetrics;
+}
+
+class PayoutSender;
+class ChainBackend;
+
 // ============================================================================
 // Pool Configuration
 // ============================================================================
@@ -46,13 +59,25 @@ struct PoolConfig {
         PPLNS,                        // Pay Per Last N Shares
         PPS,                          // Pay Per Share
         PROP,                         // Proportional
-        SOLO                          // Solo mining (winner takes all)
+        SOLO,                         // Solo mining (winner takes all)
+        // Appended so the values above keep their meaning
+        PPLNS_DECAYED,                // Time-decayed PPLNS (exponential scoring)
+        FPPS,                         // Full PPS (subsidy plus smoothed fees per share)
+        PPS_PLUS                      // PPS on subsidy, block fees split PPLNS
     };
     PayoutMethod payout_method;
-    uint64_t pplns_window;            // N shares for PPLNS
+    uint64_t pplns_window = 1000000;  // N shares for PPLNS
+    uint32_t decay_half_life_secs = 900;  // Share score half-life for PPLNS_DECAYED
+    uint32_t fee_average_secs = 3600;     // Template fee smoothing for FPPS
     double pool_fee_percent;          // Pool fee (0-100)
     uint64_t min_payout;              // Minimum payout threshold
     uint64_t payout_interval;         // Seconds between payouts
+    size_t payout_max_tx_bytes = 100000;  // Size limit of one payout transaction
+    uint32_t payout_confirmations = 6;    // Depth at which a payout is final
+    uint32_t block_maturity = 100;        // Confirmations before a round is credited
+    uint32_t luck_window = 100;           // Closed rounds in the rolling luck
+    uint32_t network_hashrate_blocks = 120;  // Blocks behind the network hashrate
+    uint32_t chain_refresh_secs = 30;     // Chain state re-read when no tip arrives
 
     // Connection limits
     size_t max_workers_per_miner;
@@ -64,6 +89,18 @@ struct PoolConfig {
     bool ban_on_invalid_share;
     size_t max_invalid_shares;
     std::chrono::seconds ban_duration;
+
+    // Persistence
+    std::string data_dir;                       // Journal/database directory (empty = memory only)
+    size_t db_cache_mb = 512;                   // Database block cache
+    bool journal_durable = true;                // fdatasync share journal on each group commit
+    uint32_t journal_commit_interval_ms = 10;   // Max delay before a group commit
+    uint32_t journal_commit_records = 4096;     // Records that force a group commit
+    uint32_t snapshot_interval_secs = 300;      // Seconds between state snapshots
+    uint32_t snapshots_to_keep = 2;             // Older snapshots are pruned
+    std::string share_cold_dir;                 // Compressed share history (empty = data_dir/cold)
+    uint32_t share_warm_hours = 6;              // Raw shares older than this are compressed
+    uint32_t share_raw_retention_hours = 24;    // Summarized raw shares older than this are dropped
 };
 
 // ============================================================================
@@ -93,6 +130,7 @@ struct Work {
     uint256 merkle_root;
     uint64_t height;
     uint64_t difficulty;
+    uint64_t coinbase_value;          // Subsidy plus transaction fees
     std::chrono::system_clock::time_point created_at;
     bool clean_jobs;                  // Should miners abandon previous work
 };
@@ -106,7 +144,7 @@ struct Payment {
     std::chrono::system_clock::time_point created_at;
     std::chrono::system_clock::time_point confirmed_at;
     bool is_confirmed;
-    std::string status;               // "pending", "confirmed", "failed"
+    std::string status;               // "pending", "sending", "sent", "confirmed", "unknown"
 };
 
 // ============================================================================
@@ -131,6 +169,7 @@ struct Worker {
     // Difficulty management
     uint64_t current_difficulty;
     std::chrono::system_clock::time_point last_share_time;
+    std::chrono::system_clock::time_point last_retarget;   // Last vardiff change (or connect)
     std::vector<std::chrono::system_clock::time_point> recent_shares;
 
     // Connection
@@ -177,6 +216,34 @@ struct Miner {
 // Pool Statistics
 // ============================================================================
 
+/// Sliding windows kept for the pool, each miner and each worker
+enum class StatsWindow {
+    MINUTE,                            // 4 x 15 s
+    FIVE_MINUTES,                      // 5 x 1 min
+    TEN_MINUTES,                       // 10 x 1 min (hashrate default)
+    HOUR,                              // 12 x 5 min
+    DAY                                // 24 x 1 h
+};
+
+/// Accepted shares over one window
+struct WindowTotals {
+    uint64_t shares = 0;
+    uint64_t work = 0;                 // Sum of share difficulty
+    std::chrono::seconds span{0};      // Time covered; shorter until the window fills
+    double hashrate = 0.0;             // Hashes per second over the span
+};
+
+/// Chain tip, difficulty and reward schedule as last read from the node
+struct ChainState {
+    uint64_t height = 0;               // Best block height
+    uint64_t difficulty = 0;           // Difficulty of the next block
+    double network_hashrate = 0.0;     // Hashes per second over recent block times
+    uint64_t block_reward = 0;         // Subsidy of the next block
+    uint64_t next_reward_height = 0;   // Height the subsidy next changes at (0: never)
+    uint64_t next_block_reward = 0;    // Subsidy from next_reward_height on
+    std::chrono::system_clock::time_point updated_at;
+};
+
 struct PoolStatistics {
     // Network
     uint64_t network_height;
@@ -208,11 +275,13 @@ struct PoolStatistics {
     uint64_t total_paid;              // Total INTS paid to miners
     uint64_t total_unpaid;            // Total unpaid balance
     uint64_t pool_revenue;            // Pool fees collected
+    int64_t pps_fund = 0;             // Negative while per-share credit runs ahead of matured blocks
 
     // Performance
     double uptime_hours;
     double efficiency;                // % of valid shares
-    double luck;                      // Actual blocks / expected blocks
+    double luck;                      // Expected / actual work over recent rounds (%)
+    double round_effort;              // Current round's work / expected work (%)
 };
 
 struct RoundStatistics {
@@ -225,6 +294,84 @@ struct RoundStatistics {
     uint64_t block_reward;
     std::map<uint64_t, uint64_t> miner_shares;  // miner_id -> share count
     bool is_complete;
+    uint64_t total_work = 0;          // Sum of accepted share difficulty
+    uint64_t network_difficulty = 0;  // Expected work, taken at round start
+};
+
+/// Effort and luck of one closed round
+struct RoundLuck {
+    uint64_t round_id = 0;
+    uint64_t work = 0;                // Sum of accepted share difficulty
+    uint64_t network_difficulty = 0;  // Expected work
+    double effort = 0.0;              // work / expected (%)
+    double luck = 0.0;                // expected / work (%)
+};
+
+/// Round credits, ascending by miner id
+using MinerCredits = std::vector<std::pair<uint64_t, uint64_t>>;
+
+/// A block found by the pool, tracked until it matures or is orphaned
+struct FoundBlock {
+    enum class Status { PENDING, CONFIRMED, ORPHANED };
+
+    uint64_t round_id = 0;
+    uint64_t height = 0;
+    uint256 hash{};
+    uint64_t reward = 0;
+    uint64_t finder_id = 0;
+    MinerCredits credits;                       // Credited at maturity
+    uint64_t pool_fee = 0;
+    uint64_t pps_funding = 0;                   // Value miners were prepaid per share
+    Status status = Status::PENDING;
+    uint64_t confirmations = 0;
+    std::chrono::system_clock::time_point found_at;
+};
+
+/// A solo miner's job: the shared template with a coinbase paying them
+struct SoloJob {
+    uint256 job_id;
+    uint64_t miner_id = 0;
+    Transaction coinbase;
+    uint256 merkle_root;                        // With this coinbase
+    std::string coinbase1;                      // Hex, before the extranonce
+    std::string coinbase2;                      // Hex, after the extranonce
+    std::shared_ptr<const std::vector<std::string>> merkle_branch;  // Hex, same for every miner
+};
+
+/// A solo miner's own round, kept apart from the pooled round
+struct SoloRound {
+    uint64_t miner_id = 0;
+    uint64_t shares = 0;                        // Since the miner's last block
+    uint64_t work = 0;                          // Share difficulty since then
+    uint64_t blocks_found = 0;
+    std::chrono::system_clock::time_point started_at;
+};
+
+/// Index of a chain in the job scheduler; 0 is the pool's own chain
+using ChainId = uint16_t;
+
+/// A chain hashrate can be pointed at (separate daemon or aux chain)
+struct ChainConfig {
+    std::string name;
+    double price = 1.0;                         // One base unit, in the pool's accounting unit
+    uint16_t port = 0;                          // Stratum port pinned to this chain (0 = switchable)
+    size_t pplns_window = 1000000;              // Shares in the chain's own PPLNS window
+    double pool_fee_percent = 1.0;
+    uint32_t block_maturity = 100;              // Confirmations before a block's round is credited
+};
+
+struct ChainStatistics {
+    ChainId chain_id = 0;
+    std::string name;
+    double profit = 0.0;                        // Value per unit of share difficulty
+    bool active = false;                        // Switchable hashrate is on this chain
+    uint64_t height = 0;                        // Of the current template
+    uint64_t round_id = 0;
+    uint64_t round_shares = 0;
+    uint64_t round_work = 0;
+    uint64_t blocks_found = 0;
+    uint64_t unpaid = 0;                        // Ledger balances not yet paid (pool's own chain)
+    uint64_t immature = 0;                      // Credits held until their block matures
 };
 
 // ============================================================================
@@ -319,7 +466,7 @@ public:
     /// Get miner by username
     std::optional<Miner> GetMinerByUsername(const std::string& username) const;
 
-    /// Update miner payout address
+    /// Update miner payout address (persisted before it takes effect)
     Result<void> UpdatePayoutAddress(uint64_t miner_id,
                                      const std::string& new_address);
 
@@ -370,7 +517,8 @@ public:
     /// Process valid share
     void ProcessValidShare(const Share& share);
 
-    /// Process block found
+    /// Process block found (caller holds the pool lock, and refreshes work
+    /// once it is released)
     Result<void> ProcessBlockFound(const Share& share);
 
     /// Get recent shares
@@ -392,9 +540,41 @@ public:
     /// Update work (on new block)
     Result<void> UpdateWork();
 
+    /// New chain tip: re-check found blocks (crediting rounds that matured),
+    /// then refresh work
+    Result<void> NotifyNewTip();
+
     /// Broadcast work to all miners
     void BroadcastWork(const Work& work);
 
+    /// Solo mode: the current job for a worker's miner, with a coinbase
+    /// paying the miner's address (built once per job, then cached)
+    Result<std::shared_ptr<const SoloJob>> GetSoloJob(uint64_t worker_id);
+
+    // ------------------------------------------------------------------------
+    // Multi-Chain Scheduling
+    // ------------------------------------------------------------------------
+
+    /// Add a chain for hashrate switching; its template is fetched at once
+    Result<ChainId> AddChain(const ChainConfig& config, std::shared_ptr<ChainBackend> backend);
+
+    /// New template from a chain's backend (call on its block notification);
+    /// notifies miners when that chain is the one they are on
+    Result<void> RefreshChain(ChainId chain);
+
+    /// Re-rank chains by profitability and move switchable hashrate with
+    /// one clean-jobs notify if the best chain changed
+    Result<void> RebalanceChains();
+
+    /// Job for miners on a Stratum port: its pinned chain, else the best
+    std::optional<Work> GetWorkForPort(uint16_t port) const;
+
+    /// Chain a Stratum port's miners are mining
+    ChainId GetChainForPort(uint16_t port) const;
+
+    /// Rounds, payout state and profitability of every chain
+    std::vector<ChainStatistics> GetChainStatistics() const;
+
     // ------------------------------------------------------------------------
     // Difficulty Management (VarDiff)
     // ------------------------------------------------------------------------
@@ -418,7 +598,7 @@ public:
     /// Calculate PPLNS payouts
     std::map<uint64_t, uint64_t> CalculatePPLNSPayouts(uint64_t block_reward);
 
-    /// Calculate PPS payouts
+    /// PPS credit accrued since the last ledger checkpoint (whole base units)
     std::map<uint64_t, uint64_t> CalculatePPSPayouts();
 
     /// Process payouts
@@ -443,12 +623,27 @@ public:
     /// Get pool statistics
     PoolStatistics GetStatistics() const;
 
+    /// Cached chain tip, difficulty, network hashrate and reward schedule
+    ChainState GetChainState() const;
+
+    /// Counters, gauges and latency histograms served at /metrics
+    pool::PoolMetrics& GetMetrics() const;
+
     /// Get current round statistics
     RoundStatistics GetCurrentRound() const;
 
     /// Get round history
     std::vector<RoundStatistics> GetRoundHistory(size_t count) const;
 
+    /// Effort and luck of recently closed rounds, newest first
+    std::vector<RoundLuck> GetRoundLuck(size_t limit) const;
+
+    /// Blocks found by the pool with their maturity status, newest first
+    std::vector<FoundBlock> GetFoundBlocks(size_t limit) const;
+
+    /// Solo mode: the miner's own round since their last block
+    std::optional<SoloRound> GetSoloRound(uint64_t miner_id) const;
+
     /// Calculate pool hashrate
     double CalculatePoolHashrate() const;
 
@@ -458,6 +653,20 @@ public:
     /// Calculate miner hashrate
     double CalculateMinerHashrate(uint64_t miner_id) const;
 
+    /// Accepted shares, work and hashrate over a window (O(1))
+    WindowTotals GetPoolTotals(StatsWindow window) const;
+    WindowTotals GetMinerTotals(uint64_t miner_id, StatsWindow window) const;
+    WindowTotals GetWorkerTotals(uint64_t worker_id, StatsWindow window) const;
+
+    // ------------------------------------------------------------------------
+    // History Export
+    // ------------------------------------------------------------------------
+
+    /// Stream archived history (see pool::ExportHistory); takes no pool
+    /// locks, and fails with "Pool is stopping" once Stop() is called
+    Result<void> ExportHistory(const pool::ExportOptions& options,
+                               const std::function<Result<void>(const uint8_t*, size_t)>& sink) const;
+
     // ------------------------------------------------------------------------
     // Stratum Protocol
     // ------------------------------------------------------------------------
@@ -533,7 +742,14 @@ public:
     /// Register payout callback
     void RegisterPayoutCallback(PayoutCallback callback);
 
+    /// Wallet that signs and broadcasts payout transactions; without one,
+    /// payouts are debited and left pending
+    void SetPayoutSender(std::shared_ptr<PayoutSender> sender);
+
 private:
+    /// Clean-jobs notify of the active chain's template
+    Result<void> BroadcastActiveChain();
+
     class Impl;
     std::unique_ptr<Impl> impl_;
 };
@@ -569,14 +785,16 @@ class VarDiffManager {
 public:
     VarDiffManager(double target_share_time, double retarget_time, double variance);
 
-    /// Calculate new difficulty for worker
-    uint64_t CalculateDifficulty(const Worker& worker) const;
+    /// Calculate new difficulty for worker from its recent accepted shares
+    uint64_t CalculateDifficulty(const Worker& worker, const WindowTotals& recent,
+                                 std::chrono::system_clock::time_point now) const;
 
     /// Check if difficulty adjustment needed
-    bool ShouldAdjust(const Worker& worker) const;
+    bool ShouldAdjust(const Worker& worker, const WindowTotals& recent,
+                      std::chrono::system_clock::time_point now) const;
 
     /// Get share rate (shares per second)
-    double GetShareRate(const Worker& worker) const;
+    double GetShareRate(const WindowTotals& recent) const;
 
 private:
     double target_share_time_;
@@ -588,6 +806,12 @@ private:
 // Payout Calculator
 // ============================================================================
 
+/// Per-miner weights as parallel arrays, ascending by miner id
+struct DenseMinerWork {
+    std::vector<uint64_t> miner_ids;
+    std::vector<uint64_t> work;
+};
+
 class PayoutCalculator {
 public:
     /// Calculate PPLNS (Pay Per Last N Shares)
@@ -610,8 +834,549 @@ public:
         uint64_t block_reward,
         double pool_fee);
 
-    /// Calculate pool fee
+    /// Split reward (after fee) pro rata by per-miner weight; payouts sum
+    /// to exactly block_reward - fee
+    static std::map<uint64_t, uint64_t> DistributeReward(
+        const std::map<uint64_t, uint64_t>& miner_weights,
+        uint64_t block_reward,
+        double pool_fee);
+
+    /// Exact pro rata split in 128-bit arithmetic; leftover units go to the
+    /// largest remainders, so outputs sum to amount (all zero if no weight)
+    static void SplitExact(const uint64_t* weights, size_t n, uint64_t amount, uint64_t* out);
+
+    /// DistributeReward over dense arrays, skipping zero payouts; for
+    /// block-found payouts over large windows
+    static MinerCredits DistributeDense(const DenseMinerWork& miner_work,
+                                        uint64_t block_reward,
+                                        double pool_fee);
+
+    /// Sum (miner_id, work) pairs per miner, in parallel over dense id ranges
+    static DenseMinerWork AggregateWork(const std::vector<std::pair<uint64_t, uint64_t>>& shares);
+
+    /// Calculate pool fee (fixed point; fee_percent resolves to 1e-7 %)
     static uint64_t CalculateFee(uint64_t amount, double fee_percent);
+
+    /// Set a found block's pps_funding (`prepaid` less fee) and pool_fee
+    /// once its credits are split
+    static void SettleBlockValue(FoundBlock& block, uint64_t prepaid, double pool_fee);
+};
+
+// ============================================================================
+// PPLNS Window
+// ============================================================================
+
+/// Last N valid shares weighted by difficulty, with per-miner sums and a
+/// Fenwick tree for newest-k suffix work
+class PPLNSWindow {
+public:
+    explicit PPLNSWindow(size_t window);
+
+    /// Add a valid share, evicting the oldest once the window is full
+    void Add(uint64_t miner_id, uint64_t difficulty);
+
+    /// Drop all shares
+    void Clear();
+
+    /// Shares currently in the window
+    size_t Size() const { return count_; }
+
+    /// Window length N
+    size_t Capacity() const { return ring_.size(); }
+
+    /// Sum of share difficulty in the window
+    uint64_t GetTotalWork() const { return total_work_; }
+
+    /// Per-miner sum of share difficulty in the window
+    std::map<uint64_t, uint64_t> GetMinerWork() const;
+
+    /// Per-miner work as dense arrays, from the maintained sums (O(miners))
+    DenseMinerWork GetDenseMinerWork() const;
+
+    /// Work of the newest n shares (n is clamped to Size())
+    uint64_t GetRecentWork(size_t n) const;
+
+    /// Fewest newest shares whose work reaches `work` (Size() if none do)
+    size_t SharesForWork(uint64_t work) const;
+
+private:
+    struct Slot {
+        uint64_t miner_id = 0;
+        uint64_t difficulty = 0;
+    };
+    struct MinerWork {
+        uint64_t work = 0;
+        uint64_t shares = 0;
+    };
+
+    /// Sum of ring slots [0, slots)
+    uint64_t PrefixWork(size_t slots) const;
+
+    std::vector<Slot> ring_;
+    std::vector<uint64_t> tree_;      // Fenwick tree over ring_ difficulties (1-based)
+    size_t next_ = 0;                 // Slot the next share goes into
+    size_t count_ = 0;
+    uint64_t total_work_ = 0;
+    std::unordered_map<uint64_t, MinerWork> miners_;
+};
+
+// ============================================================================
+// Decayed Score
+// ============================================================================
+
+/// Time-decayed share scoring (exponential PPLNS); a share's weight halves
+/// every half-life
+class DecayedScore {
+public:
+    explicit DecayedScore(double half_life_secs);
+
+    /// Score a valid share accepted at timestamp_ms
+    void Add(uint64_t miner_id, uint64_t difficulty, int64_t timestamp_ms);
+
+    /// Drop all scores
+    void Clear();
+
+    /// Miners holding a score
+    size_t GetMinerCount() const { return scores_.size(); }
+
+    /// Sum of scores in difficulty units as of the newest share
+    double GetTotalWork() const;
+
+    /// Per-miner scores as fixed-point weights for DistributeReward()
+    std::map<uint64_t, uint64_t> GetMinerWeights() const;
+
+private:
+    struct MinerScore {
+        uint64_t miner_id = 0;
+        double score = 0;
+    };
+
+    /// Rescale every score to a new base time, dropping negligible ones
+    void Rebase(int64_t timestamp_ms);
+
+    double lambda_;                   // Decay rate per millisecond
+    int64_t base_ms_ = 0;             // Scores are relative to exp(lambda * base_ms_)
+    int64_t last_ms_ = 0;             // Newest share seen
+    double total_ = 0;
+    std::vector<MinerScore> scores_;
+    std::unordered_map<uint64_t, size_t> index_;  // miner_id -> scores_ slot
+    int64_t factor_ms_ = 0;           // Memoized exp() for the last timestamp
+    double factor_ = 1;
+};
+
+// ============================================================================
+// PPS Ledger
+// ============================================================================
+
+/// Pay-per-share credit accrued per miner as shares are accepted;
+/// Checkpoint() drains whole base units for the ledger
+class PPSLedger {
+public:
+    static constexpr int kRateBits = 40;      // Fraction bits of the rate
+    static constexpr int kCreditBits = 20;    // Fraction bits of accrued credit
+
+    /// Set the per-share rate from the block reward and network difficulty
+    void SetRate(uint64_t block_reward, double network_difficulty, double pool_fee);
+
+    /// Base units per unit of share difficulty, in Q(kRateBits)
+    uint64_t GetRate() const { return rate_.load(std::memory_order_relaxed); }
+
+    /// Credit a valid share; returns the credit in Q(kCreditBits) base units
+    uint64_t Credit(uint64_t miner_id, uint64_t difficulty);
+
+    /// Whole base units accrued by a miner and not yet checkpointed
+    uint64_t GetPending(uint64_t miner_id) const;
+
+    /// Whole base units accrued per miner and not yet checkpointed
+    std::map<uint64_t, uint64_t> GetPending() const;
+
+    /// Drain whole base units per miner (fractions stay accrued)
+    std::map<uint64_t, uint64_t> Checkpoint();
+
+    /// Put back credits whose checkpoint could not be posted
+    void Restore(const std::map<uint64_t, uint64_t>& credits);
+
+    /// Drop all accrued credit
+    void Clear();
+
+private:
+    struct Account {
+        std::atomic<uint64_t> accrued{0};     // Q(kCreditBits) base units
+    };
+
+    Account& GetAccount(uint64_t miner_id);
+
+    std::atomic<uint64_t> rate_{0};
+    mutable std::shared_mutex accounts_mutex_;
+    std::unordered_map<uint64_t, std::unique_ptr<Account>> accounts_;
+};
+
+// ============================================================================
+// Fee Average
+// ============================================================================
+
+/// Time-weighted average of template fee revenue, for FPPS
+class FeeAverage {
+public:
+    explicit FeeAverage(double window_secs);
+
+    /// A new template paying `fees` became the current job at `now`
+    void Update(uint64_t fees, std::chrono::steady_clock::time_point now);
+
+    /// Smoothed fee revenue per block
+    uint64_t Get() const;
+
+private:
+    double window_secs_;
+    double average_ = 0;
+    uint64_t current_fees_ = 0;       // Fees of the current template
+    std::chrono::steady_clock::time_point current_since_;
+    bool seeded_ = false;
+};
+
+// ============================================================================
+// Payout Engine
+// ============================================================================
+
+/// One output of a payout transaction
+struct PayoutOutput {
+    uint64_t payment_id = 0;          // Assigned when the balance is debited
+    uint64_t miner_id = 0;
+    std::string address;
+    uint64_t amount = 0;
+};
+
+/// Wallet side of the payout engine: builds, signs and broadcasts payouts
+class PayoutSender {
+public:
+    virtual ~PayoutSender() = default;
+
+    /// Build, sign and broadcast a transaction paying every output
+    virtual Result<uint256> Send(const std::vector<PayoutOutput>& outputs) = 0;
+
+    /// Confirmations of a broadcast transaction, -1 once it was dropped
+    /// (conflicted or expired); Error if it could not be checked
+    virtual Result<int64_t> GetConfirmations(const uint256& tx_hash) = 0;
+};
+
+struct PayoutEngineOptions {
+    size_t max_tx_bytes = 100000;               // Size limit of one transaction
+    uint32_t confirmations = 6;                 // Depth at which a payment is final
+    std::chrono::seconds interval{600};         // Between payout runs
+};
+
+/// Batched payout runs on a dedicated thread; sends hold no server lock
+/// and a payment that may have been sent is never sent again
+class PayoutEngine {
+public:
+    /// Balances due a payout, taken under the server lock
+    using CollectFn = std::function<std::vector<PayoutOutput>()>;
+
+    /// Debit the balances and assign payment ids
+    using DebitFn = std::function<Result<std::vector<PayoutOutput>>(std::vector<PayoutOutput>)>;
+
+    /// Persist a status change of one transaction's payments; a batch is
+    /// only broadcast once its "sending" update succeeded
+    using UpdateFn = std::function<Result<void>(const std::vector<Payment>&)>;
+
+    PayoutEngine(const PayoutEngineOptions& options, CollectFn collect, DebitFn debit, UpdateFn update);
+    ~PayoutEngine();
+
+    PayoutEngine(const PayoutEngine&) = delete;
+    PayoutEngine& operator=(const PayoutEngine&) = delete;
+
+    void SetSender(std::shared_ptr<PayoutSender> sender);
+
+    /// Run payouts every interval on a background thread
+    void Start();
+    void Stop();
+
+    /// One run: poll confirmations, debit what is due, send; returns payments debited
+    Result<size_t> RunOnce();
+
+    /// Resume payments persisted by a previous run ("sending" ones become
+    /// "unknown"); call before Start()
+    void Restore(const std::vector<Payment>& payments);
+
+    /// Payments debited but not yet confirmed
+    std::vector<Payment> GetOutstanding() const;
+
+    /// Estimated serialized size of a transaction with this many payout outputs
+    static size_t EstimateTxSize(size_t outputs);
+
+    /// Split outputs into transactions within max_tx_bytes
+    static std::vector<std::vector<PayoutOutput>> Pack(const std::vector<PayoutOutput>& outputs,
+                                                       size_t max_tx_bytes);
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// ============================================================================
+// Solo Job Cache
+// ============================================================================
+
+/// Per-miner solo jobs over one shared template; the coinbase merkle
+/// branch is computed once per template
+class SoloJobCache {
+public:
+    /// Output script paying an address
+    using ScriptFn = std::function<Result<Script>(const std::string& address)>;
+
+    explicit SoloJobCache(ScriptFn script_for);
+
+    /// New template; `transactions` excludes the coinbase. The pool fee,
+    /// if any, stays on the template coinbase's own output script.
+    void SetWork(const uint256& job_id, const Transaction& coinbase,
+                 std::span<const Transaction> transactions, double pool_fee);
+
+    /// The miner's job for the current template
+    Result<std::shared_ptr<const SoloJob>> GetJob(uint64_t miner_id, const std::string& address);
+
+    /// Jobs built for the current template
+    size_t GetJobCount() const;
+
+    /// Merkle branch of leaf 0 given the other leaves, bottom up
+    static std::vector<uint256> CoinbaseBranch(std::span<const uint256> tx_hashes);
+
+    /// Merkle root from the coinbase hash and its branch
+    static uint256 FoldBranch(const uint256& coinbase_hash, const std::vector<uint256>& branch);
+
+private:
+    struct Payee {
+        std::string address;
+        Script script;
+    };
+
+    mutable std::mutex mutex_;
+    ScriptFn script_for_;
+    std::optional<uint256> job_id_;
+    Transaction coinbase_;
+    uint64_t coinbase_value_ = 0;
+    uint64_t pool_fee_ = 0;
+    std::vector<uint256> branch_;
+    std::shared_ptr<const std::vector<std::string>> branch_hex_;
+    std::unordered_map<uint64_t, Payee> payees_;
+    std::unordered_map<uint64_t, std::shared_ptr<const SoloJob>> jobs_;
+};
+
+// ============================================================================
+// Job Scheduler
+// ============================================================================
+
+/// Template source and block sink for one chain
+class ChainBackend {
+public:
+    virtual ~ChainBackend() = default;
+
+    /// Template for the chain's next block; transactions start with the
+    /// coinbase, as in MiningPoolServer::CreateWork
+    virtual Result<Work> CreateWork() = 0;
+
+    /// Submit a solved block
+    virtual Result<void> SubmitBlock(const Block& block) = 0;
+
+    /// Hash of the active chain's block at a height (for maturity checks)
+    virtual Result<uint256> GetBlockHash(uint64_t height) = 0;
+};
+
+/// Current templates of several chains and the routing of hashrate between
+/// them; job ids carry their chain (chain 0 is the pool's own)
+class JobScheduler {
+public:
+    static constexpr ChainId kPrimaryChain = 0;
+
+    /// Value per unit of share difficulty; the default is
+    /// price * coinbase_value / network difficulty
+    using ProfitFn = std::function<double(const ChainConfig& config, const Work& work)>;
+
+    /// Switchable hashrate only moves to a chain at least switch_margin
+    /// (fractional) more profitable than the one it is on
+    explicit JobScheduler(double switch_margin = 0.05, ProfitFn profit = {});
+    ~JobScheduler();
+
+    JobScheduler(const JobScheduler&) = delete;
+    JobScheduler& operator=(const JobScheduler&) = delete;
+
+    /// Register a chain (the first one added is kPrimaryChain); the
+    /// backend may be null for a chain whose work is set by the caller
+    ChainId AddChain(const ChainConfig& config, std::shared_ptr<ChainBackend> backend);
+
+    /// Told of each non-primary block found or orphaned, so the caller can
+    /// persist it (called with no scheduler lock held)
+    using BlockFn = std::function<void(const std::string& chain_name, const FoundBlock& block)>;
+    void SetBlockCallback(BlockFn callback);
+
+    /// Resume tracking an immature block persisted before a restart;
+    /// false if no chain has that name
+    bool RestoreBlock(const std::string& chain_name, FoundBlock block);
+
+    size_t GetChainCount() const;
+
+    /// Make `work` the chain's current template; its job id is stamped
+    /// with the chain. Returns the stamped work.
+    Result<Work> SetWork(ChainId chain, Work work);
+
+    /// Fetch a template from the chain's backend and make it current
+    Result<Work> Refresh(ChainId chain);
+
+    /// Current template of a chain
+    std::shared_ptr<const Work> GetWork(ChainId chain) const;
+
+    /// Chain for a port: the chain pinned to it, else the best chain
+    ChainId GetChainForPort(uint16_t port) const;
+
+    /// Best chain for switchable hashrate
+    ChainId GetActiveChain() const;
+
+    /// Re-rank chains; true if switchable hashrate moved
+    bool Rebalance();
+
+    /// Chain a job id was issued by
+    static ChainId ChainOf(const uint256& job_id);
+
+    /// Account a validated share on a non-primary chain, submitting it as a
+    /// block if it meets the chain's target; call with no pool lock held
+    Result<bool> SubmitShare(const Share& share);
+
+    /// A block found on a non-primary chain that has matured; its credits
+    /// and fee are converted to the pool's unit at the chain's price
+    struct MaturedBlock {
+        ChainId chain = kPrimaryChain;
+        std::string chain_name;
+        FoundBlock block;
+    };
+
+    /// Re-check non-primary immature blocks; orphans go to the block
+    /// callback, matured blocks are returned (backends asked unlocked)
+    std::vector<MaturedBlock> CheckMaturity();
+
+    std::vector<ChainStatistics> GetStatistics() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// ============================================================================
+// Block Tracker
+// ============================================================================
+
+/// Blocks found by the pool: pending -> confirmed | orphaned
+class BlockTracker {
+public:
+    /// Hash of the active chain's block at a height; nullopt above the tip
+    /// or when the lookup fails (the block is then re-checked next tip)
+    using HashAtFn = std::function<std::optional<uint256>(uint64_t height)>;
+
+    explicit BlockTracker(uint32_t maturity = 100, size_t history = 1000);
+
+    /// Start tracking a block just submitted
+    void Add(FoundBlock block);
+
+    /// Re-check immature blocks at a new tip; returns the blocks that
+    /// confirmed or were orphaned
+    std::vector<FoundBlock> OnTip(uint64_t tip_height, const HashAtFn& hash_at);
+
+    /// Pending and recently settled blocks, newest first
+    std::vector<FoundBlock> GetRecent(size_t limit) const;
+
+    const std::vector<FoundBlock>& GetPending() const { return pending_; }
+    uint64_t GetConfirmedCount() const { return confirmed_count_; }
+    uint64_t GetOrphanedCount() const { return orphaned_count_; }
+
+private:
+    uint32_t maturity_;
+    size_t history_;
+    std::vector<FoundBlock> pending_;           // Immature, by height
+    std::deque<FoundBlock> settled_;            // Newest last, at most history_
+    uint64_t confirmed_count_ = 0;
+    uint64_t orphaned_count_ = 0;
+    uint64_t tip_height_ = 0;
+    std::optional<uint256> tip_hash_;
+};
+
+// ============================================================================
+// Chain State Cache
+// ============================================================================
+
+/// The node's tip, difficulty, network hashrate and reward, read once per
+/// tip; readers never block
+class ChainStateCache {
+public:
+    struct Source {
+        std::function<uint64_t()> best_height;
+        std::function<uint64_t()> difficulty;
+        /// Timestamp (unix seconds) of the active chain's block at a height
+        std::function<std::optional<uint64_t>(uint64_t height)> time_at;
+        /// Subsidy of the block at a height; never increases with height
+        std::function<uint64_t(uint64_t height)> reward_at;
+    };
+
+    explicit ChainStateCache(Source source, uint32_t hashrate_blocks = 120);
+    ChainStateCache(const ChainStateCache&) = delete;
+    ChainStateCache& operator=(const ChainStateCache&) = delete;
+
+    /// Re-read the chain; returns true if the tip moved
+    bool Refresh();
+
+    /// Latest state (all zero before the first refresh)
+    ChainState Get() const;
+
+    uint64_t GetHeight() const { return height_.load(std::memory_order_acquire); }
+    uint64_t GetDifficulty() const { return difficulty_.load(std::memory_order_acquire); }
+
+private:
+    Source source_;
+    uint32_t hashrate_blocks_;
+    std::mutex refresh_mutex_;                            // One refresh at a time
+    std::deque<std::pair<uint64_t, uint64_t>> times_;    // (height, timestamp), newest last
+
+    std::atomic<uint64_t> sequence_{0};   // Odd while a refresh is publishing
+    std::atomic<uint64_t> height_{0};
+    std::atomic<uint64_t> difficulty_{0};
+    std::atomic<double> network_hashrate_{0.0};
+    std::atomic<uint64_t> block_reward_{0};
+    std::atomic<uint64_t> next_reward_height_{0};
+    std::atomic<uint64_t> next_block_reward_{0};
+    std::atomic<int64_t> updated_ms_{0};
+};
+
+// ============================================================================
+// Luck Tracker
+// ============================================================================
+
+/// Round effort and rolling luck from accumulated work
+class LuckTracker {
+public:
+    explicit LuckTracker(size_t window = 100);
+
+    /// Effort of a round so far (%); 0 without a difficulty
+    static double Effort(const RoundStatistics& round);
+
+    /// Add a closed round; rounds without work or difficulty are skipped
+    void Close(const RoundStatistics& round);
+
+    /// Work for a closed round that became durable after it closed
+    void AddWork(uint64_t round_id, uint64_t work);
+
+    /// Closed rounds over the rolling window, oldest first (at startup)
+    void Restore(const std::vector<RoundStatistics>& rounds);
+
+    /// Expected / actual work over the window (%); 0 before any round
+    double GetRollingLuck() const;
+
+    /// Closed rounds in the window, newest first
+    std::vector<RoundLuck> GetRecent(size_t limit) const;
+
+    size_t GetRoundCount() const { return rounds_.size(); }
+
+private:
+    size_t window_;
+    std::deque<RoundLuck> rounds_;    // Newest last
+    uint64_t work_sum_ = 0;
+    uint64_t expected_sum_ = 0;
 };
 
 // ============================================================================
@@ -637,6 +1402,50 @@ public:
                                             uint64_t share_difficulty);
 };
 
+/// Share counts and hashrate over sliding windows, O(1) lock-free reads
+class HashrateMeter {
+public:
+    using Window = StatsWindow;
+    using Totals = WindowTotals;
+
+    HashrateMeter() = default;
+    HashrateMeter(const HashrateMeter&) = delete;
+    HashrateMeter& operator=(const HashrateMeter&) = delete;
+
+    /// Credit one share of difficulty `work` at `now`
+    void Add(uint64_t work, std::chrono::steady_clock::time_point now);
+
+    /// Shares and work in `window`, ending at `now`
+    Totals Get(Window window, std::chrono::steady_clock::time_point now) const;
+
+    /// Work credited in the last ten minutes
+    uint64_t GetWork(std::chrono::steady_clock::time_point now) const;
+
+    /// Hashes per second over `window` (ten minutes by default)
+    double GetHashrate(std::chrono::steady_clock::time_point now,
+                       Window window = Window::TEN_MINUTES) const;
+
+private:
+    struct Tier {
+        uint64_t bucket_secs;
+        size_t buckets;                // Longest window served, in buckets
+        size_t offset;                 // First of the tier's buckets + 1 slots
+    };
+    static constexpr std::array<Tier, 4> kTiers = {{
+        {15, 4, 0}, {60, 10, 5}, {300, 12, 16}, {3600, 24, 29}
+    }};
+    static constexpr size_t kSlots = 54;
+    static constexpr uint64_t kEmpty = UINT64_MAX;
+
+    std::array<std::atomic<uint64_t>, kSlots> work_{};
+    std::array<std::atomic<uint32_t>, kSlots> shares_{};  // Modulo 2^32; windows hold fewer
+    std::atomic<uint64_t> sequence_{0};   // Odd while a write is in progress
+    std::atomic<uint64_t> head_{0};       // Second of the latest share
+    std::atomic<uint64_t> start_{kEmpty}; // Second of the first share
+    std::atomic<uint64_t> total_work_{0};
+    std::atomic<uint32_t> total_shares_{0};
+};
+
 // ============================================================================
 // Utility Functions
 // ============================================================================
@@ -644,6 +1453,16 @@ public:
 /// Convert payout method to string
 std::string ToString(PoolConfig::PayoutMethod method);
 
+/// Parse a payout method name (PPLNS, PPLNS-DECAYED, PPS, FPPS, PPS-PLUS,
+/// PROP/PROPORTIONAL, SOLO), case-insensitive
+std::optional<PoolConfig::PayoutMethod> ParsePayoutMethod(const std::string& name);
+
+/// True for methods credited per share (PPS, FPPS, PPS+)
+bool IsPerShareMethod(PoolConfig::PayoutMethod method);
+
+/// Convert block status to string ("pending", "confirmed", "orphaned")
+std::string ToString(FoundBlock::Status status);
+
 /// Parse Stratum message from JSON
 Result<stratum::Message> ParseStratumMessage(const std::string& json);
 
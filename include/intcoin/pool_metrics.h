@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2025 INTcoin Team (Neil Adamson)
+ * MIT License
+ * Mining Pool Metrics (Prometheus)
+ */
+
+#ifndef INTCOIN_POOL_METRICS_H
+#define INTCOIN_POOL_METRICS_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace intcoin {
+namespace pool {
+
+// ============================================================================
+// Metric Types
+// ============================================================================
+
+/// Shards per counter and histogram; threads are spread over them round robin
+constexpr size_t kMetricShards = 8;
+
+/// This thread's shard, fixed on first use
+size_t MetricShard();
+
+/**
+ * Monotonic counter. Each thread increments its own cache line, so hot
+ * paths never contend; a scrape sums the shards.
+ */
+class Counter {
+public:
+    void Inc(uint64_t n = 1) {
+        shards_[MetricShard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t Value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Shard, kMetricShards> shards_{};
+};
+
+/// Value that goes up and down (connections, heights, rates)
+class Gauge {
+public:
+    void Set(double value) { value_.store(value, std::memory_order_relaxed); }
+    void Add(double delta) { value_.fetch_add(delta, std::memory_order_relaxed); }
+    double Value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> value_{0.0};
+};
+
+/**
+ * Latency histogram in nanoseconds, HDR style: each power of two from
+ * 1.024 us to 17.2 s is split into four linear buckets, so a bucket is
+ * never wider than a quarter of its values. Slower values land in +Inf.
+ * Recording is one relaxed add on the thread's own shard; Prometheus
+ * sees the buckets as cumulative `le` bounds in seconds.
+ */
+class Histogram {
+public:
+    static constexpr unsigned kMinExponent = 10;     // First octave: 2^10 ns
+    static constexpr unsigned kOctaves = 24;
+    static constexpr unsigned kSubBuckets = 4;
+    static constexpr size_t kBuckets = kOctaves * kSubBuckets;
+    static_assert(kSubBuckets == 4, "BucketOf takes two bits below the leading one");
+
+    void Record(uint64_t nanos) {
+        Shard& shard = shards_[MetricShard()];
+        shard.buckets[BucketOf(nanos)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(nanos, std::memory_order_relaxed);
+    }
+
+    void Record(std::chrono::steady_clock::duration elapsed) {
+        Record(static_cast<uint64_t>(std::max<int64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), 0)));
+    }
+
+    /// Bucket a value falls in; kBuckets is +Inf
+    static size_t BucketOf(uint64_t nanos) {
+        if (nanos < (uint64_t{1} << kMinExponent)) return 0;
+        unsigned exponent = static_cast<unsigned>(std::bit_width(nanos)) - 1;
+        if (exponent >= kMinExponent + kOctaves) return kBuckets;
+        // The two bits below the leading one pick the quarter
+        size_t sub = (nanos >> (exponent - 2)) & (kSubBuckets - 1);
+        return (exponent - kMinExponent) * kSubBuckets + sub;
+    }
+
+    /// Upper bound of a bucket (ns)
+    static uint64_t UpperBound(size_t bucket);
+
+    /// Per-bucket counts (not cumulative; the last is +Inf) and the sum (ns)
+    void Collect(std::array<uint64_t, kBuckets + 1>& counts, uint64_t& sum) const;
+
+private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, kBuckets + 1> buckets{};
+        std::atomic<uint64_t> sum{0};
+    };
+    std::array<Shard, kMetricShards> shards_{};
+};
+
+/// Records the time from construction to destruction
+class MetricTimer {
+public:
+    explicit MetricTimer(Histogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+    ~MetricTimer() { histogram_.Record(std::chrono::steady_clock::now() - start_); }
+
+    MetricTimer(const MetricTimer&) = delete;
+    MetricTimer& operator=(const MetricTimer&) = delete;
+
+private:
+    Histogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// ============================================================================
+// Metrics Registry
+// ============================================================================
+
+/**
+ * Metrics registered up front and rendered in Prometheus text format.
+ *
+ * Every metric is created before the registry is served, so names, help
+ * text and label sets are formatted once; a scrape only reads atomics and
+ * writes numbers into the caller's buffer. Series registered under the
+ * same name share one HELP/TYPE header. Registration is not thread-safe.
+ */
+class MetricsRegistry {
+public:
+    /// `labels` is the inside of the braces, e.g. `result="accepted"`
+    Counter& AddCounter(const std::string& name, const std::string& help, const std::string& labels = "");
+    Gauge& AddGauge(const std::string& name, const std::string& help, const std::string& labels = "");
+    Histogram& AddHistogram(const std::string& name, const std::string& help, const std::string& labels = "");
+
+    /// Append every metric (text format 0.0.4). The buffer is reserved
+    /// from the previous scrape's size; nothing else is allocated.
+    void Render(std::string& out) const;
+
+private:
+    enum class Type { COUNTER, GAUGE, HISTOGRAM };
+
+    struct Series {
+        std::string name;               // Family name plus `{labels}`
+        std::string bucket_prefix;      // `name_bucket{labels,le="` (histograms)
+        std::string sum_name;           // `name_sum{labels}`
+        std::string count_name;         // `name_count{labels}`
+        const void* metric;
+    };
+
+    struct Family {
+        std::string name;
+        std::string header;             // HELP and TYPE lines
+        Type type;
+        std::vector<Series> series;
+    };
+
+    Family& FamilyFor(const std::string& name, const std::string& help, Type type);
+
+    std::vector<Family> families_;
+    std::deque<Counter> counters_;
+    std::deque<Gauge> gauges_;
+    std::deque<Histogram> histograms_;
+    mutable std::atomic<size_t> last_size_{4096};
+};
+
+// ============================================================================
+// Pool Metrics
+// ============================================================================
+
+/// The pool's metrics, registered once and shared by its components
+struct PoolMetrics {
+    PoolMetrics();
+    PoolMetrics(const PoolMetrics&) = delete;
+    PoolMetrics& operator=(const PoolMetrics&) = delete;
+
+    MetricsRegistry registry;
+
+    Counter& shares_accepted;
+    Counter& shares_rejected;
+    Counter& blocks_found;
+    Counter& connections_total;
+
+    Gauge& connections;
+    Gauge& pool_hashrate;
+    Gauge& network_height;
+    Gauge& network_difficulty;
+    Gauge& network_hashrate;
+    Gauge& pps_fund;
+
+    Histogram& share_validation;        // ValidateShare
+    Histogram& submit_to_ack;           // mining.submit received to reply sent
+    Histogram& notify_fanout;           // One job to every connection of a port
+    Histogram& template_build;          // Block template to Work
+    Histogram& lock_wait;               // Waiting for the pool lock on submit
+};
+
+} // namespace pool
+} // namespace intcoin
+
+#endif // INTCOIN_POOL_METRICS_H
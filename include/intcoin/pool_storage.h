@@ -0,0 +1,719 @@
+/*
+ * Copyright (c) 2025 INTcoin Team (Neil Adamson)
+ * MIT License
+ * Mining Pool Persistent Storage
+ */
+
+#ifndef INTCOIN_POOL_STORAGE_H
+#define INTCOIN_POOL_STORAGE_H
+
+#include "pool.h"
+#include <memory>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <optional>
+#include <functional>
+#include <map>
+#include <istream>
+
+namespace intcoin {
+namespace pool {
+
+class ShareArchive;
+
+// ============================================================================
+// Pool Database
+// ============================================================================
+
+struct PoolDatabaseOptions {
+    size_t block_cache_mb = 512;                      // Shared LRU block cache
+    size_t share_batch_size = 1024;                   // Shares per write batch
+    std::chrono::milliseconds flush_interval{50};     // Max delay before a batch is committed
+    bool sync_payments = true;                        // fsync payment/block writes
+    std::chrono::milliseconds stats_flush_interval{1000};  // Cadence for dirty worker/miner counters
+    bool read_only = false;                           // Open alongside a running pool (no writes)
+    bool allow_old_schema = false;                    // Open a database that still needs a migrate
+};
+
+/**
+ * RocksDB-backed pool database
+ *
+ * Column families (all keys big-endian so iteration order == numeric order):
+ * - shares:   round_id(8) | share_id(8)  -> Share       (prefix extractor: round_id)
+ * - workers:  worker_id(8)                -> Worker
+ * - miners:   miner_id(8)                 -> Miner
+ * - rounds:   round_id(8)                 -> RoundStatistics
+ * - blocks:   height(8) | hash(32)        -> BlockRecord
+ * - payments: payment_id(8)               -> Payment
+ * - worker_stats / miner_stats: id(8)     -> share and hashrate counters
+ * - ledger:   seq(8)                      -> LedgerEntry
+ * - ledger_keys: idempotency key          -> seq(8)
+ * - balances: account(1) | id(8)          -> LedgerBalance
+ * - miner_addresses: payout address       -> miner_id(8)
+ *
+ * Every record value starts with its layout version. The default column
+ * family holds the schema version; opening a database stamped with an
+ * older schema fails until `intcoin-pool-db migrate` has upgraded it.
+ *
+ * Shares are buffered into a WriteBatch and committed every
+ * share_batch_size records or flush_interval, whichever comes first.
+ * Counters marked dirty are coalesced per worker/miner and written as one
+ * batch every stats_flush_interval, so write volume follows the number of
+ * active workers rather than the share rate.
+ */
+class PoolDatabase {
+public:
+    explicit PoolDatabase(const std::string& db_path,
+                          const PoolDatabaseOptions& options = PoolDatabaseOptions());
+    ~PoolDatabase();
+
+    PoolDatabase(const PoolDatabase&) = delete;
+    PoolDatabase& operator=(const PoolDatabase&) = delete;
+
+    /// Open (or create) the database and start the batch flusher
+    Result<void> Open();
+
+    /// Commit pending writes and close the database
+    void Close();
+
+    /// Check if database is open
+    bool IsOpen() const;
+
+    /// Commit any buffered share writes
+    Result<void> Flush();
+
+    /// Serve 24h share aggregates from a columnar archive instead of
+    /// scanning the shares column family (null detaches it)
+    void SetShareArchive(std::shared_ptr<const ShareArchive> archive);
+
+    // ------------------------------------------------------------------------
+    // Worker / Miner Management
+    // ------------------------------------------------------------------------
+
+    Result<void> SaveWorker(const Worker& worker);
+    Result<Worker> LoadWorker(uint64_t worker_id);
+
+    /// Highest stored worker id (0 if none)
+    uint64_t GetLastWorkerId();
+
+    Result<void> SaveMiner(const Miner& miner);
+    Result<Miner> LoadMiner(uint64_t miner_id);
+    std::vector<Miner> LoadAllMiners();
+
+    /// Miner by payout address (miner_addresses index, kept current by
+    /// registration and payout address changes)
+    Result<Miner> LoadMinerByAddress(const std::string& address);
+
+    /// Queue a worker's counters for the next stats flush
+    /// (repeated calls before the flush coalesce into one write)
+    void MarkWorkerDirty(const Worker& worker);
+
+    /// Queue a miner's share/hashrate counters (balances go through SaveMiner)
+    void MarkMinerDirty(const Miner& miner);
+
+    /// Write all queued counters now
+    Result<void> FlushStats();
+
+    // ------------------------------------------------------------------------
+    // Share Tracking
+    // ------------------------------------------------------------------------
+
+    /// Buffer share for the next batch commit
+    Result<void> RecordShare(const Share& share, uint64_t round_id = 0);
+
+    /// Most recent shares, oldest first
+    std::vector<Share> GetRecentShares(int limit);
+
+    /// All shares recorded for a round (prefix scan)
+    std::vector<Share> GetRoundShares(uint64_t round_id);
+
+    /// Valid shares in the last 24 hours
+    uint64_t GetTotalShares24h();
+
+    // ------------------------------------------------------------------------
+    // Round Tracking
+    // ------------------------------------------------------------------------
+
+    Result<void> SaveRound(const RoundStatistics& round);
+    Result<RoundStatistics> LoadRound(uint64_t round_id);
+    std::vector<RoundStatistics> GetRecentRounds(int limit);
+
+    // ------------------------------------------------------------------------
+    // Block Tracking
+    // ------------------------------------------------------------------------
+
+    struct BlockRecord {
+        uint64_t height;
+        uint256 hash;
+        std::string finder_address;
+        uint64_t reward;
+        std::string status;  // "pending", "confirmed", "orphaned"
+        std::chrono::system_clock::time_point timestamp;
+        uint64_t round_id = 0;
+        uint64_t finder_id = 0;
+        std::vector<std::pair<uint64_t, uint64_t>> credits;   // (miner_id, amount) by id, posted at maturity
+        uint64_t pool_fee = 0;
+        uint64_t pps_funding = 0;    // Prepaid per share; moves to PPS_FUND at maturity
+        std::string chain;           // Other chains' blocks; empty for the pool's own
+    };
+
+    Result<void> RecordBlock(uint64_t height, const uint256& hash,
+                             const std::string& finder, uint64_t reward);
+    Result<void> RecordBlock(const BlockRecord& block);
+    Result<void> UpdateBlockStatus(uint64_t height, const uint256& hash,
+                                   const std::string& status);
+    std::vector<BlockRecord> GetRecentBlocks(int limit);
+
+    /// Blocks in one status (a full scan of the blocks table; for startup)
+    std::vector<BlockRecord> GetBlocksByStatus(const std::string& status);
+
+    // ------------------------------------------------------------------------
+    // Payment Tracking
+    // ------------------------------------------------------------------------
+
+    struct Payment {
+        uint64_t payment_id;
+        std::string address;
+        uint64_t amount;
+        std::string txid;
+        std::chrono::system_clock::time_point timestamp;
+        uint64_t miner_id = 0;
+        std::string status;         // Payout engine state; empty for legacy rows
+    };
+
+    Result<void> RecordPayment(const std::string& address, uint64_t amount,
+                               const std::string& txid);
+
+    /// Record the payments of one transaction in a single durable write.
+    /// Payments with id 0 get a new id; others replace the row with their id.
+    Result<void> RecordPayments(const std::vector<Payment>& payments);
+
+    std::vector<Payment> GetRecentPayments(int limit);
+
+    /// Payments in one status (a full scan of the payments table; for startup)
+    std::vector<Payment> GetPaymentsByStatus(const std::string& status);
+
+    // ------------------------------------------------------------------------
+    // Ledger
+    // ------------------------------------------------------------------------
+
+    /// Double-entry accounts; only MINER accounts are per-id
+    enum class LedgerAccount : uint8_t {
+        MINER = 0,
+        BLOCK_REWARDS = 1,      // Source of round credits, fees and PPS funding
+        PPS_FUND = 2,           // Source of per-share credits, refilled by matured blocks
+        POOL_FEES = 3,
+        PAYOUTS = 4,            // Sink for payments sent
+    };
+
+    /// Entry types, each moving amount from one account to another
+    enum class LedgerType : uint8_t {
+        ROUND_CREDIT = 1,       // BLOCK_REWARDS -> MINER
+        PPS_CREDIT = 2,         // PPS_FUND -> MINER
+        POOL_FEE = 3,           // BLOCK_REWARDS -> POOL_FEES
+        PAYMENT = 4,            // MINER -> PAYOUTS
+        PPS_FUNDING = 5,        // BLOCK_REWARDS -> PPS_FUND
+    };
+
+    struct LedgerEntry {
+        std::string key;            // Idempotency key, e.g. "round/42/7"
+        LedgerType type = LedgerType::ROUND_CREDIT;
+        uint64_t miner_id = 0;
+        uint64_t amount = 0;
+        uint64_t reference = 0;     // round_id, share_id or payment_id
+        std::string memo;           // Payout address, txid, ...
+        std::chrono::system_clock::time_point timestamp;
+        uint64_t seq = 0;           // Assigned when posted
+    };
+
+    struct LedgerBalance {
+        int64_t balance = 0;
+        uint64_t credited = 0;
+        uint64_t debited = 0;
+    };
+
+    /// Post entries together with their balance changes in one durable
+    /// batch. Entries whose key was already posted are skipped, so a replay
+    /// after a crash is harmless. Fails without writing anything if a
+    /// payment would overdraw a miner. `payments` rows are written in the
+    /// same batch, so a debit is never durable without its payment record.
+    /// Returns the number of entries applied.
+    Result<size_t> PostLedgerEntries(const std::vector<LedgerEntry>& entries,
+                                     const std::vector<Payment>& payments = {});
+
+    /// Materialized balance, served from memory
+    LedgerBalance GetBalance(LedgerAccount account, uint64_t miner_id = 0) const;
+
+    /// Highest reference posted for an entry type (e.g. last payment_id)
+    uint64_t GetLastLedgerReference(LedgerType type) const;
+
+    /// Entries with seq > after_seq, oldest first
+    std::vector<LedgerEntry> GetLedgerEntries(uint64_t after_seq, size_t limit);
+
+    /// Rebuild balances from the ledger and compare with the materialized
+    /// view; also checks that all accounts sum to zero
+    Result<void> VerifyLedger();
+
+    // ------------------------------------------------------------------------
+    // Statistics
+    // ------------------------------------------------------------------------
+
+    struct WorkerStats {
+        std::string address;
+        uint64_t hashrate = 0;
+        uint64_t shares_24h = 0;
+        uint64_t balance = 0;
+        uint64_t total_paid = 0;
+    };
+
+    std::vector<WorkerStats> GetTopMiners(int limit);
+
+    // ------------------------------------------------------------------------
+    // Maintenance (intcoin-pool-db)
+    // ------------------------------------------------------------------------
+
+    struct MaintenanceStats {
+        uint64_t records = 0;           // Records visited
+        uint64_t written = 0;           // Records written
+        uint64_t outdated = 0;          // Records with an older layout version
+        uint64_t bytes = 0;             // Value bytes visited
+    };
+
+    /// Schema version stamped in the database
+    uint32_t GetSchemaVersion() const;
+
+    /// Visit the legacy shares column family in key (round, share) order
+    Result<void> ForEachShare(const std::function<Result<void>(const Share&, uint64_t round_id)>& fn);
+
+    /// Bulk-load rounds and payments; writes skip the WAL and are flushed
+    /// to table files before returning. Payments with id 0 get a new id.
+    Result<MaintenanceStats> ImportRecords(const std::vector<RoundStatistics>& rounds,
+                                           const std::vector<Payment>& payments);
+
+    /// Re-encode records written with an older layout version, splitting
+    /// each column family into key ranges handled by `threads` workers,
+    /// then rebuild indexes and stamp the current schema. rewrite_all
+    /// re-encodes current records as well.
+    Result<MaintenanceStats> MigrateRecords(unsigned threads, bool rewrite_all = false);
+
+    /// Check table file checksums, decode every record (in parallel key
+    /// ranges), verify the ledger and the address index
+    Result<MaintenanceStats> VerifyRecords(unsigned threads);
+
+    /// Rebuild derived tables from their sources: miner_addresses from
+    /// miners, ledger_keys and balances from the ledger
+    Result<MaintenanceStats> RebuildIndexes();
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// ============================================================================
+// Share Journal (write-ahead log)
+// ============================================================================
+
+/// CRC-32C (Castagnoli); pass the previous result as crc to extend
+uint32_t Crc32c(const uint8_t* data, size_t len, uint32_t crc = 0);
+
+/// Journal record flags
+enum JournalFlags : uint32_t {
+    JOURNAL_SHARE_VALID = 1 << 0,   // Accepted share
+    JOURNAL_SHARE_BLOCK = 1 << 1,   // Share also solved a block
+    JOURNAL_ROUND_END   = 1 << 2,   // Round closed (no share payload)
+};
+
+/**
+ * Fixed-size journal record (64 bytes on disk, little-endian)
+ *
+ * | crc32c(4) | flags(4) | seq(8) | share_id(8) | round_id(8) |
+ * | miner_id(8) | worker_id(8) | difficulty(8) | timestamp_ms(8) |
+ *
+ * The CRC covers bytes 4..63 so torn writes at the tail are detected.
+ */
+struct JournalRecord {
+    static constexpr size_t kSize = 64;
+
+    uint32_t flags = 0;
+    uint64_t seq = 0;
+    uint64_t share_id = 0;
+    uint64_t round_id = 0;
+    uint64_t miner_id = 0;
+    uint64_t worker_id = 0;
+    uint64_t difficulty = 0;
+    int64_t timestamp_ms = 0;
+};
+
+struct ShareJournalOptions {
+    std::string dir;                                  // Segment directory
+    bool durable = true;                              // fdatasync each group commit
+    std::chrono::milliseconds commit_interval{10};    // Max delay before a group commit
+    size_t commit_records = 4096;                     // Records that force a group commit
+    size_t segment_bytes = 64 * 1024 * 1024;          // Rotate segments at this size
+    uint64_t first_seq = 1;                           // Lowest sequence to hand out (e.g. past imported shares)
+};
+
+/**
+ * Append-only share journal with group commit
+ *
+ * Append() only enqueues; a dedicated writer thread batches queued records
+ * into one write(2) + fdatasync per group commit and then hands the batch
+ * to the durable callback, which is where shares should start counting
+ * toward payouts.
+ */
+class ShareJournal {
+public:
+    using DurableCallback = std::function<void(const std::vector<JournalRecord>&)>;
+
+    explicit ShareJournal(const ShareJournalOptions& options);
+    ~ShareJournal();
+
+    ShareJournal(const ShareJournal&) = delete;
+    ShareJournal& operator=(const ShareJournal&) = delete;
+
+    /// Open segments, truncate a torn tail and start the writer thread
+    Result<void> Open();
+
+    /// Commit everything queued and stop the writer thread
+    void Close();
+
+    /// Called on the writer thread after each durable group commit
+    void SetDurableCallback(DurableCallback callback);
+
+    /// Queue an accepted share; returns its journal sequence number
+    uint64_t Append(const Share& share, uint64_t round_id);
+
+    /// Queue a round-closed marker
+    uint64_t AppendRoundEnd(uint64_t round_id);
+
+    /// Block until every record queued so far is durable
+    /// (must not be called from the durable callback)
+    Result<void> Sync();
+
+    /// Replay durable records with seq > after_seq, in order
+    Result<void> Replay(uint64_t after_seq,
+                        const std::function<void(const JournalRecord&)>& fn) const;
+
+    /// Delete whole segments whose records are all <= seq
+    Result<void> TruncateBefore(uint64_t seq);
+
+    /// Highest sequence number known to be on disk
+    uint64_t GetDurableSeq() const;
+
+    struct Stats {
+        uint64_t records_written = 0;
+        uint64_t group_commits = 0;
+        uint64_t bytes_written = 0;
+    };
+    Stats GetStats() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// ============================================================================
+// Share Archive (columnar, memory-mapped)
+// ============================================================================
+
+struct ShareArchiveOptions {
+    std::string dir;                                  // Segment directory
+    std::chrono::seconds segment_span{3600};          // Time covered by one segment
+    size_t segment_capacity = 4 * 1024 * 1024;        // Max shares per segment
+    std::chrono::seconds raw_retention{86400};        // Compaction never drops newer raw shares
+    size_t hot_shares = 1024 * 1024;                  // Newest shares kept in RAM (0 = no hot tier)
+    std::string cold_dir;                             // Compressed segments (empty = no cold tier)
+    std::chrono::seconds warm_retention{6 * 3600};    // Age at which sealed segments go cold
+    int cold_compression_level = 3;                   // zstd level for cold segments
+    bool read_only = false;                           // Map alongside a running pool (no writes)
+};
+
+/// Totals for one miner or worker from an archive scan
+struct ShareTotals {
+    uint64_t shares = 0;          // Valid shares
+    uint64_t work = 0;            // Sum of share difficulty
+    int64_t first_ms = 0;         // Oldest share timestamp
+    int64_t last_ms = 0;          // Newest share timestamp
+};
+
+/// A run of archived shares, column by column; the pointers may refer
+/// straight to mapped segment memory and are valid only during a callback
+struct ShareColumns {
+    size_t rows = 0;
+    const int64_t* timestamp_ms = nullptr;
+    const uint64_t* round_id = nullptr;
+    const uint64_t* miner_id = nullptr;
+    const uint64_t* worker_id = nullptr;
+    const uint64_t* difficulty = nullptr;
+    const uint8_t* flags = nullptr;               // JournalFlags
+};
+
+/// Work credited to one miner in a compacted round
+struct RoundWork {
+    uint64_t miner_id = 0;
+    uint64_t shares = 0;          // Valid shares
+    uint64_t work = 0;            // Sum of share difficulty
+};
+
+/// Compacted round: per-miner sums that replace the raw shares
+struct RoundSummary {
+    uint64_t round_id = 0;
+    uint64_t shares = 0;
+    uint64_t work = 0;
+    int64_t first_ms = 0;
+    int64_t last_ms = 0;
+    uint256 merkle_root{};            // Root over miners, in order
+    std::vector<RoundWork> miners;    // Sorted by miner_id
+    uint64_t network_difficulty = 0;  // Expected work; not archived, exports take it from the database
+};
+
+/// Merkle leaf: SHA3(round_id | miner_id | shares | work), little-endian
+uint256 RoundWorkLeaf(uint64_t round_id, const RoundWork& work);
+
+/// Merkle root over a summary's miners, hashed with the miner count
+/// (SHA3(count | tree root)); odd levels repeat the last node
+uint256 RoundMerkleRoot(const RoundSummary& summary);
+
+/// Sibling hashes from miners[index] up to the root
+std::vector<uint256> RoundMerkleProof(const RoundSummary& summary, size_t index);
+
+/// Check one miner's work against a published round root of leaf_count miners
+bool VerifyRoundMerkleProof(uint64_t round_id, const RoundWork& work, size_t index, size_t leaf_count,
+                            const std::vector<uint256>& proof, const uint256& root);
+
+/**
+ * Append-only columnar share archive
+ *
+ * Shares live in three tiers:
+ * - hot:  a ring of the newest hot_shares records in RAM, which answers
+ *         PPLNS windows without touching disk
+ * - warm: mmap'd column segments, written in place by Append()
+ * - cold: sealed segments older than warm_retention, each compressed into
+ *         one zstd file in cold_dir; only their headers stay in memory
+ *
+ * Each warm segment is a directory of fixed-width column files (timestamp,
+ * round_id, miner_id, worker_id, difficulty, flags) that are mmap'd and
+ * filled in place. Segments cover segment_span of wall-clock time; scans
+ * skip whole segments by their min/max timestamp and only touch the
+ * columns needed.
+ *
+ * Compact() rolls closed rounds into RoundSummary records (rounds.dat) and
+ * deletes raw segments once every round in them is summarized and they
+ * fall outside the PPLNS window and raw_retention, so long-term disk use
+ * grows with rounds x miners rather than with shares. MigrateCold() moves
+ * aged segments to the cold tier; scans route across tiers by the time
+ * range of each segment, so RAM stays bounded by hot_shares plus the warm
+ * window however long the history grows.
+ *
+ * Single writer (the journal's durable callback), any number of readers.
+ */
+class ShareArchive {
+public:
+    explicit ShareArchive(const ShareArchiveOptions& options);
+    ~ShareArchive();
+
+    ShareArchive(const ShareArchive&) = delete;
+    ShareArchive& operator=(const ShareArchive&) = delete;
+
+    /// Map existing segments (creating the directory if needed)
+    Result<void> Open();
+
+    /// Sync and unmap all segments
+    void Close();
+
+    /// Append durable journal records; non-share records are skipped
+    Result<void> Append(const std::vector<JournalRecord>& records);
+
+    /// msync the active segment (and any sealed segment whose msync failed)
+    Result<void> Sync();
+
+    /// Journal sequence of the last archived record
+    uint64_t GetLastSeq() const;
+
+    /// Total archived shares (all tiers)
+    uint64_t GetShareCount() const;
+
+    /// Per-miner totals over the last n valid shares (PPLNS window)
+    std::map<uint64_t, ShareTotals> ScanLastShares(uint64_t n) const;
+
+    /// Visit the last n valid shares, newest first
+    void ForEachLastShare(uint64_t n,
+                          const std::function<void(uint64_t miner_id, int64_t timestamp_ms,
+                                                   uint64_t difficulty)>& fn) const;
+
+    /// Per-miner totals for shares in [from, to)
+    std::map<uint64_t, ShareTotals> ScanMiners(std::chrono::system_clock::time_point from,
+                                               std::chrono::system_clock::time_point to) const;
+
+    /// Per-worker totals for shares in [from, to)
+    std::map<uint64_t, ShareTotals> ScanWorkers(std::chrono::system_clock::time_point from,
+                                                std::chrono::system_clock::time_point to) const;
+
+    /// Stream every share (valid or not) with a timestamp in [from, to),
+    /// oldest segment first, in runs of at most chunk_rows. Segments wholly
+    /// inside the range are handed out without copying.
+    Result<void> ForEachShareChunk(std::chrono::system_clock::time_point from,
+                                   std::chrono::system_clock::time_point to, size_t chunk_rows,
+                                   const std::function<Result<void>(const ShareColumns&)>& fn) const;
+
+    /// Stream compacted round summaries, lowest round first
+    Result<void> ForEachRoundSummary(const std::function<Result<void>(const RoundSummary&)>& fn) const;
+
+    /// Summarize rounds up to through_round, then drop raw segments that are
+    /// fully summarized and older than the newest keep_last_shares valid
+    /// shares; returns the number of segments dropped
+    Result<size_t> Compact(uint64_t through_round, uint64_t keep_last_shares);
+
+    /// Compress sealed segments older than warm_retention into cold_dir;
+    /// returns the number of segments migrated
+    Result<size_t> MigrateCold();
+
+    struct TierStats {
+        uint64_t hot_shares = 0;
+        uint64_t warm_segments = 0;
+        uint64_t warm_shares = 0;
+        uint64_t cold_segments = 0;
+        uint64_t cold_shares = 0;
+        uint64_t cold_bytes = 0;      // Compressed size on disk
+    };
+    TierStats GetTierStats() const;
+
+    /// Highest round rolled into a summary
+    uint64_t GetCompactedRound() const;
+
+    /// Load a compacted round
+    Result<RoundSummary> GetRoundSummary(uint64_t round_id) const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// ============================================================================
+// State Snapshots
+// ============================================================================
+
+/**
+ * Point-in-time copy of pool state
+ *
+ * The snapshot reflects every journal record up to journal_seq; recovery
+ * loads it and replays the journal from journal_seq + 1.
+ */
+struct PoolSnapshot {
+    uint64_t journal_seq = 0;
+    std::chrono::system_clock::time_point created_at;
+
+    // ID allocators
+    uint64_t next_miner_id = 1;
+    uint64_t next_worker_id = 1;
+    uint64_t next_share_id = 1;
+    uint64_t next_round_id = 1;
+    uint64_t next_payment_id = 1;
+
+    RoundStatistics current_round;
+    std::map<uint64_t, Miner> miners;   // Registry and balances (workers are not persisted)
+};
+
+/**
+ * Snapshot files: snapshot-<journal_seq>.snap, CRC32C-framed
+ *
+ * Written to a temp file, fsync'd and renamed into place, so a crash
+ * mid-write leaves the previous snapshot intact.
+ */
+class SnapshotStore {
+public:
+    explicit SnapshotStore(const std::string& dir, size_t keep = 2);
+
+    /// Durably write a snapshot and prune all but the newest `keep`
+    Result<void> Write(const PoolSnapshot& snapshot);
+
+    /// Load the newest snapshot that passes its checksum
+    Result<PoolSnapshot> LoadLatest() const;
+
+private:
+    std::string dir_;
+    size_t keep_;
+};
+
+// ============================================================================
+// History Export
+// ============================================================================
+
+/// Tables selectable for export
+enum ExportTables : uint32_t {
+    EXPORT_SHARES   = 1 << 0,
+    EXPORT_ROUNDS   = 1 << 1,   // Compacted round summaries, one row per miner
+    EXPORT_PAYMENTS = 1 << 2,   // PAYMENT ledger entries
+    EXPORT_ALL      = EXPORT_SHARES | EXPORT_ROUNDS | EXPORT_PAYMENTS,
+};
+
+enum class ExportFormat {
+    COLUMNAR,                   // Chunked binary columns (see ExportHistory)
+    CSV,                        // One table per export, with a header row
+};
+
+struct ExportOptions {
+    std::chrono::system_clock::time_point from;
+    std::chrono::system_clock::time_point to;
+    uint32_t tables = EXPORT_ALL;
+    ExportFormat format = ExportFormat::COLUMNAR;
+    size_t chunk_rows = 65536;                        // Max rows per columnar chunk
+};
+
+struct ExportStats {
+    uint64_t shares = 0;
+    uint64_t round_rows = 0;
+    uint64_t payments = 0;
+    uint64_t chunks = 0;
+    uint64_t bytes = 0;
+};
+
+/// Receives the export as consecutive byte ranges; a range may point into
+/// mapped archive memory and is only valid for the duration of the call
+using ExportSink = std::function<Result<void>(const uint8_t* data, size_t len)>;
+
+/**
+ * Stream archived history for [from, to) straight from storage
+ *
+ * Reads the share archive and the ledger only, so it never waits on the
+ * pool's locks; database may be null to skip payments (rounds then carry
+ * no network difficulty). Columnar layout
+ * (all integers little-endian):
+ *
+ *   header:  magic "#INCXPRT"(8) | version(4) | tables(4) | from_ms(8) | to_ms(8)
+ *   chunk:   table(4) | rows(4) | payload_bytes(8) | crc32c(4) | reserved(4) | payload
+ *   end:     a chunk with table 0 and no rows
+ *
+ * A payload holds the table's columns one after another, rows x width
+ * bytes each; string columns are (rows + 1) u32 offsets followed by the
+ * bytes. Table ids are the ExportTables bits:
+ *
+ *   shares:   timestamp_ms i64, round_id, miner_id, worker_id, difficulty, flags u8
+ *   rounds:   round_id, miner_id, shares, work, first_ms i64, last_ms i64, network_difficulty
+ *   payments: seq, payment_id, miner_id, amount, timestamp_ms i64, key str, memo str
+ *
+ * A round's rows never span two chunks. CSV exports must select a single
+ * table. Version 1 exports lack the rounds network_difficulty column; they
+ * still read, with the difficulty left at 0.
+ */
+Result<ExportStats> ExportHistory(const ShareArchive* archive, PoolDatabase* database,
+                                  const ExportOptions& options, const ExportSink& sink);
+
+/// Callbacks for ReadExport; unset callbacks skip their table
+struct ExportVisitor {
+    std::function<Result<void>(const ShareColumns&)> shares;
+    std::function<Result<void>(const RoundSummary&)> rounds;
+    std::function<Result<void>(const PoolDatabase::LedgerEntry&)> payments;
+};
+
+/// Parse a columnar export, checking every chunk's CRC
+Result<ExportStats> ReadExport(std::istream& in, const ExportVisitor& visitor);
+
+/// Closed round as stored in the pool database, rebuilt from an exported summary
+RoundStatistics RoundFromSummary(const RoundSummary& summary);
+
+} // namespace pool
+} // namespace intcoin
+
+#endif // INTCOIN_POOL_STORAGE_H
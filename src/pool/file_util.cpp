@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2025 INTcoin Team (Neil Adamson)
+ * MIT License
+ * Mining Pool File Helpers (internal)
+ */
+
+#include "file_util.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace intcoin {
+namespace pool {
+
+Result<void> WriteAll(int fd, const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (len > 0) {
+        ssize_t n = ::write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return Result<void>::Error(std::string("write failed: ") + std::strerror(errno));
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return Result<void>::Ok();
+}
+
+void SyncDirectory(const std::string& dir) {
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+} // namespace pool
+} // namespace intcoin
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2025 INTcoin Team (Neil Adamson)
+ * MIT License
+ * Mining Pool File Helpers (internal)
+ */
+
+#ifndef INTCOIN_POOL_FILE_UTIL_H
+#define INTCOIN_POOL_FILE_UTIL_H
+
+#include "intcoin/types.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace intcoin {
+namespace pool {
+
+// ============================================================================
+// Little-Endian Encoding
+// ============================================================================
+
+inline void PutLE32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = static_cast<uint8_t>(v >> (i * 8));
+}
+
+inline void PutLE64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = static_cast<uint8_t>(v >> (i * 8));
+}
+
+inline void PutLE32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<char>(v >> (i * 8)));
+}
+
+inline void PutLE64(std::string& out, uint64_t v) {
+    for (int i = 0; i < 8; i++) out.push_back(static_cast<char>(v >> (i * 8)));
+}
+
+inline uint32_t GetLE32(const uint8_t* p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+inline uint64_t GetLE64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+// ============================================================================
+// Timestamps
+// ============================================================================
+
+inline int64_t ToMillis(std::chrono::system_clock::time_point tp) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(tp.time_since_epoch()).count();
+}
+
+inline std::chrono::system_clock::time_point FromMillis(int64_t ms) {
+    return std::chrono::system_clock::time_point(std::chrono::milliseconds(ms));
+}
+
+// ============================================================================
+// Durable Writes
+// ============================================================================
+
+/// Write all of data to fd, retrying short writes and EINTR
+Result<void> WriteAll(int fd, const void* data, size_t len);
+
+/// fsync a directory so a create or rename in it survives a crash
+void SyncDirectory(const std::string& dir);
+
+} // namespace pool
+} // namespace intcoin
+
+#endif // INTCOIN_POOL_FILE_UTIL_H
@@ -5,6 +5,8 @@
  */
 
 #include "intcoin/pool.h"
+#include "intcoin/pool_storage.h"
+#include "intcoin/pool_metrics.h"
 #include "intcoin/rpc.h"
 #include <sstream>
 #include <iomanip>
@@ -26,6 +28,10 @@
 #include <fcntl.h>
 #endif
 
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
 namespace intcoin {
 namespace pool {
 
@@ -170,13 +176,14 @@ private:
             }
 
             // Handle request in separate thread (simple approach for now)
-            std::thread([this, client_socket]() {
-                HandleClient(client_socket);
+            bool loopback = (ntohl(client_addr.sin_addr.s_addr) >> 24) == 127;
+            std::thread([this, client_socket, loopback]() {
+                HandleClient(client_socket, loopback);
             }).detach();
         }
     }
 
-    void HandleClient(int client_socket) {
+    void HandleClient(int client_socket, bool loopback) {
         // Read request
         char buffer[4096];
         ssize_t bytes_read = recv(client_socket, buffer, sizeof(buffer) - 1, 0);
@@ -191,6 +198,18 @@ private:
         // Parse HTTP request
         HttpRequest request = ParseRequest(std::string(buffer));
 
+        // Exports stream their body instead of building it in memory
+        if (request.method == "GET" && request.path == "/api/pool/export") {
+            StreamExport(client_socket, request, loopback);
+            close(client_socket);
+            return;
+        }
+        if (request.method == "GET" && request.path == "/metrics") {
+            ServeMetrics(client_socket);
+            close(client_socket);
+            return;
+        }
+
         // Generate response
         HttpResponse response = HandleRequest(request);
 
@@ -344,6 +363,22 @@ private:
         return default_value;
     }
 
+    /// hashrate_<window> and shares_<window> for the 1m, 5m, 1h and 24h windows
+    static void AddWindows(std::map<std::string, rpc::JSONValue>& object,
+                           const std::function<WindowTotals(StatsWindow)>& totals_for) {
+        static const std::pair<const char*, StatsWindow> kWindows[] = {
+            {"1m", StatsWindow::MINUTE},
+            {"5m", StatsWindow::FIVE_MINUTES},
+            {"1h", StatsWindow::HOUR},
+            {"24h", StatsWindow::DAY},
+        };
+        for (const auto& [suffix, window] : kWindows) {
+            WindowTotals totals = totals_for(window);
+            object[std::string("hashrate_") + suffix] = rpc::JSONValue(static_cast<int64_t>(totals.hashrate));
+            object[std::string("shares_") + suffix] = rpc::JSONValue(static_cast<int64_t>(totals.shares));
+        }
+    }
+
     // ========================================================================
     // API Endpoints (matching pool dashboard requirements)
     // ========================================================================
@@ -358,10 +393,15 @@ private:
         std::map<std::string, rpc::JSONValue> response;
         response["hashrate"] = rpc::JSONValue(static_cast<int64_t>(stats.pool_hashrate));
         response["difficulty"] = rpc::JSONValue(static_cast<int64_t>(stats.network_difficulty));
+        response["network_hashrate"] = rpc::JSONValue(static_cast<int64_t>(stats.network_hashrate));
+        response["height"] = rpc::JSONValue(static_cast<int64_t>(stats.network_height));
         response["miners"] = rpc::JSONValue(static_cast<int64_t>(stats.active_miners));
         response["blocks_found"] = rpc::JSONValue(static_cast<int64_t>(stats.blocks_found));
         response["total_shares"] = rpc::JSONValue(static_cast<int64_t>(stats.total_shares));
         response["valid_shares_24h"] = rpc::JSONValue(static_cast<int64_t>(stats.shares_last_day));
+        response["luck"] = rpc::JSONValue(stats.luck);
+        response["round_effort"] = rpc::JSONValue(stats.round_effort);
+        AddWindows(response, [this](StatsWindow window) { return pool_.GetPoolTotals(window); });
 
         return rpc::JSONValue(response);
     }
@@ -371,66 +411,40 @@ private:
      * Returns recent blocks found by pool
      */
     rpc::JSONValue GetRecentBlocks(int limit) {
-        auto rounds = pool_.GetRoundHistory(limit);
+        // Status comes from the block tracker, which compares each immature
+        // block with the chain on every new tip
+        auto found = pool_.GetFoundBlocks(limit > 0 ? static_cast<size_t>(limit) : 0);
+
+        // Effort of each block's round, while it is in the luck window
+        std::map<uint64_t, double> round_effort;
+        for (const auto& round : pool_.GetRoundLuck(pool_.GetConfig().luck_window)) {
+            round_effort[round.round_id] = round.effort;
+        }
 
         std::vector<rpc::JSONValue> blocks;
 
-        for (const auto& round : rounds) {
-            if (!round.is_complete) continue;
-
+        for (const auto& found_block : found) {
             std::map<std::string, rpc::JSONValue> block;
-            block["height"] = rpc::JSONValue(static_cast<int64_t>(round.block_height));
-            block["hash"] = rpc::JSONValue(ToHex(round.block_hash));
+            block["height"] = rpc::JSONValue(static_cast<int64_t>(found_block.height));
+            block["hash"] = rpc::JSONValue(ToHex(found_block.hash));
             block["timestamp"] = rpc::JSONValue(static_cast<int64_t>(
                 std::chrono::duration_cast<std::chrono::milliseconds>(
-                    round.ended_at.time_since_epoch()).count()));
+                    found_block.found_at.time_since_epoch()).count()));
 
-            // Find block finder (miner with most shares in this round)
+            // Get finder's payout address
             std::string finder_address = "pool";
-            if (!round.miner_shares.empty()) {
-                uint64_t max_shares = 0;
-                uint64_t finder_miner_id = 0;
-
-                for (const auto& [miner_id, share_count] : round.miner_shares) {
-                    if (share_count > max_shares) {
-                        max_shares = share_count;
-                        finder_miner_id = miner_id;
-                    }
-                }
-
-                // Get finder's payout address
-                if (finder_miner_id > 0) {
-                    auto miner_opt = pool_.GetMiner(finder_miner_id);
-                    if (miner_opt.has_value()) {
-                        finder_address = miner_opt->payout_address;
-                    }
-                }
+            auto miner_opt = pool_.GetMiner(found_block.finder_id);
+            if (miner_opt.has_value()) {
+                finder_address = miner_opt->payout_address;
             }
             block["finder"] = rpc::JSONValue(finder_address);
-            block["reward"] = rpc::JSONValue(static_cast<int64_t>(round.block_reward));
-
-            // Check block status from blockchain
-            // Get current network height from pool statistics
-            std::string status = "pending";
-            auto pool_stats = pool_.GetStatistics();
-            uint64_t current_height = pool_stats.network_height;
-
-            if (round.block_height <= current_height) {
-                uint64_t confirmations = current_height - round.block_height + 1;
-
-                if (confirmations >= 100) {
-                    status = "confirmed";
-                } else if (confirmations >= 1) {
-                    status = "confirming";
-                } else {
-                    status = "pending";
-                }
-
-                // Note: To properly detect orphaned blocks, would need direct blockchain access
-                // For now, assume blocks with sufficient confirmations are valid
-                // In full implementation, would check if block hash at this height matches
+            block["reward"] = rpc::JSONValue(static_cast<int64_t>(found_block.reward));
+            block["status"] = rpc::JSONValue(ToString(found_block.status));
+            block["confirmations"] = rpc::JSONValue(static_cast<int64_t>(found_block.confirmations));
+            auto effort = round_effort.find(found_block.round_id);
+            if (effort != round_effort.end()) {
+                block["effort"] = rpc::JSONValue(effort->second);
             }
-            block["status"] = rpc::JSONValue(status);
 
             blocks.push_back(rpc::JSONValue(block));
         }
@@ -513,6 +527,9 @@ private:
                 stats["shares"] = rpc::JSONValue(static_cast<int64_t>(miner.total_shares_accepted));
                 stats["balance"] = rpc::JSONValue(static_cast<int64_t>(miner.unpaid_balance));
                 stats["total_paid"] = rpc::JSONValue(static_cast<int64_t>(miner.paid_balance));
+                AddWindows(stats, [this, &miner](StatsWindow window) {
+                    return pool_.GetMinerTotals(miner.miner_id, window);
+                });
 
                 return rpc::JSONValue(stats);
             }
@@ -524,6 +541,161 @@ private:
         return rpc::JSONValue(error);
     }
 
+    /**
+     * GET /api/pool/export?from=<unix>&to=<unix>&tables=shares,rounds,payments&format=columnar|csv
+     * Streams archived history (default: the last 24 hours, all tables)
+     * with chunked transfer encoding; see pool::ExportHistory for the layout.
+     * Exports carry every miner's payout history, so they are served to
+     * loopback clients only and never shared cross-origin.
+     */
+    void StreamExport(int client_socket, const HttpRequest& request, bool loopback) {
+        // Longest range one request may ask for
+        constexpr auto kMaxExportSpan = std::chrono::hours(24 * 31);
+
+        if (!loopback) {
+            SendExportError(client_socket, 403, "Forbidden", "Export is only available from localhost");
+            return;
+        }
+
+        auto now = std::chrono::system_clock::now();
+        ExportOptions options;
+        std::string error;
+        try {
+            std::string to = GetQueryParam(request.query_string, "to", "");
+            std::string from = GetQueryParam(request.query_string, "from", "");
+            options.to = to.empty() ? now : std::chrono::system_clock::time_point(std::chrono::seconds(std::stoll(to)));
+            options.from = from.empty() ? options.to - std::chrono::hours(24)
+                                        : std::chrono::system_clock::time_point(std::chrono::seconds(std::stoll(from)));
+        } catch (...) {
+            error = "from/to must be unix timestamps";
+        }
+
+        std::string tables = GetQueryParam(request.query_string, "tables", "shares,rounds,payments");
+        options.tables = 0;
+        std::istringstream table_stream(tables);
+        std::string table;
+        while (std::getline(table_stream, table, ',')) {
+            if (table == "shares") options.tables |= EXPORT_SHARES;
+            else if (table == "rounds") options.tables |= EXPORT_ROUNDS;
+            else if (table == "payments") options.tables |= EXPORT_PAYMENTS;
+            else error = "Unknown table: " + table;
+        }
+
+        std::string format = GetQueryParam(request.query_string, "format", "columnar");
+        if (format == "csv") {
+            options.format = ExportFormat::CSV;
+            if (options.tables == 0 || (options.tables & (options.tables - 1)) != 0) {
+                error = "CSV export needs exactly one table";
+            }
+        } else if (format != "columnar") {
+            error = "format must be columnar or csv";
+        }
+        if (error.empty() && options.to <= options.from) {
+            error = "Export range is empty";
+        }
+        if (error.empty() && options.to - options.from > kMaxExportSpan) {
+            error = "Export range is limited to 31 days";
+        }
+
+        if (!error.empty()) {
+            SendExportError(client_socket, 400, "Bad Request", error);
+            return;
+        }
+
+        bool csv = options.format == ExportFormat::CSV;
+        std::string head = "HTTP/1.1 200 OK\r\n";
+        head += csv ? "Content-Type: text/csv\r\n" : "Content-Type: application/octet-stream\r\n";
+        head += std::string("Content-Disposition: attachment; filename=\"pool-export.") + (csv ? "csv" : "bin") + "\"\r\n";
+        head += "Transfer-Encoding: chunked\r\n\r\n";
+        if (!SendAll(client_socket, head.data(), head.size())) return;
+
+        // Small pieces are coalesced; large column runs go out as their own
+        // HTTP chunk, straight from the archive mapping
+        constexpr size_t kCoalesce = 64 * 1024;
+        std::string pending;
+        auto send_chunk = [&](const uint8_t* data, size_t len) {
+            char size_line[32];
+            int n = std::snprintf(size_line, sizeof(size_line), "%zx\r\n", len);
+            return SendAll(client_socket, size_line, static_cast<size_t>(n)) &&
+                   SendAll(client_socket, reinterpret_cast<const char*>(data), len) &&
+                   SendAll(client_socket, "\r\n", 2);
+        };
+        auto flush = [&]() {
+            bool ok = pending.empty() || send_chunk(reinterpret_cast<const uint8_t*>(pending.data()), pending.size());
+            pending.clear();
+            return ok;
+        };
+
+        auto result = pool_.ExportHistory(options, [&](const uint8_t* data, size_t len) {
+            if (len >= kCoalesce) {
+                if (!flush() || !send_chunk(data, len)) return Result<void>::Error("Client disconnected");
+                return Result<void>::Ok();
+            }
+            pending.append(reinterpret_cast<const char*>(data), len);
+            if (pending.size() >= kCoalesce && !flush()) return Result<void>::Error("Client disconnected");
+            return Result<void>::Ok();
+        });
+
+        // On failure the terminating chunk is withheld, so the client sees
+        // a truncated transfer rather than a short but valid export
+        if (!result.IsOk()) {
+            LogF(LogLevel::WARNING, "HTTP export aborted: %s", result.error.c_str());
+            return;
+        }
+        if (flush()) {
+            SendAll(client_socket, "0\r\n\r\n", 5);
+        }
+    }
+
+    void SendExportError(int client_socket, int status_code, const std::string& status_text,
+                         const std::string& error) {
+        HttpResponse response;
+        response.status_code = status_code;
+        response.status_text = status_text;
+        response.headers["Content-Type"] = "application/json";
+        std::map<std::string, rpc::JSONValue> body;
+        body["error"] = rpc::JSONValue(error);
+        response.body = rpc::JSONValue(body).ToJSONString();
+        std::string raw = response.ToString();
+        SendAll(client_socket, raw.data(), raw.size());
+    }
+
+    /**
+     * GET /metrics
+     * Prometheus text format. Gauges read from caches are brought up to
+     * date first; nothing here takes the pool lock.
+     */
+    void ServeMetrics(int client_socket) {
+        auto& metrics = pool_.GetMetrics();
+        ChainState chain = pool_.GetChainState();
+        metrics.network_height.Set(static_cast<double>(chain.height));
+        metrics.network_difficulty.Set(static_cast<double>(chain.difficulty));
+        metrics.network_hashrate.Set(chain.network_hashrate);
+        metrics.pool_hashrate.Set(pool_.GetPoolTotals(StatsWindow::TEN_MINUTES).hashrate);
+
+        std::string body;
+        metrics.registry.Render(body);
+
+        char head[160];
+        int n = std::snprintf(head, sizeof(head),
+                              "HTTP/1.1 200 OK\r\n"
+                              "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                              "Content-Length: %zu\r\n\r\n", body.size());
+        if (SendAll(client_socket, head, static_cast<size_t>(n))) {
+            SendAll(client_socket, body.data(), body.size());
+        }
+    }
+
+    bool SendAll(int client_socket, const char* data, size_t len) {
+        while (len > 0) {
+            ssize_t sent = send(client_socket, data, len, MSG_NOSIGNAL);
+            if (sent <= 0) return false;
+            data += sent;
+            len -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
 private:
     uint16_t port_;
     MiningPoolServer& pool_;
@@ -0,0 +1,498 @@
+// Copyright (c) 2025 INTcoin Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "intcoin/intcoin.h"
+#include "intcoin/pool_storage.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <cstdio>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+using namespace intcoin;
+
+void print_usage() {
+    std::cout << "Usage: intcoin-pool-db <command> [options]\n\n";
+    std::cout << "Commands:\n";
+    std::cout << "  export                         Stream shares, rounds and payments\n";
+    std::cout << "  import                         Bulk-load an export or the legacy shares table\n";
+    std::cout << "  migrate                        Upgrade records and schema to this version\n";
+    std::cout << "  verify                         Check checksums, records, ledger and indexes\n";
+    std::cout << "  reindex                        Rebuild address index and ledger balances\n";
+    std::cout << "\n";
+    std::cout << "Storage:\n";
+    std::cout << "  --data-dir=<dir>               Pool data directory (default: ./pooldata)\n";
+    std::cout << "  --cold-dir=<dir>               Cold share directory (default: <data-dir>/cold)\n";
+    std::cout << "\n";
+    std::cout << "Export:\n";
+    std::cout << "  --from=<unix time>             Range start (default: 24 hours before --to)\n";
+    std::cout << "  --to=<unix time>               Range end, exclusive (default: now)\n";
+    std::cout << "  --tables=<list>                shares,rounds,payments (default: all)\n";
+    std::cout << "  --format=<fmt>                 columnar or csv (default: columnar)\n";
+    std::cout << "  --output=<file>                Output file (default: stdout)\n";
+    std::cout << "\n";
+    std::cout << "Import:\n";
+    std::cout << "  --input=<file>                 Columnar export to load (- for stdin)\n";
+    std::cout << "  --legacy-shares                Move the database's shares table into the archive\n";
+    std::cout << "\n";
+    std::cout << "Migrate / Verify:\n";
+    std::cout << "  --threads=<n>                  Parallel key-range workers (default: all cores)\n";
+    std::cout << "  --rewrite-all                  Re-encode every record, not just outdated ones\n";
+    std::cout << "\n";
+    std::cout << "export and verify open storage read-only and can run beside a live pool;\n";
+    std::cout << "import, migrate and reindex need the pool to be stopped.\n";
+    std::cout << "\n";
+    std::cout << "Examples:\n";
+    std::cout << "  # Last 30 days of shares as CSV\n";
+    std::cout << "  intcoin-pool-db export --data-dir=/var/lib/intcoin-pool --tables=shares --format=csv \\\n";
+    std::cout << "    --from=$(date -d '30 days ago' +%s) --output=shares.csv\n";
+    std::cout << "\n";
+    std::cout << "  # Restore a history export into a fresh data directory\n";
+    std::cout << "  intcoin-pool-db import --data-dir=/var/lib/intcoin-pool-new --input=history.bin\n";
+    std::cout << "\n";
+    std::cout << "  # Upgrade after installing a new release, then check the result\n";
+    std::cout << "  intcoin-pool-db migrate --data-dir=/var/lib/intcoin-pool\n";
+    std::cout << "  intcoin-pool-db verify --data-dir=/var/lib/intcoin-pool\n";
+    std::cout << "\n";
+}
+
+struct ToolConfig {
+    std::string command;
+    std::string data_dir = "./pooldata";
+    std::string cold_dir;
+
+    // Export
+    std::optional<int64_t> from;
+    std::optional<int64_t> to;
+    std::string tables = "shares,rounds,payments";
+    std::string format = "columnar";
+    std::string output = "-";
+
+    // Import
+    std::string input;
+    bool legacy_shares = false;
+
+    // Migrate / verify
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    bool rewrite_all = false;
+};
+
+/// Storage opened from a pool data directory
+struct PoolStorage {
+    std::unique_ptr<pool::ShareArchive> archive;
+    std::unique_ptr<pool::PoolDatabase> database;
+};
+
+enum StorageParts {
+    OPEN_ARCHIVE  = 1 << 0,
+    OPEN_DATABASE = 1 << 1,
+};
+
+bool open_storage(const ToolConfig& config, int parts, bool read_only, PoolStorage& storage,
+                  bool allow_old_schema = false) {
+    std::filesystem::path data_dir(config.data_dir);
+
+    if (parts & OPEN_ARCHIVE) {
+        pool::ShareArchiveOptions archive_options;
+        archive_options.dir = (data_dir / "archive").string();
+        archive_options.cold_dir = config.cold_dir.empty() ? (data_dir / "cold").string() : config.cold_dir;
+        archive_options.hot_shares = 0;
+        archive_options.read_only = read_only;
+
+        storage.archive = std::make_unique<pool::ShareArchive>(archive_options);
+        auto archive_result = storage.archive->Open();
+        if (!archive_result.IsOk()) {
+            std::cerr << "Error opening share archive: " << archive_result.error << "\n";
+            return false;
+        }
+    }
+
+    if (parts & OPEN_DATABASE) {
+        pool::PoolDatabaseOptions db_options;
+        db_options.read_only = read_only;
+        db_options.allow_old_schema = allow_old_schema;
+        storage.database = std::make_unique<pool::PoolDatabase>((data_dir / "db").string(), db_options);
+        auto db_result = storage.database->Open();
+        if (!db_result.IsOk()) {
+            std::cerr << "Error opening pool database: " << db_result.error << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int run_export(const ToolConfig& config) {
+    pool::ExportOptions options;
+    auto now = std::chrono::system_clock::now();
+    options.to = config.to ? std::chrono::system_clock::time_point(std::chrono::seconds(*config.to)) : now;
+    options.from = config.from ? std::chrono::system_clock::time_point(std::chrono::seconds(*config.from))
+                               : options.to - std::chrono::hours(24);
+
+    options.tables = 0;
+    std::istringstream table_stream(config.tables);
+    std::string table;
+    while (std::getline(table_stream, table, ',')) {
+        if (table == "shares") options.tables |= pool::EXPORT_SHARES;
+        else if (table == "rounds") options.tables |= pool::EXPORT_ROUNDS;
+        else if (table == "payments") options.tables |= pool::EXPORT_PAYMENTS;
+        else {
+            std::cerr << "Error: Unknown table: " << table << "\n";
+            return 1;
+        }
+    }
+
+    if (config.format == "csv") {
+        options.format = pool::ExportFormat::CSV;
+    } else if (config.format != "columnar") {
+        std::cerr << "Error: --format must be columnar or csv\n";
+        return 1;
+    }
+
+    PoolStorage storage;
+    int parts = OPEN_ARCHIVE | ((options.tables & pool::EXPORT_PAYMENTS) ? OPEN_DATABASE : 0);
+    if (!open_storage(config, parts, true, storage)) {
+        return 1;
+    }
+
+    FILE* out = stdout;
+    if (config.output != "-") {
+        out = std::fopen(config.output.c_str(), "wb");
+        if (!out) {
+            std::cerr << "Error: Could not open " << config.output << " for writing\n";
+            return 1;
+        }
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    auto result = pool::ExportHistory(storage.archive.get(), storage.database.get(), options,
+                                      [out](const uint8_t* data, size_t len) {
+        if (std::fwrite(data, 1, len, out) != len) {
+            return Result<void>::Error("write failed");
+        }
+        return Result<void>::Ok();
+    });
+    bool write_ok = std::fflush(out) == 0;
+    if (out != stdout) {
+        write_ok = std::fclose(out) == 0 && write_ok;
+    }
+
+    if (!result.IsOk() || !write_ok) {
+        std::cerr << "Error: " << (result.IsOk() ? std::string("write failed") : result.error) << "\n";
+        return 1;
+    }
+
+    const auto& stats = result.GetValue();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    std::cerr << "Exported " << stats.shares << " shares, " << stats.round_rows << " round rows, "
+              << stats.payments << " payments (" << stats.bytes << " bytes) in " << seconds << "s\n";
+    return 0;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void print_throughput(const char* what, uint64_t records, uint64_t bytes, double seconds) {
+    double rate = seconds > 0 ? records / seconds : 0;
+    std::cerr << what << " " << records << " records (" << bytes / (1024 * 1024) << " MiB) in "
+              << seconds << "s, " << static_cast<uint64_t>(rate) << " records/s";
+    if (rate > 0) {
+        std::cerr << " (1B records: ~" << static_cast<uint64_t>(1e9 / rate / 60) << " min)";
+    }
+    std::cerr << "\n";
+}
+
+/// Appends imported shares to the archive with fresh sequence numbers
+class ShareImporter {
+public:
+    explicit ShareImporter(pool::ShareArchive& archive)
+        : archive_(archive), next_seq_(archive.GetLastSeq() + 1) {
+        batch_.reserve(kBatch);
+    }
+
+    Result<void> Add(int64_t timestamp_ms, uint64_t round_id, uint64_t miner_id,
+                     uint64_t worker_id, uint64_t difficulty, uint32_t flags) {
+        pool::JournalRecord rec{};
+        rec.seq = next_seq_++;
+        rec.share_id = rec.seq;
+        rec.flags = flags & (pool::JOURNAL_SHARE_VALID | pool::JOURNAL_SHARE_BLOCK);
+        rec.round_id = round_id;
+        rec.miner_id = miner_id;
+        rec.worker_id = worker_id;
+        rec.difficulty = difficulty;
+        rec.timestamp_ms = timestamp_ms;
+        batch_.push_back(rec);
+        return batch_.size() >= kBatch ? Flush() : Result<void>::Ok();
+    }
+
+    Result<void> Flush() {
+        auto result = archive_.Append(batch_);
+        imported_ += batch_.size();
+        batch_.clear();
+        return result;
+    }
+
+    uint64_t imported() const { return imported_; }
+
+private:
+    static constexpr size_t kBatch = 65536;
+
+    pool::ShareArchive& archive_;
+    uint64_t next_seq_;
+    uint64_t imported_ = 0;
+    std::vector<pool::JournalRecord> batch_;
+};
+
+int run_import(const ToolConfig& config) {
+    if (config.input.empty() == !config.legacy_shares) {
+        std::cerr << "Error: import needs exactly one of --input or --legacy-shares\n";
+        return 1;
+    }
+
+    PoolStorage storage;
+    if (!open_storage(config, OPEN_ARCHIVE | OPEN_DATABASE, false, storage, config.legacy_shares)) {
+        return 1;
+    }
+
+    // Imported shares get sequence numbers past anything archived, so the
+    // archive must not already hold newer history
+    if (storage.archive->GetShareCount() > 0) {
+        std::cerr << "Error: the share archive is not empty; import into a fresh data directory\n";
+        return 1;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    ShareImporter shares(*storage.archive);
+    std::vector<RoundStatistics> rounds;
+    std::vector<pool::PoolDatabase::Payment> payments;
+
+    Result<void> result = Result<void>::Ok();
+    if (config.legacy_shares) {
+        result = storage.database->ForEachShare([&](const Share& share, uint64_t round_id) {
+            uint32_t flags = 0;
+            if (share.valid) flags |= pool::JOURNAL_SHARE_VALID;
+            if (share.is_block) flags |= pool::JOURNAL_SHARE_BLOCK;
+            int64_t ts = std::chrono::duration_cast<std::chrono::milliseconds>(
+                share.timestamp.time_since_epoch()).count();
+            return shares.Add(ts, round_id, share.miner_id, share.worker_id, share.difficulty, flags);
+        });
+    } else {
+        std::ifstream file;
+        if (config.input != "-") {
+            file.open(config.input, std::ios::binary);
+            if (!file) {
+                std::cerr << "Error: Could not open " << config.input << "\n";
+                return 1;
+            }
+        }
+        std::istream& in = config.input == "-" ? std::cin : file;
+
+        pool::ExportVisitor visitor;
+        visitor.shares = [&](const pool::ShareColumns& chunk) {
+            for (size_t i = 0; i < chunk.rows; i++) {
+                auto added = shares.Add(chunk.timestamp_ms[i], chunk.round_id[i], chunk.miner_id[i],
+                                        chunk.worker_id[i], chunk.difficulty[i], chunk.flags[i]);
+                if (!added.IsOk()) return added;
+            }
+            return Result<void>::Ok();
+        };
+        visitor.rounds = [&](const pool::RoundSummary& summary) {
+            rounds.push_back(pool::RoundFromSummary(summary));
+            return Result<void>::Ok();
+        };
+        visitor.payments = [&](const pool::PoolDatabase::LedgerEntry& entry) {
+            pool::PoolDatabase::Payment payment;
+            payment.payment_id = entry.reference;
+            payment.address = entry.memo;
+            payment.amount = entry.amount;
+            payment.timestamp = entry.timestamp;
+            payments.push_back(std::move(payment));
+            return Result<void>::Ok();
+        };
+
+        auto read = pool::ReadExport(in, visitor);
+        if (!read.IsOk()) result = Result<void>::Error(read.error);
+    }
+
+    if (result.IsOk()) result = shares.Flush();
+    if (result.IsOk()) result = storage.archive->Sync();
+    if (!result.IsOk()) {
+        std::cerr << "Error: " << result.error << "\n";
+        return 1;
+    }
+
+    auto imported = storage.database->ImportRecords(rounds, payments);
+    if (!imported.IsOk()) {
+        std::cerr << "Error: " << imported.error << "\n";
+        return 1;
+    }
+
+    std::cerr << "Imported " << shares.imported() << " shares, " << rounds.size() << " rounds, "
+              << payments.size() << " payments in " << seconds_since(started) << "s\n";
+    return 0;
+}
+
+int run_migrate(const ToolConfig& config) {
+    PoolStorage storage;
+    if (!open_storage(config, OPEN_DATABASE, false, storage, true)) {
+        return 1;
+    }
+
+    uint32_t from_version = storage.database->GetSchemaVersion();
+    auto started = std::chrono::steady_clock::now();
+    auto result = storage.database->MigrateRecords(config.threads, config.rewrite_all);
+    if (!result.IsOk()) {
+        std::cerr << "Error: " << result.error << "\n";
+        return 1;
+    }
+
+    const auto& stats = result.GetValue();
+    std::cerr << "Schema v" << from_version << " -> v" << storage.database->GetSchemaVersion()
+              << ", " << stats.outdated << " outdated records, " << stats.written << " rewritten ("
+              << config.threads << " threads)\n";
+    print_throughput("Migrated", stats.records, stats.bytes, seconds_since(started));
+    return 0;
+}
+
+int run_verify(const ToolConfig& config) {
+    PoolStorage storage;
+    if (!open_storage(config, OPEN_ARCHIVE | OPEN_DATABASE, true, storage)) {
+        return 1;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    auto result = storage.database->VerifyRecords(config.threads);
+    if (!result.IsOk()) {
+        std::cerr << "Database: FAILED: " << result.error << "\n";
+        return 1;
+    }
+    const auto& stats = result.GetValue();
+    std::cerr << "Database: OK, schema v" << storage.database->GetSchemaVersion() << ", "
+              << stats.outdated << " records need migrate\n";
+    print_throughput("Verified", stats.records, stats.bytes, seconds_since(started));
+
+    // Reading every row decompresses cold segments and checks their CRCs;
+    // a segment that fails is skipped, so the row count comes up short
+    uint64_t rows = 0;
+    auto scanned = storage.archive->ForEachShareChunk(
+        std::chrono::system_clock::time_point(), std::chrono::system_clock::time_point::max(), 65536,
+        [&](const pool::ShareColumns& chunk) {
+            rows += chunk.rows;
+            return Result<void>::Ok();
+        });
+    uint64_t rounds = 0;
+    if (scanned.IsOk()) {
+        scanned = storage.archive->ForEachRoundSummary([&](const pool::RoundSummary&) {
+            rounds++;
+            return Result<void>::Ok();
+        });
+    }
+    if (!scanned.IsOk() || rows != storage.archive->GetShareCount()) {
+        std::cerr << "Share archive: FAILED: "
+                  << (scanned.IsOk() ? "read " + std::to_string(rows) + " of " +
+                                       std::to_string(storage.archive->GetShareCount()) + " shares"
+                                     : scanned.error) << "\n";
+        return 1;
+    }
+    std::cerr << "Share archive: OK, " << rows << " shares, " << rounds << " round summaries\n";
+    return 0;
+}
+
+int run_reindex(const ToolConfig& config) {
+    PoolStorage storage;
+    if (!open_storage(config, OPEN_DATABASE, false, storage)) {
+        return 1;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    auto result = storage.database->RebuildIndexes();
+    if (!result.IsOk()) {
+        std::cerr << "Error: " << result.error << "\n";
+        return 1;
+    }
+    std::cerr << "Rebuilt " << result.GetValue().written << " index entries from "
+              << result.GetValue().records << " records in " << seconds_since(started) << "s\n";
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    ToolConfig config;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        try {
+            if (arg == "-h" || arg == "--help") {
+                print_usage();
+                return 0;
+            }
+            else if (arg.find("--data-dir=") == 0) {
+                config.data_dir = arg.substr(11);
+            }
+            else if (arg.find("--cold-dir=") == 0) {
+                config.cold_dir = arg.substr(11);
+            }
+            else if (arg.find("--from=") == 0) {
+                config.from = std::stoll(arg.substr(7));
+            }
+            else if (arg.find("--to=") == 0) {
+                config.to = std::stoll(arg.substr(5));
+            }
+            else if (arg.find("--tables=") == 0) {
+                config.tables = arg.substr(9);
+            }
+            else if (arg.find("--format=") == 0) {
+                config.format = arg.substr(9);
+            }
+            else if (arg.find("--output=") == 0) {
+                config.output = arg.substr(9);
+            }
+            else if (arg.find("--input=") == 0) {
+                config.input = arg.substr(8);
+            }
+            else if (arg == "--legacy-shares") {
+                config.legacy_shares = true;
+            }
+            else if (arg.find("--threads=") == 0) {
+                config.threads = std::max(1, std::stoi(arg.substr(10)));
+            }
+            else if (arg == "--rewrite-all") {
+                config.rewrite_all = true;
+            }
+            else if (arg[0] != '-' && config.command.empty()) {
+                config.command = arg;
+            }
+            else {
+                std::cerr << "Unknown option: " << arg << "\n";
+                std::cerr << "Use -h or --help for usage information.\n";
+                return 1;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Error: Invalid value in " << arg << "\n";
+            return 1;
+        }
+    }
+
+    if (config.command == "export") {
+        return run_export(config);
+    }
+    if (config.command == "import") {
+        return run_import(config);
+    }
+    if (config.command == "migrate") {
+        return run_migrate(config);
+    }
+    if (config.command == "verify") {
+        return run_verify(config);
+    }
+    if (config.command == "reindex") {
+        return run_reindex(config);
+    }
+
+    std::cerr << (config.command.empty() ? "Error: No command given\n" : "Error: Unknown command: " + config.command + "\n");
+    std::cerr << "Use -h or --help for usage information.\n";
+    return 1;
+}
@@ -4,6 +4,8 @@
 
 #include "intcoin/intcoin.h"
 #include "intcoin/network.h"
+#include "intcoin/pool.h"
+#include <atomic>
 #include <iostream>
 #include <csignal>
 #include <thread>
@@ -12,15 +14,13 @@
 
 using namespace intcoin;
 
-// Global pool server
-static MiningPoolServer* g_pool_server = nullptr;
+// Set by the signal handler; main() stops the server (Stop() joins threads
+// and takes locks, so it must not run inside the handler)
+static std::atomic<int> g_stop_signal{0};
 
 // Signal handler
 void signal_handler(int signum) {
-    std::cout << "\nReceived signal " << signum << ", stopping pool server...\n";
-    if (g_pool_server) {
-        g_pool_server->Stop();
-    }
+    g_stop_signal = signum;
 }
 
 void print_banner() {
@@ -56,19 +56,22 @@ void print_usage() {
     std::cout << "  --pool-address=<addr>          Pool's payout address (required)\n";
     std::cout << "  --payout-threshold=<amount>    Minimum payout in ints (default: 1000000000)\n";
     std::cout << "  --pool-fee=<percent>           Pool fee percentage (default: 1.0)\n";
-    std::cout << "  --payout-method=<method>       PPLNS, PPS, or PROP (default: PPLNS)\n";
+    std::cout << "  --payout-method=<method>       PPLNS, PPLNS-DECAYED, PPS, FPPS, PPS-PLUS,\n";
+    std::cout << "                                 PROP or SOLO (default: PPLNS)\n";
     std::cout << "  --vardiff-min=<diff>           Minimum difficulty (default: 1000)\n";
     std::cout << "  --vardiff-max=<diff>           Maximum difficulty (default: 100000)\n";
     std::cout << "  --vardiff-target=<sec>         Target time per share (default: 15)\n";
     std::cout << "\n";
     std::cout << "Database:\n";
-    std::cout << "  --db-path=<path>               Database directory (default: ./pooldb)\n";
+    std::cout << "  --data-dir=<path>              Database, journal and snapshots (default: ./pooldb)\n";
+    std::cout << "  --db-cache-size=<mb>           Database block cache in MB (default: 512)\n";
     std::cout << "\n";
     std::cout << "Daemon Connection:\n";
     std::cout << "  --daemon-host=<host>           intcoind RPC host (default: 127.0.0.1)\n";
     std::cout << "  --daemon-port=<port>           intcoind RPC port (default: " << network::MAINNET_RPC_PORT << ")\n";
     std::cout << "  --rpc-user=<user>              RPC username\n";
     std::cout << "  --rpc-password=<pass>          RPC password\n";
+    std::cout << "  --chain-dir=<path>             intcoind data directory (default: ./data)\n";
     std::cout << "\n";
     std::cout << "Examples:\n";
     std::cout << "  # Basic pool server (no SSL)\n";
@@ -108,13 +111,15 @@ struct ServerConfig {
     uint32_t vardiff_target = 15;  // seconds
 
     // Database
-    std::string db_path = "./pooldb";
+    std::string data_dir = "./pooldb";
+    size_t db_cache_size = 512;  // MB
 
     // Daemon connection
     std::string daemon_host = "127.0.0.1";
     uint16_t daemon_port = network::MAINNET_RPC_PORT;
     std::string rpc_user;
     std::string rpc_password;
+    std::string chain_dir = "./data";
 
     // Network
     bool testnet = false;
@@ -165,11 +170,13 @@ bool load_config_file(const std::string& path, ServerConfig& config) {
         else if (key == "vardiff-min") config.vardiff_min = std::stoull(value);
         else if (key == "vardiff-max") config.vardiff_max = std::stoull(value);
         else if (key == "vardiff-target") config.vardiff_target = std::stoul(value);
-        else if (key == "db-path") config.db_path = value;
+        else if (key == "data-dir") config.data_dir = value;
+        else if (key == "db-cache-size") config.db_cache_size = std::stoull(value);
         else if (key == "daemon-host") config.daemon_host = value;
         else if (key == "daemon-port") config.daemon_port = std::stoi(value);
         else if (key == "rpc-user") config.rpc_user = value;
         else if (key == "rpc-password") config.rpc_password = value;
+        else if (key == "chain-dir") config.chain_dir = value;
         else if (key == "testnet") config.testnet = (value == "true" || value == "1");
     }
 
@@ -245,8 +252,11 @@ int main(int argc, char* argv[]) {
         else if (arg.find("--vardiff-target=") == 0) {
             config.vardiff_target = std::stoul(arg.substr(17));
         }
-        else if (arg.find("--db-path=") == 0) {
-            config.db_path = arg.substr(10);
+        else if (arg.find("--data-dir=") == 0) {
+            config.data_dir = arg.substr(11);
+        }
+        else if (arg.find("--db-cache-size=") == 0) {
+            config.db_cache_size = std::stoull(arg.substr(16));
         }
         else if (arg.find("--daemon-host=") == 0) {
             config.daemon_host = arg.substr(14);
@@ -260,6 +270,9 @@ int main(int argc, char* argv[]) {
         else if (arg.find("--rpc-password=") == 0) {
             config.rpc_password = arg.substr(15);
         }
+        else if (arg.find("--chain-dir=") == 0) {
+            config.chain_dir = arg.substr(12);
+        }
         else {
             std::cerr << "Unknown option: " << arg << "\n";
             std::cerr << "Use -h or --help for usage information.\n";
@@ -287,6 +300,13 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    auto payout_method = ParsePayoutMethod(config.payout_method);
+    if (!payout_method) {
+        std::cerr << "Error: Unknown payout method: " << config.payout_method << "\n";
+        std::cerr << "Use -h or --help for usage information.\n";
+        return 1;
+    }
+
     if (config.use_ssl && (config.ssl_cert.empty() || config.ssl_key.empty())) {
         std::cerr << "Error: SSL enabled but certificate or key not specified\n";
         std::cerr << "Use --ssl-cert and --ssl-key to provide SSL credentials.\n";
@@ -305,13 +325,40 @@ int main(int argc, char* argv[]) {
         std::cout << "Connecting to intcoind at " << config.daemon_host << ":" << config.daemon_port << "...\n";
 
         // TODO: Create blockchain RPC client
-        // For now, this is a placeholder
-        // Blockchain blockchain(config.daemon_host, config.daemon_port, config.rpc_user, config.rpc_password);
+        // Until then the pool reads the node's chain from its data directory
+        BlockchainConfig chain_config;
+        chain_config.network = config.testnet ? NetworkType::TESTNET : NetworkType::MAINNET;
+        chain_config.data_dir = config.chain_dir;
+        auto blockchain = std::make_shared<Blockchain>(chain_config);
+
+        PoolConfig pool_config;
+        pool_config.pool_name = "INTcoin Pool";
+        pool_config.pool_address = config.pool_address;
+        pool_config.stratum_port = config.stratum_port;
+        pool_config.http_port = config.http_port;
+        pool_config.min_difficulty = config.vardiff_min;
+        pool_config.initial_difficulty = config.vardiff_min;
+        pool_config.target_share_time = config.vardiff_target;
+        pool_config.vardiff_retarget_time = 60.0;
+        pool_config.vardiff_variance = 0.3;
+        pool_config.payout_method = *payout_method;
+        pool_config.pool_fee_percent = config.pool_fee;
+        pool_config.min_payout = config.payout_threshold;
+        pool_config.payout_interval = 3600;
+        pool_config.max_workers_per_miner = 100;
+        pool_config.max_miners = 100000;
+        pool_config.max_connections_per_ip = 100;
+        pool_config.require_password = false;
+        pool_config.ban_on_invalid_share = true;
+        pool_config.max_invalid_shares = 50;
+        pool_config.ban_duration = std::chrono::hours(1);
+        pool_config.data_dir = config.data_dir;
+        pool_config.db_cache_mb = config.db_cache_size;
 
         // Initialize mining pool server
         std::cout << "Initializing mining pool server...\n";
         std::cout << "  Pool address: " << config.pool_address << "\n";
-        std::cout << "  Payout method: " << config.payout_method << "\n";
+        std::cout << "  Payout method: " << ToString(*payout_method) << "\n";
         std::cout << "  Pool fee: " << config.pool_fee << "%\n";
         std::cout << "  Payout threshold: " << config.payout_threshold << " ints\n";
         std::cout << "\n";
@@ -334,28 +381,45 @@ int main(int argc, char* argv[]) {
         std::cout << "  Target: " << config.vardiff_target << " seconds\n";
         std::cout << "\n";
 
-        // TODO: Create and start pool server
-        // For now, this is a placeholder
-        // MiningPoolServer pool_server(blockchain, config);
-        // g_pool_server = &pool_server;
-        //
-        // auto result = pool_server.Start();
-        // if (!result.IsOk()) {
-        //     std::cerr << "Error starting pool server: " << result.GetError() << "\n";
-        //     return 1;
-        // }
+        // The server opens its database, journal and snapshots under data_dir
+        std::cout << "Database:\n";
+        std::cout << "  Data directory: " << config.data_dir << "\n";
+        std::cout << "  Cache: " << config.db_cache_size << " MB\n";
+        std::cout << "\n";
+
+        MiningPoolServer pool_server(pool_config, blockchain, nullptr);
+        auto result = pool_server.Start();
+        if (!result.IsOk()) {
+            std::cerr << "Error starting pool server: " << result.error << "\n";
+            return 1;
+        }
 
         std::cout << "Pool server started successfully!\n";
         std::cout << "Mining pool is ready to accept connections.\n";
         std::cout << "Press Ctrl+C to stop.\n\n";
 
-        // Keep running until signal received
-        while (true) {
+        // Keep running until signal received, with a status line every minute
+        auto next_stats = std::chrono::steady_clock::now() + std::chrono::minutes(1);
+        while (g_stop_signal == 0 && pool_server.IsRunning()) {
             std::this_thread::sleep_for(std::chrono::seconds(1));
 
-            // TODO: Print periodic statistics
-            // pool_server.PrintStats();
+            if (std::chrono::steady_clock::now() >= next_stats) {
+                next_stats += std::chrono::minutes(1);
+                auto stats = pool_server.GetStatistics();
+                std::cout << "Height " << stats.network_height
+                          << " | miners " << stats.active_miners
+                          << " | workers " << stats.active_workers
+                          << " | hashrate " << stats.pool_hashrate << " H/s"
+                          << " | round shares " << stats.shares_this_round
+                          << " | blocks " << stats.blocks_found << "\n";
+            }
+        }
+
+        if (g_stop_signal != 0) {
+            std::cout << "\nReceived signal " << g_stop_signal << ", stopping pool server...\n";
         }
+        pool_server.Stop();
+        std::cout << "Pool server stopped.\n";
 
     } catch (const std::exception& e) {
         std::cerr << "Fatal error: " << e.what() << "\n";
@@ -0,0 +1,424 @@
+/*
+ * Copyright (c) 2025 INTcoin Team (Neil Adamson)
+ * MIT License
+ * Multi-Chain Job Scheduler
+ */
+
+#include "intcoin/pool.h"
+#include "intcoin/util.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace intcoin {
+
+namespace {
+
+double DefaultProfit(const ChainConfig& config, const Work& work) {
+    if (work.difficulty == 0) return 0.0;
+    return config.price * static_cast<double>(work.coinbase_value) / static_cast<double>(work.difficulty);
+}
+
+/// amount * price, rounded down, in 128-bit fixed point: the price's
+/// 53-bit mantissa and binary exponent are exact, so no double rounding
+uint64_t ConvertAtPrice(uint64_t amount, double price) {
+    using u128 = unsigned __int128;
+    if (!std::isfinite(price) || price <= 0.0) return 0;
+
+    int exponent = 0;
+    double fraction = std::frexp(price, &exponent);     // price = fraction * 2^exponent
+    auto mantissa = static_cast<uint64_t>(std::ldexp(fraction, 53));
+    exponent -= 53;
+
+    u128 value = static_cast<u128>(amount) * mantissa;
+    if (exponent < 0) {
+        value = exponent <= -128 ? 0 : value >> -exponent;
+    } else if (exponent >= 64 || value > (static_cast<u128>(UINT64_MAX) >> exponent)) {
+        return UINT64_MAX;
+    } else {
+        value <<= exponent;
+    }
+    return value > UINT64_MAX ? UINT64_MAX : static_cast<uint64_t>(value);
+}
+
+} // namespace
+
+class JobScheduler::Impl {
+public:
+    struct Chain {
+        Chain(const ChainConfig& chain_config, std::shared_ptr<ChainBackend> chain_backend)
+            : config(chain_config)
+            , backend(std::move(chain_backend))
+            , window(chain_config.pplns_window)
+            , blocks(chain_config.block_maturity) {}
+
+        ChainConfig config;
+        std::shared_ptr<ChainBackend> backend;
+        std::shared_ptr<const Work> work;       // Current template
+        double profit = 0.0;
+
+        // Round and payout state (non-primary chains)
+        PPLNSWindow window;
+        uint64_t round_id = 1;
+        uint64_t round_shares = 0;
+        uint64_t round_work = 0;
+        uint64_t blocks_found = 0;
+        BlockTracker blocks;                    // Found blocks awaiting maturity
+    };
+
+    Impl(double switch_margin, ProfitFn profit)
+        : switch_margin_(switch_margin)
+        , profit_(profit ? std::move(profit) : ProfitFn(DefaultProfit)) {}
+
+    Chain* Find(ChainId chain) const {
+        return chain < chains_.size() ? chains_[chain].get() : nullptr;
+    }
+
+    double switch_margin_;
+    ProfitFn profit_;
+
+    mutable std::shared_mutex mutex_;
+    std::vector<std::unique_ptr<Chain>> chains_;  // Indexed by ChainId
+    ChainId active_ = kPrimaryChain;
+    BlockFn block_callback_;
+    std::mutex maturity_mutex_;                   // One CheckMaturity() at a time
+
+    Chain* FindByName(const std::string& name) const {
+        for (size_t i = 1; i < chains_.size(); i++) {
+            if (chains_[i]->config.name == name) return chains_[i].get();
+        }
+        return nullptr;
+    }
+};
+
+JobScheduler::JobScheduler(double switch_margin, ProfitFn profit)
+    : impl_(std::make_unique<Impl>(switch_margin, std::move(profit))) {}
+
+JobScheduler::~JobScheduler() = default;
+
+ChainId JobScheduler::AddChain(const ChainConfig& config, std::shared_ptr<ChainBackend> backend) {
+    std::unique_lock<std::shared_mutex> lock(impl_->mutex_);
+    impl_->chains_.push_back(std::make_unique<Impl::Chain>(config, std::move(backend)));
+    return static_cast<ChainId>(impl_->chains_.size() - 1);
+}
+
+void JobScheduler::SetBlockCallback(BlockFn callback) {
+    std::unique_lock<std::shared_mutex> lock(impl_->mutex_);
+    impl_->block_callback_ = std::move(callback);
+}
+
+bool JobScheduler::RestoreBlock(const std::string& chain_name, FoundBlock block) {
+    std::unique_lock<std::shared_mutex> lock(impl_->mutex_);
+    Impl::Chain* state = impl_->FindByName(chain_name);
+    if (!state) return false;
+    state->round_id = std::max(state->round_id, block.round_id + 1);
+    state->blocks.Add(std::move(block));
+    return true;
+}
+
+size_t JobScheduler::GetChainCount() const {
+    std::shared_lock<std::shared_mutex> lock(impl_->mutex_);
+    return impl_->chains_.size();
+}
+
+Result<Work> JobScheduler::SetWork(ChainId chain, Work work) {
+    work.job_id[0] = static_cast<uint8_t>(chain >> 8);
+    work.job_id[1] = static_cast<uint8_t>(chain & 0xff);
+    auto shared = std::make_shared<const Work>(work);
+
+    std::unique_lock<std::shared_mutex> lock(impl_->mutex_);
+    Impl::Chain* state = impl_->Find(chain);
+    if (!state) {
+        return Result<Work>::Error("Unknown chain " + std::to_string(chain));
+    }
+    state->profit = impl_->profit_(state->config, work);
+    state->work = std::move(shared);
+    return Result<Work>::Ok(std::move(work));
+}
+
+Result<Work> JobScheduler::Refresh(ChainId chain) {
+    std::shared_ptr<ChainBackend> backend;
+    {
+        std::shared_lock<std::shared_mutex> lock(impl_->mutex_);
+        Impl::Chain* state = impl_->Find(chain);
+        if (!state) {
+            return Result<Work>::Error("Unknown chain " + std::to_string(chain));
+        }
+        backend = state->backend;
+    }
+    if (!backend) {
+        return Result<Work>::Error("Chain " + std::to_string(chain) + " has no backend");
+    }
+
+    // The daemon is asked with no lock held
+    auto work = backend->CreateWork();
+    if (!work.IsOk()) {
+        return work;
+    }
+    return SetWork(chain, std::move(work.GetValue()));
+}
+
+std::shared_ptr<const Work> JobScheduler::GetWork(ChainId chain) const {
+    std::shared_lock<std::shared_mutex> lock(impl_->mutex_);
+    Impl::Chain* state = impl_->Find(chain);
+    return state ? state->work : nullptr;
+}
+
+ChainId JobScheduler::GetChainForPort(uint16_t port) const {
+    std::shared_lock<std::shared_mutex> lock(impl_->mutex_);
+    if (port != 0) {
+        for (size_t i = 0; i < impl_->chains_.size(); i++) {
+            if (impl_->chains_[i]->config.port == port) {
+                return static_cast<ChainId>(i);
+            }
+        }
+    }
+    return impl_->active_;
+}
+
+ChainId JobScheduler::GetActiveChain() const {
+    std::shared_lock<std::shared_mutex> lock(impl_->mutex_);
+    return impl_->active_;
+}
+
+bool JobScheduler::Rebalance() {
+    std::unique_lock<std::shared_mutex> lock(impl_->mutex_);
+
+    // Only chains with work and no pinned port take switchable hashrate
+    std::optional<ChainId> best;
+    for (size_t i = 0; i < impl_->chains_.size(); i++) {
+        const Impl::Chain& chain = *impl_->chains_[i];
+        if (!chain.work || chain.config.port != 0) continue;
+        if (!best || chain.profit > impl_->chains_[*best]->profit) {
+            best = static_cast<ChainId>(i);
+        }
+    }
+    if (!best || *best == impl_->active_) {
+        return false;
+    }
+
+    // Hysteresis keeps hashrate from flapping between near-equal chains
+    const Impl::Chain* active = impl_->Find(impl_->active_);
+    bool active_usable = active && active->work && active->config.port == 0;
+    if (active_usable &&
+        impl_->chains_[*best]->profit <= active->profit * (1.0 + impl_->switch_margin_)) {
+        return false;
+    }
+
+    LogF(LogLevel::INFO, "Switching hashrate from %s to %s",
+         active ? active->config.name.c_str() : "(none)",
+         impl_->chains_[*best]->config.name.c_str());
+    impl_->active_ = *best;
+    return true;
+}
+
+ChainId JobScheduler::ChainOf(const uint256& job_id) {
+    return static_cast<ChainId>((static_cast<uint16_t>(job_id[0]) << 8) | job_id[1]);
+}
+
+Result<bool> JobScheduler::SubmitShare(const Share& share) {
+    ChainId chain = ChainOf(share.job_id);
+    std::shared_ptr<const Work> work;
+    std::shared_ptr<ChainBackend> backend;
+    {
+        std::unique_lock<std::shared_mutex> lock(impl_->mutex_);
+        Impl::Chain* state = impl_->Find(chain);
+        if (!state || chain == kPrimaryChain) {
+            return Result<bool>::Error("Unknown job");
+        }
+        if (!state->work || state->work->job_id != share.job_id) {
+            return Result<bool>::Error("Share is for stale work");
+        }
+        if (!ShareValidator::ValidateDifficulty(share.share_hash, share.difficulty)) {
+            return Result<bool>::Error("Share does not meet difficulty requirement");
+        }
+
+        state->window.Add(share.miner_id, share.difficulty);
+        state->round_shares++;
+        state->round_work += share.difficulty;
+
+        if (!ShareValidator::IsValidBlock(share.share_hash, state->work->difficulty)) {
+            return Result<bool>::Ok(false);
+        }
+        work = state->work;
+        backend = state->backend;
+    }
+    if (!backend) {
+        return Result<bool>::Error("Chain " + std::to_string(chain) + " has no backend");
+    }
+
+    Block block;
+    block.header = work->header;
+    uint64_t nonce = 0;
+    for (size_t i = 0; i < 8 && i < share.nonce.size(); i++) {
+        nonce |= static_cast<uint64_t>(share.nonce[i]) << (i * 8);
+    }
+    block.header.nonce = nonce;
+    block.transactions = work->transactions;
+
+    // The daemon is told with no lock held
+    auto submitted = backend->SubmitBlock(block);
+    if (!submitted.IsOk()) {
+        return Result<bool>::Error("Failed to submit block: " + submitted.error);
+    }
+
+    // Split now, while the window reflects this round; credited at maturity
+    FoundBlock callback_block;
+    std::unique_lock<std::shared_mutex> lock(impl_->mutex_);
+    Impl::Chain& state = *impl_->Find(chain);
+    FoundBlock found;
+    found.round_id = state.round_id;
+    found.height = work->height;
+    found.hash = block.GetHash();
+    found.reward = work->coinbase_value;
+    found.finder_id = share.miner_id;
+    found.credits = PayoutCalculator::DistributeDense(
+        state.window.GetDenseMinerWork(), work->coinbase_value, state.config.pool_fee_percent);
+    uint64_t credited = 0;
+    for (const auto& [miner_id, amount] : found.credits) {
+        credited += amount;
+    }
+    if (!found.credits.empty() && credited < found.reward) {
+        found.pool_fee = found.reward - credited;
+    }
+    found.found_at = share.timestamp;
+    size_t miners = found.credits.size();
+    BlockFn callback = impl_->block_callback_;
+    std::string chain_name = state.config.name;
+    if (callback) callback_block = found;
+    state.blocks.Add(std::move(found));
+
+    state.blocks_found++;
+    state.round_id++;
+    state.round_shares = 0;
+    state.round_work = 0;
+    lock.unlock();
+
+    LogF(LogLevel::INFO, "Block found on %s at height %llu (%zu miners credited at maturity)",
+         chain_name.c_str(), static_cast<unsigned long long>(work->height), miners);
+    if (callback) callback(chain_name, callback_block);
+    return Result<bool>::Ok(true);
+}
+
+std::vector<JobScheduler::MaturedBlock> JobScheduler::CheckMaturity() {
+    std::lock_guard<std::mutex> check_lock(impl_->maturity_mutex_);
+
+    // Heights to look up, per chain, taken under the lock
+    struct Lookup {
+        ChainId chain;
+        std::shared_ptr<ChainBackend> backend;
+        uint64_t tip_height;
+        std::vector<uint64_t> heights;
+        std::unordered_map<uint64_t, uint256> hashes;
+    };
+    std::vector<Lookup> lookups;
+    {
+        std::shared_lock<std::shared_mutex> lock(impl_->mutex_);
+        for (size_t i = 1; i < impl_->chains_.size(); i++) {
+            const Impl::Chain& chain = *impl_->chains_[i];
+            if (chain.blocks.GetPending().empty() || !chain.backend || !chain.work ||
+                chain.work->height == 0) {
+                continue;
+            }
+            Lookup lookup{static_cast<ChainId>(i), chain.backend, chain.work->height - 1, {}, {}};
+            for (const auto& block : chain.blocks.GetPending()) {
+                if (block.height <= lookup.tip_height) lookup.heights.push_back(block.height);
+            }
+            lookup.heights.push_back(lookup.tip_height);
+            lookups.push_back(std::move(lookup));
+        }
+    }
+
+    // The daemons are asked with no lock held
+    for (auto& lookup : lookups) {
+        std::sort(lookup.heights.begin(), lookup.heights.end());
+        lookup.heights.erase(std::unique(lookup.heights.begin(), lookup.heights.end()), lookup.heights.end());
+        for (uint64_t height : lookup.heights) {
+            auto hash = lookup.backend->GetBlockHash(height);
+            if (hash.IsOk()) {
+                lookup.hashes[height] = hash.GetValue();
+            }
+        }
+    }
+
+    std::vector<MaturedBlock> matured;
+    std::vector<std::pair<std::string, FoundBlock>> orphaned;
+    std::unique_lock<std::shared_mutex> lock(impl_->mutex_);
+    for (const auto& lookup : lookups) {
+        Impl::Chain& chain = *impl_->chains_[lookup.chain];
+        auto settled = chain.blocks.OnTip(lookup.tip_height, [&lookup](uint64_t height) -> std::optional<uint256> {
+            auto it = lookup.hashes.find(height);
+            if (it == lookup.hashes.end()) return std::nullopt;
+            return it->second;
+        });
+
+        for (auto& block : settled) {
+            if (block.status != FoundBlock::Status::CONFIRMED) {
+                LogF(LogLevel::WARNING, "Block %llu on %s was orphaned; round %llu is not credited",
+                     static_cast<unsigned long long>(block.height), chain.config.name.c_str(),
+                     static_cast<unsigned long long>(block.round_id));
+                orphaned.emplace_back(chain.config.name, std::move(block));
+                continue;
+            }
+
+            // The ledger is kept in the pool's unit. The block's total is
+            // converted once and split back over credits and fee, so the
+            // parts still add up to it.
+            std::vector<uint64_t> weights;
+            weights.reserve(block.credits.size() + 1);
+            uint64_t total = block.pool_fee;
+            for (const auto& [miner_id, amount] : block.credits) {
+                weights.push_back(amount);
+                total += amount;
+            }
+            weights.push_back(block.pool_fee);
+            std::vector<uint64_t> converted(weights.size());
+            PayoutCalculator::SplitExact(weights.data(), weights.size(),
+                                         ConvertAtPrice(total, chain.config.price), converted.data());
+            for (size_t i = 0; i < block.credits.size(); i++) {
+                block.credits[i].second = converted[i];
+            }
+            block.pool_fee = converted.back();
+            matured.push_back(MaturedBlock{lookup.chain, chain.config.name, std::move(block)});
+        }
+    }
+
+    BlockFn callback = impl_->block_callback_;
+    lock.unlock();
+    if (callback) {
+        for (const auto& [chain_name, block] : orphaned) {
+            callback(chain_name, block);
+        }
+    }
+    return matured;
+}
+
+std::vector<ChainStatistics> JobScheduler::GetStatistics() const {
+    std::shared_lock<std::shared_mutex> lock(impl_->mutex_);
+    std::vector<ChainStatistics> stats;
+    stats.reserve(impl_->chains_.size());
+    for (size_t i = 0; i < impl_->chains_.size(); i++) {
+        const Impl::Chain& chain = *impl_->chains_[i];
+        ChainStatistics entry;
+        entry.chain_id = static_cast<ChainId>(i);
+        entry.name = chain.config.name;
+        entry.profit = chain.profit;
+        entry.active = entry.chain_id == impl_->active_;
+        entry.height = chain.work ? chain.work->height : 0;
+        entry.round_id = chain.round_id;
+        entry.round_shares = chain.round_shares;
+        entry.round_work = chain.round_work;
+        entry.blocks_found = chain.blocks_found;
+        for (const auto& block : chain.blocks.GetPending()) {
+            for (const auto& [miner_id, amount] : block.credits) {
+                entry.immature += amount;
+            }
+        }
+        stats.push_back(std::move(entry));
+    }
+    return stats;
+}
+
+} // namespace intcoin
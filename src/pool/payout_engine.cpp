@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2025 INTcoin Team (Neil Adamson)
+ * MIT License
+ * Mining Pool Payout Engine
+ */
+
+#include "intcoin/pool.h"
+#include "intcoin/util.h"
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <thread>
+
+namespace intcoin {
+
+namespace {
+
+// Transaction size model: the wallet funds each payout from a couple of
+// inputs, each carrying a Dilithium3 signature (3293 bytes) and public key
+// (1952 bytes), and adds one change output
+constexpr size_t kTxOverheadBytes = 30;         // Version, locktime, counts
+constexpr size_t kSignedInputBytes = 5290;      // Outpoint, sequence, signature, key
+constexpr size_t kFundingInputs = 2;
+constexpr size_t kOutputBytes = 49;             // Value, script length, P2PKH script
+
+} // namespace
+
+class PayoutEngine::Impl {
+public:
+    Impl(const PayoutEngineOptions& options, CollectFn collect, DebitFn debit, UpdateFn update)
+        : options_(options)
+        , collect_(std::move(collect))
+        , debit_(std::move(debit))
+        , update_(std::move(update)) {}
+
+    /// A broadcast transaction awaiting confirmations
+    struct Transfer {
+        uint256 tx_hash;
+        std::vector<PayoutOutput> outputs;
+    };
+
+    PayoutEngineOptions options_;
+    CollectFn collect_;
+    DebitFn debit_;
+    UpdateFn update_;
+
+    mutable std::mutex state_mutex_;            // Guards sender_, unsent_, sent_ and unknown_
+    std::shared_ptr<PayoutSender> sender_;
+    std::vector<PayoutOutput> unsent_;          // Debited, not broadcast yet
+    std::vector<Transfer> sent_;
+    std::vector<PayoutOutput> unknown_;         // May have been paid; held for an operator
+
+    std::mutex run_mutex_;                      // One run at a time
+    std::thread thread_;
+    std::mutex stop_mutex_;
+    std::condition_variable stop_cv_;
+    bool stop_ = true;
+
+    static Payment ToPayment(const PayoutOutput& output, const uint256& tx_hash, const std::string& status) {
+        Payment payment{};
+        payment.payment_id = output.payment_id;
+        payment.miner_id = output.miner_id;
+        payment.payout_address = output.address;
+        payment.amount = output.amount;
+        payment.tx_hash = tx_hash;
+        payment.status = status;
+        return payment;
+    }
+
+    std::shared_ptr<PayoutSender> GetSender() const {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        return sender_;
+    }
+
+    Result<void> Notify(const std::vector<PayoutOutput>& outputs, const uint256& tx_hash,
+                        const std::string& status) {
+        auto now = std::chrono::system_clock::now();
+        std::vector<Payment> payments;
+        payments.reserve(outputs.size());
+        for (const auto& output : outputs) {
+            payments.push_back(ToPayment(output, tx_hash, status));
+            payments.back().is_confirmed = status == "confirmed";
+            if (payments.back().is_confirmed) {
+                payments.back().confirmed_at = now;
+            }
+        }
+        auto result = update_(payments);
+        if (!result.IsOk()) {
+            LogF(LogLevel::ERROR, "Failed to record %zu payments as %s: %s",
+                 payments.size(), status.c_str(), result.error.c_str());
+        }
+        return result;
+    }
+
+    /// Hold payments that may already have been paid; sending them again
+    /// could pay twice, so only an operator can settle them
+    void HoldUnknown(const std::vector<PayoutOutput>& outputs, const uint256& tx_hash) {
+        Notify(outputs, tx_hash, "unknown");
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        unknown_.insert(unknown_.end(), outputs.begin(), outputs.end());
+    }
+
+    /// Finish confirmed transfers; hold dropped ones for an operator
+    void PollConfirmations(PayoutSender& sender) {
+        std::vector<Transfer> sent;
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            sent.swap(sent_);
+        }
+
+        std::vector<Transfer> waiting;
+        for (auto& transfer : sent) {
+            auto confirmations = sender.GetConfirmations(transfer.tx_hash);
+            if (!confirmations.IsOk()) {
+                waiting.push_back(std::move(transfer));
+                continue;
+            }
+
+            // Ask again before giving up on it: a transaction that went back
+            // into the mempool or got mined must not be paid a second time
+            int64_t depth = confirmations.GetValue();
+            if (depth < 0) {
+                auto recheck = sender.GetConfirmations(transfer.tx_hash);
+                if (!recheck.IsOk() || recheck.GetValue() >= 0) {
+                    waiting.push_back(std::move(transfer));
+                    continue;
+                }
+                LogF(LogLevel::ERROR, "Payout transaction %s was dropped; holding %zu payments for review",
+                     ToHex(transfer.tx_hash).c_str(), transfer.outputs.size());
+                HoldUnknown(transfer.outputs, transfer.tx_hash);
+            } else if (static_cast<uint64_t>(depth) >= options_.confirmations) {
+                Notify(transfer.outputs, transfer.tx_hash, "confirmed");
+            } else {
+                waiting.push_back(std::move(transfer));
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        sent_.insert(sent_.end(), std::make_move_iterator(waiting.begin()),
+                     std::make_move_iterator(waiting.end()));
+    }
+
+    /// Pack and broadcast everything unsent. Each batch is marked "sending"
+    /// first, so a crash mid-send is not mistaken for a payment never made;
+    /// if that mark cannot be recorded, the batch and the rest stay queued.
+    /// A failed send may still have broadcast, so its payments are held.
+    Result<void> SendQueued(PayoutSender& sender) {
+        std::vector<PayoutOutput> unsent;
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            unsent.swap(unsent_);
+        }
+        if (unsent.empty()) return Result<void>::Ok();
+
+        std::vector<Transfer> sent;
+        Result<void> marked = Result<void>::Ok();
+        std::vector<PayoutOutput> requeue;
+        for (auto& batch : Pack(unsent, options_.max_tx_bytes)) {
+            if (marked.IsOk()) {
+                marked = Notify(batch, uint256{}, "sending");
+            }
+            if (!marked.IsOk()) {
+                requeue.insert(requeue.end(), batch.begin(), batch.end());
+                continue;
+            }
+            auto result = sender.Send(batch);
+            if (!result.IsOk()) {
+                LogF(LogLevel::ERROR, "Payout transaction of %zu outputs failed: %s; holding for review",
+                     batch.size(), result.error.c_str());
+                HoldUnknown(batch, uint256{});
+                continue;
+            }
+            // Left "sending" if this fails, which a restart holds for review
+            Notify(batch, result.GetValue(), "sent");
+            sent.push_back(Transfer{result.GetValue(), std::move(batch)});
+        }
+
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        sent_.insert(sent_.end(), std::make_move_iterator(sent.begin()),
+                     std::make_move_iterator(sent.end()));
+        unsent_.insert(unsent_.begin(), requeue.begin(), requeue.end());
+        if (!marked.IsOk()) {
+            return Result<void>::Error("Failed to mark payouts as sending: " + marked.error);
+        }
+        return Result<void>::Ok();
+    }
+
+    void Restore(const std::vector<Payment>& payments) {
+        std::vector<PayoutOutput> unsent;
+        std::map<uint256, std::vector<PayoutOutput>> sent;
+        std::vector<PayoutOutput> interrupted;
+        for (const auto& payment : payments) {
+            PayoutOutput output{payment.payment_id, payment.miner_id, payment.payout_address, payment.amount};
+            if (payment.status == "pending") {
+                unsent.push_back(std::move(output));
+            } else if (payment.status == "sent") {
+                sent[payment.tx_hash].push_back(std::move(output));
+            } else if (payment.status == "sending") {
+                interrupted.push_back(std::move(output));
+            } else if (payment.status == "unknown") {
+                std::lock_guard<std::mutex> lock(state_mutex_);
+                unknown_.push_back(std::move(output));
+            }
+        }
+
+        if (!interrupted.empty()) {
+            LogF(LogLevel::ERROR, "%zu payments were being sent at shutdown; holding them for review",
+                 interrupted.size());
+            HoldUnknown(interrupted, uint256{});
+        }
+
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        unsent_.insert(unsent_.end(), unsent.begin(), unsent.end());
+        for (auto& [tx_hash, outputs] : sent) {
+            sent_.push_back(Transfer{tx_hash, std::move(outputs)});
+        }
+    }
+
+    void Loop() {
+        std::unique_lock<std::mutex> lock(stop_mutex_);
+        while (!stop_) {
+            stop_cv_.wait_for(lock, options_.interval, [this]() { return stop_; });
+            if (stop_) break;
+
+            lock.unlock();
+            auto start = std::chrono::steady_clock::now();
+            auto result = RunOnce();
+            if (!result.IsOk()) {
+                LogF(LogLevel::ERROR, "Payout run failed: %s", result.error.c_str());
+            } else if (result.GetValue() > 0) {
+                double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                LogF(LogLevel::INFO, "Payout run: %zu payments in %.2fs", result.GetValue(), secs);
+            }
+            lock.lock();
+        }
+    }
+
+    Result<size_t> RunOnce() {
+        std::lock_guard<std::mutex> run_lock(run_mutex_);
+        auto sender = GetSender();
+
+        if (sender) {
+            PollConfirmations(*sender);
+        }
+
+        size_t debited = 0;
+        auto due = collect_();
+        if (!due.empty()) {
+            auto result = debit_(std::move(due));
+            if (!result.IsOk()) {
+                return Result<size_t>::Error("Failed to debit payouts: " + result.error);
+            }
+            debited = result.GetValue().size();
+
+            // Without a wallet the payments stay pending, as recorded
+            if (sender) {
+                std::lock_guard<std::mutex> lock(state_mutex_);
+                unsent_.insert(unsent_.end(), result.GetValue().begin(), result.GetValue().end());
+            }
+        }
+
+        if (sender) {
+            auto sent = SendQueued(*sender);
+            if (!sent.IsOk()) {
+                return Result<size_t>::Error(sent.error);
+            }
+        }
+        return Result<size_t>::Ok(debited);
+    }
+};
+
+PayoutEngine::PayoutEngine(const PayoutEngineOptions& options, CollectFn collect, DebitFn debit,
+                           UpdateFn update)
+    : impl_(std::make_unique<Impl>(options, std::move(collect), std::move(debit), std::move(update))) {}
+
+PayoutEngine::~PayoutEngine() {
+    Stop();
+}
+
+void PayoutEngine::SetSender(std::shared_ptr<PayoutSender> sender) {
+    std::lock_guard<std::mutex> lock(impl_->state_mutex_);
+    impl_->sender_ = std::move(sender);
+}
+
+void PayoutEngine::Start() {
+    std::lock_guard<std::mutex> lock(impl_->stop_mutex_);
+    if (!impl_->stop_) return;
+    impl_->stop_ = false;
+    impl_->thread_ = std::thread([this]() { impl_->Loop(); });
+}
+
+void PayoutEngine::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(impl_->stop_mutex_);
+        impl_->stop_ = true;
+    }
+    impl_->stop_cv_.notify_all();
+    if (impl_->thread_.joinable()) {
+        impl_->thread_.join();
+    }
+}
+
+Result<size_t> PayoutEngine::RunOnce() {
+    return impl_->RunOnce();
+}
+
+void PayoutEngine::Restore(const std::vector<Payment>& payments) {
+    impl_->Restore(payments);
+}
+
+std::vector<Payment> PayoutEngine::GetOutstanding() const {
+    std::vector<Payment> outstanding;
+    std::lock_guard<std::mutex> lock(impl_->state_mutex_);
+    for (const auto& output : impl_->unsent_) {
+        outstanding.push_back(Impl::ToPayment(output, uint256{}, "pending"));
+    }
+    for (const auto& transfer : impl_->sent_) {
+        for (const auto& output : transfer.outputs) {
+            outstanding.push_back(Impl::ToPayment(output, transfer.tx_hash, "sent"));
+        }
+    }
+    for (const auto& output : impl_->unknown_) {
+        outstanding.push_back(Impl::ToPayment(output, uint256{}, "unknown"));
+    }
+    return outstanding;
+}
+
+size_t PayoutEngine::EstimateTxSize(size_t outputs) {
+    return kTxOverheadBytes + kFundingInputs * kSignedInputBytes + (outputs + 1) * kOutputBytes;
+}
+
+std::vector<std::vector<PayoutOutput>> PayoutEngine::Pack(const std::vector<PayoutOutput>& outputs,
+                                                          size_t max_tx_bytes) {
+    size_t base = EstimateTxSize(0);
+    size_t per_tx = max_tx_bytes > base ? std::max<size_t>((max_tx_bytes - base) / kOutputBytes, 1) : 1;
+
+    std::vector<std::vector<PayoutOutput>> batches;
+    batches.reserve((outputs.size() + per_tx - 1) / per_tx);
+    for (size_t i = 0; i < outputs.size(); i += per_tx) {
+        size_t end = std::min(outputs.size(), i + per_tx);
+        batches.emplace_back(outputs.begin() + i, outputs.begin() + end);
+    }
+    return batches;
+}
+
+} // namespace intcoin
@@ -5,14 +5,26 @@
  */
 
 #include "intcoin/pool.h"
+#include "intcoin/pool_storage.h"
+#include "intcoin/pool_metrics.h"
+#include "intcoin/consensus.h"
+#include "intcoin/crypto.h"
 #include "intcoin/rpc.h"
 #include "intcoin/util.h"
 #include <algorithm>
+#include <cctype>
+#include <charconv>
 #include <cmath>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <memory>
+#include <filesystem>
+#include <thread>
+#include <condition_variable>
+#include <unordered_map>
+#include <unordered_set>
 
 // Forward declarations of server classes and factory functions
 namespace intcoin {
@@ -42,16 +54,22 @@ VarDiffManager::VarDiffManager(double target_share_time, double retarget_time, d
     , retarget_time_(retarget_time)
     , variance_(variance) {}
 
-uint64_t VarDiffManager::CalculateDifficulty(const Worker& worker) const {
-    if (worker.recent_shares.size() < 3) {
+uint64_t VarDiffManager::CalculateDifficulty(const Worker& worker, const WindowTotals& recent,
+                                             std::chrono::system_clock::time_point now) const {
+    if (recent.shares < 3 || recent.work == 0) {
         return worker.current_difficulty;
     }
 
-    // Calculate average time between shares from recent_shares
-    auto total_duration = std::chrono::duration_cast<std::chrono::seconds>(
-        worker.recent_shares.back() - worker.recent_shares.front());
-    double avg_time = static_cast<double>(total_duration.count()) /
-                     static_cast<double>(worker.recent_shares.size() - 1);
+    // The meter rounds its span up to whole buckets; a worker that connected
+    // inside the window has only been mining since then
+    auto connected = std::chrono::duration_cast<std::chrono::seconds>(now - worker.connected_at);
+    auto span = std::max(std::chrono::seconds(1), std::min(recent.span, connected));
+
+    // Average time between shares at the current difficulty, from the
+    // difficulty-weighted work, so shares from before a retarget count right
+    double avg_time = static_cast<double>(span.count()) *
+                      static_cast<double>(worker.current_difficulty) /
+                      static_cast<double>(recent.work);
     double ratio = avg_time / target_share_time_;
 
     uint64_t new_diff = worker.current_difficulty;
@@ -64,19 +82,16 @@ uint64_t VarDiffManager::CalculateDifficulty(const Worker& worker) const {
     return std::max(uint64_t(1000), new_diff);
 }
 
-bool VarDiffManager::ShouldAdjust(const Worker& worker) const {
-    auto now = std::chrono::system_clock::now();
+bool VarDiffManager::ShouldAdjust(const Worker& worker, const WindowTotals& recent,
+                                  std::chrono::system_clock::time_point now) const {
     auto duration = std::chrono::duration_cast<std::chrono::seconds>(
-        now - worker.last_share_time);
-    return duration.count() >= retarget_time_ && worker.recent_shares.size() >= 3;
+        now - worker.last_retarget);
+    return duration.count() >= retarget_time_ && recent.shares >= 3;
 }
 
-double VarDiffManager::GetShareRate(const Worker& worker) const {
-    if (worker.recent_shares.size() < 2) return 0.0;
-    auto duration = std::chrono::duration_cast<std::chrono::seconds>(
-        worker.recent_shares.back() - worker.recent_shares.front());
-    if (duration.count() == 0) return 0.0;
-    return static_cast<double>(worker.recent_shares.size()) / duration.count();
+double VarDiffManager::GetShareRate(const WindowTotals& recent) const {
+    if (recent.span.count() == 0) return 0.0;
+    return static_cast<double>(recent.shares) / recent.span.count();
 }
 
 // ============================================================================
@@ -129,35 +144,127 @@ bool ShareValidator::IsDuplicateShare(const Share& share, const std::vector<Shar
 // Payout Calculator
 // ============================================================================
 
+namespace {
+
+// Below this many items per thread, spawning costs more than it saves
+constexpr size_t kParallelGrain = 65536;
+
+// Cap on threads x id range for the per-thread partial arrays (256 MiB)
+constexpr size_t kMaxPartialEntries = size_t{1} << 25;
+
+size_t ParallelThreads(size_t n) {
+    size_t hw = std::max(1u, std::thread::hardware_concurrency());
+    return std::clamp<size_t>(n / kParallelGrain, 1, hw);
+}
+
+/// Run fn(slice, begin, end) over `threads` even slices of [0, n); slice 0
+/// runs on the calling thread
+template <typename Fn>
+void ParallelSlices(size_t n, size_t threads, Fn fn) {
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; t++) {
+        workers.emplace_back(fn, t, n * t / threads, n * (t + 1) / threads);
+    }
+    fn(size_t{0}, size_t{0}, n / threads);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+/// Partitioned reduction of n (miner_id, work) items, get(i) -> pair
+template <typename Get>
+DenseMinerWork AggregateDense(size_t n, Get get) {
+    DenseMinerWork result;
+    if (n == 0) return result;
+
+    uint64_t lo = UINT64_MAX;
+    uint64_t hi = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t miner_id = get(i).first;
+        lo = std::min(lo, miner_id);
+        hi = std::max(hi, miner_id);
+    }
+
+    // Ids are allocated sequentially, so the range is normally about the
+    // number of miners; a sparse range is summed in a hash map instead
+    uint64_t range = hi - lo + 1;
+    if (hi - lo >= 4 * static_cast<uint64_t>(n) + 1024) {
+        std::unordered_map<uint64_t, uint64_t> sums;
+        for (size_t i = 0; i < n; i++) {
+            auto [miner_id, work] = get(i);
+            sums[miner_id] += work;
+        }
+        std::vector<std::pair<uint64_t, uint64_t>> sorted(sums.begin(), sums.end());
+        std::sort(sorted.begin(), sorted.end());
+        result.miner_ids.reserve(sorted.size());
+        result.work.reserve(sorted.size());
+        for (const auto& [miner_id, work] : sorted) {
+            if (work == 0) continue;
+            result.miner_ids.push_back(miner_id);
+            result.work.push_back(work);
+        }
+        return result;
+    }
+
+    size_t threads = std::min(ParallelThreads(n),
+                              std::max<size_t>(1, kMaxPartialEntries / range));
+
+    // Each thread sums its slice into its own array; no sharing, no locks
+    std::vector<std::vector<uint64_t>> partial(threads);
+    ParallelSlices(n, threads, [&](size_t t, size_t begin, size_t end) {
+        std::vector<uint64_t>& sums = partial[t];
+        sums.assign(range, 0);
+        for (size_t i = begin; i < end; i++) {
+            auto [miner_id, work] = get(i);
+            sums[miner_id - lo] += work;
+        }
+    });
+
+    // Merge the partials into the first, each thread owning an id range
+    std::vector<uint64_t>& sums = partial[0];
+    if (threads > 1) {
+        ParallelSlices(range, threads, [&](size_t, size_t begin, size_t end) {
+            for (size_t t = 1; t < threads; t++) {
+                const std::vector<uint64_t>& other = partial[t];
+                for (size_t i = begin; i < end; i++) {
+                    sums[i] += other[i];
+                }
+            }
+        });
+    }
+
+    size_t miners = 0;
+    for (uint64_t work : sums) miners += work != 0;
+    result.miner_ids.reserve(miners);
+    result.work.reserve(miners);
+    for (size_t i = 0; i < range; i++) {
+        if (sums[i] == 0) continue;
+        result.miner_ids.push_back(lo + i);
+        result.work.push_back(sums[i]);
+    }
+    return result;
+}
+
+} // namespace
+
 std::map<uint64_t, uint64_t> PayoutCalculator::CalculatePPLNS(
     const std::vector<Share>& shares,
     size_t n_shares,
     uint64_t block_reward,
     double pool_fee)
 {
-    std::map<uint64_t, uint64_t> payouts;
-    uint64_t fee = CalculateFee(block_reward, pool_fee);
-    uint64_t reward = block_reward - fee;
-
-    // Count shares per miner in last N shares
-    std::map<uint64_t, uint64_t> miner_shares;
+    // Weight each of the last N shares by its difficulty
     size_t start = shares.size() > n_shares ? shares.size() - n_shares : 0;
-    uint64_t total = 0;
+    DenseMinerWork miner_work = AggregateDense(shares.size() - start, [&](size_t i) {
+        const Share& share = shares[start + i];
+        return std::pair<uint64_t, uint64_t>(share.miner_id, share.valid ? share.difficulty : 0);
+    });
 
-    for (size_t i = start; i < shares.size(); ++i) {
-        if (shares[i].valid) {
-            miner_shares[shares[i].miner_id]++;
-            total++;
-        }
-    }
-
-    if (total == 0) return payouts;
-
-    for (const auto& [miner_id, count] : miner_shares) {
-        uint64_t payout = (reward * count) / total;
-        payouts[miner_id] = payout;
+    std::map<uint64_t, uint64_t> payouts;
+    auto hint = payouts.end();
+    for (const auto& [miner_id, amount] : DistributeDense(miner_work, block_reward, pool_fee)) {
+        hint = payouts.emplace_hint(hint, miner_id, amount);
     }
-
     return payouts;
 }
 
@@ -185,425 +292,2812 @@ std::map<uint64_t, uint64_t> PayoutCalculator::CalculateProportional(
     uint64_t block_reward,
     double pool_fee)
 {
-    std::map<uint64_t, uint64_t> payouts;
-    uint64_t fee = CalculateFee(block_reward, pool_fee);
-    uint64_t reward = block_reward - fee;
-
     std::map<uint64_t, uint64_t> miner_shares;
-    uint64_t total = 0;
-
     for (const auto& share : round_shares) {
         if (share.valid) {
             miner_shares[share.miner_id]++;
-            total++;
         }
     }
 
-    if (total == 0) return payouts;
+    return DistributeReward(miner_shares, block_reward, pool_fee);
+}
+
+std::map<uint64_t, uint64_t> PayoutCalculator::DistributeReward(
+    const std::map<uint64_t, uint64_t>& miner_weights,
+    uint64_t block_reward,
+    double pool_fee)
+{
+    std::map<uint64_t, uint64_t> payouts;
+    uint64_t reward = block_reward - CalculateFee(block_reward, pool_fee);
+
+    // Flat arrays for the kernel; map order makes ties go to lower miner ids
+    std::vector<uint64_t> weights;
+    weights.reserve(miner_weights.size());
+    for (const auto& [miner_id, weight] : miner_weights) {
+        weights.push_back(weight);
+    }
+    std::vector<uint64_t> amounts(weights.size());
+    SplitExact(weights.data(), weights.size(), reward, amounts.data());
+
+    bool any = false;
+    for (uint64_t weight : weights) any |= weight != 0;
+    if (!any) return payouts;
+
+    auto hint = payouts.end();
+    size_t i = 0;
+    for (const auto& [miner_id, weight] : miner_weights) {
+        hint = payouts.emplace_hint(hint, miner_id, amounts[i++]);
+    }
+
+    return payouts;
+}
+
+void PayoutCalculator::SplitExact(const uint64_t* weights, size_t n, uint64_t amount, uint64_t* out) {
+    using u128 = unsigned __int128;
+
+    u128 total = 0;
+    for (size_t i = 0; i < n; i++) {
+        total += weights[i];
+    }
+    if (total == 0) {
+        std::fill(out, out + n, 0);
+        return;
+    }
 
-    for (const auto& [miner_id, count] : miner_shares) {
-        payouts[miner_id] = (reward * count) / total;
+    // Floor shares; amount * weight < 2^128, so nothing can overflow.
+    // Slices are independent, each keeping its own partial sum of paid
+    std::vector<u128> remainders(n);
+    size_t threads = ParallelThreads(n);
+    std::vector<uint64_t> partial_paid(threads, 0);
+    ParallelSlices(n, threads, [&](size_t t, size_t begin, size_t end) {
+        uint64_t paid = 0;
+        if (total <= UINT64_MAX) {
+            uint64_t divisor = static_cast<uint64_t>(total);
+            for (size_t i = begin; i < end; i++) {
+                u128 product = static_cast<u128>(amount) * weights[i];
+                if ((product >> 64) == 0) {
+                    // Typical case; native 64-bit division is much cheaper
+                    uint64_t narrow = static_cast<uint64_t>(product);
+                    out[i] = narrow / divisor;
+                    remainders[i] = narrow % divisor;
+                } else {
+                    out[i] = static_cast<uint64_t>(product / divisor);
+                    remainders[i] = product % divisor;
+                }
+                paid += out[i];
+            }
+        } else {
+            for (size_t i = begin; i < end; i++) {
+                u128 product = static_cast<u128>(amount) * weights[i];
+                out[i] = static_cast<uint64_t>(product / total);
+                remainders[i] = product % total;
+                paid += out[i];
+            }
+        }
+        partial_paid[t] = paid;
+    });
+    uint64_t paid = 0;
+    for (uint64_t part : partial_paid) paid += part;
+
+    // Fewer than n units are left; the remainders sum to left * total and
+    // each is below total, so only positive weights can be picked
+    size_t left = static_cast<size_t>(amount - paid);
+    if (left == 0) return;
+
+    std::vector<uint32_t> order(n);
+    for (size_t i = 0; i < n; i++) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+    auto larger = [&remainders](uint32_t a, uint32_t b) {
+        return remainders[a] != remainders[b] ? remainders[a] > remainders[b] : a < b;
+    };
+    std::nth_element(order.begin(), order.begin() + (left - 1), order.end(), larger);
+    for (size_t k = 0; k < left; k++) {
+        out[order[k]]++;
     }
+}
 
+MinerCredits PayoutCalculator::DistributeDense(const DenseMinerWork& miner_work,
+                                               uint64_t block_reward,
+                                               double pool_fee)
+{
+    MinerCredits payouts;
+    const std::vector<uint64_t>& weights = miner_work.work;
+    uint64_t reward = block_reward - CalculateFee(block_reward, pool_fee);
+
+    std::vector<uint64_t> amounts(weights.size());
+    SplitExact(weights.data(), weights.size(), reward, amounts.data());
+
+    size_t paid = 0;
+    for (uint64_t amount : amounts) paid += amount != 0;
+    payouts.reserve(paid);
+    for (size_t i = 0; i < amounts.size(); i++) {
+        if (amounts[i] == 0) continue;
+        payouts.emplace_back(miner_work.miner_ids[i], amounts[i]);
+    }
     return payouts;
 }
 
+DenseMinerWork PayoutCalculator::AggregateWork(const std::vector<std::pair<uint64_t, uint64_t>>& shares) {
+    return AggregateDense(shares.size(), [&shares](size_t i) { return shares[i]; });
+}
+
 uint64_t PayoutCalculator::CalculateFee(uint64_t amount, double fee_percent) {
-    return static_cast<uint64_t>(amount * fee_percent / 100.0);
+    // Rate in parts per billion, so the fee itself is exact integer math
+    double clamped = std::clamp(fee_percent, 0.0, 100.0);
+    auto rate = static_cast<uint64_t>(std::llround(clamped * 1e7));
+    return static_cast<uint64_t>(static_cast<unsigned __int128>(amount) * rate / 1000000000u);
+}
+
+void PayoutCalculator::SettleBlockValue(FoundBlock& block, uint64_t prepaid, double pool_fee) {
+    prepaid = std::min(prepaid, block.reward);
+    uint64_t prepaid_fee = CalculateFee(prepaid, pool_fee);
+    block.pps_funding = prepaid - prepaid_fee;
+    block.pool_fee = prepaid_fee;
+
+    uint64_t credited = 0;
+    for (const auto& [miner_id, amount] : block.credits) {
+        credited += amount;
+    }
+    uint64_t distributed = block.reward - prepaid;
+    if (!block.credits.empty() && credited < distributed) {
+        block.pool_fee += distributed - credited;
+    }
 }
 
 // ============================================================================
-// Hashrate Calculator
+// PPLNS Window
 // ============================================================================
 
-double HashrateCalculator::CalculateHashrate(const std::vector<Share>& shares,
-                                             std::chrono::seconds window)
-{
-    auto now = std::chrono::system_clock::now();
-    auto cutoff = now - window;
+PPLNSWindow::PPLNSWindow(size_t window)
+    : ring_(std::max<size_t>(window, 1))
+    , tree_(ring_.size() + 1, 0) {}
 
-    uint64_t total_difficulty = 0;
-    size_t count = 0;
+void PPLNSWindow::Add(uint64_t miner_id, uint64_t difficulty) {
+    Slot& slot = ring_[next_];
 
-    for (const auto& share : shares) {
-        if (share.timestamp >= cutoff && share.valid) {
-            total_difficulty += share.difficulty;
-            count++;
+    // The slot being reused holds the oldest share once the window is full
+    if (count_ == ring_.size()) {
+        auto it = miners_.find(slot.miner_id);
+        it->second.work -= slot.difficulty;
+        if (--it->second.shares == 0) {
+            miners_.erase(it);
         }
+        total_work_ -= slot.difficulty;
+        count_--;
     }
 
-    if (count == 0 || window.count() == 0) return 0.0;
+    // Unsigned wraparound makes this a signed delta
+    uint64_t delta = difficulty - slot.difficulty;
+    for (size_t i = next_ + 1; i < tree_.size(); i += i & (~i + 1)) {
+        tree_[i] += delta;
+    }
 
-    // Hashrate = (shares * difficulty * 2^32) / time
-    return (total_difficulty * 4294967296.0) / window.count();
+    slot.miner_id = miner_id;
+    slot.difficulty = difficulty;
+    MinerWork& miner = miners_[miner_id];
+    miner.work += difficulty;
+    miner.shares++;
+    total_work_ += difficulty;
+    count_++;
+    next_ = (next_ + 1) % ring_.size();
 }
 
-double HashrateCalculator::CalculateHashrateFromDifficulty(uint64_t difficulty,
-                                                           std::chrono::seconds time)
-{
-    if (time.count() == 0) return 0.0;
-    return (difficulty * 4294967296.0) / time.count();
+void PPLNSWindow::Clear() {
+    std::fill(ring_.begin(), ring_.end(), Slot());
+    std::fill(tree_.begin(), tree_.end(), 0);
+    next_ = 0;
+    count_ = 0;
+    total_work_ = 0;
+    miners_.clear();
 }
 
-std::chrono::seconds HashrateCalculator::EstimateBlockTime(double pool_hashrate,
-                                                           uint64_t network_difficulty)
-{
-    if (pool_hashrate == 0.0) {
-        return std::chrono::seconds(std::numeric_limits<int64_t>::max());
+std::map<uint64_t, uint64_t> PPLNSWindow::GetMinerWork() const {
+    std::map<uint64_t, uint64_t> work;
+    for (const auto& [miner_id, miner] : miners_) {
+        work.emplace(miner_id, miner.work);
     }
+    return work;
+}
 
-    double expected_hashes = network_difficulty * 4294967296.0;
-    int64_t seconds = static_cast<int64_t>(expected_hashes / pool_hashrate);
+DenseMinerWork PPLNSWindow::GetDenseMinerWork() const {
+    // From the maintained per-miner sums: O(M log M), independent of N
+    std::vector<std::pair<uint64_t, uint64_t>> sums;
+    sums.reserve(miners_.size());
+    for (const auto& [miner_id, miner] : miners_) {
+        sums.emplace_back(miner_id, miner.work);
+    }
+    std::sort(sums.begin(), sums.end());
+
+    DenseMinerWork dense;
+    dense.miner_ids.reserve(sums.size());
+    dense.work.reserve(sums.size());
+    for (const auto& [miner_id, work] : sums) {
+        dense.miner_ids.push_back(miner_id);
+        dense.work.push_back(work);
+    }
+    return dense;
+}
 
-    return std::chrono::seconds(seconds);
+uint64_t PPLNSWindow::PrefixWork(size_t slots) const {
+    uint64_t sum = 0;
+    for (size_t i = slots; i > 0; i -= i & (~i + 1)) {
+        sum += tree_[i];
+    }
+    return sum;
 }
 
-uint64_t HashrateCalculator::CalculateExpectedShares(uint64_t network_difficulty,
-                                                     uint64_t share_difficulty)
-{
-    if (share_difficulty == 0) return 0;
-    return network_difficulty / share_difficulty;
+uint64_t PPLNSWindow::GetRecentWork(size_t n) const {
+    n = std::min(n, count_);
+    if (n <= next_) {
+        return PrefixWork(next_) - PrefixWork(next_ - n);
+    }
+    // Wraps: [0, next_) plus the tail of the ring
+    return PrefixWork(next_) + PrefixWork(ring_.size()) - PrefixWork(ring_.size() - (n - next_));
+}
+
+size_t PPLNSWindow::SharesForWork(uint64_t work) const {
+    size_t lo = 0;
+    size_t hi = count_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (GetRecentWork(mid) >= work) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
 }
 
 // ============================================================================
-// Utility Functions
+// Decayed Score
 // ============================================================================
 
-std::string ToString(PoolConfig::PayoutMethod method) {
-    switch (method) {
-        case PoolConfig::PayoutMethod::PPLNS: return "PPLNS";
-        case PoolConfig::PayoutMethod::PPS: return "PPS";
-        case PoolConfig::PayoutMethod::PROP: return "Proportional";
-        case PoolConfig::PayoutMethod::SOLO: return "Solo";
-        default: return "Unknown";
-    }
-}
+namespace {
 
-Result<stratum::Message> ParseStratumMessage(const std::string& json) {
-    // Parse JSON string using RPC JSON parser
-    auto json_result = rpc::JSONValue::Parse(json);
-    if (json_result.IsError()) {
-        return Result<stratum::Message>::Error("Invalid JSON: " +
-                                               std::string(json_result.error));
-    }
+// exp(64) leaves ample headroom below DBL_MAX for summed difficulty
+constexpr double kMaxDecayExponent = 64.0;
 
-    const auto& json_obj = *json_result.value;
-    if (!json_obj.IsObject()) {
-        return Result<stratum::Message>::Error("JSON must be an object");
-    }
+// Scores below this fraction of the total cannot earn a base unit
+constexpr double kNegligibleScore = 1e-15;
 
-    stratum::Message msg;
-    msg.type = stratum::MessageType::UNKNOWN;
+// Fixed-point scale for payout weights (full double mantissa)
+constexpr double kWeightScale = 9007199254740992.0;  // 2^53
 
-    // Parse ID (can be null for notifications)
-    if (json_obj.HasKey("id")) {
-        const auto& id_val = json_obj["id"];
-        if (id_val.IsNumber()) {
-            msg.id = static_cast<uint64_t>(id_val.GetInt());
-        }
-    }
+} // namespace
 
-    // Parse method (for requests and notifications)
-    if (json_obj.HasKey("method")) {
-        msg.method = json_obj["method"].GetString();
+DecayedScore::DecayedScore(double half_life_secs)
+    : lambda_(std::log(2.0) / (std::max(half_life_secs, 0.001) * 1000.0)) {}
 
-        // Determine message type from method
-        if (msg.method == "mining.subscribe") {
-            msg.type = stratum::MessageType::SUBSCRIBE;
-        } else if (msg.method == "mining.authorize") {
-            msg.type = stratum::MessageType::AUTHORIZE;
-        } else if (msg.method == "mining.submit") {
-            msg.type = stratum::MessageType::SUBMIT;
-        } else if (msg.method == "mining.notify") {
-            msg.type = stratum::MessageType::NOTIFY;
-        } else if (msg.method == "mining.set_difficulty") {
-            msg.type = stratum::MessageType::SET_DIFFICULTY;
-        } else if (msg.method == "mining.set_extranonce") {
-            msg.type = stratum::MessageType::SET_EXTRANONCE;
-        } else if (msg.method == "client.get_version") {
-            msg.type = stratum::MessageType::GET_VERSION;
-        } else if (msg.method == "client.show_message") {
-            msg.type = stratum::MessageType::SHOW_MESSAGE;
-        } else if (msg.method == "client.reconnect") {
-            msg.type = stratum::MessageType::RECONNECT;
-        }
+void DecayedScore::Add(uint64_t miner_id, uint64_t difficulty, int64_t timestamp_ms) {
+    if (scores_.empty()) {
+        base_ms_ = timestamp_ms;
+        last_ms_ = timestamp_ms;
+        factor_ms_ = timestamp_ms;
+        factor_ = 1;
+    } else if (lambda_ * static_cast<double>(timestamp_ms - base_ms_) > kMaxDecayExponent) {
+        Rebase(timestamp_ms);
     }
 
-    // Parse params (array of strings)
-    if (json_obj.HasKey("params")) {
-        const auto& params_val = json_obj["params"];
-        if (params_val.IsArray()) {
-            const auto& params_arr = params_val.GetArray();
-            for (const auto& param : params_arr) {
-                if (param.IsString()) {
-                    msg.params.push_back(param.GetString());
-                } else if (param.IsNumber()) {
-                    msg.params.push_back(std::to_string(param.GetInt()));
-                } else if (param.IsBool()) {
-                    msg.params.push_back(param.GetBool() ? "true" : "false");
-                }
-            }
-        }
+    // Shares arrive in bursts with the same millisecond
+    if (timestamp_ms != factor_ms_) {
+        factor_ms_ = timestamp_ms;
+        factor_ = std::exp(lambda_ * static_cast<double>(timestamp_ms - base_ms_));
     }
 
-    // Parse result (for responses)
-    if (json_obj.HasKey("result")) {
-        const auto& result_val = json_obj["result"];
-        if (result_val.IsString()) {
-            msg.result = result_val.GetString();
-        } else if (result_val.IsBool()) {
-            msg.result = result_val.GetBool() ? "true" : "false";
-        } else if (result_val.IsNull()) {
-            msg.result = "null";
-        } else {
-            msg.result = result_val.ToJSONString();
-        }
+    double score = static_cast<double>(difficulty) * factor_;
+    auto [it, inserted] = index_.try_emplace(miner_id, scores_.size());
+    if (inserted) {
+        scores_.push_back(MinerScore{miner_id, 0});
     }
+    scores_[it->second].score += score;
+    total_ += score;
+    last_ms_ = std::max(last_ms_, timestamp_ms);
+}
 
-    // Parse error (for error responses)
-    if (json_obj.HasKey("error")) {
-        const auto& error_val = json_obj["error"];
-        if (!error_val.IsNull()) {
-            if (error_val.IsString()) {
-                msg.error = error_val.GetString();
-            } else if (error_val.IsArray()) {
-                // Stratum error format: [error_code, "error_message", null]
-                const auto& err_arr = error_val.GetArray();
-                if (err_arr.size() >= 2) {
-                    msg.error = err_arr[1].GetString();
-                }
-            } else {
-                msg.error = error_val.ToJSONString();
-            }
+void DecayedScore::Rebase(int64_t timestamp_ms) {
+    double factor = std::exp(-lambda_ * static_cast<double>(timestamp_ms - base_ms_));
+    double threshold = total_ * factor * kNegligibleScore;
+
+    size_t kept = 0;
+    total_ = 0;
+    for (size_t i = 0; i < scores_.size(); i++) {
+        MinerScore entry = scores_[i];
+        entry.score *= factor;
+        if (entry.score < threshold) {
+            index_.erase(entry.miner_id);
+            continue;
+        }
+        if (kept != i) {
+            index_[entry.miner_id] = kept;
         }
+        scores_[kept++] = entry;
+        total_ += entry.score;
     }
+    scores_.resize(kept);
 
-    return Result<stratum::Message>::Ok(msg);
+    base_ms_ = timestamp_ms;
+    factor_ms_ = timestamp_ms;
+    factor_ = 1;
 }
 
-std::string FormatStratumResponse(const stratum::Message& msg) {
-    // Build JSON response using RPC JSON builder
-    rpc::JSONValue response;
-    response.type = rpc::JSONType::Object;
+void DecayedScore::Clear() {
+    scores_.clear();
+    index_.clear();
+    total_ = 0;
+}
 
-    // Add ID (required for responses, null for notifications)
-    if (msg.id != 0 || !msg.method.empty()) {
-        response["id"] = rpc::JSONValue(static_cast<int64_t>(msg.id));
-    } else {
-        response["id"] = rpc::JSONValue();  // null
-    }
+double DecayedScore::GetTotalWork() const {
+    return total_ * std::exp(-lambda_ * static_cast<double>(last_ms_ - base_ms_));
+}
 
-    // If this is a notification (has method but response format)
-    if (!msg.method.empty()) {
-        response["method"] = rpc::JSONValue(msg.method);
+std::map<uint64_t, uint64_t> DecayedScore::GetMinerWeights() const {
+    std::map<uint64_t, uint64_t> weights;
+    if (total_ <= 0) return weights;
 
-        // Add params for notifications
-        if (!msg.params.empty()) {
-            std::vector<rpc::JSONValue> params_arr;
-            for (const auto& param : msg.params) {
-                params_arr.push_back(rpc::JSONValue(param));
-            }
-            response["params"] = rpc::JSONValue(params_arr);
+    for (const auto& entry : scores_) {
+        uint64_t weight = static_cast<uint64_t>(entry.score / total_ * kWeightScale);
+        if (weight > 0) {
+            weights.emplace(entry.miner_id, weight);
         }
     }
+    return weights;
+}
 
-    // Add result (for successful responses)
-    if (msg.result.has_value()) {
-        const std::string& result_str = *msg.result;
+// ============================================================================
+// PPS Ledger
+// ============================================================================
 
-        // Try to parse result as JSON if it looks like JSON
-        if (!result_str.empty() && (result_str[0] == '{' || result_str[0] == '[')) {
-            auto result_json = rpc::JSONValue::Parse(result_str);
-            if (result_json.IsOk()) {
-                response["result"] = *result_json.value;
-            } else {
-                response["result"] = rpc::JSONValue(result_str);
-            }
-        } else if (result_str == "true") {
-            response["result"] = rpc::JSONValue(true);
-        } else if (result_str == "false") {
-            response["result"] = rpc::JSONValue(false);
-        } else if (result_str == "null") {
-            response["result"] = rpc::JSONValue();  // null
-        } else {
-            response["result"] = rpc::JSONValue(result_str);
+void PPSLedger::SetRate(uint64_t block_reward, double network_difficulty, double pool_fee) {
+    uint64_t reward = block_reward - PayoutCalculator::CalculateFee(block_reward, pool_fee);
+    long double rate = std::ldexp(static_cast<long double>(reward), kRateBits) /
+                       std::max<long double>(network_difficulty, 1.0L);
+
+    // Saturate rather than wrap on a near-zero test network difficulty
+    constexpr long double kMaxRate = static_cast<long double>(UINT64_MAX);
+    rate_.store(rate >= kMaxRate ? UINT64_MAX : static_cast<uint64_t>(rate), std::memory_order_relaxed);
+}
+
+PPSLedger::Account& PPSLedger::GetAccount(uint64_t miner_id) {
+    {
+        std::shared_lock<std::shared_mutex> lock(accounts_mutex_);
+        auto it = accounts_.find(miner_id);
+        if (it != accounts_.end()) return *it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(accounts_mutex_);
+    auto& account = accounts_[miner_id];
+    if (!account) {
+        account = std::make_unique<Account>();
+    }
+    return *account;
+}
+
+uint64_t PPSLedger::Credit(uint64_t miner_id, uint64_t difficulty) {
+    unsigned __int128 credit = static_cast<unsigned __int128>(GetRate()) * difficulty;
+    credit >>= kRateBits - kCreditBits;
+    uint64_t amount = credit > UINT64_MAX ? UINT64_MAX : static_cast<uint64_t>(credit);
+
+    GetAccount(miner_id).accrued.fetch_add(amount, std::memory_order_relaxed);
+    return amount;
+}
+
+uint64_t PPSLedger::GetPending(uint64_t miner_id) const {
+    std::shared_lock<std::shared_mutex> lock(accounts_mutex_);
+    auto it = accounts_.find(miner_id);
+    if (it == accounts_.end()) return 0;
+    return it->second->accrued.load(std::memory_order_relaxed) >> kCreditBits;
+}
+
+std::map<uint64_t, uint64_t> PPSLedger::GetPending() const {
+    std::map<uint64_t, uint64_t> pending;
+    std::shared_lock<std::shared_mutex> lock(accounts_mutex_);
+    for (const auto& [miner_id, account] : accounts_) {
+        uint64_t whole = account->accrued.load(std::memory_order_relaxed) >> kCreditBits;
+        if (whole > 0) {
+            pending.emplace(miner_id, whole);
         }
-    } else {
-        response["result"] = rpc::JSONValue();  // null
     }
+    return pending;
+}
 
-    // Add error (Stratum format: [error_code, "message", null])
-    if (msg.error.has_value()) {
-        std::vector<rpc::JSONValue> error_arr;
-        error_arr.push_back(rpc::JSONValue(static_cast<int64_t>(20)));  // Generic error code
-        error_arr.push_back(rpc::JSONValue(*msg.error));
-        error_arr.push_back(rpc::JSONValue());  // null traceback
-        response["error"] = rpc::JSONValue(error_arr);
+std::map<uint64_t, uint64_t> PPSLedger::Checkpoint() {
+    std::map<uint64_t, uint64_t> credits;
+    std::shared_lock<std::shared_mutex> lock(accounts_mutex_);
+    for (const auto& [miner_id, account] : accounts_) {
+        // Shares credited meanwhile only add, so the whole part never shrinks
+        uint64_t whole = account->accrued.load(std::memory_order_relaxed) >> kCreditBits;
+        if (whole == 0) continue;
+        account->accrued.fetch_sub(whole << kCreditBits, std::memory_order_relaxed);
+        credits.emplace(miner_id, whole);
+    }
+    return credits;
+}
+
+void PPSLedger::Restore(const std::map<uint64_t, uint64_t>& credits) {
+    for (const auto& [miner_id, amount] : credits) {
+        GetAccount(miner_id).accrued.fetch_add(amount << kCreditBits, std::memory_order_relaxed);
+    }
+}
+
+void PPSLedger::Clear() {
+    std::unique_lock<std::shared_mutex> lock(accounts_mutex_);
+    accounts_.clear();
+}
+
+// ============================================================================
+// Fee Average
+// ============================================================================
+
+FeeAverage::FeeAverage(double window_secs)
+    : window_secs_(std::max(window_secs, 1.0)) {}
+
+void FeeAverage::Update(uint64_t fees, std::chrono::steady_clock::time_point now) {
+    if (!seeded_) {
+        average_ = static_cast<double>(fees);
+        seeded_ = true;
     } else {
-        response["error"] = rpc::JSONValue();  // null
+        // Fold in the outgoing template, weighted by how long it was live
+        double live = std::chrono::duration<double>(now - current_since_).count();
+        double alpha = 1.0 - std::exp(-std::max(live, 0.0) / window_secs_);
+        average_ += alpha * (static_cast<double>(current_fees_) - average_);
     }
+    current_fees_ = fees;
+    current_since_ = now;
+}
 
-    return response.ToJSONString();
+uint64_t FeeAverage::Get() const {
+    return static_cast<uint64_t>(average_);
 }
 
-uint64_t CalculateShareDifficulty(const uint256& hash) {
-    // Calculate difficulty from hash using Bitcoin's pool difficulty formula
-    // difficulty = difficulty_1_target / hash
-    //
-    // Pool difficulty 1 target (pdiff):
-    // 0x00000000FFFF0000000000000000000000000000000000000000000000000000
-    //
-    // This is the target for 1 difficulty share (roughly 2^32 hashes on average)
+// ============================================================================
+// Solo Job Cache
+// ============================================================================
 
-    // Count leading zero bits in hash
-    size_t leading_zeros = 0;
-    for (size_t i = 0; i < 32; i++) {
-        uint8_t byte = hash.data()[31 - i];  // Start from most significant byte
-        if (byte == 0) {
-            leading_zeros += 8;
+namespace {
+
+// Where the Stratum server cuts the serialized coinbase for the extranonce
+constexpr size_t kExtranonceOffset = 42;
+constexpr size_t kExtranonceSize = 8;
+
+std::string BytesToHex(const uint8_t* data, size_t size) {
+    static constexpr char kDigits[] = "0123456789abcdef";
+    std::string hex(size * 2, '0');
+    for (size_t i = 0; i < size; i++) {
+        hex[2 * i] = kDigits[data[i] >> 4];
+        hex[2 * i + 1] = kDigits[data[i] & 0x0f];
+    }
+    return hex;
+}
+
+// Interior merkle node, as Block::CalculateMerkleRoot combines children
+uint256 HashPair(const uint256& left, const uint256& right) {
+    uint8_t buffer[64];
+    std::memcpy(buffer, left.data(), 32);
+    std::memcpy(buffer + 32, right.data(), 32);
+    return SHA3::Hash(buffer, sizeof(buffer));
+}
+
+} // namespace
+
+SoloJobCache::SoloJobCache(ScriptFn script_for)
+    : script_for_(std::move(script_for)) {}
+
+void SoloJobCache::SetWork(const uint256& job_id, const Transaction& coinbase,
+                           std::span<const Transaction> transactions, double pool_fee) {
+    // The shared part of every job, hashed before taking the lock
+    std::vector<uint256> hashes;
+    hashes.reserve(transactions.size());
+    for (const auto& tx : transactions) {
+        hashes.push_back(tx.GetHash());
+    }
+    std::vector<uint256> branch = CoinbaseBranch(hashes);
+
+    auto branch_hex = std::make_shared<std::vector<std::string>>();
+    branch_hex->reserve(branch.size());
+    for (const auto& hash : branch) {
+        branch_hex->push_back(BytesToHex(hash.data(), hash.size()));
+    }
+
+    uint64_t value = 0;
+    for (const auto& out : coinbase.outputs) {
+        value += out.value;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_id_ = job_id;
+    coinbase_ = coinbase;
+    coinbase_value_ = value;
+    // With no output of its own to keep, the template cannot carry a fee
+    pool_fee_ = coinbase.outputs.empty() ? 0 : PayoutCalculator::CalculateFee(value, pool_fee);
+    branch_ = std::move(branch);
+    branch_hex_ = std::move(branch_hex);
+    jobs_.clear();
+}
+
+Result<std::shared_ptr<const SoloJob>> SoloJobCache::GetJob(uint64_t miner_id, const std::string& address) {
+    using JobResult = Result<std::shared_ptr<const SoloJob>>;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!job_id_.has_value()) {
+        return JobResult::Error("No current work available");
+    }
+
+    // Resolve the payout script once per address, not per job
+    auto payee = payees_.find(miner_id);
+    if (payee == payees_.end() || payee->second.address != address) {
+        auto script = script_for_(address);
+        if (script.IsError()) {
+            return JobResult::Error("Invalid payout address: " + script.error);
+        }
+        payee = payees_.insert_or_assign(miner_id, Payee{address, std::move(script.GetValue())}).first;
+        jobs_.erase(miner_id);
+    }
+
+    auto cached = jobs_.find(miner_id);
+    if (cached != jobs_.end()) {
+        return JobResult::Ok(cached->second);
+    }
+
+    auto job = std::make_shared<SoloJob>();
+    job->job_id = *job_id_;
+    job->miner_id = miner_id;
+    job->coinbase = coinbase_;
+    job->coinbase.outputs.clear();
+
+    TxOut reward;
+    reward.value = coinbase_value_ - pool_fee_;
+    reward.script_pubkey = payee->second.script;
+    job->coinbase.outputs.push_back(std::move(reward));
+    if (pool_fee_ > 0) {
+        TxOut fee;
+        fee.value = pool_fee_;
+        fee.script_pubkey = coinbase_.outputs[0].script_pubkey;
+        job->coinbase.outputs.push_back(std::move(fee));
+    }
+
+    std::vector<uint8_t> bytes = job->coinbase.Serialize();
+    size_t split = std::min(kExtranonceOffset, bytes.size());
+    size_t resume = std::min(split + kExtranonceSize, bytes.size());
+    job->coinbase1 = BytesToHex(bytes.data(), split);
+    job->coinbase2 = BytesToHex(bytes.data() + resume, bytes.size() - resume);
+    job->merkle_root = FoldBranch(job->coinbase.GetHash(), branch_);
+    job->merkle_branch = branch_hex_;
+
+    jobs_[miner_id] = job;
+    return JobResult::Ok(std::move(job));
+}
+
+size_t SoloJobCache::GetJobCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jobs_.size();
+}
+
+std::vector<uint256> SoloJobCache::CoinbaseBranch(std::span<const uint256> tx_hashes) {
+    // Each level holds the nodes right of the coinbase path; its first
+    // node is the path's sibling, and the rest pair up (the last with
+    // itself when odd) into the next level
+    std::vector<uint256> branch;
+    std::vector<uint256> level(tx_hashes.begin(), tx_hashes.end());
+    while (!level.empty()) {
+        branch.push_back(level[0]);
+        std::vector<uint256> next;
+        next.reserve(level.size() / 2);
+        for (size_t i = 1; i < level.size(); i += 2) {
+            next.push_back(HashPair(level[i], i + 1 < level.size() ? level[i + 1] : level[i]));
+        }
+        level = std::move(next);
+    }
+    return branch;
+}
+
+uint256 SoloJobCache::FoldBranch(const uint256& coinbase_hash, const std::vector<uint256>& branch) {
+    uint256 root = coinbase_hash;
+    for (const auto& sibling : branch) {
+        root = HashPair(root, sibling);
+    }
+    return root;
+}
+
+// ============================================================================
+// Block Tracker
+// ============================================================================
+
+BlockTracker::BlockTracker(uint32_t maturity, size_t history)
+    : maturity_(std::max<uint32_t>(maturity, 1)), history_(history) {}
+
+void BlockTracker::Add(FoundBlock block) {
+    block.status = FoundBlock::Status::PENDING;
+    block.confirmations = 0;
+    auto pos = std::upper_bound(pending_.begin(), pending_.end(), block.height,
+                                [](uint64_t height, const FoundBlock& b) { return height < b.height; });
+    pending_.insert(pos, std::move(block));
+}
+
+std::vector<FoundBlock> BlockTracker::OnTip(uint64_t tip_height, const HashAtFn& hash_at) {
+    std::vector<FoundBlock> settled;
+
+    // Same tip as last time: nothing can have changed
+    auto tip_hash = hash_at(tip_height);
+    if (tip_hash && tip_hash_ && tip_height == tip_height_ && *tip_hash == *tip_hash_) {
+        return settled;
+    }
+    tip_height_ = tip_height;
+    tip_hash_ = tip_hash;
+
+    std::vector<FoundBlock> still_pending;
+    still_pending.reserve(pending_.size());
+    std::optional<uint256> chain_hash;
+    uint64_t chain_height = 0;
+    bool have_chain_hash = false;
+
+    for (auto& block : pending_) {
+        if (block.height > tip_height) {
+            block.confirmations = 0;  // Tip moved back below it; wait
+            still_pending.push_back(std::move(block));
+            continue;
+        }
+
+        // Pending blocks are height-ordered; one lookup per distinct height
+        if (!have_chain_hash || chain_height != block.height) {
+            chain_height = block.height;
+            chain_hash = block.height == tip_height ? tip_hash : hash_at(block.height);
+            have_chain_hash = true;
+        }
+
+        if (!chain_hash) {
+            still_pending.push_back(std::move(block));
+        } else if (*chain_hash != block.hash) {
+            block.status = FoundBlock::Status::ORPHANED;
+            block.confirmations = 0;
+            orphaned_count_++;
+            settled.push_back(block);
         } else {
-            // Count leading zeros in this byte
-            for (int bit = 7; bit >= 0; bit--) {
-                if ((byte & (1 << bit)) == 0) {
-                    leading_zeros++;
-                } else {
-                    break;
-                }
+            block.confirmations = tip_height - block.height + 1;
+            if (block.confirmations >= maturity_) {
+                block.status = FoundBlock::Status::CONFIRMED;
+                confirmed_count_++;
+                settled.push_back(block);
+            } else {
+                still_pending.push_back(std::move(block));
             }
-            break;
         }
     }
+    pending_.swap(still_pending);
 
-    // Calculate difficulty based on leading zeros
-    // Each leading zero bit roughly doubles the difficulty
-    // Base difficulty (pool difficulty 1) has ~32 leading zeros (0x00000000FFFF...)
-    //
-    // For a more accurate calculation:
-    // difficulty = 2^(leading_zeros - 32) * adjustment_factor
-    //
-    // Simplified formula: difficulty ≈ 2^(leading_zeros - 32) * 65536
+    for (const auto& block : settled) {
+        settled_.push_back(block);
+        if (settled_.size() > history_) {
+            settled_.pop_front();
+        }
+    }
+    return settled;
+}
 
-    if (leading_zeros < 32) {
-        // Hash doesn't meet even difficulty 1 (very unlikely in practice)
-        return 1;
+std::vector<FoundBlock> BlockTracker::GetRecent(size_t limit) const {
+    std::vector<FoundBlock> blocks;
+    blocks.reserve(std::min(limit, pending_.size() + settled_.size()));
+    blocks.insert(blocks.end(), pending_.begin(), pending_.end());
+    blocks.insert(blocks.end(), settled_.begin(), settled_.end());
+
+    // Newest first: settled blocks can be older or newer than pending ones
+    std::sort(blocks.begin(), blocks.end(), [](const FoundBlock& a, const FoundBlock& b) {
+        if (a.height != b.height) return a.height > b.height;
+        return a.found_at > b.found_at;
+    });
+    if (blocks.size() > limit) {
+        blocks.resize(limit);
     }
+    return blocks;
+}
 
-    // Calculate difficulty: 2^(leading_zeros - 32) * 65536
-    uint64_t difficulty = 65536ULL;  // Base multiplier (0xFFFF + 1)
-    size_t extra_zeros = leading_zeros - 32;
+// ============================================================================
+// Chain State Cache
+// ============================================================================
 
-    // Multiply by 2^extra_zeros (with overflow protection)
-    if (extra_zeros > 0) {
-        if (extra_zeros >= 48) {
-            // Cap at maximum uint64_t to prevent overflow
-            return UINT64_MAX;
+namespace {
+
+// Furthest the reward schedule is searched for its next change
+constexpr uint64_t kRewardSearchLimit = uint64_t{1} << 40;
+
+} // namespace
+
+ChainStateCache::ChainStateCache(Source source, uint32_t hashrate_blocks)
+    : source_(std::move(source))
+    , hashrate_blocks_(std::max<uint32_t>(hashrate_blocks, 1)) {}
+
+bool ChainStateCache::Refresh() {
+    std::lock_guard<std::mutex> lock(refresh_mutex_);
+
+    uint64_t height = source_.best_height();
+    uint64_t difficulty = source_.difficulty();
+    bool moved = height != height_.load(std::memory_order_relaxed);
+
+    // Block times: drop what a reorg removed or the window passed, then
+    // read only blocks not yet seen (a failed read is retried next time)
+    while (!times_.empty() && times_.back().first > height) {
+        times_.pop_back();
+    }
+    uint64_t first = height > hashrate_blocks_ ? height - hashrate_blocks_ : 0;
+    while (!times_.empty() && times_.front().first < first) {
+        times_.pop_front();
+    }
+    for (uint64_t h = times_.empty() ? first : times_.back().first + 1; h <= height; h++) {
+        auto time = source_.time_at(h);
+        if (!time) break;
+        times_.emplace_back(h, *time);
+    }
+
+    double network_hashrate = 0.0;
+    if (times_.size() >= 2 && times_.back().second > times_.front().second) {
+        uint64_t blocks = times_.back().first - times_.front().first;
+        uint64_t span = times_.back().second - times_.front().second;
+        network_hashrate = static_cast<double>(difficulty) * 4294967296.0 *
+                           static_cast<double>(blocks) / static_cast<double>(span);
+    }
+
+    // Reward schedule: search for the next change only once it is reached
+    uint64_t next = height + 1;
+    uint64_t reward = source_.reward_at(next);
+    uint64_t next_reward_height = next_reward_height_.load(std::memory_order_relaxed);
+    uint64_t next_block_reward = next_block_reward_.load(std::memory_order_relaxed);
+    if (reward != block_reward_.load(std::memory_order_relaxed) ||
+        (next_reward_height != 0 && next >= next_reward_height)) {
+        uint64_t lo = next;
+        uint64_t hi = next + 1;
+        while (hi - next < kRewardSearchLimit && source_.reward_at(hi) == reward) {
+            lo = hi;
+            hi = next + (hi - next) * 2;
+        }
+        if (hi - next >= kRewardSearchLimit) {
+            next_reward_height = 0;
+            next_block_reward = reward;
+        } else {
+            while (hi - lo > 1) {
+                uint64_t mid = lo + (hi - lo) / 2;
+                (source_.reward_at(mid) == reward ? lo : hi) = mid;
+            }
+            next_reward_height = hi;
+            next_block_reward = source_.reward_at(hi);
         }
-        difficulty <<= extra_zeros;
     }
 
-    // Minimum difficulty of 1
-    return std::max(difficulty, static_cast<uint64_t>(1));
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // Publish: the sequence is odd while fields are being replaced
+    uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    height_.store(height, std::memory_order_relaxed);
+    difficulty_.store(difficulty, std::memory_order_relaxed);
+    network_hashrate_.store(network_hashrate, std::memory_order_relaxed);
+    block_reward_.store(reward, std::memory_order_relaxed);
+    next_reward_height_.store(next_reward_height, std::memory_order_relaxed);
+    next_block_reward_.store(next_block_reward, std::memory_order_relaxed);
+    updated_ms_.store(now_ms, std::memory_order_relaxed);
+    sequence_.store(sequence + 2, std::memory_order_release);
+
+    return moved;
 }
 
-uint256 GenerateJobID() {
-    return GetRandomUint256();
+ChainState ChainStateCache::Get() const {
+    for (;;) {
+        uint64_t sequence = sequence_.load(std::memory_order_acquire);
+        if (sequence & 1) continue;
+
+        ChainState state;
+        state.height = height_.load(std::memory_order_relaxed);
+        state.difficulty = difficulty_.load(std::memory_order_relaxed);
+        state.network_hashrate = network_hashrate_.load(std::memory_order_relaxed);
+        state.block_reward = block_reward_.load(std::memory_order_relaxed);
+        state.next_reward_height = next_reward_height_.load(std::memory_order_relaxed);
+        state.next_block_reward = next_block_reward_.load(std::memory_order_relaxed);
+        state.updated_at = std::chrono::system_clock::time_point(
+            std::chrono::milliseconds(updated_ms_.load(std::memory_order_relaxed)));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence_.load(std::memory_order_relaxed) == sequence) {
+            return state;
+        }
+    }
 }
 
 // ============================================================================
-// Mining Pool Server Implementation
+// Luck Tracker
 // ============================================================================
 
-class MiningPoolServer::Impl {
-public:
-    Impl(const PoolConfig& config,
-         std::shared_ptr<Blockchain> blockchain,
-         std::shared_ptr<Miner> miner)
-        : config_(config)
-        , blockchain_(blockchain)
-        , solo_miner_(miner)
-        , running_(false)
-        , next_miner_id_(1)
-        , next_worker_id_(1)
-        , next_share_id_(1)
-        , next_round_id_(1)
-        , next_payment_id_(1)
-        , vardiff_(config.target_share_time, config.vardiff_retarget_time, config.vardiff_variance)
-        , stratum_server_(nullptr)
-        , http_api_server_(nullptr)
-    {
-        current_round_.round_id = next_round_id_++;
-        current_round_.started_at = std::chrono::system_clock::now();
-        current_round_.shares_submitted = 0;
-        current_round_.is_complete = false;
+LuckTracker::LuckTracker(size_t window)
+    : window_(std::max<size_t>(window, 1)) {}
+
+double LuckTracker::Effort(const RoundStatistics& round) {
+    if (round.network_difficulty == 0) return 0.0;
+    return 100.0 * static_cast<double>(round.total_work) / static_cast<double>(round.network_difficulty);
+}
+
+void LuckTracker::Close(const RoundStatistics& round) {
+    if (round.total_work == 0 || round.network_difficulty == 0) {
+        return;
+    }
+
+    RoundLuck luck;
+    luck.round_id = round.round_id;
+    luck.work = round.total_work;
+    luck.network_difficulty = round.network_difficulty;
+    luck.effort = Effort(round);
+    luck.luck = 100.0 * static_cast<double>(round.network_difficulty) / static_cast<double>(round.total_work);
+
+    rounds_.push_back(luck);
+    work_sum_ += luck.work;
+    expected_sum_ += luck.network_difficulty;
+    if (rounds_.size() > window_) {
+        work_sum_ -= rounds_.front().work;
+        expected_sum_ -= rounds_.front().network_difficulty;
+        rounds_.pop_front();
+    }
+}
+
+void LuckTracker::AddWork(uint64_t round_id, uint64_t work) {
+    for (auto it = rounds_.rbegin(); it != rounds_.rend(); ++it) {
+        if (it->round_id != round_id) continue;
+        it->work += work;
+        it->effort = 100.0 * static_cast<double>(it->work) / static_cast<double>(it->network_difficulty);
+        it->luck = 100.0 * static_cast<double>(it->network_difficulty) / static_cast<double>(it->work);
+        work_sum_ += work;
+        return;
+    }
+}
+
+void LuckTracker::Restore(const std::vector<RoundStatistics>& rounds) {
+    rounds_.clear();
+    work_sum_ = 0;
+    expected_sum_ = 0;
+    for (const auto& round : rounds) {
+        Close(round);
+    }
+}
+
+double LuckTracker::GetRollingLuck() const {
+    if (work_sum_ == 0) return 0.0;
+    return 100.0 * static_cast<double>(expected_sum_) / static_cast<double>(work_sum_);
+}
+
+std::vector<RoundLuck> LuckTracker::GetRecent(size_t limit) const {
+    size_t count = std::min(limit, rounds_.size());
+    return std::vector<RoundLuck>(rounds_.rbegin(), rounds_.rbegin() + count);
+}
+
+// ============================================================================
+// Hashrate Calculator
+// ============================================================================
+
+double HashrateCalculator::CalculateHashrate(const std::vector<Share>& shares,
+                                             std::chrono::seconds window)
+{
+    auto now = std::chrono::system_clock::now();
+    auto cutoff = now - window;
+
+    uint64_t total_difficulty = 0;
+    size_t count = 0;
+
+    for (const auto& share : shares) {
+        if (share.timestamp >= cutoff && share.valid) {
+            total_difficulty += share.difficulty;
+            count++;
+        }
+    }
+
+    if (count == 0 || window.count() == 0) return 0.0;
+
+    // Hashrate = (shares * difficulty * 2^32) / time
+    return (total_difficulty * 4294967296.0) / window.count();
+}
+
+double HashrateCalculator::CalculateHashrateFromDifficulty(uint64_t difficulty,
+                                                           std::chrono::seconds time)
+{
+    if (time.count() == 0) return 0.0;
+    return (difficulty * 4294967296.0) / time.count();
+}
+
+std::chrono::seconds HashrateCalculator::EstimateBlockTime(double pool_hashrate,
+                                                           uint64_t network_difficulty)
+{
+    if (pool_hashrate == 0.0) {
+        return std::chrono::seconds(std::numeric_limits<int64_t>::max());
     }
 
-    ~Impl() {
-        Stop();
-    }
+    double expected_hashes = network_difficulty * 4294967296.0;
+    int64_t seconds = static_cast<int64_t>(expected_hashes / pool_hashrate);
+
+    return std::chrono::seconds(seconds);
+}
+
+uint64_t HashrateCalculator::CalculateExpectedShares(uint64_t network_difficulty,
+                                                     uint64_t share_difficulty)
+{
+    if (share_difficulty == 0) return 0;
+    return network_difficulty / share_difficulty;
+}
+
+namespace {
+
+uint64_t SecondOf(std::chrono::steady_clock::time_point now) {
+    auto secs = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+    return static_cast<uint64_t>(std::max<int64_t>(secs, 0));
+}
+
+} // namespace
+
+void HashrateMeter::Add(uint64_t work, std::chrono::steady_clock::time_point now) {
+    uint64_t second = SecondOf(now);
+
+    // Take the write side: an even sequence made odd
+    uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+    while ((sequence & 1) ||
+           !sequence_.compare_exchange_weak(sequence, sequence + 1,
+                                            std::memory_order_acquire, std::memory_order_relaxed)) {
+        sequence = sequence_.load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint64_t total_work = total_work_.load(std::memory_order_relaxed);
+    uint32_t total_shares = total_shares_.load(std::memory_order_relaxed);
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    if (start_.load(std::memory_order_relaxed) == kEmpty) {
+        start_.store(second, std::memory_order_relaxed);
+        head = second;
+    } else if (second > head) {
+        // Buckets without shares end where they started; at most one ring's worth
+        for (const Tier& tier : kTiers) {
+            uint64_t bucket = second / tier.bucket_secs;
+            uint64_t from = std::max(head / tier.bucket_secs + 1,
+                                     bucket > tier.buckets ? bucket - tier.buckets : 0);
+            for (uint64_t b = from; b < bucket; b++) {
+                size_t slot = tier.offset + b % (tier.buckets + 1);
+                work_[slot].store(total_work, std::memory_order_relaxed);
+                shares_[slot].store(total_shares, std::memory_order_relaxed);
+            }
+        }
+        head = second;
+    }
+
+    // A share stamped before the head counts in the head's buckets
+    total_work += work;
+    total_shares++;
+    for (const Tier& tier : kTiers) {
+        size_t slot = tier.offset + (head / tier.bucket_secs) % (tier.buckets + 1);
+        work_[slot].store(total_work, std::memory_order_relaxed);
+        shares_[slot].store(total_shares, std::memory_order_relaxed);
+    }
+    total_work_.store(total_work, std::memory_order_relaxed);
+    total_shares_.store(total_shares, std::memory_order_relaxed);
+    head_.store(head, std::memory_order_relaxed);
+
+    sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+HashrateMeter::Totals HashrateMeter::Get(Window window, std::chrono::steady_clock::time_point now) const {
+    size_t tier_index = 0;
+    size_t buckets = 0;
+    switch (window) {
+        case Window::MINUTE:       tier_index = 0; buckets = 4;  break;
+        case Window::FIVE_MINUTES: tier_index = 1; buckets = 5;  break;
+        case Window::TEN_MINUTES:  tier_index = 1; buckets = 10; break;
+        case Window::HOUR:         tier_index = 2; buckets = 12; break;
+        case Window::DAY:          tier_index = 3; buckets = 24; break;
+    }
+    const Tier& tier = kTiers[tier_index];
+    uint64_t second = SecondOf(now);
+
+    for (;;) {
+        uint64_t sequence = sequence_.load(std::memory_order_acquire);
+        if (sequence & 1) continue;
+
+        Totals totals;
+        uint64_t start = start_.load(std::memory_order_relaxed);
+        if (start != kEmpty) {
+            uint64_t head = head_.load(std::memory_order_relaxed);
+            uint64_t total_work = total_work_.load(std::memory_order_relaxed);
+            uint32_t total_shares = total_shares_.load(std::memory_order_relaxed);
+            uint64_t head_bucket = head / tier.bucket_secs;
+            uint64_t end = std::max(second, head) / tier.bucket_secs;
+
+            // The window is the buckets after `lower`, up to and including `end`
+            uint64_t work_before = 0;
+            uint32_t shares_before = 0;
+            if (end >= buckets) {
+                uint64_t lower = end - buckets;
+                if (lower >= head_bucket) {
+                    work_before = total_work;
+                    shares_before = total_shares;
+                } else {
+                    size_t slot = tier.offset + lower % (tier.buckets + 1);
+                    work_before = work_[slot].load(std::memory_order_relaxed);
+                    shares_before = shares_[slot].load(std::memory_order_relaxed);
+                }
+            }
+            totals.work = total_work - work_before;
+            totals.shares = static_cast<uint32_t>(total_shares - shares_before);
+            uint64_t covered = std::min<uint64_t>(buckets, end - std::min(start / tier.bucket_secs, end) + 1);
+            totals.span = std::chrono::seconds(covered * tier.bucket_secs);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence_.load(std::memory_order_relaxed) == sequence) {
+            totals.hashrate = HashrateCalculator::CalculateHashrateFromDifficulty(totals.work, totals.span);
+            return totals;
+        }
+    }
+}
+
+uint64_t HashrateMeter::GetWork(std::chrono::steady_clock::time_point now) const {
+    return Get(Window::TEN_MINUTES, now).work;
+}
+
+double HashrateMeter::GetHashrate(std::chrono::steady_clock::time_point now, Window window) const {
+    return Get(window, now).hashrate;
+}
+
+// ============================================================================
+// Utility Functions
+// ============================================================================
+
+std::string ToString(PoolConfig::PayoutMethod method) {
+    switch (method) {
+        case PoolConfig::PayoutMethod::PPLNS: return "PPLNS";
+        case PoolConfig::PayoutMethod::PPLNS_DECAYED: return "PPLNS (decayed)";
+        case PoolConfig::PayoutMethod::PPS: return "PPS";
+        case PoolConfig::PayoutMethod::FPPS: return "FPPS";
+        case PoolConfig::PayoutMethod::PPS_PLUS: return "PPS+";
+        case PoolConfig::PayoutMethod::PROP: return "Proportional";
+        case PoolConfig::PayoutMethod::SOLO: return "Solo";
+        default: return "Unknown";
+    }
+}
+
+std::optional<PoolConfig::PayoutMethod> ParsePayoutMethod(const std::string& name) {
+    std::string upper;
+    for (char c : name) {
+        upper.push_back(c == '_' ? '-' : static_cast<char>(std::toupper(static_cast<unsigned char>(c))));
+    }
+    if (upper == "PPLNS") return PoolConfig::PayoutMethod::PPLNS;
+    if (upper == "PPLNS-DECAYED") return PoolConfig::PayoutMethod::PPLNS_DECAYED;
+    if (upper == "PPS") return PoolConfig::PayoutMethod::PPS;
+    if (upper == "FPPS") return PoolConfig::PayoutMethod::FPPS;
+    if (upper == "PPS-PLUS" || upper == "PPS+") return PoolConfig::PayoutMethod::PPS_PLUS;
+    if (upper == "PROP" || upper == "PROPORTIONAL") return PoolConfig::PayoutMethod::PROP;
+    if (upper == "SOLO") return PoolConfig::PayoutMethod::SOLO;
+    return std::nullopt;
+}
+
+bool IsPerShareMethod(PoolConfig::PayoutMethod method) {
+    return method == PoolConfig::PayoutMethod::PPS ||
+           method == PoolConfig::PayoutMethod::FPPS ||
+           method == PoolConfig::PayoutMethod::PPS_PLUS;
+}
+
+std::string ToString(FoundBlock::Status status) {
+    switch (status) {
+        case FoundBlock::Status::PENDING: return "pending";
+        case FoundBlock::Status::CONFIRMED: return "confirmed";
+        case FoundBlock::Status::ORPHANED: return "orphaned";
+        default: return "unknown";
+    }
+}
+
+Result<stratum::Message> ParseStratumMessage(const std::string& json) {
+    // Parse JSON string using RPC JSON parser
+    auto json_result = rpc::JSONValue::Parse(json);
+    if (json_result.IsError()) {
+        return Result<stratum::Message>::Error("Invalid JSON: " +
+                                               std::string(json_result.error));
+    }
+
+    const auto& json_obj = *json_result.value;
+    if (!json_obj.IsObject()) {
+        return Result<stratum::Message>::Error("JSON must be an object");
+    }
+
+    stratum::Message msg;
+    msg.type = stratum::MessageType::UNKNOWN;
+
+    // Parse ID (can be null for notifications)
+    if (json_obj.HasKey("id")) {
+        const auto& id_val = json_obj["id"];
+        if (id_val.IsNumber()) {
+            msg.id = static_cast<uint64_t>(id_val.GetInt());
+        }
+    }
+
+    // Parse method (for requests and notifications)
+    if (json_obj.HasKey("method")) {
+        msg.method = json_obj["method"].GetString();
+
+        // Determine message type from method
+        if (msg.method == "mining.subscribe") {
+            msg.type = stratum::MessageType::SUBSCRIBE;
+        } else if (msg.method == "mining.authorize") {
+            msg.type = stratum::MessageType::AUTHORIZE;
+        } else if (msg.method == "mining.submit") {
+            msg.type = stratum::MessageType::SUBMIT;
+        } else if (msg.method == "mining.notify") {
+            msg.type = stratum::MessageType::NOTIFY;
+        } else if (msg.method == "mining.set_difficulty") {
+            msg.type = stratum::MessageType::SET_DIFFICULTY;
+        } else if (msg.method == "mining.set_extranonce") {
+            msg.type = stratum::MessageType::SET_EXTRANONCE;
+        } else if (msg.method == "client.get_version") {
+            msg.type = stratum::MessageType::GET_VERSION;
+        } else if (msg.method == "client.show_message") {
+            msg.type = stratum::MessageType::SHOW_MESSAGE;
+        } else if (msg.method == "client.reconnect") {
+            msg.type = stratum::MessageType::RECONNECT;
+        }
+    }
+
+    // Parse params (array of strings)
+    if (json_obj.HasKey("params")) {
+        const auto& params_val = json_obj["params"];
+        if (params_val.IsArray()) {
+            const auto& params_arr = params_val.GetArray();
+            for (const auto& param : params_arr) {
+                if (param.IsString()) {
+                    msg.params.push_back(param.GetString());
+                } else if (param.IsNumber()) {
+                    msg.params.push_back(std::to_string(param.GetInt()));
+                } else if (param.IsBool()) {
+                    msg.params.push_back(param.GetBool() ? "true" : "false");
+                }
+            }
+        }
+    }
+
+    // Parse result (for responses)
+    if (json_obj.HasKey("result")) {
+        const auto& result_val = json_obj["result"];
+        if (result_val.IsString()) {
+            msg.result = result_val.GetString();
+        } else if (result_val.IsBool()) {
+            msg.result = result_val.GetBool() ? "true" : "false";
+        } else if (result_val.IsNull()) {
+            msg.result = "null";
+        } else {
+            msg.result = result_val.ToJSONString();
+        }
+    }
+
+    // Parse error (for error responses)
+    if (json_obj.HasKey("error")) {
+        const auto& error_val = json_obj["error"];
+        if (!error_val.IsNull()) {
+            if (error_val.IsString()) {
+                msg.error = error_val.GetString();
+            } else if (error_val.IsArray()) {
+                // Stratum error format: [error_code, "error_message", null]
+                const auto& err_arr = error_val.GetArray();
+                if (err_arr.size() >= 2) {
+                    msg.error = err_arr[1].GetString();
+                }
+            } else {
+                msg.error = error_val.ToJSONString();
+            }
+        }
+    }
+
+    return Result<stratum::Message>::Ok(msg);
+}
+
+std::string FormatStratumResponse(const stratum::Message& msg) {
+    // Build JSON response using RPC JSON builder
+    rpc::JSONValue response;
+    response.type = rpc::JSONType::Object;
+
+    // Add ID (required for responses, null for notifications)
+    if (msg.id != 0 || !msg.method.empty()) {
+        response["id"] = rpc::JSONValue(static_cast<int64_t>(msg.id));
+    } else {
+        response["id"] = rpc::JSONValue();  // null
+    }
+
+    // If this is a notification (has method but response format)
+    if (!msg.method.empty()) {
+        response["method"] = rpc::JSONValue(msg.method);
+
+        // Add params for notifications
+        if (!msg.params.empty()) {
+            std::vector<rpc::JSONValue> params_arr;
+            for (const auto& param : msg.params) {
+                params_arr.push_back(rpc::JSONValue(param));
+            }
+            response["params"] = rpc::JSONValue(params_arr);
+        }
+    }
+
+    // Add result (for successful responses)
+    if (msg.result.has_value()) {
+        const std::string& result_str = *msg.result;
+
+        // Try to parse result as JSON if it looks like JSON
+        if (!result_str.empty() && (result_str[0] == '{' || result_str[0] == '[')) {
+            auto result_json = rpc::JSONValue::Parse(result_str);
+            if (result_json.IsOk()) {
+                response["result"] = *result_json.value;
+            } else {
+                response["result"] = rpc::JSONValue(result_str);
+            }
+        } else if (result_str == "true") {
+            response["result"] = rpc::JSONValue(true);
+        } else if (result_str == "false") {
+            response["result"] = rpc::JSONValue(false);
+        } else if (result_str == "null") {
+            response["result"] = rpc::JSONValue();  // null
+        } else {
+            response["result"] = rpc::JSONValue(result_str);
+        }
+    } else {
+        response["result"] = rpc::JSONValue();  // null
+    }
+
+    // Add error (Stratum format: [error_code, "message", null])
+    if (msg.error.has_value()) {
+        std::vector<rpc::JSONValue> error_arr;
+        error_arr.push_back(rpc::JSONValue(static_cast<int64_t>(20)));  // Generic error code
+        error_arr.push_back(rpc::JSONValue(*msg.error));
+        error_arr.push_back(rpc::JSONValue());  // null traceback
+        response["error"] = rpc::JSONValue(error_arr);
+    } else {
+        response["error"] = rpc::JSONValue();  // null
+    }
+
+    return response.ToJSONString();
+}
+
+uint64_t CalculateShareDifficulty(const uint256& hash) {
+    // Calculate difficulty from hash using Bitcoin's pool difficulty formula
+    // difficulty = difficulty_1_target / hash
+    //
+    // Pool difficulty 1 target (pdiff):
+    // 0x00000000FFFF0000000000000000000000000000000000000000000000000000
+    //
+    // This is the target for 1 difficulty share (roughly 2^32 hashes on average)
+
+    // Count leading zero bits in hash
+    size_t leading_zeros = 0;
+    for (size_t i = 0; i < 32; i++) {
+        uint8_t byte = hash.data()[31 - i];  // Start from most significant byte
+        if (byte == 0) {
+            leading_zeros += 8;
+        } else {
+            // Count leading zeros in this byte
+            for (int bit = 7; bit >= 0; bit--) {
+                if ((byte & (1 << bit)) == 0) {
+                    leading_zeros++;
+                } else {
+                    break;
+                }
+            }
+            break;
+        }
+    }
+
+    // Calculate difficulty based on leading zeros
+    // Each leading zero bit roughly doubles the difficulty
+    // Base difficulty (pool difficulty 1) has ~32 leading zeros (0x00000000FFFF...)
+    //
+    // For a more accurate calculation:
+    // difficulty = 2^(leading_zeros - 32) * adjustment_factor
+    //
+    // Simplified formula: difficulty ≈ 2^(leading_zeros - 32) * 65536
+
+    if (leading_zeros < 32) {
+        // Hash doesn't meet even difficulty 1 (very unlikely in practice)
+        return 1;
+    }
+
+    // Calculate difficulty: 2^(leading_zeros - 32) * 65536
+    uint64_t difficulty = 65536ULL;  // Base multiplier (0xFFFF + 1)
+    size_t extra_zeros = leading_zeros - 32;
+
+    // Multiply by 2^extra_zeros (with overflow protection)
+    if (extra_zeros > 0) {
+        if (extra_zeros >= 48) {
+            // Cap at maximum uint64_t to prevent overflow
+            return UINT64_MAX;
+        }
+        difficulty <<= extra_zeros;
+    }
+
+    // Minimum difficulty of 1
+    return std::max(difficulty, static_cast<uint64_t>(1));
+}
+
+uint256 GenerateJobID() {
+    return GetRandomUint256();
+}
+
+namespace {
+
+/// Inverse of ToHex for the transaction hashes stored in payment rows
+std::optional<uint256> ParseTxHash(const std::string& hex) {
+    uint256 hash{};
+    if (hex.size() != hash.size() * 2) return std::nullopt;
+    for (size_t i = 0; i < hash.size(); i++) {
+        uint8_t byte = 0;
+        auto [end, ec] = std::from_chars(hex.data() + i * 2, hex.data() + i * 2 + 2, byte, 16);
+        if (ec != std::errc() || end != hex.data() + i * 2 + 2) return std::nullopt;
+        hash[i] = byte;
+    }
+    // ToHex may print in display (reversed) byte order
+    if (ToHex(hash) != hex) {
+        std::reverse(hash.begin(), hash.end());
+    }
+    return hash;
+}
+
+} // namespace
+
+// ============================================================================
+// Mining Pool Server Implementation
+// ============================================================================
+
+class MiningPoolServer::Impl {
+public:
+    Impl(const PoolConfig& config,
+         std::shared_ptr<Blockchain> blockchain,
+         std::shared_ptr<Miner> miner)
+        : config_(config)
+        , blockchain_(blockchain)
+        , solo_miner_(miner)
+        , running_(false)
+        , next_miner_id_(1)
+        , next_worker_id_(1)
+        , next_share_id_(1)
+        , next_round_id_(1)
+        , pplns_(config.pplns_window)
+        , decayed_(config.decay_half_life_secs)
+        , fee_average_(config.fee_average_secs)
+        , blocks_(config.block_maturity)
+        , luck_(config.luck_window)
+        , chain_state_(ChainStateCache::Source{
+              [this]() { return blockchain_->GetBestHeight(); },
+              [this]() { return static_cast<uint64_t>(blockchain_->GetDifficulty()); },
+              [this](uint64_t height) -> std::optional<uint64_t> {
+                  auto block = blockchain_->GetBlockByHeight(height);
+                  if (!block.IsOk()) return std::nullopt;
+                  return block.GetValue().header.timestamp;
+              },
+              [](uint64_t height) { return ConsensusValidator::GetBlockReward(height); },
+          }, config.network_hashrate_blocks)
+        , solo_jobs_([](const std::string& address) -> Result<Script> {
+              auto pubkey_hash = AddressEncoder::DecodeAddress(address);
+              if (pubkey_hash.IsError()) {
+                  return Result<Script>::Error(pubkey_hash.error);
+              }
+              return Result<Script>::Ok(Script::CreateP2PKH(pubkey_hash.GetValue()));
+          })
+        , next_payment_id_(1)
+        , vardiff_(config.target_share_time, config.vardiff_retarget_time, config.vardiff_variance)
+        , stratum_server_(nullptr)
+        , http_api_server_(nullptr)
+    {
+        current_round_.round_id = next_round_id_++;
+        current_round_.started_at = std::chrono::system_clock::now();
+        current_round_.shares_submitted = 0;
+        current_round_.is_complete = false;
+
+        // The pool's own chain; its work and accounting stay here
+        ChainConfig primary;
+        primary.name = config.pool_name;
+        primary.pplns_window = config.pplns_window;
+        primary.pool_fee_percent = config.pool_fee_percent;
+        scheduler_.AddChain(primary, nullptr);
+        scheduler_.SetBlockCallback([this](const std::string& chain_name, const FoundBlock& block) {
+            RecordChainBlock(chain_name, block);
+        });
+
+        PayoutEngineOptions payout_options;
+        payout_options.max_tx_bytes = config.payout_max_tx_bytes;
+        payout_options.confirmations = config.payout_confirmations;
+        payout_options.interval = std::chrono::seconds(std::max<uint64_t>(config.payout_interval, 1));
+        payout_engine_ = std::make_unique<PayoutEngine>(
+            payout_options,
+            [this]() { return CollectPayouts(); },
+            [this](std::vector<PayoutOutput> outputs) { return DebitPayouts(std::move(outputs)); },
+            [this](const std::vector<Payment>& payments) { return OnPaymentUpdate(payments); });
+    }
+
+    ~Impl() {
+        Stop();
+    }
+
+    // Configuration
+    PoolConfig config_;
+    std::shared_ptr<Blockchain> blockchain_;
+    std::shared_ptr<Miner> solo_miner_;  // For solo mining mode
+
+    // Server state
+    std::atomic<bool> running_;
+    std::mutex mutex_;
+    mutable pool::PoolMetrics metrics_;
+
+    // Miners and workers
+    std::map<uint64_t, Miner> miners_;
+    std::map<std::string, uint64_t> username_to_miner_id_;
+    std::map<uint64_t, Worker> workers_;
+    std::map<uint64_t, uint64_t> worker_to_miner_;  // worker_id -> miner_id
+    std::atomic<uint64_t> next_miner_id_;
+    std::atomic<uint64_t> next_worker_id_;
+
+    // Shares and rounds
+    std::vector<Share> recent_shares_;
+    std::atomic<uint64_t> next_share_id_;
+    RoundStatistics current_round_;
+    std::vector<RoundStatistics> round_history_;
+    std::atomic<uint64_t> next_round_id_;
+    PPLNSWindow pplns_;                         // Last N durable valid shares, by difficulty
+    DecayedScore decayed_;                      // Exponentially decayed share scores
+    PPSLedger pps_;                             // Per-share credit not yet in the ledger
+    FeeAverage fee_average_;                    // Smoothed template fees (FPPS)
+    uint64_t pps_checkpoint_seq_ = 0;           // Journal seq covered by posted PPS credit
+    BlockTracker blocks_;                       // Found blocks awaiting maturity
+    std::mutex block_check_mutex_;              // One CheckBlocks() at a time
+    LuckTracker luck_;                          // Luck over recently closed rounds
+    ChainStateCache chain_state_;               // Node tip, difficulty and rewards
+    SoloJobCache solo_jobs_;                    // Per-miner coinbases (SOLO)
+    std::unordered_map<uint64_t, SoloRound> solo_rounds_;
+    JobScheduler scheduler_;                    // Templates and rounds of every chain mined
+    std::vector<FoundBlock> unposted_blocks_;   // Matured, ledger post failed
+    std::vector<JobScheduler::MaturedBlock> unposted_chain_blocks_;  // Matured, ledger post failed
+    std::vector<std::pair<std::string, FoundBlock>> unrestored_chain_blocks_;  // Immature, chain not added yet
+
+    // Payment tracking
+    std::vector<Payment> payment_history_;
+    std::unordered_map<uint64_t, size_t> payment_index_;   // payment_id -> payment_history_ slot
+    std::atomic<uint64_t> next_payment_id_;
+    std::unordered_set<uint64_t> payable_miners_;          // Balance at or above min_payout
+    std::unique_ptr<PayoutEngine> payout_engine_;
+
+    // Current work
+    std::optional<Work> current_work_;
+    std::mutex work_mutex_;
+
+    // Variable difficulty
+    VarDiffManager vardiff_;
+
+    // Hashrate, credited by difficulty as shares are accepted
+    using RateMap = std::unordered_map<uint64_t, std::unique_ptr<HashrateMeter>>;
+    HashrateMeter pool_rate_;
+    std::shared_mutex rate_mutex_;              // Guards the maps below, not the meters
+    RateMap worker_rates_;
+    RateMap miner_rates_;
+
+    // Statistics
+    PoolStatistics stats_;
+    std::chrono::system_clock::time_point start_time_;
+
+    // Security - banned miners and IPs
+    std::map<std::string, std::chrono::system_clock::time_point> banned_ips_;
+    std::mutex security_mutex_;
+
+    // Callbacks
+    std::optional<MiningPoolServer::BlockFoundCallback> block_found_callback_;
+    std::optional<MiningPoolServer::PayoutCallback> payout_callback_;
+
+    // Network servers (raw pointers due to forward declarations)
+    stratum::StratumServer* stratum_server_;
+    pool::HttpApiServer* http_api_server_;
+
+    // Share journal and columnar archive (null when running memory-only)
+    std::unique_ptr<pool::ShareJournal> journal_;
+    std::shared_ptr<pool::ShareArchive> archive_;
+    uint64_t applied_seq_ = 0;                  // Last journal record reflected in state
+    std::atomic<bool> archive_behind_{false};   // An append failed; catch up before appending again
+
+    // Payment/credit ledger (null when running memory-only)
+    std::unique_ptr<pool::PoolDatabase> database_;
+
+    // History exports run on detached HTTP threads without mutex_; Stop()
+    // waits for them to drain before closing the archive and database
+    std::mutex export_mutex_;
+    std::condition_variable export_cv_;
+    int active_exports_ = 0;
+    std::atomic<bool> storage_closing_{false};
+
+    // State snapshots: miners changed since the last capture are copied into
+    // a shadow snapshot owned by the snapshot thread, so the capture pause is
+    // proportional to active miners rather than registered ones.
+    std::unordered_set<uint64_t> dirty_miners_;
+    pool::PoolSnapshot snapshot_;
+    std::unique_ptr<pool::SnapshotStore> snapshot_store_;
+    std::thread snapshot_thread_;
+    std::mutex snapshot_mutex_;
+    std::condition_variable snapshot_cv_;
+    bool snapshot_stop_ = false;
+
+    // Chain state re-read on a timer, in case a tip notification is missed
+    std::thread chain_thread_;
+    std::mutex chain_mutex_;
+    std::condition_variable chain_cv_;
+    bool chain_stop_ = false;
+
+    void Stop() {
+        running_ = false;
+
+        {
+            std::lock_guard<std::mutex> lock(chain_mutex_);
+            chain_stop_ = true;
+        }
+        chain_cv_.notify_all();
+        if (chain_thread_.joinable()) {
+            chain_thread_.join();
+        }
+
+        // Let an in-flight payout run finish before state is torn down
+        if (payout_engine_) {
+            payout_engine_->Stop();
+        }
+
+        // Stop and delete network servers
+        if (stratum_server_) {
+            stratum::DestroyStratumServer(stratum_server_);
+            stratum_server_ = nullptr;
+        }
+        if (http_api_server_) {
+            pool::DestroyHttpApiServer(http_api_server_);
+            http_api_server_ = nullptr;
+        }
+
+        // Stop periodic snapshots
+        {
+            std::lock_guard<std::mutex> lock(snapshot_mutex_);
+            snapshot_stop_ = true;
+        }
+        snapshot_cv_.notify_all();
+        if (snapshot_thread_.joinable()) {
+            snapshot_thread_.join();
+        }
+
+        // Commit queued shares and stop the journal writer
+        if (journal_) {
+            journal_->Close();
+        }
+
+        // Final snapshot covers everything the journal made durable
+        if (snapshot_store_) {
+            auto result = TakeSnapshot();
+            if (!result.IsOk()) {
+                LogF(LogLevel::ERROR, "Final snapshot failed: %s", result.error.c_str());
+            }
+            snapshot_store_.reset();
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(export_mutex_);
+            storage_closing_ = true;
+            export_cv_.wait(lock, [this]() { return active_exports_ == 0; });
+        }
+
+        journal_.reset();
+        if (archive_) {
+            if (database_) database_->SetShareArchive(nullptr);
+            archive_->Close();
+            archive_.reset();
+        }
+        if (database_) {
+            database_->Close();
+            database_.reset();
+        }
+    }
+
+    /// Count a share toward its round and payout scores (caller holds mutex_)
+    void CreditShare(uint64_t round_id, uint64_t miner_id, uint64_t difficulty, int64_t timestamp_ms) {
+        // Solo miners are paid by their own coinbase; each has a round of
+        // their own and nothing goes into the pooled one
+        if (config_.payout_method == PoolConfig::PayoutMethod::SOLO) {
+            auto [it, inserted] = solo_rounds_.try_emplace(miner_id);
+            if (inserted) {
+                it->second.miner_id = miner_id;
+                it->second.started_at = std::chrono::system_clock::now();
+            }
+            it->second.shares++;
+            it->second.work += difficulty;
+            return;
+        }
+
+        pplns_.Add(miner_id, difficulty);
+        decayed_.Add(miner_id, difficulty, timestamp_ms);
+        if (IsPerShareMethod(config_.payout_method)) {
+            pps_.Credit(miner_id, difficulty);
+        }
+
+        if (round_id == current_round_.round_id) {
+            // A round is expected to take the difficulty it was opened at
+            if (current_round_.network_difficulty == 0) {
+                current_round_.network_difficulty = chain_state_.GetDifficulty();
+            }
+            current_round_.shares_submitted++;
+            current_round_.total_work += difficulty;
+            current_round_.miner_shares[miner_id]++;
+            return;
+        }
+
+        // Share became durable after its round closed
+        for (auto it = round_history_.rbegin(); it != round_history_.rend(); ++it) {
+            if (it->round_id == round_id) {
+                it->shares_submitted++;
+                it->total_work += difficulty;
+                it->miner_shares[miner_id]++;
+                luck_.AddWork(round_id, difficulty);
+                if (database_) {
+                    database_->SaveRound(*it);
+                }
+                return;
+            }
+        }
+    }
+
+    /// Queue an accepted share; it counts once durable (caller holds mutex_)
+    void AccountShare(const Share& share) {
+        if (journal_) {
+            journal_->Append(share, current_round_.round_id);
+        } else {
+            int64_t timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                share.timestamp.time_since_epoch()).count();
+            CreditShare(current_round_.round_id, share.miner_id, share.difficulty, timestamp_ms);
+        }
+    }
+
+    /// Journal writer callback: credit a durable group commit
+    void OnSharesDurable(const std::vector<pool::JournalRecord>& records) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& rec : records) {
+            if (rec.flags & pool::JOURNAL_SHARE_VALID) {
+                CreditShare(rec.round_id, rec.miner_id, rec.difficulty, rec.timestamp_ms);
+            }
+        }
+        if (!records.empty()) {
+            applied_seq_ = records.back().seq;
+        }
+    }
+
+    /// Open the ledger database under data_dir
+    Result<void> OpenDatabase() {
+        pool::PoolDatabaseOptions options;
+        options.block_cache_mb = config_.db_cache_mb;
+        database_ = std::make_unique<pool::PoolDatabase>(
+            (std::filesystem::path(config_.data_dir) / "db").string(), options);
+        auto result = database_->Open();
+        if (!result.IsOk()) {
+            database_.reset();
+            return result;
+        }
+
+        // Journal replay must not re-accrue PPS credit already posted
+        pps_checkpoint_seq_ = database_->GetLastLedgerReference(pool::PoolDatabase::LedgerType::PPS_CREDIT);
+        luck_.Restore(database_->GetRecentRounds(static_cast<int>(config_.luck_window)));
+        return result;
+    }
+
+    /// Take balances from the ledger (it is authoritative over snapshots)
+    /// and move the payment/round allocators past anything already posted,
+    /// so idempotency keys are never reused after a crash
+    void ReconcileLedger() {
+        using Ledger = pool::PoolDatabase;
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        for (auto& [miner_id, miner] : miners_) {
+            auto balance = database_->GetBalance(Ledger::LedgerAccount::MINER, miner_id);
+            uint64_t unpaid = static_cast<uint64_t>(std::max<int64_t>(balance.balance, 0));
+            if (miner.unpaid_balance != unpaid || miner.paid_balance != balance.debited) {
+                miner.unpaid_balance = unpaid;
+                miner.paid_balance = balance.debited;
+                MarkMinerDirty(miner_id);
+            }
+            UpdatePayable(miner_id, miner);
+        }
+
+        next_payment_id_ = std::max<uint64_t>(
+            next_payment_id_, database_->GetLastLedgerReference(Ledger::LedgerType::PAYMENT) + 1);
+        metrics_.pps_fund.Set(static_cast<double>(
+            database_->GetBalance(Ledger::LedgerAccount::PPS_FUND).balance));
+
+        // A round credited just before a crash may not have its close in the journal
+        AdvanceRoundPast(std::max({database_->GetLastLedgerReference(Ledger::LedgerType::ROUND_CREDIT),
+                                   database_->GetLastLedgerReference(Ledger::LedgerType::POOL_FEE),
+                                   database_->GetLastLedgerReference(Ledger::LedgerType::PPS_FUNDING)}));
+    }
+
+    /// Start a fresh round if last_round (already ended) is not behind the
+    /// current one (caller holds mutex_)
+    void AdvanceRoundPast(uint64_t last_round) {
+        if (last_round > 0 && last_round >= current_round_.round_id) {
+            LogF(LogLevel::WARNING, "Round %llu already ended; starting round %llu",
+                 static_cast<unsigned long long>(last_round),
+                 static_cast<unsigned long long>(last_round + 1));
+            current_round_ = RoundStatistics();
+            current_round_.round_id = last_round + 1;
+            current_round_.started_at = std::chrono::system_clock::now();
+            current_round_.is_complete = false;
+        }
+        next_round_id_ = std::max<uint64_t>(next_round_id_, current_round_.round_id + 1);
+    }
+
+    /// Resume tracking blocks that had not matured at shutdown
+    void LoadBlocks() {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        uint64_t last_round = 0;
+        auto records = database_->GetBlocksByStatus(ToString(FoundBlock::Status::PENDING));
+        for (auto& record : records) {
+            FoundBlock block;
+            block.round_id = record.round_id;
+            block.height = record.height;
+            block.hash = record.hash;
+            block.reward = record.reward;
+            block.finder_id = record.finder_id;
+            block.credits = std::move(record.credits);
+            block.pool_fee = record.pool_fee;
+            block.pps_funding = record.pps_funding;
+            block.found_at = record.timestamp;
+
+            // Other chains' blocks go back to the scheduler, once their chain is added
+            if (!record.chain.empty()) {
+                unrestored_chain_blocks_.emplace_back(std::move(record.chain), std::move(block));
+                continue;
+            }
+            blocks_.Add(std::move(block));
+            last_round = std::max(last_round, record.round_id);
+        }
+        AdvanceRoundPast(last_round);
+        RestoreChainBlocks();
+
+        if (!records.empty()) {
+            LogF(LogLevel::INFO, "Tracking %zu immature blocks", records.size());
+        }
+    }
+
+    /// Hand persisted immature blocks to the chains added so far (caller
+    /// holds mutex_)
+    void RestoreChainBlocks() {
+        auto it = std::remove_if(unrestored_chain_blocks_.begin(), unrestored_chain_blocks_.end(),
+                                 [this](auto& entry) {
+            return scheduler_.RestoreBlock(entry.first, entry.second);
+        });
+        unrestored_chain_blocks_.erase(it, unrestored_chain_blocks_.end());
+    }
+
+    /// Persist another chain's block when it is found or orphaned; matured
+    /// ones are marked once credited (no pool lock held)
+    void RecordChainBlock(const std::string& chain_name, const FoundBlock& block) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!database_) return;
+
+        Result<void> recorded = Result<void>::Ok();
+        if (block.status == FoundBlock::Status::PENDING) {
+            pool::PoolDatabase::BlockRecord record;
+            record.height = block.height;
+            record.hash = block.hash;
+            auto finder = miners_.find(block.finder_id);
+            record.finder_address = finder != miners_.end() ? finder->second.payout_address : "";
+            record.reward = block.reward;
+            record.status = ToString(block.status);
+            record.timestamp = block.found_at;
+            record.round_id = block.round_id;
+            record.finder_id = block.finder_id;
+            record.credits = block.credits;
+            record.pool_fee = block.pool_fee;
+            record.chain = chain_name;
+            recorded = database_->RecordBlock(record);
+        } else {
+            recorded = database_->UpdateBlockStatus(block.height, block.hash, ToString(block.status));
+        }
+        if (!recorded.IsOk()) {
+            LogF(LogLevel::ERROR, "Failed to record %s block %llu: %s", chain_name.c_str(),
+                 static_cast<unsigned long long>(block.height), recorded.error.c_str());
+        }
+    }
+
+    /// Track a block just submitted; its round is credited once it matures
+    /// (caller holds mutex_)
+    void TrackBlock(FoundBlock block) {
+        if (database_) {
+            pool::PoolDatabase::BlockRecord record;
+            record.height = block.height;
+            record.hash = block.hash;
+            auto finder = miners_.find(block.finder_id);
+            record.finder_address = finder != miners_.end() ? finder->second.payout_address : "";
+            record.reward = block.reward;
+            record.status = ToString(FoundBlock::Status::PENDING);
+            record.timestamp = block.found_at;
+            record.round_id = block.round_id;
+            record.finder_id = block.finder_id;
+            record.credits = block.credits;
+            record.pool_fee = block.pool_fee;
+            record.pps_funding = block.pps_funding;
+
+            auto recorded = database_->RecordBlock(record);
+            if (!recorded.IsOk()) {
+                LogF(LogLevel::ERROR, "Failed to record block %llu: %s",
+                     static_cast<unsigned long long>(block.height), recorded.error.c_str());
+            }
+        }
+        blocks_.Add(std::move(block));
+    }
+
+    /// Re-check immature blocks against the chain tip and settle those that
+    /// matured or were orphaned. The node is asked for block hashes without
+    /// mutex_ held; a block added meanwhile is checked on a later tip.
+    void CheckBlocks() {
+        std::lock_guard<std::mutex> check_lock(block_check_mutex_);
+        uint64_t tip_height = chain_state_.GetHeight();
+        std::vector<uint64_t> heights;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (blocks_.GetPending().empty() && unposted_blocks_.empty()) return;
+            for (const auto& block : blocks_.GetPending()) {
+                if (block.height <= tip_height) heights.push_back(block.height);
+            }
+        }
+        heights.push_back(tip_height);
+        std::sort(heights.begin(), heights.end());
+        heights.erase(std::unique(heights.begin(), heights.end()), heights.end());
+
+        std::unordered_map<uint64_t, uint256> hashes;
+        for (uint64_t height : heights) {
+            auto block = blockchain_->GetBlockByHeight(height);
+            if (block.IsOk()) {
+                hashes[height] = block.GetValue().GetHash();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto settled = blocks_.OnTip(tip_height, [&hashes](uint64_t height) -> std::optional<uint256> {
+            auto it = hashes.find(height);
+            if (it == hashes.end()) return std::nullopt;
+            return it->second;
+        });
+        settled.insert(settled.begin(), std::make_move_iterator(unposted_blocks_.begin()),
+                       std::make_move_iterator(unposted_blocks_.end()));
+        unposted_blocks_.clear();
+        for (auto& block : settled) {
+            if (!SettleBlock(block)) {
+                unposted_blocks_.push_back(std::move(block));
+            }
+        }
+    }
+
+    /// Credit rounds of other chains whose blocks matured; the scheduler
+    /// asks their daemons with no pool lock held
+    void CheckChainBlocks() {
+        auto matured = scheduler_.CheckMaturity();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        matured.insert(matured.begin(), std::make_move_iterator(unposted_chain_blocks_.begin()),
+                       std::make_move_iterator(unposted_chain_blocks_.end()));
+        unposted_chain_blocks_.clear();
+        for (auto& entry : matured) {
+            if (!SettleChainBlock(entry)) {
+                unposted_chain_blocks_.push_back(std::move(entry));
+            }
+        }
+    }
+
+    /// Post a matured block of another chain to the ledger (caller holds
+    /// mutex_). Keys carry the chain and block hash, as that chain's round
+    /// ids restart with the pool; references stay 0 so the pool's own
+    /// round allocator is untouched. Returns false if it must be retried.
+    bool SettleChainBlock(const JobScheduler::MaturedBlock& matured) {
+        using Ledger = pool::PoolDatabase;
+        const FoundBlock& block = matured.block;
+        std::string prefix = "chain/" + matured.chain_name + "/" + ToHex(block.hash) + "/";
+        auto now = std::chrono::system_clock::now();
+
+        std::vector<Ledger::LedgerEntry> credits;
+        for (const auto& [miner_id, amount] : block.credits) {
+            if (amount == 0) continue;
+            Ledger::LedgerEntry entry;
+            entry.key = prefix + std::to_string(miner_id);
+            entry.type = Ledger::LedgerType::ROUND_CREDIT;
+            entry.miner_id = miner_id;
+            entry.amount = amount;
+            entry.memo = matured.chain_name;
+            entry.timestamp = now;
+            credits.push_back(entry);
+        }
+        if (block.pool_fee > 0) {
+            Ledger::LedgerEntry fee;
+            fee.key = prefix + "fee";
+            fee.type = Ledger::LedgerType::POOL_FEE;
+            fee.amount = block.pool_fee;
+            fee.memo = matured.chain_name;
+            fee.timestamp = now;
+            credits.push_back(fee);
+        }
+
+        auto posted = PostLedger(credits);
+        if (!posted.IsOk()) {
+            LogF(LogLevel::ERROR, "Failed to credit %s block %llu: %s", matured.chain_name.c_str(),
+                 static_cast<unsigned long long>(block.height), posted.error.c_str());
+            return false;
+        }
+        LogF(LogLevel::INFO, "%s block %llu matured; credited %zu miners", matured.chain_name.c_str(),
+             static_cast<unsigned long long>(block.height), block.credits.size());
+
+        if (database_) {
+            auto updated = database_->UpdateBlockStatus(block.height, block.hash, ToString(block.status));
+            if (!updated.IsOk()) {
+                LogF(LogLevel::ERROR, "Failed to update %s block %llu: %s", matured.chain_name.c_str(),
+                     static_cast<unsigned long long>(block.height), updated.error.c_str());
+            }
+        }
+        return true;
+    }
+
+    /// Credit a matured round, or drop an orphaned one (caller holds mutex_).
+    /// Returns false if crediting failed; the block stays pending in the
+    /// database and is retried on the next tip (or start), which the
+    /// idempotent keys make safe.
+    bool SettleBlock(const FoundBlock& block) {
+        using Ledger = pool::PoolDatabase;
+
+        if (block.status == FoundBlock::Status::CONFIRMED) {
+            std::vector<Ledger::LedgerEntry> credits;
+            auto now = std::chrono::system_clock::now();
+            for (const auto& [miner_id, amount] : block.credits) {
+                Ledger::LedgerEntry entry;
+                entry.key = "round/" + std::to_string(block.round_id) + "/" + std::to_string(miner_id);
+                entry.type = Ledger::LedgerType::ROUND_CREDIT;
+                entry.miner_id = miner_id;
+                entry.amount = amount;
+                entry.reference = block.round_id;
+                entry.timestamp = now;
+                credits.push_back(entry);
+            }
+            if (block.pool_fee > 0) {
+                Ledger::LedgerEntry fee;
+                fee.key = "round/" + std::to_string(block.round_id) + "/fee";
+                fee.type = Ledger::LedgerType::POOL_FEE;
+                fee.amount = block.pool_fee;
+                fee.reference = block.round_id;
+                fee.timestamp = now;
+                credits.push_back(fee);
+            }
+            if (block.pps_funding > 0) {
+                Ledger::LedgerEntry funding;
+                funding.key = "round/" + std::to_string(block.round_id) + "/pps";
+                funding.type = Ledger::LedgerType::PPS_FUNDING;
+                funding.amount = block.pps_funding;
+                funding.reference = block.round_id;
+                funding.timestamp = now;
+                credits.push_back(funding);
+            }
+
+            auto credit_result = PostLedger(credits);
+            if (!credit_result.IsOk()) {
+                LogF(LogLevel::ERROR, "Failed to credit round %llu (will retry): %s",
+                     static_cast<unsigned long long>(block.round_id), credit_result.error.c_str());
+                return false;
+            }
+            LogF(LogLevel::INFO, "Block %llu matured; credited round %llu to %zu miners",
+                 static_cast<unsigned long long>(block.height),
+                 static_cast<unsigned long long>(block.round_id), block.credits.size());
+        } else {
+            LogF(LogLevel::WARNING, "Block %llu (%s) was orphaned; round %llu is not credited",
+                 static_cast<unsigned long long>(block.height), ToHex(block.hash).c_str(),
+                 static_cast<unsigned long long>(block.round_id));
+        }
+
+        if (database_) {
+            auto updated = database_->UpdateBlockStatus(block.height, block.hash, ToString(block.status));
+            if (!updated.IsOk()) {
+                LogF(LogLevel::ERROR, "Failed to update block %llu: %s",
+                     static_cast<unsigned long long>(block.height), updated.error.c_str());
+            }
+        }
+        return true;
+    }
+
+    /// Post ledger entries (and payment rows in the same write), then mirror
+    /// the resulting balances onto miners (caller holds mutex_). Memory-only
+    /// pools apply the entries directly.
+    Result<void> PostLedger(const std::vector<pool::PoolDatabase::LedgerEntry>& entries,
+                            const std::vector<pool::PoolDatabase::Payment>& payments = {}) {
+        using Ledger = pool::PoolDatabase;
+        if (database_) {
+            auto posted = database_->PostLedgerEntries(entries, payments);
+            if (!posted.IsOk()) {
+                return Result<void>::Error(posted.error);
+            }
+            metrics_.pps_fund.Set(static_cast<double>(
+                database_->GetBalance(Ledger::LedgerAccount::PPS_FUND).balance));
+        }
+
+        for (const auto& entry : entries) {
+            if (entry.type == Ledger::LedgerType::POOL_FEE ||
+                entry.type == Ledger::LedgerType::PPS_FUNDING) continue;
+            auto it = miners_.find(entry.miner_id);
+            if (it == miners_.end()) continue;
+
+            Miner& miner = it->second;
+            if (database_) {
+                auto balance = database_->GetBalance(Ledger::LedgerAccount::MINER, entry.miner_id);
+                miner.unpaid_balance = static_cast<uint64_t>(std::max<int64_t>(balance.balance, 0));
+                miner.paid_balance = balance.debited;
+            } else if (entry.type == Ledger::LedgerType::PAYMENT) {
+                miner.unpaid_balance -= std::min(entry.amount, miner.unpaid_balance);
+                miner.paid_balance += entry.amount;
+            } else {
+                miner.unpaid_balance += entry.amount;
+            }
+            MarkMinerDirty(entry.miner_id);
+            UpdatePayable(entry.miner_id, miner);
+        }
+        return Result<void>::Ok();
+    }
+
+    /// Keep the payable index in step with a balance (caller holds mutex_)
+    void UpdatePayable(uint64_t miner_id, const Miner& miner) {
+        if (miner.unpaid_balance > 0 && miner.unpaid_balance >= config_.min_payout) {
+            payable_miners_.insert(miner_id);
+        } else {
+            payable_miners_.erase(miner_id);
+        }
+    }
+
+    /// Payout engine: balances due, read from the payable index so a run
+    /// costs O(payable miners) under the lock rather than O(miners)
+    std::vector<PayoutOutput> CollectPayouts() {
+        // Credit rounds that matured even if no tip notification arrived
+        CheckBlocks();
+        CheckChainBlocks();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Bring balances up to date with per-share credit
+        auto checkpoint = CheckpointPPS();
+        if (!checkpoint.IsOk()) {
+            LogF(LogLevel::ERROR, "Failed to record PPS credit: %s", checkpoint.error.c_str());
+        }
+
+        std::vector<PayoutOutput> due;
+        due.reserve(payable_miners_.size());
+        auto now = std::chrono::system_clock::now();
+        for (uint64_t miner_id : payable_miners_) {
+            auto it = miners_.find(miner_id);
+            if (it == miners_.end()) continue;
+            const Miner& miner = it->second;
+
+            // Check if enough time has passed since last payout
+            auto time_since_last = std::chrono::duration_cast<std::chrono::seconds>(
+                now - miner.last_payout).count();
+            if (time_since_last < static_cast<int64_t>(config_.payout_interval)) {
+                continue;
+            }
+            if (miner.payout_address.empty()) {
+                continue;
+            }
+
+            PayoutOutput output;
+            output.miner_id = miner_id;
+            output.address = miner.payout_address;
+            output.amount = miner.unpaid_balance;
+            due.push_back(output);
+        }
+
+        // Stable payment ids across runs regardless of hash order
+        std::sort(due.begin(), due.end(), [](const PayoutOutput& a, const PayoutOutput& b) {
+            return a.miner_id < b.miner_id;
+        });
+        return due;
+    }
+
+    /// Payout engine: debit every payment in one ledger batch, together
+    /// with its pending payment row, before any in-memory state changes; a
+    /// crash on either side leaves balances consistent and the payments
+    /// are sent on the next start
+    Result<std::vector<PayoutOutput>> DebitPayouts(std::vector<PayoutOutput> outputs) {
+        using Ledger = pool::PoolDatabase;
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto now = std::chrono::system_clock::now();
+        std::vector<Ledger::LedgerEntry> debits;
+        std::vector<Ledger::Payment> records;
+        debits.reserve(outputs.size());
+        records.reserve(outputs.size());
+        for (auto& output : outputs) {
+            output.payment_id = next_payment_id_++;
+
+            Ledger::LedgerEntry entry;
+            entry.key = "payment/" + std::to_string(output.payment_id);
+            entry.type = Ledger::LedgerType::PAYMENT;
+            entry.miner_id = output.miner_id;
+            entry.amount = output.amount;
+            entry.reference = output.payment_id;
+            entry.memo = output.address;
+            entry.timestamp = now;
+            debits.push_back(entry);
+
+            Ledger::Payment record;
+            record.payment_id = output.payment_id;
+            record.miner_id = output.miner_id;
+            record.address = output.address;
+            record.amount = output.amount;
+            record.timestamp = now;
+            record.status = "pending";
+            records.push_back(record);
+        }
+
+        auto posted = PostLedger(debits, records);
+        if (!posted.IsOk()) {
+            return Result<std::vector<PayoutOutput>>::Error(posted.error);
+        }
+
+        payment_history_.reserve(payment_history_.size() + outputs.size());
+        for (const auto& output : outputs) {
+            Payment payment{};
+            payment.payment_id = output.payment_id;
+            payment.miner_id = output.miner_id;
+            payment.payout_address = output.address;
+            payment.amount = output.amount;
+            payment.tx_hash.fill(0);  // Filled in when the transaction is sent
+            payment.created_at = now;
+            payment.is_confirmed = false;
+            payment.status = "pending";
+
+            payment_index_[payment.payment_id] = payment_history_.size();
+            payment_history_.push_back(payment);
+            miners_[payment.miner_id].last_payout = now;
+
+            if (payout_callback_) {
+                (*payout_callback_)(payment.miner_id, payment.amount);
+            }
+        }
+
+        LogF(LogLevel::INFO, "Debited %zu payouts", outputs.size());
+        return Result<std::vector<PayoutOutput>>::Ok(std::move(outputs));
+    }
+
+    /// Payout engine: a transaction was sent, confirmed, dropped or failed
+    Result<void> OnPaymentUpdate(const std::vector<Payment>& payments) {
+        std::vector<pool::PoolDatabase::Payment> records;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& update : payments) {
+                auto it = payment_index_.find(update.payment_id);
+                if (it == payment_index_.end()) continue;
+
+                Payment& payment = payment_history_[it->second];
+                payment.tx_hash = update.tx_hash;
+                payment.status = update.status;
+                payment.is_confirmed = update.is_confirmed;
+                if (update.is_confirmed) {
+                    payment.confirmed_at = update.confirmed_at;
+                }
+
+                if (database_) {
+                    records.push_back(ToPaymentRecord(payment));
+                }
+            }
+        }
+
+        // One durable write per transaction, outside the server lock
+        if (!records.empty() && database_) {
+            auto result = database_->RecordPayments(records);
+            if (!result.IsOk()) {
+                LogF(LogLevel::ERROR, "Failed to record payout transaction: %s", result.error.c_str());
+                return Result<void>::Error(result.error);
+            }
+        }
+        return Result<void>::Ok();
+    }
+
+    /// Payment row keyed by the ledger payment id
+    static pool::PoolDatabase::Payment ToPaymentRecord(const Payment& payment) {
+        pool::PoolDatabase::Payment record;
+        record.payment_id = payment.payment_id;
+        record.miner_id = payment.miner_id;
+        record.address = payment.payout_address;
+        record.amount = payment.amount;
+        record.txid = payment.tx_hash == uint256{} ? "" : ToHex(payment.tx_hash);
+        record.timestamp = payment.created_at;
+        record.status = payment.status;
+        return record;
+    }
+
+    /// Hand payments a previous run left unfinished back to the payout
+    /// engine, so a debit made before a crash is still paid (or held)
+    void LoadPayments() {
+        std::vector<Payment> unfinished;
+        for (const char* status : {"pending", "sending", "sent", "unknown"}) {
+            for (const auto& record : database_->GetPaymentsByStatus(status)) {
+                Payment payment{};
+                payment.payment_id = record.payment_id;
+                payment.miner_id = record.miner_id;
+                payment.payout_address = record.address;
+                payment.amount = record.amount;
+                payment.tx_hash = ParseTxHash(record.txid).value_or(uint256{});
+                payment.created_at = record.timestamp;
+                payment.is_confirmed = false;
+                payment.status = record.status;
+                unfinished.push_back(payment);
+            }
+        }
+        if (unfinished.empty()) return;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& payment : unfinished) {
+                if (payment_index_.contains(payment.payment_id)) continue;
+                payment_index_[payment.payment_id] = payment_history_.size();
+                payment_history_.push_back(payment);
+            }
+        }
+        payout_engine_->Restore(unfinished);
+        LogF(LogLevel::INFO, "Resuming %zu unfinished payments", unfinished.size());
+    }
+
+    /// Refresh the per-share rate for the next block (work is null before
+    /// the first job). FPPS adds smoothed template fees to the subsidy;
+    /// PPS and PPS+ pay the subsidy alone.
+    void RefreshPPSRate(const Work* work) {
+        uint64_t height = work ? work->height : chain_state_.GetHeight() + 1;
+        uint64_t reward = ConsensusValidator::GetBlockReward(height);
+        if (work) {
+            uint64_t fees = work->coinbase_value > reward ? work->coinbase_value - reward : 0;
+            fee_average_.Update(fees, std::chrono::steady_clock::now());
+        }
+        if (config_.payout_method == PoolConfig::PayoutMethod::FPPS) {
+            reward += fee_average_.Get();
+        }
+        pps_.SetRate(reward, chain_state_.GetDifficulty(), config_.pool_fee_percent);
+    }
+
+    /// Post whole units of accrued PPS credit to the ledger (caller holds
+    /// mutex_). Keys carry the journal seq the credit is complete through,
+    /// which recovery uses to skip shares already paid.
+    Result<void> CheckpointPPS() {
+        using Ledger = pool::PoolDatabase;
+        auto credits = pps_.Checkpoint();
+        if (credits.empty()) {
+            return Result<void>::Ok();
+        }
+
+        std::vector<Ledger::LedgerEntry> entries;
+        entries.reserve(credits.size());
+        auto now = std::chrono::system_clock::now();
+        for (const auto& [miner_id, amount] : credits) {
+            Ledger::LedgerEntry entry;
+            entry.key = "pps/" + std::to_string(applied_seq_) + "/" + std::to_string(miner_id);
+            entry.type = Ledger::LedgerType::PPS_CREDIT;
+            entry.miner_id = miner_id;
+            entry.amount = amount;
+            entry.reference = applied_seq_;
+            entry.timestamp = now;
+            entries.push_back(entry);
+        }
+
+        auto posted = PostLedger(entries);
+        if (!posted.IsOk()) {
+            pps_.Restore(credits);
+            return posted;
+        }
+        pps_checkpoint_seq_ = applied_seq_;
+        return Result<void>::Ok();
+    }
+
+    /// Record that a miner changed since the last snapshot, and queue its
+    /// counters for the database's next stats flush (caller holds mutex_)
+    void MarkMinerDirty(uint64_t miner_id) {
+        if (snapshot_store_) {
+            dirty_miners_.insert(miner_id);
+        }
+        if (database_) {
+            auto it = miners_.find(miner_id);
+            if (it != miners_.end()) {
+                database_->MarkMinerDirty(it->second);
+            }
+        }
+    }
+
+    /// Queue a worker's counters for the database's next stats flush
+    /// (caller holds mutex_)
+    void MarkWorkerDirty(uint64_t worker_id) {
+        if (database_) {
+            auto it = workers_.find(worker_id);
+            if (it != workers_.end()) {
+                database_->MarkWorkerDirty(it->second);
+            }
+        }
+    }
+
+    /// Write a miner's full record; identity, address and ban state change
+    /// rarely, unlike the counters MarkMinerDirty queues (caller holds mutex_)
+    void SaveMiner(uint64_t miner_id) {
+        auto it = miners_.find(miner_id);
+        if (!database_ || it == miners_.end()) return;
+        auto saved = database_->SaveMiner(it->second);
+        if (saved.IsError()) {
+            LogF(LogLevel::ERROR, "Failed to save miner %llu: %s",
+                 static_cast<unsigned long long>(miner_id), saved.error.c_str());
+        }
+    }
+
+    /// Write a new worker's full record so its id stays taken across
+    /// restarts (caller holds mutex_)
+    void SaveWorker(uint64_t worker_id) {
+        auto it = workers_.find(worker_id);
+        if (!database_ || it == workers_.end()) return;
+        auto saved = database_->SaveWorker(it->second);
+        if (saved.IsError()) {
+            LogF(LogLevel::ERROR, "Failed to save worker %llu: %s",
+                 static_cast<unsigned long long>(worker_id), saved.error.c_str());
+        }
+    }
+
+    /// Credit a share's difficulty to its worker, its miner and the pool
+    void CreditHashrate(uint64_t worker_id, uint64_t miner_id, uint64_t work,
+                        std::chrono::steady_clock::time_point now) {
+        pool_rate_.Add(work, now);
+        {
+            std::shared_lock<std::shared_mutex> lock(rate_mutex_);
+            auto worker = worker_rates_.find(worker_id);
+            auto miner = miner_rates_.find(miner_id);
+            if (worker != worker_rates_.end() && miner != miner_rates_.end()) {
+                worker->second->Add(work, now);
+                miner->second->Add(work, now);
+                return;
+            }
+        }
+
+        // First share from this worker or miner
+        std::unique_lock<std::shared_mutex> lock(rate_mutex_);
+        auto& worker = worker_rates_[worker_id];
+        if (!worker) worker = std::make_unique<HashrateMeter>();
+        auto& miner = miner_rates_[miner_id];
+        if (!miner) miner = std::make_unique<HashrateMeter>();
+        worker->Add(work, now);
+        miner->Add(work, now);
+    }
+
+    /// One worker's or miner's window (no need to hold mutex_)
+    WindowTotals TotalsOf(const RateMap& meters, uint64_t id, StatsWindow window,
+                         std::chrono::steady_clock::time_point now) {
+        std::shared_lock<std::shared_mutex> lock(rate_mutex_);
+        auto it = meters.find(id);
+        return it != meters.end() ? it->second->Get(window, now) : WindowTotals{};
+    }
+
+    /// Retarget a worker from its meter if it is due; returns the new
+    /// difficulty, or 0 if unchanged (caller holds mutex_)
+    uint64_t RetargetWorker(Worker& worker) {
+        auto now = std::chrono::system_clock::now();
+        WindowTotals recent = TotalsOf(worker_rates_, worker.worker_id, StatsWindow::FIVE_MINUTES,
+                                       std::chrono::steady_clock::now());
+        if (!vardiff_.ShouldAdjust(worker, recent, now)) return 0;
+
+        worker.last_retarget = now;
+        uint64_t old_diff = worker.current_difficulty;
+        uint64_t new_diff = vardiff_.CalculateDifficulty(worker, recent, now);
+        if (new_diff == old_diff) return 0;
+
+        worker.current_difficulty = new_diff;
+        MarkWorkerDirty(worker.worker_id);
+        LogF(LogLevel::DEBUG, "Adjusted worker %llu difficulty: %llu -> %llu",
+             static_cast<unsigned long long>(worker.worker_id),
+             static_cast<unsigned long long>(old_diff), static_cast<unsigned long long>(new_diff));
+        return new_diff;
+    }
+
+    /// Miners seen in the last ten minutes (caller holds mutex_)
+    std::vector<Miner> ActiveMiners() const {
+        std::vector<Miner> active;
+        auto now = std::chrono::system_clock::now();
+        for (const auto& [id, miner] : miners_) {
+            if (now - miner.last_seen < std::chrono::minutes(10)) {
+                active.push_back(miner);
+            }
+        }
+        return active;
+    }
+
+    /// Restore the newest snapshot, if any (before the journal is replayed)
+    void LoadSnapshot() {
+        snapshot_store_ = std::make_unique<pool::SnapshotStore>(
+            (std::filesystem::path(config_.data_dir) / "snapshots").string(),
+            config_.snapshots_to_keep);
+
+        auto loaded = snapshot_store_->LoadLatest();
+        if (!loaded.IsOk()) {
+            LogF(LogLevel::INFO, "Starting without snapshot (%s)", loaded.error.c_str());
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        snapshot_ = std::move(loaded.GetValue());
+
+        miners_ = snapshot_.miners;
+        username_to_miner_id_.clear();
+        payable_miners_.clear();
+        for (const auto& [miner_id, miner] : miners_) {
+            username_to_miner_id_.emplace(miner.username, miner_id);
+            UpdatePayable(miner_id, miner);
+        }
+
+        next_miner_id_ = snapshot_.next_miner_id;
+        next_worker_id_ = snapshot_.next_worker_id;
+        next_share_id_ = snapshot_.next_share_id;
+        next_round_id_ = snapshot_.next_round_id;
+        next_payment_id_ = snapshot_.next_payment_id;
+        current_round_ = snapshot_.current_round;
+        applied_seq_ = snapshot_.journal_seq;
+
+        LogF(LogLevel::INFO, "Loaded snapshot at journal seq %llu (%zu miners, round %llu)",
+             static_cast<unsigned long long>(snapshot_.journal_seq), miners_.size(),
+             static_cast<unsigned long long>(current_round_.round_id));
+    }
+
+    /// Add miners registered after the snapshot, and take counters flushed
+    /// after it, from the miners table; worker ids resume past the stored
+    /// ones (before the journal is replayed)
+    void LoadMiners() {
+        if (!database_) return;
+        auto stored = database_->LoadAllMiners();
+        uint64_t last_worker_id = database_->GetLastWorkerId();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t added = 0;
+        for (auto& miner : stored) {
+            auto it = miners_.find(miner.miner_id);
+            if (it == miners_.end()) {
+                uint64_t miner_id = miner.miner_id;
+                username_to_miner_id_.emplace(miner.username, miner_id);
+                UpdatePayable(miner_id, miner);
+                if (next_miner_id_ <= miner_id) next_miner_id_ = miner_id + 1;
+                miners_.emplace(miner_id, std::move(miner));
+                added++;
+            } else if (miner.total_shares_submitted > it->second.total_shares_submitted) {
+                Miner& current = it->second;
+                current.total_shares_submitted = miner.total_shares_submitted;
+                current.total_shares_accepted = miner.total_shares_accepted;
+                current.total_shares_rejected = miner.total_shares_rejected;
+                current.total_blocks_found = miner.total_blocks_found;
+                current.total_hashrate = miner.total_hashrate;
+                current.estimated_earnings = miner.estimated_earnings;
+                current.invalid_share_count = miner.invalid_share_count;
+                current.last_seen = miner.last_seen;
+            }
+        }
+        if (next_worker_id_ <= last_worker_id) next_worker_id_ = last_worker_id + 1;
+
+        if (added > 0) {
+            LogF(LogLevel::INFO, "Restored %zu miners registered since the snapshot", added);
+        }
+    }
+
+    /// Capture dirty state under the lock, then write it out unlocked
+    Result<void> TakeSnapshot() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            // Credit posted first keeps the snapshot seq at or below the
+            // checkpoint, so journal records it trims are never unpaid
+            auto checkpoint = CheckpointPPS();
+            if (!checkpoint.IsOk()) {
+                return Result<void>::Error("PPS checkpoint failed: " + checkpoint.error);
+            }
+
+            for (uint64_t miner_id : dirty_miners_) {
+                auto it = miners_.find(miner_id);
+                if (it == miners_.end()) {
+                    snapshot_.miners.erase(miner_id);
+                    continue;
+                }
+                Miner& copy = snapshot_.miners[miner_id];
+                copy = it->second;
+                copy.workers.clear();
+            }
+            dirty_miners_.clear();
+
+            snapshot_.journal_seq = applied_seq_;
+            snapshot_.created_at = std::chrono::system_clock::now();
+            snapshot_.next_miner_id = next_miner_id_;
+            snapshot_.next_worker_id = next_worker_id_;
+            snapshot_.next_share_id = next_share_id_;
+            snapshot_.next_round_id = next_round_id_;
+            snapshot_.next_payment_id = next_payment_id_;
+            snapshot_.current_round = current_round_;
+        }
+
+        auto result = snapshot_store_->Write(snapshot_);
+        if (!result.IsOk()) return result;
+
+        // Journal records covered by the snapshot (and archived) can go. The
+        // archive only appends contiguously, so its last seq is a safe bound;
+        // while it is behind, keep everything for the catch-up replay.
+        if (journal_) {
+            if (archive_behind_) return Result<void>::Ok();
+            uint64_t keep_after = snapshot_.journal_seq;
+            if (archive_) {
+                // Read the bound before syncing so every record below it is on disk
+                keep_after = std::min(keep_after, archive_->GetLastSeq());
+                auto synced = archive_->Sync();
+                if (!synced.IsOk()) return synced;
+            }
+            return journal_->TruncateBefore(keep_after);
+        }
+        return Result<void>::Ok();
+    }
+
+    /// Summarize closed rounds and drop raw shares past the PPLNS window
+    void CompactArchive() {
+        if (!archive_ || !journal_) return;
+
+        uint64_t through_round = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (current_round_.round_id > 0) through_round = current_round_.round_id - 1;
+        }
+
+        // Every share of a closed round must be archived before it is summarized
+        auto synced = journal_->Sync();
+        if (!synced.IsOk()) {
+            LogF(LogLevel::ERROR, "Compaction skipped: %s", synced.error.c_str());
+            return;
+        }
+
+        auto result = archive_->Compact(through_round, config_.pplns_window);
+        if (!result.IsOk()) {
+            LogF(LogLevel::ERROR, "Share archive compaction failed: %s", result.error.c_str());
+        } else if (result.GetValue() > 0) {
+            LogF(LogLevel::INFO, "Compacted share archive through round %llu (%zu segments dropped)",
+                 static_cast<unsigned long long>(through_round), result.GetValue());
+        }
+    }
+
+    void ChainStateLoop() {
+        std::unique_lock<std::mutex> lock(chain_mutex_);
+        while (!chain_stop_) {
+            chain_cv_.wait_for(lock, std::chrono::seconds(std::max<uint32_t>(config_.chain_refresh_secs, 1)),
+                               [this]() { return chain_stop_; });
+            if (chain_stop_) break;
+
+            lock.unlock();
+            if (chain_state_.Refresh()) {
+                LogF(LogLevel::INFO, "Chain tip moved to %llu without a notification",
+                     static_cast<unsigned long long>(chain_state_.GetHeight()));
+            }
+            lock.lock();
+        }
+    }
+
+    void SnapshotLoop() {
+        std::unique_lock<std::mutex> lock(snapshot_mutex_);
+        while (!snapshot_stop_) {
+            snapshot_cv_.wait_for(lock, std::chrono::seconds(config_.snapshot_interval_secs),
+                                  [this]() { return snapshot_stop_; });
+            if (snapshot_stop_) break;
+
+            lock.unlock();
+            auto result = TakeSnapshot();
+            if (!result.IsOk()) {
+                LogF(LogLevel::ERROR, "Snapshot failed: %s", result.error.c_str());
+            }
+            CompactArchive();
+            if (archive_) {
+                auto migrated = archive_->MigrateCold();
+                if (!migrated.IsOk()) {
+                    LogF(LogLevel::ERROR, "Cold share migration failed: %s", migrated.error.c_str());
+                }
+            }
+            lock.lock();
+        }
+    }
+
+    Result<void> OpenJournal() {
+        // Open the archive first: journal numbering must continue past it,
+        // since shares may have been imported straight into the archive
+        auto archive_result = OpenArchive();
+        if (!archive_result.IsOk()) {
+            return archive_result;
+        }
+
+        pool::ShareJournalOptions options;
+        options.dir = (std::filesystem::path(config_.data_dir) / "journal").string();
+        options.durable = config_.journal_durable;
+        options.commit_interval = std::chrono::milliseconds(config_.journal_commit_interval_ms);
+        options.commit_records = config_.journal_commit_records;
+        options.first_seq = archive_->GetLastSeq() + 1;
+
+        journal_ = std::make_unique<pool::ShareJournal>(options);
+        auto open_result = journal_->Open();
+        if (!open_result.IsOk()) {
+            journal_.reset();
+            archive_->Close();
+            archive_.reset();
+            return open_result;
+        }
+
+        auto replay_result = RecoverFromJournal();
+        if (replay_result.IsOk()) {
+            replay_result = CatchUpArchive();
+        }
+        if (replay_result.IsOk()) {
+            SeedPPLNSWindow();
+        }
+        if (!replay_result.IsOk()) {
+            journal_->Close();
+            journal_.reset();
+            archive_->Close();
+            archive_.reset();
+            return replay_result;
+        }
+
+        journal_->SetDurableCallback([this](const std::vector<pool::JournalRecord>& records) {
+            if (archive_) {
+                // Appending past a failed batch would leave a hole the archive's
+                // last seq hides, so refill it from the journal first. This
+                // batch is not durable yet, so the replay stops short of it.
+                auto archive_result = Result<void>::Ok();
+                if (archive_behind_) {
+                    archive_result = CatchUpArchive();
+                }
+                if (archive_result.IsOk()) {
+                    archive_result = archive_->Append(records);
+                }
+                archive_behind_ = !archive_result.IsOk();
+                if (!archive_result.IsOk()) {
+                    LogF(LogLevel::ERROR, "Share archive append failed (will catch up): %s",
+                         archive_result.error.c_str());
+                }
+            }
+            OnSharesDurable(records);
+        });
 
-    // Configuration
-    PoolConfig config_;
-    std::shared_ptr<Blockchain> blockchain_;
-    std::shared_ptr<Miner> solo_miner_;  // For solo mining mode
+        // 24h aggregates (top miners, share totals) come from the archive
+        if (database_) {
+            database_->SetShareArchive(archive_);
+        }
+        return Result<void>::Ok();
+    }
 
-    // Server state
-    std::atomic<bool> running_;
-    std::mutex mutex_;
+    /// Map the columnar archive
+    Result<void> OpenArchive() {
+        pool::ShareArchiveOptions options;
+        options.dir = (std::filesystem::path(config_.data_dir) / "archive").string();
+        options.cold_dir = config_.share_cold_dir.empty()
+            ? (std::filesystem::path(config_.data_dir) / "cold").string()
+            : config_.share_cold_dir;
+        options.hot_shares = std::max<size_t>(config_.pplns_window, options.hot_shares);
+        options.warm_retention = std::chrono::hours(config_.share_warm_hours);
+        options.raw_retention = std::chrono::hours(config_.share_raw_retention_hours);
+
+        archive_ = std::make_shared<pool::ShareArchive>(options);
+        auto open_result = archive_->Open();
+        if (!open_result.IsOk()) {
+            archive_.reset();
+            return open_result;
+        }
+        return Result<void>::Ok();
+    }
 
-    // Miners and workers
-    std::map<uint64_t, Miner> miners_;
-    std::map<std::string, uint64_t> username_to_miner_id_;
-    std::map<uint64_t, Worker> workers_;
-    std::map<uint64_t, uint64_t> worker_to_miner_;  // worker_id -> miner_id
-    std::atomic<uint64_t> next_miner_id_;
-    std::atomic<uint64_t> next_worker_id_;
+    /// Refill the PPLNS window and decayed scores from the archive, oldest share first
+    void SeedPPLNSWindow() {
+        struct Seed {
+            uint64_t miner_id;
+            int64_t timestamp_ms;
+            uint64_t difficulty;
+        };
+        std::vector<Seed> shares;
+        shares.reserve(pplns_.Capacity());
+        archive_->ForEachLastShare(pplns_.Capacity(),
+                                   [&](uint64_t miner_id, int64_t timestamp_ms, uint64_t difficulty) {
+            shares.push_back(Seed{miner_id, timestamp_ms, difficulty});
+        });
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        pplns_.Clear();
+        decayed_.Clear();
+        for (auto it = shares.rbegin(); it != shares.rend(); ++it) {
+            pplns_.Add(it->miner_id, it->difficulty);
+            decayed_.Add(it->miner_id, it->difficulty, it->timestamp_ms);
+        }
+    }
 
-    // Shares and rounds
-    std::vector<Share> recent_shares_;
-    std::atomic<uint64_t> next_share_id_;
-    RoundStatistics current_round_;
-    std::vector<RoundStatistics> round_history_;
-    std::atomic<uint64_t> next_round_id_;
+    /// Append journal records the archive has not seen yet
+    Result<void> CatchUpArchive() {
+        std::vector<pool::JournalRecord> batch;
+        Result<void> append_result = Result<void>::Ok();
+        auto replay_result = journal_->Replay(archive_->GetLastSeq(), [&](const pool::JournalRecord& rec) {
+            batch.push_back(rec);
+            if (batch.size() >= 4096) {
+                if (append_result.IsOk()) append_result = archive_->Append(batch);
+                batch.clear();
+            }
+        });
+        if (append_result.IsOk() && !batch.empty()) {
+            append_result = archive_->Append(batch);
+        }
 
-    // Payment tracking
-    std::vector<Payment> payment_history_;
-    std::atomic<uint64_t> next_payment_id_;
+        return replay_result.IsOk() ? append_result : replay_result;
+    }
 
-    // Current work
-    std::optional<Work> current_work_;
-    std::mutex work_mutex_;
+    /// Rebuild the open round and recent shares from the journal
+    /// (on top of the loaded snapshot, if any)
+    Result<void> RecoverFromJournal() {
+        std::lock_guard<std::mutex> lock(mutex_);
 
-    // Variable difficulty
-    VarDiffManager vardiff_;
+        RoundStatistics round = current_round_;
+        bool round_closed = false;
+        uint64_t max_share_id = 0;
+        uint64_t replayed = 0;
 
-    // Statistics
-    PoolStatistics stats_;
-    std::chrono::system_clock::time_point start_time_;
+        auto result = journal_->Replay(applied_seq_, [&](const pool::JournalRecord& rec) {
+            applied_seq_ = rec.seq;
 
-    // Security - banned miners and IPs
-    std::map<std::string, std::chrono::system_clock::time_point> banned_ips_;
-    std::mutex security_mutex_;
+            auto timestamp = std::chrono::system_clock::time_point(
+                std::chrono::milliseconds(rec.timestamp_ms));
 
-    // Callbacks
-    std::optional<MiningPoolServer::BlockFoundCallback> block_found_callback_;
-    std::optional<MiningPoolServer::PayoutCallback> payout_callback_;
+            if (rec.round_id > round.round_id) {
+                round = RoundStatistics();
+                round.round_id = rec.round_id;
+                round.started_at = timestamp;
+                round.is_complete = false;
+                round_closed = false;
+            }
 
-    // Network servers (raw pointers due to forward declarations)
-    stratum::StratumServer* stratum_server_;
-    pool::HttpApiServer* http_api_server_;
+            if (rec.flags & pool::JOURNAL_ROUND_END) {
+                round_closed = rec.round_id == round.round_id;
+                return;
+            }
 
-    void Stop() {
-        running_ = false;
+            replayed++;
+            max_share_id = std::max(max_share_id, rec.share_id);
+            if (rec.round_id == round.round_id && (rec.flags & pool::JOURNAL_SHARE_VALID)) {
+                round.shares_submitted++;
+                round.total_work += rec.difficulty;
+                round.miner_shares[rec.miner_id]++;
+            }
+            if ((rec.flags & pool::JOURNAL_SHARE_VALID) && rec.seq > pps_checkpoint_seq_ &&
+                IsPerShareMethod(config_.payout_method)) {
+                pps_.Credit(rec.miner_id, rec.difficulty);
+            }
 
-        // Stop and delete network servers
-        if (stratum_server_) {
-            stratum::DestroyStratumServer(stratum_server_);
-            stratum_server_ = nullptr;
+            Share share{};
+            share.share_id = rec.share_id;
+            share.miner_id = rec.miner_id;
+            share.worker_id = rec.worker_id;
+            share.difficulty = rec.difficulty;
+            share.timestamp = timestamp;
+            share.valid = rec.flags & pool::JOURNAL_SHARE_VALID;
+            share.is_block = rec.flags & pool::JOURNAL_SHARE_BLOCK;
+            recent_shares_.push_back(share);
+
+            if (recent_shares_.size() > 10000) {
+                recent_shares_.erase(recent_shares_.begin(), recent_shares_.begin() + 1000);
+            }
+        });
+        if (!result.IsOk()) return result;
+
+        if (round.round_id > 0) {
+            if (round_closed) {
+                current_round_ = RoundStatistics();
+                current_round_.round_id = round.round_id + 1;
+                current_round_.started_at = std::chrono::system_clock::now();
+                current_round_.is_complete = false;
+            } else {
+                current_round_ = round;
+            }
+            next_round_id_ = std::max<uint64_t>(next_round_id_, current_round_.round_id + 1);
         }
-        if (http_api_server_) {
-            pool::DestroyHttpApiServer(http_api_server_);
-            http_api_server_ = nullptr;
+        next_share_id_ = std::max<uint64_t>(next_share_id_, max_share_id + 1);
+
+        if (replayed > 0) {
+            LogF(LogLevel::INFO, "Recovered %llu shares from journal (round %llu, %llu shares)",
+                 static_cast<unsigned long long>(replayed),
+                 static_cast<unsigned long long>(current_round_.round_id),
+                 static_cast<unsigned long long>(current_round_.shares_submitted));
         }
+        return Result<void>::Ok();
     }
 };
 
@@ -627,6 +3121,39 @@ Result<void> MiningPoolServer::Start() {
 
     impl_->running_ = true;
 
+    // Replayed shares accrue PPS credit at the current rate
+    impl_->chain_state_.Refresh();
+    impl_->RefreshPPSRate(nullptr);
+
+    // Load the last snapshot, then replay the share journal on top of it
+    if (!impl_->config_.data_dir.empty()) {
+        impl_->storage_closing_ = false;
+        auto db_result = impl_->OpenDatabase();
+        if (!db_result.IsOk()) {
+            impl_->running_ = false;
+            return Result<void>::Error("Failed to open pool database: " + db_result.error);
+        }
+
+        impl_->LoadSnapshot();
+        impl_->LoadMiners();
+
+        auto journal_result = impl_->OpenJournal();
+        if (!journal_result.IsOk()) {
+            impl_->snapshot_store_.reset();
+            impl_->database_->Close();
+            impl_->database_.reset();
+            impl_->running_ = false;
+            return Result<void>::Error("Failed to open share journal: " + journal_result.error);
+        }
+
+        impl_->ReconcileLedger();
+        impl_->LoadBlocks();
+        impl_->LoadPayments();
+
+        impl_->snapshot_stop_ = false;
+        impl_->snapshot_thread_ = std::thread([this]() { impl_->SnapshotLoop(); });
+    }
+
     // Create initial work
     auto work_result = CreateWork(false);
     if (!work_result.IsOk()) {
@@ -660,6 +3187,12 @@ Result<void> MiningPoolServer::Start() {
         return Result<void>::Error("Failed to start HTTP API server: " + http_result.error);
     }
 
+    // Pay balances due every payout_interval
+    impl_->payout_engine_->Start();
+
+    impl_->chain_stop_ = false;
+    impl_->chain_thread_ = std::thread([this]() { impl_->ChainStateLoop(); });
+
     return Result<void>::Ok();
 }
 
@@ -708,6 +3241,8 @@ Result<uint64_t> MiningPoolServer::RegisterMiner(const std::string& username,
 
     impl_->miners_[miner.miner_id] = miner;
     impl_->username_to_miner_id_[username] = miner.miner_id;
+    impl_->MarkMinerDirty(miner.miner_id);
+    impl_->SaveMiner(miner.miner_id);
 
     return Result<uint64_t>::Ok(miner.miner_id);
 }
@@ -739,7 +3274,18 @@ Result<void> MiningPoolServer::UpdatePayoutAddress(uint64_t miner_id,
         return Result<void>::Error("Miner not found");
     }
 
+    // Write the record first so the address index never lags the pool
+    if (impl_->database_) {
+        Miner updated = it->second;
+        updated.payout_address = new_address;
+        auto saved = impl_->database_->SaveMiner(updated);
+        if (saved.IsError()) {
+            return Result<void>::Error(saved.error);
+        }
+    }
+
     it->second.payout_address = new_address;
+    impl_->MarkMinerDirty(miner_id);
     return Result<void>::Ok();
 }
 
@@ -754,16 +3300,7 @@ std::vector<Miner> MiningPoolServer::GetAllMiners() const {
 
 std::vector<Miner> MiningPoolServer::GetActiveMiners() const {
     std::lock_guard<std::mutex> lock(impl_->mutex_);
-    std::vector<Miner> active_miners;
-    auto now = std::chrono::system_clock::now();
-    auto timeout = std::chrono::minutes(10);
-
-    for (const auto& [id, miner] : impl_->miners_) {
-        if (now - miner.last_seen < timeout) {
-            active_miners.push_back(miner);
-        }
-    }
-    return active_miners;
+    return impl_->ActiveMiners();
 }
 
 // Worker Management
@@ -800,12 +3337,14 @@ Result<uint64_t> MiningPoolServer::AddWorker(uint64_t miner_id,
     worker.ip_address = ip_address;
     worker.port = port;
     worker.connected_at = std::chrono::system_clock::now();
+    worker.last_retarget = worker.connected_at;
     worker.last_activity = std::chrono::system_clock::now();
     worker.is_active = true;
 
     impl_->workers_[worker.worker_id] = worker;
     impl_->worker_to_miner_[worker.worker_id] = miner_id;
     miner_it->second.workers[worker.worker_id] = worker;
+    impl_->SaveWorker(worker.worker_id);
 
     return Result<uint64_t>::Ok(worker.worker_id);
 }
@@ -826,6 +3365,9 @@ void MiningPoolServer::RemoveWorker(uint64_t worker_id) {
 
     impl_->workers_.erase(worker_id);
     impl_->worker_to_miner_.erase(worker_id);
+
+    std::unique_lock<std::shared_mutex> rate_lock(impl_->rate_mutex_);
+    impl_->worker_rates_.erase(worker_id);
 }
 
 std::optional<Worker> MiningPoolServer::GetWorker(uint64_t worker_id) const {
@@ -881,7 +3423,9 @@ Result<void> MiningPoolServer::SubmitShare(uint64_t worker_id,
                                             const uint256& nonce,
                                             const uint256& share_hash)
 {
-    std::lock_guard<std::mutex> lock(impl_->mutex_);
+    auto wait_start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(impl_->mutex_);
+    impl_->metrics_.lock_wait.Record(std::chrono::steady_clock::now() - wait_start);
 
     // Get worker
     auto worker_it = impl_->workers_.find(worker_id);
@@ -910,7 +3454,44 @@ Result<void> MiningPoolServer::SubmitShare(uint64_t worker_id,
     share.valid = false;
 
     // Validate share
+    auto validate_start = std::chrono::steady_clock::now();
     auto validation_result = ValidateShare(share);
+    impl_->metrics_.share_validation.Record(std::chrono::steady_clock::now() - validate_start);
+
+    // Jobs from other chains are accounted by their chain, which may talk
+    // to its daemon, so the pool lock is released first. The share goes
+    // into the recent set before that, so a replay is caught as a duplicate.
+    if (validation_result.IsOk() && JobScheduler::ChainOf(job_id) != JobScheduler::kPrimaryChain) {
+        impl_->recent_shares_.push_back(share);
+        if (impl_->recent_shares_.size() > 10000) {
+            impl_->recent_shares_.erase(impl_->recent_shares_.begin(),
+                                        impl_->recent_shares_.begin() + 1000);
+        }
+        lock.unlock();
+        auto routed = impl_->scheduler_.SubmitShare(share);
+        lock.lock();
+
+        worker_it = impl_->workers_.find(worker_id);
+        miner_it = impl_->miners_.find(miner_id);
+        if (worker_it == impl_->workers_.end() || miner_it == impl_->miners_.end()) {
+            return routed.IsOk() ? Result<void>::Ok() : Result<void>::Error("Share rejected: " + routed.error);
+        }
+        if (!routed.IsOk()) {
+            validation_result = Result<bool>::Error(routed.error);
+        } else {
+            impl_->CreditHashrate(worker_id, miner_id, share.difficulty, std::chrono::steady_clock::now());
+            worker_it->second.shares_submitted++;
+            worker_it->second.shares_accepted++;
+            miner_it->second.total_shares_submitted++;
+            miner_it->second.total_shares_accepted++;
+            miner_it->second.invalid_share_count = 0;
+            miner_it->second.last_seen = share.timestamp;
+            impl_->MarkWorkerDirty(worker_id);
+            impl_->MarkMinerDirty(miner_id);
+            return Result<void>::Ok();
+        }
+    }
+
     if (!validation_result.IsOk()) {
         share.valid = false;
         share.error_msg = validation_result.error;
@@ -921,6 +3502,8 @@ Result<void> MiningPoolServer::SubmitShare(uint64_t worker_id,
 
         // Check for excessive invalid shares
         miner_it->second.invalid_share_count++;
+        impl_->MarkWorkerDirty(worker_id);
+        impl_->MarkMinerDirty(miner_id);
         CheckInvalidShares(miner_id);
 
         return Result<void>::Error("Share rejected: " + validation_result.error);
@@ -932,7 +3515,7 @@ Result<void> MiningPoolServer::SubmitShare(uint64_t worker_id,
         ProcessValidShare(share);
 
         // Check if this is also a valid block
-        auto network_difficulty = impl_->blockchain_->GetDifficulty();
+        auto network_difficulty = impl_->chain_state_.GetDifficulty();
         if (ShareValidator::IsValidBlock(share_hash, network_difficulty)) {
             share.is_block = true;
             auto block_result = ProcessBlockFound(share);
@@ -952,17 +3535,34 @@ Result<void> MiningPoolServer::SubmitShare(uint64_t worker_id,
                                     impl_->recent_shares_.begin() + 1000);
     }
 
+    // New work goes out with no pool lock held: building it takes the work
+    // lock, and solo notifies read miners back through the pool
+    if (share.is_block) {
+        lock.unlock();
+        UpdateWork();
+    }
+
     return Result<void>::Ok();
 }
 
 Result<bool> MiningPoolServer::ValidateShare(const Share& share) {
-    // Get current work
-    std::lock_guard<std::mutex> work_lock(impl_->work_mutex_);
-    if (!impl_->current_work_.has_value()) {
-        return Result<bool>::Error("No current work available");
+    // Jobs from other chains are checked against their chain's template
+    std::shared_ptr<const Work> chain_work;
+    std::unique_lock<std::mutex> work_lock(impl_->work_mutex_, std::defer_lock);
+    ChainId chain = JobScheduler::ChainOf(share.job_id);
+    if (chain != JobScheduler::kPrimaryChain) {
+        chain_work = impl_->scheduler_.GetWork(chain);
+        if (!chain_work) {
+            return Result<bool>::Error("Unknown job");
+        }
+    } else {
+        work_lock.lock();
+        if (!impl_->current_work_.has_value()) {
+            return Result<bool>::Error("No current work available");
+        }
     }
 
-    const Work& work = *impl_->current_work_;
+    const Work& work = chain_work ? *chain_work : *impl_->current_work_;
 
     // Validate difficulty
     if (!ShareValidator::ValidateDifficulty(share.share_hash, share.difficulty)) {
@@ -988,25 +3588,26 @@ Result<bool> MiningPoolServer::ValidateShare(const Share& share) {
 }
 
 void MiningPoolServer::ProcessValidShare(const Share& share) {
+    // Credited by the share's own difficulty, so retargets do not skew it
+    auto now = std::chrono::steady_clock::now();
+    impl_->CreditHashrate(share.worker_id, share.miner_id, share.difficulty, now);
+
     // Update worker statistics
     auto worker_it = impl_->workers_.find(share.worker_id);
     if (worker_it != impl_->workers_.end()) {
         worker_it->second.shares_submitted++;
         worker_it->second.shares_accepted++;
-        worker_it->second.recent_shares.push_back(share.timestamp);
-
-        // Keep only last 100 shares for hashrate calculation
-        if (worker_it->second.recent_shares.size() > 100) {
-            worker_it->second.recent_shares.erase(worker_it->second.recent_shares.begin());
-        }
+        worker_it->second.last_share_time = share.timestamp;
 
-        // Update hashrate
-        worker_it->second.current_hashrate = CalculateWorkerHashrate(share.worker_id);
+        worker_it->second.current_hashrate =
+            impl_->TotalsOf(impl_->worker_rates_, share.worker_id, StatsWindow::TEN_MINUTES, now).hashrate;
 
-        // Update difficulty if needed
-        if (impl_->vardiff_.ShouldAdjust(worker_it->second)) {
-            AdjustWorkerDifficulty(share.worker_id);
+        // Update difficulty if needed (mutex_ is already held)
+        uint64_t new_diff = impl_->RetargetWorker(worker_it->second);
+        if (new_diff != 0) {
+            SendSetDifficulty(share.worker_id, new_diff);
         }
+        impl_->MarkWorkerDirty(share.worker_id);
     }
 
     // Update miner statistics
@@ -1014,15 +3615,17 @@ void MiningPoolServer::ProcessValidShare(const Share& share) {
     if (miner_it != impl_->miners_.end()) {
         miner_it->second.total_shares_submitted++;
         miner_it->second.total_shares_accepted++;
+        miner_it->second.total_hashrate =
+            impl_->TotalsOf(impl_->miner_rates_, share.miner_id, StatsWindow::TEN_MINUTES, now).hashrate;
         miner_it->second.last_seen = std::chrono::system_clock::now();
 
         // Reset invalid share count on valid share
         miner_it->second.invalid_share_count = 0;
+        impl_->MarkMinerDirty(share.miner_id);
     }
 
-    // Update round statistics
-    impl_->current_round_.shares_submitted++;
-    impl_->current_round_.miner_shares[share.miner_id]++;
+    // Update round statistics (deferred until the share is durable)
+    impl_->AccountShare(share);
 
     // Update pool statistics
     impl_->stats_.shares_this_round++;
@@ -1049,25 +3652,41 @@ Result<void> MiningPoolServer::ProcessBlockFound(const Share& share) {
     block.header.nonce = nonce_u64;
     block.transactions = work.transactions;
 
+    // A solo miner was hashing a header committing to their own coinbase
+    if (impl_->config_.payout_method == PoolConfig::PayoutMethod::SOLO) {
+        auto finder = impl_->miners_.find(share.miner_id);
+        if (finder == impl_->miners_.end()) {
+            return Result<void>::Error("Miner not found");
+        }
+        auto job = impl_->solo_jobs_.GetJob(share.miner_id, finder->second.payout_address);
+        if (!job.IsOk()) {
+            return Result<void>::Error("No solo job for block: " + job.error);
+        }
+        block.transactions[0] = job.GetValue()->coinbase;
+        block.header.merkle_root = job.GetValue()->merkle_root;
+    }
+
     // Submit block to blockchain
     auto submit_result = impl_->blockchain_->AddBlock(block);
     if (!submit_result.IsOk()) {
         return Result<void>::Error("Failed to submit block: " + submit_result.error);
     }
+    impl_->metrics_.blocks_found.Inc();
 
     // Update statistics
     auto worker_it = impl_->workers_.find(share.worker_id);
     if (worker_it != impl_->workers_.end()) {
         worker_it->second.blocks_found++;
+        impl_->MarkWorkerDirty(share.worker_id);
     }
 
     auto miner_it = impl_->miners_.find(share.miner_id);
     if (miner_it != impl_->miners_.end()) {
         miner_it->second.total_blocks_found++;
+        impl_->MarkMinerDirty(share.miner_id);
     }
 
     impl_->stats_.blocks_found++;
-    impl_->stats_.blocks_pending++;
     impl_->stats_.last_block_found = std::chrono::system_clock::now();
 
     // Complete current round
@@ -1075,12 +3694,89 @@ Result<void> MiningPoolServer::ProcessBlockFound(const Share& share) {
     impl_->current_round_.block_height = work.height;
     impl_->current_round_.block_hash = block.GetHash();
 
-    // Calculate block reward (simplified - actual reward depends on height)
-    uint64_t block_reward = 50 * 100000000ULL;  // 50 INTS in base units
+    // Subsidy plus fees of the template the block was built from
+    uint64_t block_reward = work.coinbase_value;
     impl_->current_round_.block_reward = block_reward;
     impl_->current_round_.is_complete = true;
 
+    // Split the reward now, while the window still reflects this round;
+    // the credit is posted once the block matures
+    {
+        double fee_percent = impl_->config_.pool_fee_percent;
+
+        std::map<uint64_t, uint64_t> payouts;
+        MinerCredits credits;
+        uint64_t prepaid = 0;       // Already paid to miners per share
+        switch (impl_->config_.payout_method) {
+            case PoolConfig::PayoutMethod::PPLNS:
+                // The window's running per-miner sums, split by the exact
+                // kernel: O(miners in window), independent of N
+                credits = PayoutCalculator::DistributeDense(impl_->pplns_.GetDenseMinerWork(),
+                                                            block_reward, fee_percent);
+                break;
+            case PoolConfig::PayoutMethod::PPLNS_DECAYED:
+                payouts = PayoutCalculator::DistributeReward(impl_->decayed_.GetMinerWeights(),
+                                                             block_reward, fee_percent);
+                break;
+            case PoolConfig::PayoutMethod::PROP:
+                payouts = PayoutCalculator::DistributeReward(impl_->current_round_.miner_shares,
+                                                             block_reward, fee_percent);
+                break;
+            case PoolConfig::PayoutMethod::SOLO: {
+                // The coinbase paid the finder (and the fee) directly;
+                // only their own round restarts
+                SoloRound& round = impl_->solo_rounds_[share.miner_id];
+                round.miner_id = share.miner_id;
+                round.shares = 0;
+                round.work = 0;
+                round.blocks_found++;
+                round.started_at = impl_->current_round_.ended_at;
+                break;
+            }
+            case PoolConfig::PayoutMethod::PPS_PLUS: {
+                // Subsidy was paid per share; the block's actual fees go PPLNS
+                prepaid = std::min(ConsensusValidator::GetBlockReward(work.height), block_reward);
+                payouts = PayoutCalculator::DistributeReward(impl_->pplns_.GetMinerWork(),
+                                                             block_reward - prepaid, fee_percent);
+                break;
+            }
+            case PoolConfig::PayoutMethod::PPS:
+            case PoolConfig::PayoutMethod::FPPS:
+                prepaid = block_reward;  // Miners were paid per share
+                break;
+        }
+
+        FoundBlock found;
+        found.round_id = impl_->current_round_.round_id;
+        found.height = work.height;
+        found.hash = impl_->current_round_.block_hash;
+        found.reward = block_reward;
+        found.finder_id = share.miner_id;
+        found.found_at = impl_->current_round_.ended_at;
+
+        for (const auto& [miner_id, amount] : payouts) {
+            if (amount == 0) continue;
+            credits.emplace_back(miner_id, amount);
+        }
+        found.credits = std::move(credits);
+        PayoutCalculator::SettleBlockValue(found, prepaid, fee_percent);
+        impl_->TrackBlock(std::move(found));
+    }
+
+    // Persisted before the round end is journaled, so a restart never
+    // loses a closed round's work
+    impl_->luck_.Close(impl_->current_round_);
+    if (impl_->database_) {
+        auto saved = impl_->database_->SaveRound(impl_->current_round_);
+        if (saved.IsError()) {
+            LogF(LogLevel::ERROR, "Failed to save round %llu: %s",
+                 static_cast<unsigned long long>(impl_->current_round_.round_id), saved.error.c_str());
+        }
+    }
     impl_->round_history_.push_back(impl_->current_round_);
+    if (impl_->journal_) {
+        impl_->journal_->AppendRoundEnd(impl_->current_round_.round_id);
+    }
 
     // Start new round
     impl_->current_round_ = RoundStatistics();
@@ -1093,9 +3789,6 @@ Result<void> MiningPoolServer::ProcessBlockFound(const Share& share) {
         (*impl_->block_found_callback_)(block, share.miner_id);
     }
 
-    // Create new work
-    UpdateWork();
-
     return Result<void>::Ok();
 }
 
@@ -1127,6 +3820,7 @@ std::vector<Share> MiningPoolServer::GetMinerShares(uint64_t miner_id, size_t co
 // Work Management
 Result<Work> MiningPoolServer::CreateWork(bool clean_jobs) {
     std::lock_guard<std::mutex> work_lock(impl_->work_mutex_);
+    pool::MetricTimer timer(impl_->metrics_.template_build);
 
     // Get block template from blockchain
     // TODO: Use proper wallet/keypair for pool rewards
@@ -1146,14 +3840,30 @@ Result<Work> MiningPoolServer::CreateWork(bool clean_jobs) {
     work.job_id = GenerateJobID();
     work.header = block_template.header;
     work.coinbase_tx = block_template.transactions[0];
+    work.coinbase_value = 0;
+    for (const auto& out : work.coinbase_tx.outputs) {
+        work.coinbase_value += out.value;
+    }
     work.transactions = block_template.transactions;
     work.merkle_root = block_template.header.merkle_root;
-    work.height = impl_->blockchain_->GetBestHeight() + 1;  // Next block height
-    work.difficulty = impl_->blockchain_->GetDifficulty();
+
+    // A new template usually means a new tip; re-read it once for everyone
+    impl_->chain_state_.Refresh();
+    ChainState chain = impl_->chain_state_.Get();
+    work.height = chain.height + 1;  // Next block height
+    work.difficulty = chain.difficulty;
     work.created_at = std::chrono::system_clock::now();
     work.clean_jobs = clean_jobs;
+    work = impl_->scheduler_.SetWork(JobScheduler::kPrimaryChain, std::move(work)).GetValue();
 
     impl_->current_work_ = work;
+    impl_->RefreshPPSRate(&work);
+
+    if (impl_->config_.payout_method == PoolConfig::PayoutMethod::SOLO && !work.transactions.empty()) {
+        impl_->solo_jobs_.SetWork(work.job_id, work.coinbase_tx,
+                                  std::span<const Transaction>(work.transactions).subspan(1),
+                                  impl_->config_.pool_fee_percent);
+    }
 
     return Result<Work>::Ok(work);
 }
@@ -1169,12 +3879,21 @@ Result<void> MiningPoolServer::UpdateWork() {
         return Result<void>::Error("Failed to create new work: " + work_result.error);
     }
 
-    // Broadcast new work to all miners
+    // A new template may change which chain is most profitable
+    if (impl_->scheduler_.Rebalance()) {
+        return BroadcastActiveChain();
+    }
     BroadcastWork(work_result.GetValue());
-
     return Result<void>::Ok();
 }
 
+Result<void> MiningPoolServer::NotifyNewTip() {
+    impl_->chain_state_.Refresh();
+    impl_->CheckBlocks();
+    impl_->CheckChainBlocks();
+    return UpdateWork();
+}
+
 void MiningPoolServer::BroadcastWork(const Work& work) {
     // Broadcast work to all connected miners via Stratum
     if (impl_->stratum_server_) {
@@ -1182,6 +3901,115 @@ void MiningPoolServer::BroadcastWork(const Work& work) {
     }
 }
 
+Result<ChainId> MiningPoolServer::AddChain(const ChainConfig& config, std::shared_ptr<ChainBackend> backend) {
+    if (!backend) {
+        return Result<ChainId>::Error("Chain needs a backend");
+    }
+    ChainId chain = impl_->scheduler_.AddChain(config, std::move(backend));
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex_);
+        impl_->RestoreChainBlocks();
+    }
+    auto refreshed = RefreshChain(chain);
+    if (!refreshed.IsOk()) {
+        // Registered anyway; it takes hashrate once a refresh succeeds
+        LogF(LogLevel::WARNING, "No template yet for chain %s: %s",
+             config.name.c_str(), refreshed.error.c_str());
+    }
+    return Result<ChainId>::Ok(chain);
+}
+
+Result<void> MiningPoolServer::RefreshChain(ChainId chain) {
+    if (chain == JobScheduler::kPrimaryChain) {
+        return UpdateWork();
+    }
+
+    auto work = impl_->scheduler_.Refresh(chain);
+    if (!work.IsOk()) {
+        return Result<void>::Error("Failed to refresh chain: " + work.error);
+    }
+    impl_->CheckChainBlocks();
+    if (impl_->scheduler_.Rebalance()) {
+        return BroadcastActiveChain();
+    }
+
+    // Stratum only passes it on to ports mining this chain
+    BroadcastWork(work.GetValue());
+    return Result<void>::Ok();
+}
+
+Result<void> MiningPoolServer::RebalanceChains() {
+    if (!impl_->scheduler_.Rebalance()) {
+        return Result<void>::Ok();
+    }
+    return BroadcastActiveChain();
+}
+
+Result<void> MiningPoolServer::BroadcastActiveChain() {
+    // The active chain's template is already held, so the switch is one
+    // notify; shares in flight for the old chain still route to it
+    auto work = impl_->scheduler_.GetWork(impl_->scheduler_.GetActiveChain());
+    if (!work) {
+        return Result<void>::Error("Active chain has no work");
+    }
+    Work clean = *work;
+    clean.clean_jobs = true;
+    BroadcastWork(clean);
+    return Result<void>::Ok();
+}
+
+std::optional<Work> MiningPoolServer::GetWorkForPort(uint16_t port) const {
+    auto work = impl_->scheduler_.GetWork(impl_->scheduler_.GetChainForPort(port));
+    if (!work) {
+        return std::nullopt;
+    }
+    return *work;
+}
+
+ChainId MiningPoolServer::GetChainForPort(uint16_t port) const {
+    return impl_->scheduler_.GetChainForPort(port);
+}
+
+std::vector<ChainStatistics> MiningPoolServer::GetChainStatistics() const {
+    auto stats = impl_->scheduler_.GetStatistics();
+
+    // The pool's own chain keeps its round and balances in the pool
+    std::lock_guard<std::mutex> lock(impl_->mutex_);
+    ChainStatistics& primary = stats[JobScheduler::kPrimaryChain];
+    primary.round_id = impl_->current_round_.round_id;
+    primary.round_shares = impl_->current_round_.shares_submitted;
+    primary.round_work = impl_->pplns_.GetTotalWork();
+    primary.blocks_found = impl_->stats_.blocks_found;
+    primary.unpaid = 0;
+    for (const auto& [miner_id, miner] : impl_->miners_) {
+        primary.unpaid += miner.unpaid_balance;
+    }
+    return stats;
+}
+
+Result<std::shared_ptr<const SoloJob>> MiningPoolServer::GetSoloJob(uint64_t worker_id) {
+    using JobResult = Result<std::shared_ptr<const SoloJob>>;
+    uint64_t miner_id;
+    std::string address;
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex_);
+        if (impl_->config_.payout_method != PoolConfig::PayoutMethod::SOLO) {
+            return JobResult::Error("Pool is not in solo mode");
+        }
+        auto owner = impl_->worker_to_miner_.find(worker_id);
+        if (owner == impl_->worker_to_miner_.end()) {
+            return JobResult::Error("Worker not found");
+        }
+        auto miner_it = impl_->miners_.find(owner->second);
+        if (miner_it == impl_->miners_.end()) {
+            return JobResult::Error("Miner not found");
+        }
+        miner_id = owner->second;
+        address = miner_it->second.payout_address;
+    }
+    return impl_->solo_jobs_.GetJob(miner_id, address);
+}
+
 // Configuration
 const PoolConfig& MiningPoolServer::GetConfig() const {
     return impl_->config_;
@@ -1190,6 +4018,11 @@ const PoolConfig& MiningPoolServer::GetConfig() const {
 void MiningPoolServer::UpdateConfig(const PoolConfig& config) {
     std::lock_guard<std::mutex> lock(impl_->mutex_);
     impl_->config_ = config;
+
+    // The payout threshold may have moved
+    for (const auto& [miner_id, miner] : impl_->miners_) {
+        impl_->UpdatePayable(miner_id, miner);
+    }
 }
 
 // Callbacks
@@ -1201,11 +4034,17 @@ void MiningPoolServer::RegisterPayoutCallback(PayoutCallback callback) {
     impl_->payout_callback_ = callback;
 }
 
+void MiningPoolServer::SetPayoutSender(std::shared_ptr<PayoutSender> sender) {
+    impl_->payout_engine_->SetSender(std::move(sender));
+}
+
 // Remaining stub methods (to be implemented in next iteration)
 uint64_t MiningPoolServer::CalculateWorkerDifficulty(uint64_t worker_id) const {
     auto worker = GetWorker(worker_id);
     if (!worker.has_value()) return impl_->config_.initial_difficulty;
-    return impl_->vardiff_.CalculateDifficulty(*worker);
+    WindowTotals recent = impl_->TotalsOf(impl_->worker_rates_, worker_id, StatsWindow::FIVE_MINUTES,
+                                          std::chrono::steady_clock::now());
+    return impl_->vardiff_.CalculateDifficulty(*worker, recent, std::chrono::system_clock::now());
 }
 
 void MiningPoolServer::AdjustWorkerDifficulty(uint64_t worker_id) {
@@ -1213,18 +4052,10 @@ void MiningPoolServer::AdjustWorkerDifficulty(uint64_t worker_id) {
     auto it = impl_->workers_.find(worker_id);
     if (it == impl_->workers_.end()) return;
 
-    uint64_t old_diff = it->second.current_difficulty;
-    uint64_t new_diff = impl_->vardiff_.CalculateDifficulty(it->second);
-
-    // Only update if difficulty changed
-    if (new_diff != old_diff) {
-        it->second.current_difficulty = new_diff;
-
+    uint64_t new_diff = impl_->RetargetWorker(it->second);
+    if (new_diff != 0) {
         // Send difficulty update via Stratum
         SendSetDifficulty(worker_id, new_diff);
-
-        LogF(LogLevel::DEBUG, "Adjusted worker %llu difficulty: %llu -> %llu",
-             worker_id, old_diff, new_diff);
     }
 }
 
@@ -1242,21 +4073,11 @@ void MiningPoolServer::AdjustAllDifficulties() {
     size_t adjusted_count = 0;
 
     for (auto& [worker_id, worker] : impl_->workers_) {
-        if (impl_->vardiff_.ShouldAdjust(worker)) {
-            uint64_t old_diff = worker.current_difficulty;
-            uint64_t new_diff = impl_->vardiff_.CalculateDifficulty(worker);
-
-            if (new_diff != old_diff) {
-                worker.current_difficulty = new_diff;
-
-                // Send difficulty update via Stratum
-                SendSetDifficulty(worker_id, new_diff);
-
-                LogF(LogLevel::DEBUG, "Adjusted worker %llu difficulty: %llu -> %llu",
-                     worker_id, old_diff, new_diff);
-
-                adjusted_count++;
-            }
+        uint64_t new_diff = impl_->RetargetWorker(worker);
+        if (new_diff != 0) {
+            // Send difficulty update via Stratum
+            SendSetDifficulty(worker_id, new_diff);
+            adjusted_count++;
         }
     }
 
@@ -1266,89 +4087,31 @@ void MiningPoolServer::AdjustAllDifficulties() {
 }
 
 std::map<uint64_t, uint64_t> MiningPoolServer::CalculatePPLNSPayouts(uint64_t block_reward) {
-    return PayoutCalculator::CalculatePPLNS(impl_->recent_shares_,
-                                           impl_->config_.pplns_window,
-                                           block_reward,
-                                           impl_->config_.pool_fee_percent);
+    // Per-miner work is maintained as shares become durable (caller holds
+    // mutex_), so this is O(miners in window) whatever the window length
+    return PayoutCalculator::DistributeReward(impl_->pplns_.GetMinerWork(), block_reward,
+                                              impl_->config_.pool_fee_percent);
 }
 
 std::map<uint64_t, uint64_t> MiningPoolServer::CalculatePPSPayouts() {
-    auto network_diff = impl_->blockchain_->GetDifficulty();
-    auto share_diff = impl_->config_.initial_difficulty;
-    uint64_t expected_shares = HashrateCalculator::CalculateExpectedShares(network_diff, share_diff);
-
-    // Simplified block reward (should use ConsensusValidator::GetBlockReward)
-    uint64_t block_reward = 50 * 100000000ULL;  // 50 INTS in base units
-
-    return PayoutCalculator::CalculatePPS(impl_->recent_shares_,
-                                         expected_shares,
-                                         block_reward,
-                                         impl_->config_.pool_fee_percent);
+    // Shares are credited as they are accepted; nothing is rescanned here
+    return impl_->pps_.GetPending();
 }
 
 Result<void> MiningPoolServer::ProcessPayouts() {
-    std::lock_guard<std::mutex> lock(impl_->mutex_);
-
-    std::vector<Payment> new_payments;
-    auto now = std::chrono::system_clock::now();
-
-    // Iterate through all miners to check payout eligibility
-    for (auto& [miner_id, miner] : impl_->miners_) {
-        // Check if miner has enough balance for payout
-        if (miner.unpaid_balance < impl_->config_.min_payout) {
-            continue;  // Skip miners below threshold
-        }
-
-        // Check if enough time has passed since last payout
-        auto time_since_last = std::chrono::duration_cast<std::chrono::seconds>(
-            now - miner.last_payout).count();
-
-        if (time_since_last < static_cast<int64_t>(impl_->config_.payout_interval)) {
-            continue;  // Too soon for payout
-        }
-
-        // Create payment record
-        Payment payment;
-        payment.payment_id = impl_->next_payment_id_++;
-        payment.miner_id = miner_id;
-        payment.payout_address = miner.payout_address;
-        payment.amount = miner.unpaid_balance;
-        payment.tx_hash.fill(0);  // Will be filled when transaction is created
-        payment.created_at = now;
-        payment.is_confirmed = false;
-        payment.status = "pending";
-
-        // Store payment record
-        impl_->payment_history_.push_back(payment);
-        new_payments.push_back(payment);
-
-        // Update miner balances
-        miner.unpaid_balance = 0;
-        miner.last_payout = now;
-
-        // Call payout callback if registered
-        if (impl_->payout_callback_) {
-            (*impl_->payout_callback_)(miner_id, payment.amount);
-        }
-    }
-
-    // Log payout processing
-    if (!new_payments.empty()) {
-        std::cout << "[Pool] Processed " << new_payments.size() << " payouts" << std::endl;
-        for (const auto& payment : new_payments) {
-            std::cout << "  Payout #" << payment.payment_id
-                      << ": " << payment.amount << " INTS to "
-                      << payment.payout_address << std::endl;
-        }
+    // The engine takes the server lock only to collect and debit balances;
+    // signing and broadcasting happen outside it
+    auto result = impl_->payout_engine_->RunOnce();
+    if (!result.IsOk()) {
+        return Result<void>::Error(result.error);
     }
-
     return Result<void>::Ok();
 }
 
 uint64_t MiningPoolServer::GetMinerBalance(uint64_t miner_id) const {
     auto miner = GetMiner(miner_id);
     if (!miner.has_value()) return 0;
-    return miner->unpaid_balance;
+    return miner->unpaid_balance + impl_->pps_.GetPending(miner_id);
 }
 
 uint64_t MiningPoolServer::GetMinerEstimatedEarnings(uint64_t miner_id) const {
@@ -1397,9 +4160,11 @@ PoolStatistics MiningPoolServer::GetStatistics() const {
     PoolStatistics stats = impl_->stats_;
 
     // Update real-time statistics
-    stats.network_height = impl_->blockchain_->GetBestHeight();
-    stats.network_difficulty = impl_->blockchain_->GetDifficulty();
-    stats.active_miners = GetActiveMiners().size();
+    ChainState chain = impl_->chain_state_.Get();
+    stats.network_height = chain.height;
+    stats.network_difficulty = chain.difficulty;
+    stats.network_hashrate = static_cast<uint64_t>(chain.network_hashrate);
+    stats.active_miners = impl_->ActiveMiners().size();
     stats.active_workers = 0;
 
     for (const auto& [id, worker] : impl_->workers_) {
@@ -1407,6 +4172,23 @@ PoolStatistics MiningPoolServer::GetStatistics() const {
     }
 
     stats.pool_hashrate = CalculatePoolHashrate();
+    stats.pool_hashrate_percentage = chain.network_hashrate > 0 ?
+        100.0 * stats.pool_hashrate / chain.network_hashrate : 0.0;
+    stats.shares_last_hour = GetPoolTotals(StatsWindow::HOUR).shares;
+    stats.shares_last_day = GetPoolTotals(StatsWindow::DAY).shares;
+
+    stats.blocks_pending = impl_->blocks_.GetPending().size();
+    stats.blocks_confirmed = impl_->blocks_.GetConfirmedCount();
+    stats.blocks_orphaned = impl_->blocks_.GetOrphanedCount();
+    stats.luck = impl_->luck_.GetRollingLuck();
+    stats.round_effort = LuckTracker::Effort(impl_->current_round_);
+
+    if (impl_->database_) {
+        using Ledger = pool::PoolDatabase;
+        stats.pool_revenue = static_cast<uint64_t>(std::max<int64_t>(
+            impl_->database_->GetBalance(Ledger::LedgerAccount::POOL_FEES).balance, 0));
+        stats.pps_fund = impl_->database_->GetBalance(Ledger::LedgerAccount::PPS_FUND).balance;
+    }
 
     auto now = std::chrono::system_clock::now();
     auto uptime = std::chrono::duration_cast<std::chrono::hours>(now - impl_->start_time_);
@@ -1415,6 +4197,14 @@ PoolStatistics MiningPoolServer::GetStatistics() const {
     return stats;
 }
 
+ChainState MiningPoolServer::GetChainState() const {
+    return impl_->chain_state_.Get();
+}
+
+pool::PoolMetrics& MiningPoolServer::GetMetrics() const {
+    return impl_->metrics_;
+}
+
 RoundStatistics MiningPoolServer::GetCurrentRound() const {
     std::lock_guard<std::mutex> lock(impl_->mutex_);
     return impl_->current_round_;
@@ -1430,25 +4220,90 @@ std::vector<RoundStatistics> MiningPoolServer::GetRoundHistory(size_t count) con
                                        impl_->round_history_.end());
 }
 
+std::vector<RoundLuck> MiningPoolServer::GetRoundLuck(size_t limit) const {
+    std::lock_guard<std::mutex> lock(impl_->mutex_);
+    return impl_->luck_.GetRecent(limit);
+}
+
+std::optional<SoloRound> MiningPoolServer::GetSoloRound(uint64_t miner_id) const {
+    std::lock_guard<std::mutex> lock(impl_->mutex_);
+    auto it = impl_->solo_rounds_.find(miner_id);
+    if (it == impl_->solo_rounds_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::vector<FoundBlock> MiningPoolServer::GetFoundBlocks(size_t limit) const {
+    std::lock_guard<std::mutex> lock(impl_->mutex_);
+    return impl_->blocks_.GetRecent(limit);
+}
+
 double MiningPoolServer::CalculatePoolHashrate() const {
-    return HashrateCalculator::CalculateHashrate(impl_->recent_shares_,
-                                                 std::chrono::minutes(10));
+    return impl_->pool_rate_.GetHashrate(std::chrono::steady_clock::now());
 }
 
 double MiningPoolServer::CalculateWorkerHashrate(uint64_t worker_id) const {
-    auto shares = GetMinerShares(impl_->worker_to_miner_.at(worker_id), 100);
-    std::vector<Share> worker_shares;
-    for (const auto& share : shares) {
-        if (share.worker_id == worker_id) {
-            worker_shares.push_back(share);
-        }
-    }
-    return HashrateCalculator::CalculateHashrate(worker_shares, std::chrono::minutes(5));
+    return GetWorkerTotals(worker_id, StatsWindow::TEN_MINUTES).hashrate;
 }
 
 double MiningPoolServer::CalculateMinerHashrate(uint64_t miner_id) const {
-    auto shares = GetMinerShares(miner_id, 200);
-    return HashrateCalculator::CalculateHashrate(shares, std::chrono::minutes(10));
+    return GetMinerTotals(miner_id, StatsWindow::TEN_MINUTES).hashrate;
+}
+
+WindowTotals MiningPoolServer::GetPoolTotals(StatsWindow window) const {
+    return impl_->pool_rate_.Get(window, std::chrono::steady_clock::now());
+}
+
+WindowTotals MiningPoolServer::GetMinerTotals(uint64_t miner_id, StatsWindow window) const {
+    return impl_->TotalsOf(impl_->miner_rates_, miner_id, window, std::chrono::steady_clock::now());
+}
+
+WindowTotals MiningPoolServer::GetWorkerTotals(uint64_t worker_id, StatsWindow window) const {
+    return impl_->TotalsOf(impl_->worker_rates_, worker_id, window, std::chrono::steady_clock::now());
+}
+
+// ============================================================================
+// History Export
+// ============================================================================
+
+Result<void> MiningPoolServer::ExportHistory(const pool::ExportOptions& options,
+                                             const std::function<Result<void>(const uint8_t*, size_t)>& sink) const {
+    // Storage has its own locking; mutex_ stays free for share processing.
+    // Registering as an active export keeps Stop() from closing storage
+    // underneath us, and a stopping pool cuts the export short.
+    std::shared_ptr<pool::ShareArchive> archive;
+    pool::PoolDatabase* database = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(impl_->export_mutex_);
+        if (!impl_->archive_) {
+            return Result<void>::Error("Share history is not persisted (no data_dir)");
+        }
+        if (impl_->storage_closing_) {
+            return Result<void>::Error("Pool is stopping");
+        }
+        archive = impl_->archive_;
+        database = impl_->database_.get();
+        ++impl_->active_exports_;
+    }
+
+    auto result = pool::ExportHistory(archive.get(), database, options,
+                                      [&](const uint8_t* data, size_t len) {
+        if (impl_->storage_closing_) {
+            return Result<void>::Error("Pool is stopping");
+        }
+        return sink(data, len);
+    });
+
+    {
+        std::lock_guard<std::mutex> lock(impl_->export_mutex_);
+        --impl_->active_exports_;
+    }
+    impl_->export_cv_.notify_all();
+    if (!result.IsOk()) {
+        return Result<void>::Error(result.error);
+    }
+    return Result<void>::Ok();
 }
 
 // ============================================================================
@@ -1606,9 +4461,19 @@ Result<bool> MiningPoolServer::HandleAuthorize(uint64_t conn_id,
     if (username_it != impl_->username_to_miner_id_.end()) {
         miner_id = username_it->second;
     } else {
-        // New miner - create entry
+        // New miner - create entry (wallet address doubles as username)
         miner_id = impl_->next_miner_id_++;
         impl_->username_to_miner_id_[wallet_address] = miner_id;
+
+        Miner miner{};
+        miner.miner_id = miner_id;
+        miner.username = wallet_address;
+        miner.payout_address = wallet_address;
+        miner.registered_at = std::chrono::system_clock::now();
+        miner.last_seen = miner.registered_at;
+        impl_->miners_[miner_id] = miner;
+        impl_->MarkMinerDirty(miner_id);
+        impl_->SaveMiner(miner_id);
     }
 
     // Create worker
@@ -1619,6 +4484,7 @@ Result<bool> MiningPoolServer::HandleAuthorize(uint64_t conn_id,
     worker.miner_id = miner_id;
     worker.worker_name = worker_name;
     worker.connected_at = std::chrono::system_clock::now();
+    worker.last_retarget = worker.connected_at;
     worker.last_activity = std::chrono::system_clock::now();
     worker.shares_submitted = 0;
     worker.shares_accepted = 0;
@@ -1632,6 +4498,7 @@ Result<bool> MiningPoolServer::HandleAuthorize(uint64_t conn_id,
 
     impl_->workers_[worker_id] = worker;
     impl_->worker_to_miner_[worker_id] = miner_id;
+    impl_->SaveWorker(worker_id);
 
     (void)password;  // Password typically ignored in Stratum
     (void)conn_id;   // Connection tracking at network layer
@@ -1734,26 +4601,28 @@ Result<bool> MiningPoolServer::HandleSubmit(uint64_t conn_id,
     }
 
     // Update worker statistics
+    impl_->CreditHashrate(worker_id, worker->miner_id, share.difficulty, std::chrono::steady_clock::now());
     worker->shares_submitted++;
     worker->shares_accepted++;
-    worker->last_share_time = std::chrono::system_clock::now();
+    worker->last_share_time = share.timestamp;
 
     // Store share
     impl_->recent_shares_.push_back(share);
     impl_->stats_.total_shares++;
 
     // Update round statistics
-    impl_->current_round_.shares_submitted++;
+    impl_->AccountShare(share);
     if (share.is_block) {
         impl_->current_round_.block_hash = share.share_hash;
     }
 
     // Check if VarDiff adjustment is needed
-    if (impl_->vardiff_.ShouldAdjust(*worker)) {
-        uint64_t new_diff = impl_->vardiff_.CalculateDifficulty(*worker);
-        worker->current_difficulty = new_diff;
+    uint64_t new_diff = impl_->RetargetWorker(*worker);
+    if (new_diff != 0) {
         SendSetDifficulty(conn_id, new_diff);
     }
+    impl_->MarkWorkerDirty(worker_id);
+    impl_->MarkMinerDirty(worker->miner_id);
 
     (void)job_id;  // Job ID validation in full implementation
 
@@ -1816,6 +4685,8 @@ void MiningPoolServer::BanMiner(uint64_t miner_id, std::chrono::seconds duration
     if (it != impl_->miners_.end()) {
         it->second.is_banned = true;
         it->second.ban_expires = std::chrono::system_clock::now() + duration;
+        impl_->MarkMinerDirty(miner_id);
+        impl_->SaveMiner(miner_id);
     }
 }
 
@@ -1824,6 +4695,8 @@ void MiningPoolServer::UnbanMiner(uint64_t miner_id) {
     auto it = impl_->miners_.find(miner_id);
     if (it != impl_->miners_.end()) {
         it->second.is_banned = false;
+        impl_->MarkMinerDirty(miner_id);
+        impl_->SaveMiner(miner_id);
     }
 }
 
@@ -1,293 +1,2328 @@
 /*
  * Copyright (c) 2025 INTcoin Team (Neil Adamson)
  * MIT License
- * Mining Pool Database (Stub Implementation)
+ * Mining Pool Database (RocksDB)
  */
 
-#include "intcoin/pool.h"
-#include "intcoin/storage.h"
+#include "intcoin/pool_storage.h"
+#include "intcoin/util.h"
+#include "file_util.h"
+#include <rocksdb/db.h>
+#include <rocksdb/options.h>
+#include <rocksdb/table.h>
+#include <rocksdb/filter_policy.h>
+#include <rocksdb/cache.h>
+#include <rocksdb/slice_transform.h>
+#include <rocksdb/write_batch.h>
+#include <array>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <thread>
 
 namespace intcoin {
 namespace pool {
 
-/**
- * Pool database for persistent storage of pool statistics
- *
- * This is a minimal in-memory implementation.
- * Full implementation would use RocksDB or SQLite for persistence.
- *
- * Database Schema:
- * - workers: worker_id -> Worker (serialized)
- * - shares: share_id -> Share (serialized)
- * - blocks: block_hash -> BlockRecord (height, finder, reward, status)
- * - payments: payment_id -> Payment (address, amount, txid, timestamp)
- */
-class PoolDatabase {
+// ============================================================================
+// Key / Record Encoding
+// ============================================================================
+
+namespace {
+
+// Bumped whenever a record layout changes (see intcoin-pool-db migrate).
+// Decoders branch on RecordReader::version() to read older layouts.
+//   1: initial layouts
+//   2: block round, finder and deferred credits
+//   3: round work and network difficulty
+//   4: payment miner and status
+//   5: block PPS funding
+//   6: block chain
+constexpr uint8_t kRecordVersion = 6;
+
+// Bumped whenever tables are added or rekeyed:
+//   1: initial column families
+//   2: miner_addresses index
+constexpr uint32_t kSchemaVersion = 2;
+const char* const kSchemaKey = "schema_version";
+const char* const kLastShareIdKey = "last_share_id";
+
+const char* const kSharesCF   = "shares";
+const char* const kWorkersCF  = "workers";
+const char* const kMinersCF   = "miners";
+const char* const kRoundsCF   = "rounds";
+const char* const kBlocksCF   = "blocks";
+const char* const kPaymentsCF = "payments";
+const char* const kWorkerStatsCF = "worker_stats";
+const char* const kMinerStatsCF  = "miner_stats";
+const char* const kLedgerCF      = "ledger";
+const char* const kLedgerKeysCF  = "ledger_keys";
+const char* const kBalancesCF    = "balances";
+const char* const kMinerAddressesCF = "miner_addresses";
+
+void PutBE64(std::string& out, uint64_t value) {
+    for (int i = 7; i >= 0; --i) {
+        out.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+}
+
+uint64_t GetBE64(const char* data) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value = (value << 8) | static_cast<uint8_t>(data[i]);
+    }
+    return value;
+}
+
+std::string Key64(uint64_t a) {
+    std::string key;
+    key.reserve(8);
+    PutBE64(key, a);
+    return key;
+}
+
+std::string Key64x2(uint64_t a, uint64_t b) {
+    std::string key;
+    key.reserve(16);
+    PutBE64(key, a);
+    PutBE64(key, b);
+    return key;
+}
+
+std::string BlockKey(uint64_t height, const uint256& hash) {
+    std::string key = Key64(height);
+    key.append(reinterpret_cast<const char*>(hash.data()), hash.size());
+    return key;
+}
+
+int64_t ToMicros(std::chrono::system_clock::time_point tp) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        tp.time_since_epoch()).count();
+}
+
+std::chrono::system_clock::time_point FromMicros(int64_t us) {
+    return std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::microseconds(us)));
+}
+
+/// Versioned little-endian record writer
+class RecordWriter {
+public:
+    RecordWriter() { buf_.push_back(static_cast<char>(kRecordVersion)); }
+
+    void U8(uint8_t v) { buf_.push_back(static_cast<char>(v)); }
+    void U64(uint64_t v) { PutLE64(buf_, v); }
+    void I64(int64_t v) { U64(static_cast<uint64_t>(v)); }
+    void F64(double v) { uint64_t bits; std::memcpy(&bits, &v, 8); U64(bits); }
+    void Bool(bool v) { U8(v ? 1 : 0); }
+    void Str(const std::string& s) { U64(s.size()); buf_.append(s); }
+    void Hash(const uint256& h) { buf_.append(reinterpret_cast<const char*>(h.data()), h.size()); }
+    void Time(std::chrono::system_clock::time_point tp) { I64(ToMicros(tp)); }
+
+    std::string Take() { return std::move(buf_); }
+
+private:
+    std::string buf_;
+};
+
+/// Bounds-checked reader for RecordWriter output
+class RecordReader {
+public:
+    RecordReader(const char* data, size_t size)
+        : p_(data), end_(data + size), ok_(size > 0) {
+        if (ok_) version_ = static_cast<uint8_t>(*p_++);
+        ok_ = ok_ && version_ >= 1 && version_ <= kRecordVersion;
+    }
+
+    bool ok() const { return ok_; }
+    uint8_t version() const { return version_; }
+
+    uint8_t U8() {
+        if (!Need(1)) return 0;
+        return static_cast<uint8_t>(*p_++);
+    }
+    uint64_t U64() {
+        if (!Need(8)) return 0;
+        uint64_t v = GetLE64(reinterpret_cast<const uint8_t*>(p_));
+        p_ += 8;
+        return v;
+    }
+    int64_t I64() { return static_cast<int64_t>(U64()); }
+    double F64() { uint64_t bits = U64(); double v; std::memcpy(&v, &bits, 8); return v; }
+    bool Bool() { return U8() != 0; }
+    std::string Str() {
+        uint64_t len = U64();
+        if (!Need(len)) return {};
+        std::string s(p_, len);
+        p_ += len;
+        return s;
+    }
+    uint256 Hash() {
+        uint256 h{};
+        if (!Need(h.size())) return h;
+        std::memcpy(h.data(), p_, h.size());
+        p_ += h.size();
+        return h;
+    }
+    std::chrono::system_clock::time_point Time() { return FromMicros(I64()); }
+
+private:
+    bool Need(uint64_t n) {
+        if (!ok_ || static_cast<uint64_t>(end_ - p_) < n) {
+            ok_ = false;
+            return false;
+        }
+        return true;
+    }
+
+    const char* p_;
+    const char* end_;
+    bool ok_;
+    uint8_t version_ = 0;
+};
+
+std::string EncodeShare(const Share& share) {
+    RecordWriter w;
+    w.U64(share.share_id);
+    w.U64(share.miner_id);
+    w.U64(share.worker_id);
+    w.Str(share.worker_name);
+    w.Hash(share.job_id);
+    w.Hash(share.nonce);
+    w.Hash(share.share_hash);
+    w.U64(share.difficulty);
+    w.Bool(share.is_block);
+    w.Time(share.timestamp);
+    w.Bool(share.valid);
+    w.Str(share.error_msg);
+    return w.Take();
+}
+
+bool DecodeShare(const rocksdb::Slice& value, Share& share) {
+    RecordReader r(value.data(), value.size());
+    share.share_id = r.U64();
+    share.miner_id = r.U64();
+    share.worker_id = r.U64();
+    share.worker_name = r.Str();
+    share.job_id = r.Hash();
+    share.nonce = r.Hash();
+    share.share_hash = r.Hash();
+    share.difficulty = r.U64();
+    share.is_block = r.Bool();
+    share.timestamp = r.Time();
+    share.valid = r.Bool();
+    share.error_msg = r.Str();
+    return r.ok();
+}
+
+std::string EncodeWorker(const Worker& worker) {
+    RecordWriter w;
+    w.U64(worker.worker_id);
+    w.U64(worker.miner_id);
+    w.Str(worker.worker_name);
+    w.Str(worker.user_agent);
+    w.U64(worker.shares_submitted);
+    w.U64(worker.shares_accepted);
+    w.U64(worker.shares_rejected);
+    w.U64(worker.shares_stale);
+    w.U64(worker.blocks_found);
+    w.F64(worker.current_hashrate);
+    w.F64(worker.average_hashrate);
+    w.U64(worker.current_difficulty);
+    w.Time(worker.last_share_time);
+    w.U64(worker.recent_shares.size());
+    for (const auto& tp : worker.recent_shares) {
+        w.Time(tp);
+    }
+    w.Str(worker.ip_address);
+    w.U64(worker.port);
+    w.Time(worker.connected_at);
+    w.Time(worker.last_activity);
+    w.Bool(worker.is_active);
+    return w.Take();
+}
+
+bool DecodeWorker(const rocksdb::Slice& value, Worker& worker) {
+    RecordReader r(value.data(), value.size());
+    worker.worker_id = r.U64();
+    worker.miner_id = r.U64();
+    worker.worker_name = r.Str();
+    worker.user_agent = r.Str();
+    worker.shares_submitted = r.U64();
+    worker.shares_accepted = r.U64();
+    worker.shares_rejected = r.U64();
+    worker.shares_stale = r.U64();
+    worker.blocks_found = r.U64();
+    worker.current_hashrate = r.F64();
+    worker.average_hashrate = r.F64();
+    worker.current_difficulty = r.U64();
+    worker.last_share_time = r.Time();
+    uint64_t recent = r.U64();
+    worker.recent_shares.clear();
+    for (uint64_t i = 0; i < recent && r.ok(); ++i) {
+        worker.recent_shares.push_back(r.Time());
+    }
+    worker.ip_address = r.Str();
+    worker.port = static_cast<uint16_t>(r.U64());
+    worker.connected_at = r.Time();
+    worker.last_activity = r.Time();
+    worker.is_active = r.Bool();
+    return r.ok();
+}
+
+std::string EncodeMiner(const Miner& miner) {
+    RecordWriter w;
+    w.U64(miner.miner_id);
+    w.Str(miner.username);
+    w.Str(miner.payout_address);
+    w.Str(miner.email);
+    w.U64(miner.total_shares_submitted);
+    w.U64(miner.total_shares_accepted);
+    w.U64(miner.total_shares_rejected);
+    w.U64(miner.total_blocks_found);
+    w.F64(miner.total_hashrate);
+    w.U64(miner.unpaid_balance);
+    w.U64(miner.paid_balance);
+    w.U64(miner.estimated_earnings);
+    w.Time(miner.last_payout);
+    w.U64(miner.invalid_share_count);
+    w.Bool(miner.is_banned);
+    w.Time(miner.ban_expires);
+    w.Time(miner.registered_at);
+    w.Time(miner.last_seen);
+    return w.Take();
+}
+
+bool DecodeMiner(const rocksdb::Slice& value, Miner& miner) {
+    RecordReader r(value.data(), value.size());
+    miner.miner_id = r.U64();
+    miner.username = r.Str();
+    miner.payout_address = r.Str();
+    miner.email = r.Str();
+    miner.total_shares_submitted = r.U64();
+    miner.total_shares_accepted = r.U64();
+    miner.total_shares_rejected = r.U64();
+    miner.total_blocks_found = r.U64();
+    miner.total_hashrate = r.F64();
+    miner.unpaid_balance = r.U64();
+    miner.paid_balance = r.U64();
+    miner.estimated_earnings = r.U64();
+    miner.last_payout = r.Time();
+    miner.invalid_share_count = r.U64();
+    miner.is_banned = r.Bool();
+    miner.ban_expires = r.Time();
+    miner.registered_at = r.Time();
+    miner.last_seen = r.Time();
+    return r.ok();
+}
+
+/// Worker fields that change on every share
+struct WorkerCounters {
+    uint64_t shares_submitted = 0;
+    uint64_t shares_accepted = 0;
+    uint64_t shares_rejected = 0;
+    uint64_t shares_stale = 0;
+    uint64_t blocks_found = 0;
+    double current_hashrate = 0.0;
+    double average_hashrate = 0.0;
+    uint64_t current_difficulty = 0;
+    std::chrono::system_clock::time_point last_share_time;
+    std::chrono::system_clock::time_point last_activity;
+    bool is_active = false;
+};
+
+WorkerCounters CountersOf(const Worker& worker) {
+    WorkerCounters c;
+    c.shares_submitted = worker.shares_submitted;
+    c.shares_accepted = worker.shares_accepted;
+    c.shares_rejected = worker.shares_rejected;
+    c.shares_stale = worker.shares_stale;
+    c.blocks_found = worker.blocks_found;
+    c.current_hashrate = worker.current_hashrate;
+    c.average_hashrate = worker.average_hashrate;
+    c.current_difficulty = worker.current_difficulty;
+    c.last_share_time = worker.last_share_time;
+    c.last_activity = worker.last_activity;
+    c.is_active = worker.is_active;
+    return c;
+}
+
+void ApplyCounters(const WorkerCounters& c, Worker& worker) {
+    worker.shares_submitted = c.shares_submitted;
+    worker.shares_accepted = c.shares_accepted;
+    worker.shares_rejected = c.shares_rejected;
+    worker.shares_stale = c.shares_stale;
+    worker.blocks_found = c.blocks_found;
+    worker.current_hashrate = c.current_hashrate;
+    worker.average_hashrate = c.average_hashrate;
+    worker.current_difficulty = c.current_difficulty;
+    worker.last_share_time = c.last_share_time;
+    worker.last_activity = c.last_activity;
+    worker.is_active = c.is_active;
+}
+
+std::string EncodeCounters(const WorkerCounters& c) {
+    RecordWriter w;
+    w.U64(c.shares_submitted);
+    w.U64(c.shares_accepted);
+    w.U64(c.shares_rejected);
+    w.U64(c.shares_stale);
+    w.U64(c.blocks_found);
+    w.F64(c.current_hashrate);
+    w.F64(c.average_hashrate);
+    w.U64(c.current_difficulty);
+    w.Time(c.last_share_time);
+    w.Time(c.last_activity);
+    w.Bool(c.is_active);
+    return w.Take();
+}
+
+bool DecodeCounters(const rocksdb::Slice& value, WorkerCounters& c) {
+    RecordReader r(value.data(), value.size());
+    c.shares_submitted = r.U64();
+    c.shares_accepted = r.U64();
+    c.shares_rejected = r.U64();
+    c.shares_stale = r.U64();
+    c.blocks_found = r.U64();
+    c.current_hashrate = r.F64();
+    c.average_hashrate = r.F64();
+    c.current_difficulty = r.U64();
+    c.last_share_time = r.Time();
+    c.last_activity = r.Time();
+    c.is_active = r.Bool();
+    return r.ok();
+}
+
+/// Miner fields that change on every share (balances are not included)
+struct MinerCounters {
+    uint64_t total_shares_submitted = 0;
+    uint64_t total_shares_accepted = 0;
+    uint64_t total_shares_rejected = 0;
+    uint64_t total_blocks_found = 0;
+    double total_hashrate = 0.0;
+    uint64_t estimated_earnings = 0;
+    uint64_t invalid_share_count = 0;
+    std::chrono::system_clock::time_point last_seen;
+};
+
+MinerCounters CountersOf(const Miner& miner) {
+    MinerCounters c;
+    c.total_shares_submitted = miner.total_shares_submitted;
+    c.total_shares_accepted = miner.total_shares_accepted;
+    c.total_shares_rejected = miner.total_shares_rejected;
+    c.total_blocks_found = miner.total_blocks_found;
+    c.total_hashrate = miner.total_hashrate;
+    c.estimated_earnings = miner.estimated_earnings;
+    c.invalid_share_count = miner.invalid_share_count;
+    c.last_seen = miner.last_seen;
+    return c;
+}
+
+void ApplyCounters(const MinerCounters& c, Miner& miner) {
+    miner.total_shares_submitted = c.total_shares_submitted;
+    miner.total_shares_accepted = c.total_shares_accepted;
+    miner.total_shares_rejected = c.total_shares_rejected;
+    miner.total_blocks_found = c.total_blocks_found;
+    miner.total_hashrate = c.total_hashrate;
+    miner.estimated_earnings = c.estimated_earnings;
+    miner.invalid_share_count = c.invalid_share_count;
+    miner.last_seen = c.last_seen;
+}
+
+std::string EncodeCounters(const MinerCounters& c) {
+    RecordWriter w;
+    w.U64(c.total_shares_submitted);
+    w.U64(c.total_shares_accepted);
+    w.U64(c.total_shares_rejected);
+    w.U64(c.total_blocks_found);
+    w.F64(c.total_hashrate);
+    w.U64(c.estimated_earnings);
+    w.U64(c.invalid_share_count);
+    w.Time(c.last_seen);
+    return w.Take();
+}
+
+bool DecodeCounters(const rocksdb::Slice& value, MinerCounters& c) {
+    RecordReader r(value.data(), value.size());
+    c.total_shares_submitted = r.U64();
+    c.total_shares_accepted = r.U64();
+    c.total_shares_rejected = r.U64();
+    c.total_blocks_found = r.U64();
+    c.total_hashrate = r.F64();
+    c.estimated_earnings = r.U64();
+    c.invalid_share_count = r.U64();
+    c.last_seen = r.Time();
+    return r.ok();
+}
+
+std::string EncodeRound(const RoundStatistics& round) {
+    RecordWriter w;
+    w.U64(round.round_id);
+    w.Time(round.started_at);
+    w.Time(round.ended_at);
+    w.U64(round.shares_submitted);
+    w.U64(round.block_height);
+    w.Hash(round.block_hash);
+    w.U64(round.block_reward);
+    w.U64(round.miner_shares.size());
+    for (const auto& [miner_id, count] : round.miner_shares) {
+        w.U64(miner_id);
+        w.U64(count);
+    }
+    w.Bool(round.is_complete);
+    w.U64(round.total_work);
+    w.U64(round.network_difficulty);
+    return w.Take();
+}
+
+bool DecodeRound(const rocksdb::Slice& value, RoundStatistics& round) {
+    RecordReader r(value.data(), value.size());
+    round.round_id = r.U64();
+    round.started_at = r.Time();
+    round.ended_at = r.Time();
+    round.shares_submitted = r.U64();
+    round.block_height = r.U64();
+    round.block_hash = r.Hash();
+    round.block_reward = r.U64();
+    uint64_t entries = r.U64();
+    round.miner_shares.clear();
+    for (uint64_t i = 0; i < entries && r.ok(); ++i) {
+        uint64_t miner_id = r.U64();
+        round.miner_shares[miner_id] = r.U64();
+    }
+    round.is_complete = r.Bool();
+    round.total_work = 0;
+    round.network_difficulty = 0;
+    if (r.version() >= 3) {
+        round.total_work = r.U64();
+        round.network_difficulty = r.U64();
+    }
+    return r.ok();
+}
+
+std::string EncodeBlock(const PoolDatabase::BlockRecord& block) {
+    RecordWriter w;
+    w.U64(block.height);
+    w.Hash(block.hash);
+    w.Str(block.finder_address);
+    w.U64(block.reward);
+    w.Str(block.status);
+    w.Time(block.timestamp);
+    w.U64(block.round_id);
+    w.U64(block.finder_id);
+    w.U64(block.credits.size());
+    for (const auto& [miner_id, amount] : block.credits) {
+        w.U64(miner_id);
+        w.U64(amount);
+    }
+    w.U64(block.pool_fee);
+    w.U64(block.pps_funding);
+    w.Str(block.chain);
+    return w.Take();
+}
+
+bool DecodeBlock(const rocksdb::Slice& value, PoolDatabase::BlockRecord& block) {
+    RecordReader r(value.data(), value.size());
+    block.height = r.U64();
+    block.hash = r.Hash();
+    block.finder_address = r.Str();
+    block.reward = r.U64();
+    block.status = r.Str();
+    block.timestamp = r.Time();
+    block.round_id = 0;
+    block.finder_id = 0;
+    block.credits.clear();
+    block.pool_fee = 0;
+    block.pps_funding = 0;
+    block.chain.clear();
+    if (r.version() >= 2) {
+        block.round_id = r.U64();
+        block.finder_id = r.U64();
+        uint64_t count = r.U64();
+        for (uint64_t i = 0; i < count && r.ok(); i++) {
+            uint64_t miner_id = r.U64();
+            block.credits.emplace_back(miner_id, r.U64());
+        }
+        block.pool_fee = r.U64();
+    }
+    if (r.version() >= 5) {
+        block.pps_funding = r.U64();
+    }
+    if (r.version() >= 6) {
+        block.chain = r.Str();
+    }
+    return r.ok();
+}
+
+std::string EncodePayment(const PoolDatabase::Payment& payment) {
+    RecordWriter w;
+    w.U64(payment.payment_id);
+    w.Str(payment.address);
+    w.U64(payment.amount);
+    w.Str(payment.txid);
+    w.Time(payment.timestamp);
+    w.U64(payment.miner_id);
+    w.Str(payment.status);
+    return w.Take();
+}
+
+bool DecodePayment(const rocksdb::Slice& value, PoolDatabase::Payment& payment) {
+    RecordReader r(value.data(), value.size());
+    payment.payment_id = r.U64();
+    payment.address = r.Str();
+    payment.amount = r.U64();
+    payment.txid = r.Str();
+    payment.timestamp = r.Time();
+    payment.miner_id = 0;
+    payment.status.clear();
+    if (r.version() >= 4) {
+        payment.miner_id = r.U64();
+        payment.status = r.Str();
+    }
+    return r.ok();
+}
+
+using LedgerAccount = PoolDatabase::LedgerAccount;
+using LedgerType = PoolDatabase::LedgerType;
+using LedgerEntry = PoolDatabase::LedgerEntry;
+using LedgerBalance = PoolDatabase::LedgerBalance;
+
+constexpr size_t kLedgerTypes = 6;
+
+std::string AccountKey(LedgerAccount account, uint64_t miner_id) {
+    std::string key(1, static_cast<char>(account));
+    PutBE64(key, account == LedgerAccount::MINER ? miner_id : 0);
+    return key;
+}
+
+/// Meta key in ledger_keys holding the highest reference for a type
+/// (idempotency keys never start with '#')
+std::string LastReferenceKey(LedgerType type) {
+    return std::string("#last_ref/") + static_cast<char>('0' + static_cast<int>(type));
+}
+
+/// (debited account, credited account) for an entry
+std::pair<std::string, std::string> LedgerLegs(const LedgerEntry& entry) {
+    std::string miner = AccountKey(LedgerAccount::MINER, entry.miner_id);
+    switch (entry.type) {
+        case LedgerType::ROUND_CREDIT:
+            return {AccountKey(LedgerAccount::BLOCK_REWARDS, 0), miner};
+        case LedgerType::PPS_CREDIT:
+            return {AccountKey(LedgerAccount::PPS_FUND, 0), miner};
+        case LedgerType::POOL_FEE:
+            return {AccountKey(LedgerAccount::BLOCK_REWARDS, 0), AccountKey(LedgerAccount::POOL_FEES, 0)};
+        case LedgerType::PAYMENT:
+            return {miner, AccountKey(LedgerAccount::PAYOUTS, 0)};
+        case LedgerType::PPS_FUNDING:
+            return {AccountKey(LedgerAccount::BLOCK_REWARDS, 0), AccountKey(LedgerAccount::PPS_FUND, 0)};
+    }
+    return {};
+}
+
+std::string EncodeLedgerEntry(const LedgerEntry& entry) {
+    RecordWriter w;
+    w.U64(entry.seq);
+    w.Str(entry.key);
+    w.U8(static_cast<uint8_t>(entry.type));
+    w.U64(entry.miner_id);
+    w.U64(entry.amount);
+    w.U64(entry.reference);
+    w.Str(entry.memo);
+    w.Time(entry.timestamp);
+    return w.Take();
+}
+
+bool DecodeLedgerEntry(const rocksdb::Slice& value, LedgerEntry& entry) {
+    RecordReader r(value.data(), value.size());
+    entry.seq = r.U64();
+    entry.key = r.Str();
+    entry.type = static_cast<LedgerType>(r.U8());
+    entry.miner_id = r.U64();
+    entry.amount = r.U64();
+    entry.reference = r.U64();
+    entry.memo = r.Str();
+    entry.timestamp = r.Time();
+    return r.ok();
+}
+
+std::string EncodeBalance(const LedgerBalance& balance) {
+    RecordWriter w;
+    w.I64(balance.balance);
+    w.U64(balance.credited);
+    w.U64(balance.debited);
+    return w.Take();
+}
+
+bool DecodeBalance(const rocksdb::Slice& value, LedgerBalance& balance) {
+    RecordReader r(value.data(), value.size());
+    balance.balance = static_cast<int64_t>(r.U64());
+    balance.credited = r.U64();
+    balance.debited = r.U64();
+    return r.ok();
+}
+
+void ApplyLegs(const LedgerEntry& entry, LedgerBalance& debit, LedgerBalance& credit) {
+    debit.balance -= static_cast<int64_t>(entry.amount);
+    debit.debited += entry.amount;
+    credit.balance += static_cast<int64_t>(entry.amount);
+    credit.credited += entry.amount;
+}
+
+/// Decode a record in any supported layout and encode it at kRecordVersion
+using ReencodeFn = bool (*)(const rocksdb::Slice& value, std::string& out);
+
+template <typename T, bool (*Decode)(const rocksdb::Slice&, T&), std::string (*Encode)(const T&)>
+bool Reencode(const rocksdb::Slice& value, std::string& out) {
+    T record{};
+    if (!Decode(value, record)) return false;
+    out = Encode(record);
+    return true;
+}
+
+/// Column family whose values are versioned records
+struct VersionedTable {
+    const char* name;
+    rocksdb::ColumnFamilyHandle* cf;
+    ReencodeFn reencode;
+};
+
+} // namespace
+
+// ============================================================================
+// Pool Database Implementation
+// ============================================================================
+
+class PoolDatabase::Impl {
 public:
-    explicit PoolDatabase(const std::string& db_path)
-        : db_path_(db_path), next_share_id_(1), next_payment_id_(1) {}
+    Impl(const std::string& db_path, const PoolDatabaseOptions& options)
+        : db_path_(db_path)
+        , options_(options)
+        , pending_shares_(std::make_unique<rocksdb::WriteBatch>())
+    {}
+
+    std::string db_path_;
+    PoolDatabaseOptions options_;
+
+    // RocksDB handles
+    std::unique_ptr<rocksdb::DB> db_;
+    std::vector<rocksdb::ColumnFamilyHandle*> handles_;
+    rocksdb::ColumnFamilyHandle* cf_shares_ = nullptr;
+    rocksdb::ColumnFamilyHandle* cf_workers_ = nullptr;
+    rocksdb::ColumnFamilyHandle* cf_miners_ = nullptr;
+    rocksdb::ColumnFamilyHandle* cf_rounds_ = nullptr;
+    rocksdb::ColumnFamilyHandle* cf_blocks_ = nullptr;
+    rocksdb::ColumnFamilyHandle* cf_payments_ = nullptr;
+    rocksdb::ColumnFamilyHandle* cf_worker_stats_ = nullptr;
+    rocksdb::ColumnFamilyHandle* cf_miner_stats_ = nullptr;
+    rocksdb::ColumnFamilyHandle* cf_ledger_ = nullptr;
+    rocksdb::ColumnFamilyHandle* cf_ledger_keys_ = nullptr;
+    rocksdb::ColumnFamilyHandle* cf_balances_ = nullptr;
+    rocksdb::ColumnFamilyHandle* cf_miner_addresses_ = nullptr;  // Null in read-only opens of schema 1
+    std::shared_ptr<rocksdb::Cache> block_cache_;
+    uint32_t schema_version_ = 0;
+
+    // Optional columnar archive for time-window aggregates; readers take a
+    // reference so the pool can detach it while they run
+    mutable std::mutex archive_mutex_;
+    std::shared_ptr<const ShareArchive> archive_;
+
+    std::shared_ptr<const ShareArchive> Archive() const {
+        std::lock_guard<std::mutex> lock(archive_mutex_);
+        return archive_;
+    }
+
+    // Share write batching
+    std::mutex batch_mutex_;
+    std::condition_variable batch_cv_;
+    std::unique_ptr<rocksdb::WriteBatch> pending_shares_;
+    size_t pending_count_ = 0;
+    uint64_t last_share_id_ = 0;            // Highest share id queued so far
+    std::mutex share_commit_mutex_;         // Keeps batches (and last_share_id) in order
+    std::vector<std::unique_ptr<rocksdb::WriteBatch>> unwritten_shares_;  // Failed, retried first
+    std::atomic<size_t> unwritten_batches_{0};
+    bool stop_flusher_ = false;
+    std::thread flush_thread_;
+
+    // Dirty counters, latest value per id (flushed on stats_flush_interval).
+    // stats_commit_mutex_ orders stats batches against full-record saves.
+    std::mutex stats_mutex_;
+    std::mutex stats_commit_mutex_;
+    std::unordered_map<uint64_t, WorkerCounters> dirty_workers_;
+    std::unordered_map<uint64_t, MinerCounters> dirty_miners_;
+    std::chrono::steady_clock::time_point next_stats_flush_;
+
+    // Ledger: balances are cached in full so reads never touch disk
+    mutable std::mutex ledger_mutex_;
+    std::unordered_map<std::string, LedgerBalance> balances_;
+    std::array<uint64_t, kLedgerTypes> last_reference_{};
+    uint64_t next_ledger_seq_ = 1;
+
+    // ID generators (restored on open: shares from last_share_id, payments
+    // from the last key)
+    std::atomic<uint64_t> next_share_id_{1};
+    std::atomic<uint64_t> next_payment_id_{1};
+
+    rocksdb::WriteOptions SyncWrite() const {
+        rocksdb::WriteOptions wo;
+        wo.sync = options_.sync_payments;
+        return wo;
+    }
+
+    /// Add a payment row to batch, allocating an id if it has none and
+    /// keeping the allocator past any id given; returns the value size
+    size_t PutPayment(rocksdb::WriteBatch& batch, const Payment& payment) {
+        Payment stored = payment;
+        if (stored.payment_id == 0) {
+            stored.payment_id = next_payment_id_++;
+        } else {
+            uint64_t next = next_payment_id_;
+            while (stored.payment_id >= next &&
+                   !next_payment_id_.compare_exchange_weak(next, stored.payment_id + 1)) {}
+        }
+        if (stored.timestamp == std::chrono::system_clock::time_point()) {
+            stored.timestamp = std::chrono::system_clock::now();
+        }
+        std::string value = EncodePayment(stored);
+        batch.Put(cf_payments_, Key64(stored.payment_id), value);
+        return value.size();
+    }
+
+    rocksdb::ColumnFamilyOptions PointLookupOptions() const {
+        rocksdb::BlockBasedTableOptions table;
+        table.block_cache = block_cache_;
+        table.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10, false));
+        table.whole_key_filtering = true;
+        table.cache_index_and_filter_blocks = true;
+        table.pin_l0_filter_and_index_blocks_in_cache = true;
+
+        rocksdb::ColumnFamilyOptions cf;
+        cf.OptimizeLevelStyleCompaction();
+        cf.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table));
+        cf.compression = rocksdb::kLZ4Compression;
+        cf.bottommost_compression = rocksdb::kZSTD;
+        return cf;
+    }
 
-    ~PoolDatabase() {}
+    rocksdb::ColumnFamilyOptions ShareOptions() const {
+        // Shares are only ever read by round prefix or by reverse range scan,
+        // so filter on the 8-byte round prefix instead of whole keys.
+        rocksdb::BlockBasedTableOptions table;
+        table.block_cache = block_cache_;
+        table.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10, false));
+        table.whole_key_filtering = false;
+        table.cache_index_and_filter_blocks = true;
+        table.block_size = 16 * 1024;
 
-    // ========================================================================
-    // Worker Management
-    // ========================================================================
+        rocksdb::ColumnFamilyOptions cf;
+        cf.OptimizeLevelStyleCompaction();
+        cf.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table));
+        cf.prefix_extractor.reset(rocksdb::NewFixedPrefixTransform(8));
+        cf.memtable_prefix_bloom_size_ratio = 0.1;
+        cf.write_buffer_size = 128 * 1024 * 1024;
+        cf.max_write_buffer_number = 4;
+        cf.compression = rocksdb::kLZ4Compression;
+        cf.bottommost_compression = rocksdb::kZSTD;
+        return cf;
+    }
+
+    /// Commit buffered shares (caller must not hold batch_mutex_)
+    /// Write queued shares; a batch that fails is kept and written ahead
+    /// of newer ones on the next commit, so last_share_id never goes back
+    Result<void> CommitShares() {
+        std::lock_guard<std::mutex> commit_lock(share_commit_mutex_);
+        {
+            std::lock_guard<std::mutex> lock(batch_mutex_);
+            if (pending_count_ > 0) {
+                // Share keys sort by round first, so the id allocator is
+                // persisted with the shares rather than derived from the last key
+                pending_shares_->Put(handles_[0], kLastShareIdKey, Key64(last_share_id_));
+                unwritten_shares_.push_back(std::move(pending_shares_));
+                pending_shares_ = std::make_unique<rocksdb::WriteBatch>();
+                pending_count_ = 0;
+            }
+        }
+
+        size_t written = 0;
+        Result<void> result = Result<void>::Ok();
+        for (; written < unwritten_shares_.size(); written++) {
+            rocksdb::Status status = db_->Write(rocksdb::WriteOptions(), unwritten_shares_[written].get());
+            if (!status.ok()) {
+                result = Result<void>::Error("Failed to commit share batch: " + status.ToString());
+                break;
+            }
+        }
+        unwritten_shares_.erase(unwritten_shares_.begin(), unwritten_shares_.begin() + written);
+        unwritten_batches_ = unwritten_shares_.size();
+        return result;
+    }
+
+    /// Write dirty counters as one batch; entries that fail are re-queued
+    /// unless a newer value arrived meanwhile
+    Result<void> CommitStats() {
+        std::lock_guard<std::mutex> commit_lock(stats_commit_mutex_);
+        std::unordered_map<uint64_t, WorkerCounters> workers;
+        std::unordered_map<uint64_t, MinerCounters> miners;
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            workers.swap(dirty_workers_);
+            miners.swap(dirty_miners_);
+        }
+        if (workers.empty() && miners.empty()) {
+            return Result<void>::Ok();
+        }
+
+        rocksdb::WriteBatch batch;
+        for (const auto& [worker_id, counters] : workers) {
+            batch.Put(cf_worker_stats_, Key64(worker_id), EncodeCounters(counters));
+        }
+        for (const auto& [miner_id, counters] : miners) {
+            batch.Put(cf_miner_stats_, Key64(miner_id), EncodeCounters(counters));
+        }
+
+        rocksdb::Status status = db_->Write(rocksdb::WriteOptions(), &batch);
+        if (!status.ok()) {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            dirty_workers_.insert(workers.begin(), workers.end());
+            dirty_miners_.insert(miners.begin(), miners.end());
+            return Result<void>::Error("Failed to commit stats batch: " + status.ToString());
+        }
+        return Result<void>::Ok();
+    }
+
+    void FlushLoop() {
+        std::unique_lock<std::mutex> lock(batch_mutex_);
+        while (!stop_flusher_) {
+            batch_cv_.wait_for(lock, options_.flush_interval, [this]() {
+                return stop_flusher_ || pending_count_ >= options_.share_batch_size;
+            });
+
+            bool stats_due = std::chrono::steady_clock::now() >= next_stats_flush_;
+            if (pending_count_ == 0 && unwritten_batches_ == 0 && !stats_due) continue;
+
+            lock.unlock();
+            auto committed = CommitShares();
+            if (!committed.IsOk()) {
+                LogF(LogLevel::ERROR, "PoolDatabase: %s (kept for retry)", committed.error.c_str());
+            }
+            if (stats_due) {
+                CommitStats();
+                next_stats_flush_ = std::chrono::steady_clock::now() + options_.stats_flush_interval;
+            }
+            lock.lock();
+        }
+    }
+
+    Result<void> LoadLedgerState() {
+        std::lock_guard<std::mutex> lock(ledger_mutex_);
+        balances_.clear();
 
-    Result<void> SaveWorker(const Worker& worker) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        workers_[worker.worker_id] = worker;
+        std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(rocksdb::ReadOptions(), cf_balances_));
+        for (it->SeekToFirst(); it->Valid(); it->Next()) {
+            LedgerBalance balance;
+            if (!DecodeBalance(it->value(), balance)) {
+                return Result<void>::Error("Corrupt balance record");
+            }
+            balances_.emplace(it->key().ToString(), balance);
+        }
+
+        for (size_t type = 1; type < kLedgerTypes; type++) {
+            std::string value;
+            if (db_->Get(rocksdb::ReadOptions(), cf_ledger_keys_,
+                         LastReferenceKey(static_cast<LedgerType>(type)), &value).ok() &&
+                value.size() == 8) {
+                last_reference_[type] = GetBE64(value.data());
+            }
+        }
+
+        next_ledger_seq_ = LastKeyId(cf_ledger_, 0) + 1;
         return Result<void>::Ok();
     }
 
-    Result<Worker> LoadWorker(uint64_t worker_id) {
-        std::lock_guard<std::mutex> lock(mutex_);
+    /// Overlay the newest counters (queued, else persisted) onto a record
+    template <typename Record, typename Counters>
+    void OverlayCounters(rocksdb::ColumnFamilyHandle* cf,
+                         const std::unordered_map<uint64_t, Counters>& dirty,
+                         uint64_t id, Record& record) {
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            auto it = dirty.find(id);
+            if (it != dirty.end()) {
+                ApplyCounters(it->second, record);
+                return;
+            }
+        }
+
+        std::string value;
+        Counters counters;
+        if (db_->Get(rocksdb::ReadOptions(), cf, Key64(id), &value).ok() &&
+            DecodeCounters(value, counters)) {
+            ApplyCounters(counters, record);
+        }
+    }
 
-        auto it = workers_.find(worker_id);
-        if (it == workers_.end()) {
-            return Result<Worker>::Error("Worker not found");
+    /// Highest share id stored. Databases written before the id was kept
+    /// explicitly are scanned once, since a round may hold lower ids than
+    /// an earlier one.
+    uint64_t LastShareId() {
+        std::string value;
+        if (db_->Get(rocksdb::ReadOptions(), handles_[0], kLastShareIdKey, &value).ok() &&
+            value.size() == 8) {
+            return GetBE64(value.data());
         }
 
-        return Result<Worker>::Ok(it->second);
+        uint64_t last = 0;
+        rocksdb::ReadOptions ro;
+        ro.total_order_seek = true;
+        ro.fill_cache = false;
+        std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(ro, cf_shares_));
+        for (it->SeekToFirst(); it->Valid(); it->Next()) {
+            if (it->key().size() == 16) {
+                last = std::max(last, GetBE64(it->key().data() + 8));
+            }
+        }
+        return last;
     }
 
-    // ========================================================================
-    // Share Tracking
-    // ========================================================================
+    uint64_t LastKeyId(rocksdb::ColumnFamilyHandle* cf, size_t offset) {
+        rocksdb::ReadOptions ro;
+        ro.total_order_seek = true;
+        std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(ro, cf));
+        it->SeekToLast();
+        if (!it->Valid() || it->key().size() < offset + 8) return 0;
+        return GetBE64(it->key().data() + offset);
+    }
 
-    Result<void> RecordShare(const Share& share) {
-        std::lock_guard<std::mutex> lock(mutex_);
+    bool TableEmpty(rocksdb::ColumnFamilyHandle* cf) {
+        rocksdb::ReadOptions ro;
+        ro.total_order_seek = true;
+        std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(ro, cf));
+        it->SeekToFirst();
+        return !it->Valid();
+    }
 
-        // Store share with auto-generated ID if needed
-        Share stored_share = share;
-        if (stored_share.share_id == 0) {
-            stored_share.share_id = next_share_id_++;
+    Result<void> StampSchema(uint32_t version) {
+        rocksdb::WriteOptions wo;
+        wo.sync = true;
+        rocksdb::Status status = db_->Put(wo, handles_[0], kSchemaKey, Key64(version));
+        if (!status.ok()) {
+            return Result<void>::Error("Failed to write schema version: " + status.ToString());
         }
+        schema_version_ = version;
+        return Result<void>::Ok();
+    }
+
+    /// Read the schema stamp; an unstamped database is either new (stamped
+    /// now) or predates stamping (schema 1)
+    Result<void> CheckSchema() {
+        std::string value;
+        rocksdb::Status status = db_->Get(rocksdb::ReadOptions(), handles_[0], kSchemaKey, &value);
+        if (status.ok() && value.size() == 8) {
+            schema_version_ = static_cast<uint32_t>(GetBE64(value.data()));
+        } else if (status.IsNotFound()) {
+            bool empty = TableEmpty(cf_miners_) && TableEmpty(cf_workers_) &&
+                         TableEmpty(cf_shares_) && TableEmpty(cf_ledger_);
+            schema_version_ = empty ? kSchemaVersion : 1;
+            if (empty && !options_.read_only) {
+                auto result = StampSchema(kSchemaVersion);
+                if (!result.IsOk()) return result;
+            }
+        } else {
+            return Result<void>::Error("Failed to read schema version: " + status.ToString());
+        }
+
+        if (schema_version_ > kSchemaVersion) {
+            return Result<void>::Error("Pool database schema v" + std::to_string(schema_version_) +
+                                       " is newer than this build (v" + std::to_string(kSchemaVersion) + ")");
+        }
+        if (schema_version_ < kSchemaVersion && !options_.read_only && !options_.allow_old_schema) {
+            return Result<void>::Error("Pool database schema v" + std::to_string(schema_version_) +
+                                       " needs an upgrade to v" + std::to_string(kSchemaVersion) +
+                                       "; run intcoin-pool-db migrate");
+        }
+        return Result<void>::Ok();
+    }
+
+    // ------------------------------------------------------------------------
+    // Maintenance helpers (offline tool; writes skip the WAL, see FlushTables)
+    // ------------------------------------------------------------------------
 
-        shares_.push_back(stored_share);
+    std::vector<VersionedTable> VersionedTables() const {
+        return {
+            {kSharesCF, cf_shares_, Reencode<Share, DecodeShare, EncodeShare>},
+            {kWorkersCF, cf_workers_, Reencode<Worker, DecodeWorker, EncodeWorker>},
+            {kMinersCF, cf_miners_, Reencode<Miner, DecodeMiner, EncodeMiner>},
+            {kRoundsCF, cf_rounds_, Reencode<RoundStatistics, DecodeRound, EncodeRound>},
+            {kBlocksCF, cf_blocks_, Reencode<BlockRecord, DecodeBlock, EncodeBlock>},
+            {kPaymentsCF, cf_payments_, Reencode<Payment, DecodePayment, EncodePayment>},
+            {kWorkerStatsCF, cf_worker_stats_, Reencode<WorkerCounters, DecodeCounters, EncodeCounters>},
+            {kMinerStatsCF, cf_miner_stats_, Reencode<MinerCounters, DecodeCounters, EncodeCounters>},
+            {kLedgerCF, cf_ledger_, Reencode<LedgerEntry, DecodeLedgerEntry, EncodeLedgerEntry>},
+            {kBalancesCF, cf_balances_, Reencode<LedgerBalance, DecodeBalance, EncodeBalance>},
+        };
+    }
 
-        // Keep only recent shares (last 10,000)
-        if (shares_.size() > 10000) {
-            shares_.erase(shares_.begin());
+    Result<void> BulkWrite(rocksdb::WriteBatch& batch) {
+        if (batch.Count() == 0) return Result<void>::Ok();
+        rocksdb::WriteOptions wo;
+        wo.disableWAL = true;
+        rocksdb::Status status = db_->Write(wo, &batch);
+        batch.Clear();
+        if (!status.ok()) {
+            return Result<void>::Error("Bulk write failed: " + status.ToString());
         }
+        return Result<void>::Ok();
+    }
 
+    /// Persist WAL-less bulk writes by flushing every memtable
+    Result<void> FlushTables() {
+        rocksdb::FlushOptions fo;
+        fo.wait = true;
+        rocksdb::Status status = db_->Flush(fo, handles_);
+        if (!status.ok()) {
+            return Result<void>::Error("Failed to flush tables: " + status.ToString());
+        }
         return Result<void>::Ok();
     }
 
-    std::vector<Share> GetRecentShares(int limit) {
-        std::lock_guard<std::mutex> lock(mutex_);
+    Result<void> ClearTable(rocksdb::ColumnFamilyHandle* cf) {
+        rocksdb::WriteBatch batch;
+        rocksdb::ReadOptions ro;
+        ro.total_order_seek = true;
+        std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(ro, cf));
+        for (it->SeekToFirst(); it->Valid(); it->Next()) {
+            batch.Delete(cf, it->key());
+            if (batch.Count() >= 4096) {
+                auto result = BulkWrite(batch);
+                if (!result.IsOk()) return result;
+            }
+        }
+        return BulkWrite(batch);
+    }
+
+    /// Split a column family into up to n key ranges of similar width,
+    /// reading the first 8 key bytes as a big-endian number. Ranges are
+    /// [begin, end); an empty end is unbounded.
+    std::vector<std::pair<std::string, std::string>> PartitionKeys(rocksdb::ColumnFamilyHandle* cf, unsigned n) {
+        auto prefix_of = [](const rocksdb::Slice& key) {
+            char buf[8] = {};
+            std::memcpy(buf, key.data(), std::min<size_t>(key.size(), sizeof(buf)));
+            return GetBE64(buf);
+        };
 
-        size_t start = shares_.size() > static_cast<size_t>(limit) ?
-                       shares_.size() - limit : 0;
+        rocksdb::ReadOptions ro;
+        ro.total_order_seek = true;
+        std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(ro, cf));
+        it->SeekToFirst();
+        if (!it->Valid()) return {};
+        uint64_t lo = prefix_of(it->key());
+        it->SeekToLast();
+        uint64_t hi = prefix_of(it->key());
 
-        return std::vector<Share>(shares_.begin() + start, shares_.end());
+        std::vector<std::pair<std::string, std::string>> ranges;
+        uint64_t step = n > 1 ? (hi - lo) / n : 0;
+        std::string begin;
+        for (unsigned i = 1; i < n && step > 0; i++) {
+            std::string end = Key64(lo + step * i);
+            ranges.emplace_back(begin, end);
+            begin = end;
+        }
+        ranges.emplace_back(begin, std::string());
+        return ranges;
     }
 
-    uint64_t GetTotalShares24h() {
-        std::lock_guard<std::mutex> lock(mutex_);
+    /// Visit every record of the given tables. Each table is split into
+    /// key ranges that up to `threads` workers pull from a shared queue;
+    /// the first error stops the remaining ranges.
+    Result<void> ParallelScan(const std::vector<VersionedTable>& tables, unsigned threads,
+                              const std::function<Result<void>(const VersionedTable&, rocksdb::Iterator&)>& visit) {
+        struct KeyRange {
+            const VersionedTable* table;
+            std::string begin;
+            std::string end;
+        };
+        threads = std::max(1u, threads);
+
+        std::vector<KeyRange> ranges;
+        for (const auto& table : tables) {
+            for (auto& [begin, end] : PartitionKeys(table.cf, threads)) {
+                ranges.push_back({&table, std::move(begin), std::move(end)});
+            }
+        }
 
-        auto now = std::chrono::system_clock::now();
-        auto cutoff = now - std::chrono::hours(24);
+        std::atomic<size_t> next{0};
+        std::mutex error_mutex;
+        Result<void> first_error = Result<void>::Ok();
+        auto worker = [&]() {
+            for (size_t i = next++; i < ranges.size(); i = next++) {
+                const KeyRange& range = ranges[i];
+                rocksdb::Slice upper(range.end);
+                rocksdb::ReadOptions ro;
+                ro.total_order_seek = true;
+                ro.fill_cache = false;
+                if (!range.end.empty()) ro.iterate_upper_bound = &upper;
 
-        uint64_t count = 0;
-        for (const auto& share : shares_) {
-            if (share.timestamp >= cutoff && share.valid) {
-                count++;
+                std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(ro, range.table->cf));
+                it->Seek(range.begin);
+                Result<void> result = visit(*range.table, *it);
+                if (result.IsOk() && !it->status().ok()) {
+                    result = Result<void>::Error(std::string("Failed to scan ") + range.table->name +
+                                                 ": " + it->status().ToString());
+                }
+                if (!result.IsOk()) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (first_error.IsOk()) first_error = result;
+                    next = ranges.size();
+                }
             }
+        };
+
+        std::vector<std::thread> workers;
+        size_t count = std::min<size_t>(threads, ranges.size());
+        for (size_t i = 1; i < count; i++) {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (auto& t : workers) {
+            t.join();
         }
+        return first_error;
+    }
 
-        return count;
+    template <typename T, typename Decode>
+    std::vector<T> ReadLast(rocksdb::ColumnFamilyHandle* cf, int limit, Decode decode) {
+        std::vector<T> result;
+        if (limit <= 0) return result;
+
+        rocksdb::ReadOptions ro;
+        ro.total_order_seek = true;
+        std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(ro, cf));
+        for (it->SeekToLast(); it->Valid() && result.size() < static_cast<size_t>(limit); it->Prev()) {
+            T record;
+            if (decode(it->value(), record)) {
+                result.push_back(std::move(record));
+            }
+        }
+
+        // Oldest first, matching the in-memory vectors this replaced
+        std::reverse(result.begin(), result.end());
+        return result;
+    }
+};
+
+PoolDatabase::PoolDatabase(const std::string& db_path, const PoolDatabaseOptions& options)
+    : impl_(std::make_unique<Impl>(db_path, options)) {}
+
+PoolDatabase::~PoolDatabase() {
+    Close();
+}
+
+Result<void> PoolDatabase::Open() {
+    if (impl_->db_) {
+        return Result<void>::Error("Database already open");
     }
 
-    // ========================================================================
-    // Block Tracking
-    // ========================================================================
+    impl_->block_cache_ = rocksdb::NewLRUCache(impl_->options_.block_cache_mb * 1024 * 1024);
+
+    rocksdb::DBOptions db_options;
+    db_options.create_if_missing = true;
+    db_options.create_missing_column_families = true;
+    db_options.IncreaseParallelism(static_cast<int>(std::max(2u, std::thread::hardware_concurrency())));
+    db_options.bytes_per_sync = 1024 * 1024;
+    db_options.enable_pipelined_write = true;
 
-    struct BlockRecord {
-        uint64_t height;
-        uint256 hash;
-        std::string finder_address;
-        uint64_t reward;
-        std::string status;  // "pending", "confirmed", "orphaned"
-        std::chrono::system_clock::time_point timestamp;
+    std::vector<rocksdb::ColumnFamilyDescriptor> descriptors = {
+        {rocksdb::kDefaultColumnFamilyName, impl_->PointLookupOptions()},
+        {kSharesCF, impl_->ShareOptions()},
+        {kWorkersCF, impl_->PointLookupOptions()},
+        {kMinersCF, impl_->PointLookupOptions()},
+        {kRoundsCF, impl_->PointLookupOptions()},
+        {kBlocksCF, impl_->PointLookupOptions()},
+        {kPaymentsCF, impl_->PointLookupOptions()},
+        {kWorkerStatsCF, impl_->PointLookupOptions()},
+        {kMinerStatsCF, impl_->PointLookupOptions()},
+        {kLedgerCF, impl_->PointLookupOptions()},
+        {kLedgerKeysCF, impl_->PointLookupOptions()},
+        {kBalancesCF, impl_->PointLookupOptions()},
+        {kMinerAddressesCF, impl_->PointLookupOptions()},
     };
 
-    Result<void> RecordBlock(uint64_t height, const uint256& hash,
-                            const std::string& finder, uint64_t reward) {
-        std::lock_guard<std::mutex> lock(mutex_);
+    // A read-only open cannot create column families added by newer schemas
+    if (impl_->options_.read_only) {
+        std::vector<std::string> existing;
+        rocksdb::DB::ListColumnFamilies(db_options, impl_->db_path_, &existing);
+        if (std::find(existing.begin(), existing.end(), kMinerAddressesCF) == existing.end()) {
+            descriptors.pop_back();
+        }
+    }
 
-        BlockRecord record;
-        record.height = height;
-        record.hash = hash;
-        record.finder_address = finder;
-        record.reward = reward;
-        record.status = "pending";
-        record.timestamp = std::chrono::system_clock::now();
+    // Read-only opens skip the DB lock, so tools can run beside a live pool
+    rocksdb::Status status = impl_->options_.read_only
+        ? rocksdb::DB::OpenForReadOnly(db_options, impl_->db_path_, descriptors, &impl_->handles_, &impl_->db_)
+        : rocksdb::DB::Open(db_options, impl_->db_path_, descriptors, &impl_->handles_, &impl_->db_);
+    if (!status.ok()) {
+        return Result<void>::Error("Failed to open pool database at " + impl_->db_path_ +
+                                   ": " + status.ToString());
+    }
+
+    impl_->cf_shares_ = impl_->handles_[1];
+    impl_->cf_workers_ = impl_->handles_[2];
+    impl_->cf_miners_ = impl_->handles_[3];
+    impl_->cf_rounds_ = impl_->handles_[4];
+    impl_->cf_blocks_ = impl_->handles_[5];
+    impl_->cf_payments_ = impl_->handles_[6];
+    impl_->cf_worker_stats_ = impl_->handles_[7];
+    impl_->cf_miner_stats_ = impl_->handles_[8];
+    impl_->cf_ledger_ = impl_->handles_[9];
+    impl_->cf_ledger_keys_ = impl_->handles_[10];
+    impl_->cf_balances_ = impl_->handles_[11];
+    impl_->cf_miner_addresses_ = impl_->handles_.size() > 12 ? impl_->handles_[12] : nullptr;
+
+    auto schema_result = impl_->CheckSchema();
+    if (!schema_result.IsOk()) {
+        Close();
+        return schema_result;
+    }
 
-        blocks_.push_back(record);
+    impl_->last_share_id_ = impl_->LastShareId();
+    impl_->next_share_id_ = impl_->last_share_id_ + 1;
+    impl_->next_payment_id_ = impl_->LastKeyId(impl_->cf_payments_, 0) + 1;
 
+    auto ledger_result = impl_->LoadLedgerState();
+    if (!ledger_result.IsOk()) {
+        Close();
+        return ledger_result;
+    }
+
+    if (impl_->options_.read_only) {
         return Result<void>::Ok();
     }
 
-    std::vector<BlockRecord> GetRecentBlocks(int limit) {
-        std::lock_guard<std::mutex> lock(mutex_);
+    impl_->stop_flusher_ = false;
+    impl_->next_stats_flush_ = std::chrono::steady_clock::now() + impl_->options_.stats_flush_interval;
+    impl_->flush_thread_ = std::thread([this]() { impl_->FlushLoop(); });
+
+    return Result<void>::Ok();
+}
 
-        size_t start = blocks_.size() > static_cast<size_t>(limit) ?
-                       blocks_.size() - limit : 0;
+void PoolDatabase::Close() {
+    if (!impl_->db_) return;
 
-        return std::vector<BlockRecord>(blocks_.begin() + start, blocks_.end());
+    {
+        std::lock_guard<std::mutex> lock(impl_->batch_mutex_);
+        impl_->stop_flusher_ = true;
     }
+    impl_->batch_cv_.notify_all();
+    if (impl_->flush_thread_.joinable()) {
+        impl_->flush_thread_.join();
+    }
+
+    if (!impl_->options_.read_only) {
+        impl_->CommitShares();
+        impl_->CommitStats();
+    }
+
+    for (auto* handle : impl_->handles_) {
+        impl_->db_->DestroyColumnFamilyHandle(handle);
+    }
+    impl_->handles_.clear();
+    impl_->db_->Close();
+    impl_->db_.reset();
+}
+
+bool PoolDatabase::IsOpen() const {
+    return impl_->db_ != nullptr;
+}
+
+void PoolDatabase::SetShareArchive(std::shared_ptr<const ShareArchive> archive) {
+    std::lock_guard<std::mutex> lock(impl_->archive_mutex_);
+    impl_->archive_ = std::move(archive);
+}
 
-    // ========================================================================
-    // Payment Tracking
-    // ========================================================================
+Result<void> PoolDatabase::Flush() {
+    if (!impl_->db_) return Result<void>::Error("Database not open");
+    return impl_->CommitShares();
+}
 
-    struct Payment {
-        uint64_t payment_id;
-        std::string address;
-        uint64_t amount;
-        std::string txid;
-        std::chrono::system_clock::time_point timestamp;
+// ============================================================================
+// Worker / Miner Management
+// ============================================================================
+
+Result<void> PoolDatabase::SaveWorker(const Worker& worker) {
+    // The full record supersedes any queued or persisted counters
+    std::lock_guard<std::mutex> commit_lock(impl_->stats_commit_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(impl_->stats_mutex_);
+        impl_->dirty_workers_.erase(worker.worker_id);
+    }
+
+    rocksdb::WriteBatch batch;
+    batch.Put(impl_->cf_workers_, Key64(worker.worker_id), EncodeWorker(worker));
+    batch.Put(impl_->cf_worker_stats_, Key64(worker.worker_id), EncodeCounters(CountersOf(worker)));
+    rocksdb::Status status = impl_->db_->Write(rocksdb::WriteOptions(), &batch);
+    if (!status.ok()) {
+        return Result<void>::Error("Failed to save worker: " + status.ToString());
+    }
+    return Result<void>::Ok();
+}
+
+Result<Worker> PoolDatabase::LoadWorker(uint64_t worker_id) {
+    std::string value;
+    rocksdb::Status status = impl_->db_->Get(rocksdb::ReadOptions(), impl_->cf_workers_,
+                                             Key64(worker_id), &value);
+    if (status.IsNotFound()) {
+        return Result<Worker>::Error("Worker not found");
+    }
+    if (!status.ok()) {
+        return Result<Worker>::Error("Failed to load worker: " + status.ToString());
+    }
+
+    Worker worker;
+    if (!DecodeWorker(value, worker)) {
+        return Result<Worker>::Error("Corrupt worker record");
+    }
+    impl_->OverlayCounters(impl_->cf_worker_stats_, impl_->dirty_workers_, worker_id, worker);
+    return Result<Worker>::Ok(worker);
+}
+
+uint64_t PoolDatabase::GetLastWorkerId() {
+    return impl_->LastKeyId(impl_->cf_workers_, 0);
+}
+
+Result<void> PoolDatabase::SaveMiner(const Miner& miner) {
+    // The full record supersedes any queued or persisted counters
+    std::lock_guard<std::mutex> commit_lock(impl_->stats_commit_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(impl_->stats_mutex_);
+        impl_->dirty_miners_.erase(miner.miner_id);
+    }
+
+    rocksdb::WriteBatch batch;
+    batch.Put(impl_->cf_miners_, Key64(miner.miner_id), EncodeMiner(miner));
+    batch.Put(impl_->cf_miner_stats_, Key64(miner.miner_id), EncodeCounters(CountersOf(miner)));
+
+    // Keep the address index in step; an old address is only unlinked if
+    // it still points at this miner
+    std::string value;
+    Miner previous;
+    if (impl_->db_->Get(rocksdb::ReadOptions(), impl_->cf_miners_, Key64(miner.miner_id), &value).ok() &&
+        DecodeMiner(value, previous) && !previous.payout_address.empty() &&
+        previous.payout_address != miner.payout_address &&
+        impl_->db_->Get(rocksdb::ReadOptions(), impl_->cf_miner_addresses_, previous.payout_address, &value).ok() &&
+        value == Key64(miner.miner_id)) {
+        batch.Delete(impl_->cf_miner_addresses_, previous.payout_address);
+    }
+    if (!miner.payout_address.empty()) {
+        batch.Put(impl_->cf_miner_addresses_, miner.payout_address, Key64(miner.miner_id));
+    }
+    rocksdb::Status status = impl_->db_->Write(rocksdb::WriteOptions(), &batch);
+    if (!status.ok()) {
+        return Result<void>::Error("Failed to save miner: " + status.ToString());
+    }
+    return Result<void>::Ok();
+}
+
+Result<Miner> PoolDatabase::LoadMiner(uint64_t miner_id) {
+    std::string value;
+    rocksdb::Status status = impl_->db_->Get(rocksdb::ReadOptions(), impl_->cf_miners_,
+                                             Key64(miner_id), &value);
+    if (status.IsNotFound()) {
+        return Result<Miner>::Error("Miner not found");
+    }
+    if (!status.ok()) {
+        return Result<Miner>::Error("Failed to load miner: " + status.ToString());
+    }
+
+    Miner miner;
+    if (!DecodeMiner(value, miner)) {
+        return Result<Miner>::Error("Corrupt miner record");
+    }
+    impl_->OverlayCounters(impl_->cf_miner_stats_, impl_->dirty_miners_, miner_id, miner);
+    return Result<Miner>::Ok(miner);
+}
+
+std::vector<Miner> PoolDatabase::LoadAllMiners() {
+    std::vector<Miner> miners;
+    std::unique_ptr<rocksdb::Iterator> it(
+        impl_->db_->NewIterator(rocksdb::ReadOptions(), impl_->cf_miners_));
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        Miner miner;
+        if (DecodeMiner(it->value(), miner)) {
+            impl_->OverlayCounters(impl_->cf_miner_stats_, impl_->dirty_miners_, miner.miner_id, miner);
+            miners.push_back(std::move(miner));
+        }
+    }
+    return miners;
+}
+
+Result<Miner> PoolDatabase::LoadMinerByAddress(const std::string& address) {
+    if (!impl_->cf_miner_addresses_) {
+        return Result<Miner>::Error("Address index not built; run intcoin-pool-db migrate");
+    }
+
+    std::string value;
+    rocksdb::Status status = impl_->db_->Get(rocksdb::ReadOptions(), impl_->cf_miner_addresses_,
+                                             address, &value);
+    if (status.IsNotFound()) {
+        return Result<Miner>::Error("Miner not found");
+    }
+    if (!status.ok() || value.size() != 8) {
+        return Result<Miner>::Error("Failed to read address index: " + status.ToString());
+    }
+    return LoadMiner(GetBE64(value.data()));
+}
+
+void PoolDatabase::MarkWorkerDirty(const Worker& worker) {
+    std::lock_guard<std::mutex> lock(impl_->stats_mutex_);
+    impl_->dirty_workers_[worker.worker_id] = CountersOf(worker);
+}
+
+void PoolDatabase::MarkMinerDirty(const Miner& miner) {
+    std::lock_guard<std::mutex> lock(impl_->stats_mutex_);
+    impl_->dirty_miners_[miner.miner_id] = CountersOf(miner);
+}
+
+Result<void> PoolDatabase::FlushStats() {
+    if (!impl_->db_) return Result<void>::Error("Database not open");
+    return impl_->CommitStats();
+}
+
+// ============================================================================
+// Share Tracking
+// ============================================================================
+
+Result<void> PoolDatabase::RecordShare(const Share& share, uint64_t round_id) {
+    if (!impl_->db_) return Result<void>::Error("Database not open");
+
+    bool commit_inline = false;
+    {
+        std::lock_guard<std::mutex> lock(impl_->batch_mutex_);
+
+        // Store share with auto-generated ID if needed
+        Share stored_share = share;
+        if (stored_share.share_id == 0) {
+            stored_share.share_id = impl_->next_share_id_++;
+        }
+        if (stored_share.share_id > impl_->last_share_id_) {
+            impl_->last_share_id_ = stored_share.share_id;
+            if (impl_->next_share_id_ <= stored_share.share_id) {
+                impl_->next_share_id_ = stored_share.share_id + 1;
+            }
+        }
+
+        impl_->pending_shares_->Put(impl_->cf_shares_,
+                                    Key64x2(round_id, stored_share.share_id),
+                                    EncodeShare(stored_share));
+        impl_->pending_count_++;
+
+        // Flusher fell behind: apply backpressure on the caller
+        commit_inline = impl_->pending_count_ >= impl_->options_.share_batch_size * 4;
+        if (impl_->pending_count_ >= impl_->options_.share_batch_size) {
+            impl_->batch_cv_.notify_one();
+        }
+    }
+
+    if (commit_inline) {
+        return impl_->CommitShares();
+    }
+    return Result<void>::Ok();
+}
+
+std::vector<Share> PoolDatabase::GetRecentShares(int limit) {
+    impl_->CommitShares();
+    return impl_->ReadLast<Share>(impl_->cf_shares_, limit, DecodeShare);
+}
+
+std::vector<Share> PoolDatabase::GetRoundShares(uint64_t round_id) {
+    impl_->CommitShares();
+
+    std::vector<Share> shares;
+    std::string prefix = Key64(round_id);
+
+    rocksdb::ReadOptions ro;
+    ro.prefix_same_as_start = true;
+    std::unique_ptr<rocksdb::Iterator> it(impl_->db_->NewIterator(ro, impl_->cf_shares_));
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+        Share share;
+        if (DecodeShare(it->value(), share)) {
+            shares.push_back(std::move(share));
+        }
+    }
+    return shares;
+}
+
+uint64_t PoolDatabase::GetTotalShares24h() {
+    auto now = std::chrono::system_clock::now();
+    auto cutoff = now - std::chrono::hours(24);
+    uint64_t count = 0;
+
+    if (auto archive = impl_->Archive()) {
+        for (const auto& [miner_id, totals] : archive->ScanMiners(cutoff, now + std::chrono::seconds(1))) {
+            count += totals.shares;
+        }
+        return count;
+    }
+
+    impl_->CommitShares();
+
+    // Keys are ordered by (round, share), so walking backwards visits
+    // shares newest-first and we can stop at the cutoff.
+    rocksdb::ReadOptions ro;
+    ro.total_order_seek = true;
+    std::unique_ptr<rocksdb::Iterator> it(impl_->db_->NewIterator(ro, impl_->cf_shares_));
+    for (it->SeekToLast(); it->Valid(); it->Prev()) {
+        Share share;
+        if (!DecodeShare(it->value(), share)) continue;
+        if (share.timestamp < cutoff) break;
+        if (share.valid) count++;
+    }
+
+    return count;
+}
+
+// ============================================================================
+// Round Tracking
+// ============================================================================
+
+Result<void> PoolDatabase::SaveRound(const RoundStatistics& round) {
+    rocksdb::Status status = impl_->db_->Put(impl_->SyncWrite(), impl_->cf_rounds_,
+                                             Key64(round.round_id), EncodeRound(round));
+    if (!status.ok()) {
+        return Result<void>::Error("Failed to save round: " + status.ToString());
+    }
+    return Result<void>::Ok();
+}
+
+Result<RoundStatistics> PoolDatabase::LoadRound(uint64_t round_id) {
+    std::string value;
+    rocksdb::Status status = impl_->db_->Get(rocksdb::ReadOptions(), impl_->cf_rounds_,
+                                             Key64(round_id), &value);
+    if (status.IsNotFound()) {
+        return Result<RoundStatistics>::Error("Round not found");
+    }
+    if (!status.ok()) {
+        return Result<RoundStatistics>::Error("Failed to load round: " + status.ToString());
+    }
+
+    RoundStatistics round;
+    if (!DecodeRound(value, round)) {
+        return Result<RoundStatistics>::Error("Corrupt round record");
+    }
+    return Result<RoundStatistics>::Ok(round);
+}
+
+std::vector<RoundStatistics> PoolDatabase::GetRecentRounds(int limit) {
+    return impl_->ReadLast<RoundStatistics>(impl_->cf_rounds_, limit, DecodeRound);
+}
+
+// ============================================================================
+// Block Tracking
+// ============================================================================
+
+Result<void> PoolDatabase::RecordBlock(uint64_t height, const uint256& hash,
+                                       const std::string& finder, uint64_t reward) {
+    BlockRecord record;
+    record.height = height;
+    record.hash = hash;
+    record.finder_address = finder;
+    record.reward = reward;
+    record.status = "pending";
+    record.timestamp = std::chrono::system_clock::now();
+    return RecordBlock(record);
+}
+
+Result<void> PoolDatabase::RecordBlock(const BlockRecord& record) {
+    rocksdb::Status status = impl_->db_->Put(impl_->SyncWrite(), impl_->cf_blocks_,
+                                             BlockKey(record.height, record.hash), EncodeBlock(record));
+    if (!status.ok()) {
+        return Result<void>::Error("Failed to record block: " + status.ToString());
+    }
+    return Result<void>::Ok();
+}
+
+Result<void> PoolDatabase::UpdateBlockStatus(uint64_t height, const uint256& hash,
+                                             const std::string& status_str) {
+    std::string key = BlockKey(height, hash);
+    std::string value;
+    rocksdb::Status status = impl_->db_->Get(rocksdb::ReadOptions(), impl_->cf_blocks_, key, &value);
+    if (status.IsNotFound()) {
+        return Result<void>::Error("Block not found");
+    }
+
+    BlockRecord record;
+    if (!status.ok() || !DecodeBlock(value, record)) {
+        return Result<void>::Error("Failed to load block record");
+    }
+
+    record.status = status_str;
+    status = impl_->db_->Put(impl_->SyncWrite(), impl_->cf_blocks_, key, EncodeBlock(record));
+    if (!status.ok()) {
+        return Result<void>::Error("Failed to update block: " + status.ToString());
+    }
+    return Result<void>::Ok();
+}
+
+std::vector<PoolDatabase::BlockRecord> PoolDatabase::GetRecentBlocks(int limit) {
+    return impl_->ReadLast<BlockRecord>(impl_->cf_blocks_, limit, DecodeBlock);
+}
+
+std::vector<PoolDatabase::BlockRecord> PoolDatabase::GetBlocksByStatus(const std::string& status) {
+    std::vector<BlockRecord> result;
+    if (!impl_->db_) return result;
+
+    rocksdb::ReadOptions ro;
+    ro.total_order_seek = true;
+    std::unique_ptr<rocksdb::Iterator> it(impl_->db_->NewIterator(ro, impl_->cf_blocks_));
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        BlockRecord record;
+        if (DecodeBlock(it->value(), record) && record.status == status) {
+            result.push_back(std::move(record));
+        }
+    }
+    return result;
+}
+
+// ============================================================================
+// Payment Tracking
+// ============================================================================
+
+Result<void> PoolDatabase::RecordPayment(const std::string& address, uint64_t amount,
+                                         const std::string& txid) {
+    Payment payment;
+    payment.payment_id = impl_->next_payment_id_++;
+    payment.address = address;
+    payment.amount = amount;
+    payment.txid = txid;
+    payment.timestamp = std::chrono::system_clock::now();
+
+    rocksdb::Status status = impl_->db_->Put(impl_->SyncWrite(), impl_->cf_payments_,
+                                             Key64(payment.payment_id), EncodePayment(payment));
+    if (!status.ok()) {
+        return Result<void>::Error("Failed to record payment: " + status.ToString());
+    }
+    return Result<void>::Ok();
+}
+
+Result<void> PoolDatabase::RecordPayments(const std::vector<Payment>& payments) {
+    if (!impl_->db_) return Result<void>::Error("Database not open");
+
+    rocksdb::WriteBatch batch;
+    for (const auto& record : payments) {
+        impl_->PutPayment(batch, record);
+    }
+
+    rocksdb::Status status = impl_->db_->Write(impl_->SyncWrite(), &batch);
+    if (!status.ok()) {
+        return Result<void>::Error("Failed to record payments: " + status.ToString());
+    }
+    return Result<void>::Ok();
+}
+
+std::vector<PoolDatabase::Payment> PoolDatabase::GetRecentPayments(int limit) {
+    return impl_->ReadLast<Payment>(impl_->cf_payments_, limit, DecodePayment);
+}
+
+std::vector<PoolDatabase::Payment> PoolDatabase::GetPaymentsByStatus(const std::string& status) {
+    std::vector<Payment> result;
+    if (!impl_->db_) return result;
+
+    rocksdb::ReadOptions ro;
+    ro.total_order_seek = true;
+    std::unique_ptr<rocksdb::Iterator> it(impl_->db_->NewIterator(ro, impl_->cf_payments_));
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        Payment payment;
+        if (DecodePayment(it->value(), payment) && payment.status == status) {
+            result.push_back(std::move(payment));
+        }
+    }
+    return result;
+}
+
+// ============================================================================
+// Ledger
+// ============================================================================
+
+Result<size_t> PoolDatabase::PostLedgerEntries(const std::vector<LedgerEntry>& entries,
+                                               const std::vector<Payment>& payments) {
+    if (!impl_->db_) return Result<size_t>::Error("Database not open");
+
+    std::lock_guard<std::mutex> lock(impl_->ledger_mutex_);
+
+    rocksdb::WriteBatch batch;
+    std::unordered_map<std::string, LedgerBalance> touched;
+    std::unordered_set<std::string> batch_keys;
+    auto last_reference = impl_->last_reference_;
+    uint64_t seq = impl_->next_ledger_seq_;
+    size_t applied = 0;
+
+    auto balance_of = [&](const std::string& account) -> LedgerBalance& {
+        auto it = touched.find(account);
+        if (it == touched.end()) {
+            auto cached = impl_->balances_.find(account);
+            it = touched.emplace(account, cached != impl_->balances_.end() ? cached->second
+                                                                          : LedgerBalance()).first;
+        }
+        return it->second;
     };
 
-    Result<void> RecordPayment(const std::string& address, uint64_t amount,
-                               const std::string& txid) {
-        std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : entries) {
+        if (entry.key.empty() || entry.key[0] == '#') {
+            return Result<size_t>::Error("Invalid ledger key: '" + entry.key + "'");
+        }
+        size_t type = static_cast<size_t>(entry.type);
+        if (type == 0 || type >= kLedgerTypes) {
+            return Result<size_t>::Error("Invalid ledger entry type for " + entry.key);
+        }
+
+        // Idempotency: skip entries already posted (or repeated in this batch)
+        if (!batch_keys.insert(entry.key).second) continue;
+        std::string existing;
+        rocksdb::Status status = impl_->db_->Get(rocksdb::ReadOptions(), impl_->cf_ledger_keys_,
+                                                 entry.key, &existing);
+        if (status.ok()) continue;
+        if (!status.IsNotFound()) {
+            return Result<size_t>::Error("Failed to read ledger key: " + status.ToString());
+        }
 
+        auto [debit_account, credit_account] = LedgerLegs(entry);
+        LedgerBalance& debit = balance_of(debit_account);
+        LedgerBalance& credit = balance_of(credit_account);
+        if (entry.type == LedgerType::PAYMENT && debit.balance < static_cast<int64_t>(entry.amount)) {
+            return Result<size_t>::Error("Payment " + entry.key + " exceeds balance of miner " +
+                                         std::to_string(entry.miner_id));
+        }
+        ApplyLegs(entry, debit, credit);
+
+        LedgerEntry stored = entry;
+        stored.seq = seq++;
+        batch.Put(impl_->cf_ledger_, Key64(stored.seq), EncodeLedgerEntry(stored));
+        batch.Put(impl_->cf_ledger_keys_, entry.key, Key64(stored.seq));
+        last_reference[type] = std::max(last_reference[type], entry.reference);
+        applied++;
+    }
+
+    if (applied == 0) {
+        return Result<size_t>::Ok(0);
+    }
+
+    for (const auto& payment : payments) {
+        impl_->PutPayment(batch, payment);
+    }
+    for (const auto& [account, balance] : touched) {
+        batch.Put(impl_->cf_balances_, account, EncodeBalance(balance));
+    }
+    for (size_t type = 1; type < kLedgerTypes; type++) {
+        if (last_reference[type] != impl_->last_reference_[type]) {
+            batch.Put(impl_->cf_ledger_keys_, LastReferenceKey(static_cast<LedgerType>(type)),
+                      Key64(last_reference[type]));
+        }
+    }
+
+    rocksdb::Status status = impl_->db_->Write(impl_->SyncWrite(), &batch);
+    if (!status.ok()) {
+        return Result<size_t>::Error("Failed to post ledger entries: " + status.ToString());
+    }
+
+    for (auto& [account, balance] : touched) {
+        impl_->balances_[account] = balance;
+    }
+    impl_->last_reference_ = last_reference;
+    impl_->next_ledger_seq_ = seq;
+    return Result<size_t>::Ok(applied);
+}
+
+PoolDatabase::LedgerBalance PoolDatabase::GetBalance(LedgerAccount account, uint64_t miner_id) const {
+    std::lock_guard<std::mutex> lock(impl_->ledger_mutex_);
+    auto it = impl_->balances_.find(AccountKey(account, miner_id));
+    return it != impl_->balances_.end() ? it->second : LedgerBalance();
+}
+
+uint64_t PoolDatabase::GetLastLedgerReference(LedgerType type) const {
+    size_t index = static_cast<size_t>(type);
+    if (index >= kLedgerTypes) return 0;
+    std::lock_guard<std::mutex> lock(impl_->ledger_mutex_);
+    return impl_->last_reference_[index];
+}
+
+std::vector<PoolDatabase::LedgerEntry> PoolDatabase::GetLedgerEntries(uint64_t after_seq, size_t limit) {
+    std::vector<LedgerEntry> entries;
+    std::unique_ptr<rocksdb::Iterator> it(
+        impl_->db_->NewIterator(rocksdb::ReadOptions(), impl_->cf_ledger_));
+    for (it->Seek(Key64(after_seq + 1)); it->Valid() && entries.size() < limit; it->Next()) {
+        LedgerEntry entry;
+        if (DecodeLedgerEntry(it->value(), entry)) {
+            entries.push_back(std::move(entry));
+        }
+    }
+    return entries;
+}
+
+Result<void> PoolDatabase::VerifyLedger() {
+    if (!impl_->db_) return Result<void>::Error("Database not open");
+
+    // Hold the ledger lock so the rebuild sees a consistent prefix
+    std::lock_guard<std::mutex> lock(impl_->ledger_mutex_);
+
+    std::unordered_map<std::string, LedgerBalance> rebuilt;
+    uint64_t entries = 0;
+    std::unique_ptr<rocksdb::Iterator> it(
+        impl_->db_->NewIterator(rocksdb::ReadOptions(), impl_->cf_ledger_));
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        LedgerEntry entry;
+        if (!DecodeLedgerEntry(it->value(), entry)) {
+            return Result<void>::Error("Corrupt ledger entry at seq " +
+                                       std::to_string(GetBE64(it->key().data())));
+        }
+        auto [debit_account, credit_account] = LedgerLegs(entry);
+        ApplyLegs(entry, rebuilt[debit_account], rebuilt[credit_account]);
+        entries++;
+    }
+
+    int64_t sum = 0;
+    size_t stored = 0;
+    std::unique_ptr<rocksdb::Iterator> bit(
+        impl_->db_->NewIterator(rocksdb::ReadOptions(), impl_->cf_balances_));
+    for (bit->SeekToFirst(); bit->Valid(); bit->Next()) {
+        LedgerBalance balance;
+        auto expected = rebuilt.find(bit->key().ToString());
+        if (!DecodeBalance(bit->value(), balance) || expected == rebuilt.end() ||
+            expected->second.balance != balance.balance ||
+            expected->second.credited != balance.credited ||
+            expected->second.debited != balance.debited) {
+            return Result<void>::Error("Balance mismatch for account " +
+                                       std::to_string(GetBE64(bit->key().data() + 1)));
+        }
+        sum += balance.balance;
+        stored++;
+    }
+
+    if (stored != rebuilt.size()) {
+        return Result<void>::Error("Ledger has " + std::to_string(rebuilt.size()) +
+                                   " accounts but " + std::to_string(stored) + " balances");
+    }
+    if (sum != 0) {
+        return Result<void>::Error("Ledger does not balance (" + std::to_string(entries) +
+                                   " entries, sum " + std::to_string(sum) + ")");
+    }
+    return Result<void>::Ok();
+}
+
+// ============================================================================
+// Statistics
+// ============================================================================
+
+std::vector<PoolDatabase::WorkerStats> PoolDatabase::GetTopMiners(int limit) {
+    auto now = std::chrono::system_clock::now();
+    auto cutoff_24h = now - std::chrono::hours(24);
+
+    // Aggregate last 24h of shares per worker
+    std::map<uint64_t, ShareTotals> windows;
+    if (auto archive = impl_->Archive()) {
+        windows = archive->ScanWorkers(cutoff_24h, now + std::chrono::seconds(1));
+    } else {
+        impl_->CommitShares();
+
+        // Newest-first scan, stopping at the cutoff
+        rocksdb::ReadOptions ro;
+        ro.total_order_seek = true;
+        std::unique_ptr<rocksdb::Iterator> it(impl_->db_->NewIterator(ro, impl_->cf_shares_));
+        for (it->SeekToLast(); it->Valid(); it->Prev()) {
+            Share share;
+            if (!DecodeShare(it->value(), share)) continue;
+            if (share.timestamp < cutoff_24h) break;
+            if (!share.valid) continue;
+
+            int64_t ts = std::chrono::duration_cast<std::chrono::milliseconds>(
+                share.timestamp.time_since_epoch()).count();
+            ShareTotals& window = windows[share.worker_id];
+            if (window.shares == 0) window.last_ms = ts;
+            window.first_ms = ts;
+            window.shares++;
+            window.work += share.difficulty;
+        }
+    }
+
+    // Resolve workers to their miner's payout address
+    std::map<uint64_t, std::string> miner_address;
+    std::map<std::string, WorkerStats> stats_map;
+    for (const auto& miner : LoadAllMiners()) {
+        miner_address[miner.miner_id] = miner.payout_address;
+
+        WorkerStats& stats = stats_map[miner.payout_address];
+        stats.address = miner.payout_address;
+        stats.balance += miner.unpaid_balance;
+    }
+
+    std::unique_ptr<rocksdb::Iterator> wit(
+        impl_->db_->NewIterator(rocksdb::ReadOptions(), impl_->cf_workers_));
+    for (wit->SeekToFirst(); wit->Valid(); wit->Next()) {
+        Worker worker;
+        if (!DecodeWorker(wit->value(), worker)) continue;
+
+        auto addr_it = miner_address.find(worker.miner_id);
+        std::string address = addr_it != miner_address.end() ? addr_it->second
+                                                             : worker.worker_name;
+        WorkerStats& stats = stats_map[address];
+        stats.address = address;
+
+        auto win_it = windows.find(worker.worker_id);
+        if (win_it == windows.end()) continue;
+
+        const ShareTotals& window = win_it->second;
+        stats.shares_24h += window.shares;
+
+        // Hashrate = (sum of share difficulty * 2^32) / time_period
+        int64_t time_span = (window.last_ms - window.first_ms) / 1000;
+        if (time_span > 0) {
+            double estimated_hashrate = static_cast<double>(window.work) *
+                                        4294967296.0 / time_span;
+            stats.hashrate += static_cast<uint64_t>(estimated_hashrate);
+        }
+    }
+
+    // Calculate payments by address
+    std::unique_ptr<rocksdb::Iterator> pit(
+        impl_->db_->NewIterator(rocksdb::ReadOptions(), impl_->cf_payments_));
+    for (pit->SeekToFirst(); pit->Valid(); pit->Next()) {
         Payment payment;
-        payment.payment_id = next_payment_id_++;
-        payment.address = address;
-        payment.amount = amount;
-        payment.txid = txid;
-        payment.timestamp = std::chrono::system_clock::now();
+        if (!DecodePayment(pit->value(), payment)) continue;
 
-        payments_.push_back(payment);
+        auto stats_it = stats_map.find(payment.address);
+        if (stats_it != stats_map.end()) {
+            stats_it->second.total_paid += payment.amount;
+        }
+    }
 
-        return Result<void>::Ok();
+    // Convert map to vector
+    std::vector<WorkerStats> result;
+    for (const auto& [addr, stats] : stats_map) {
+        result.push_back(stats);
+    }
+
+    // Sort by hashrate (descending)
+    std::sort(result.begin(), result.end(),
+              [](const WorkerStats& a, const WorkerStats& b) {
+                  return a.hashrate > b.hashrate;
+              });
+
+    // Limit results
+    if (result.size() > static_cast<size_t>(limit)) {
+        result.resize(limit);
     }
 
-    std::vector<Payment> GetRecentPayments(int limit) {
-        std::lock_guard<std::mutex> lock(mutex_);
+    return result;
+}
 
-        size_t start = payments_.size() > static_cast<size_t>(limit) ?
-                       payments_.size() - limit : 0;
+// ============================================================================
+// Maintenance
+// ============================================================================
 
-        return std::vector<Payment>(payments_.begin() + start, payments_.end());
+uint32_t PoolDatabase::GetSchemaVersion() const {
+    return impl_->schema_version_;
+}
+
+Result<void> PoolDatabase::ForEachShare(const std::function<Result<void>(const Share&, uint64_t round_id)>& fn) {
+    if (!impl_->db_) return Result<void>::Error("Database not open");
+
+    rocksdb::ReadOptions ro;
+    ro.total_order_seek = true;
+    ro.fill_cache = false;
+    std::unique_ptr<rocksdb::Iterator> it(impl_->db_->NewIterator(ro, impl_->cf_shares_));
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        Share share;
+        if (it->key().size() != 16 || !DecodeShare(it->value(), share)) {
+            return Result<void>::Error("Corrupt share record");
+        }
+        auto result = fn(share, GetBE64(it->key().data()));
+        if (!result.IsOk()) return result;
+    }
+    if (!it->status().ok()) {
+        return Result<void>::Error("Failed to scan shares: " + it->status().ToString());
     }
+    return Result<void>::Ok();
+}
 
-    // ========================================================================
-    // Statistics
-    // ========================================================================
+Result<PoolDatabase::MaintenanceStats> PoolDatabase::ImportRecords(const std::vector<RoundStatistics>& rounds,
+                                                                   const std::vector<Payment>& payments) {
+    if (!impl_->db_ || impl_->options_.read_only) {
+        return Result<MaintenanceStats>::Error("Database not open for writing");
+    }
 
-    struct WorkerStats {
-        std::string address;
-        uint64_t hashrate;
-        uint64_t shares_24h;
-        uint64_t balance;
-        uint64_t total_paid;
+    MaintenanceStats stats;
+    rocksdb::WriteBatch batch;
+    auto commit_full = [&]() {
+        return batch.Count() >= 4096 ? impl_->BulkWrite(batch) : Result<void>::Ok();
     };
 
-    std::vector<WorkerStats> GetTopMiners(int limit) {
-        std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& round : rounds) {
+        std::string value = EncodeRound(round);
+        batch.Put(impl_->cf_rounds_, Key64(round.round_id), value);
+        stats.records++;
+        stats.bytes += value.size();
+        auto result = commit_full();
+        if (!result.IsOk()) return Result<MaintenanceStats>::Error(result.error);
+    }
+
+    for (const auto& payment : payments) {
+        stats.records++;
+        stats.bytes += impl_->PutPayment(batch, payment);
+        auto result = commit_full();
+        if (!result.IsOk()) return Result<MaintenanceStats>::Error(result.error);
+    }
+
+    auto result = impl_->BulkWrite(batch);
+    if (result.IsOk()) result = impl_->FlushTables();
+    if (!result.IsOk()) return Result<MaintenanceStats>::Error(result.error);
 
-        // Aggregate statistics for each unique payout address
-        std::map<std::string, WorkerStats> stats_map;
+    stats.written = stats.records;
+    return Result<MaintenanceStats>::Ok(stats);
+}
+
+Result<PoolDatabase::MaintenanceStats> PoolDatabase::MigrateRecords(unsigned threads, bool rewrite_all) {
+    if (!impl_->db_ || impl_->options_.read_only) {
+        return Result<MaintenanceStats>::Error("Database not open for writing");
+    }
 
-        auto now = std::chrono::system_clock::now();
-        auto cutoff_24h = now - std::chrono::hours(24);
+    // Buffered share and stats writes must not race the rewrite
+    impl_->CommitShares();
+    impl_->CommitStats();
 
-        // Aggregate shares from last 24h by worker
-        std::map<uint64_t, uint64_t> worker_shares_24h;
-        std::map<uint64_t, std::vector<std::chrono::system_clock::time_point>> worker_share_times;
+    std::atomic<uint64_t> records{0}, written{0}, outdated{0}, bytes{0};
+    auto scan = impl_->ParallelScan(impl_->VersionedTables(), threads,
+                                    [&](const VersionedTable& table, rocksdb::Iterator& it) -> Result<void> {
+        rocksdb::WriteBatch batch;
+        std::string upgraded;
+        uint64_t visited = 0, rewritten = 0, stale = 0, value_bytes = 0;
 
-        for (const auto& share : shares_) {
-            if (share.timestamp >= cutoff_24h && share.valid) {
-                worker_shares_24h[share.worker_id]++;
-                worker_share_times[share.worker_id].push_back(share.timestamp);
+        for (; it.Valid(); it.Next()) {
+            rocksdb::Slice value = it.value();
+            uint8_t version = value.size() > 0 ? static_cast<uint8_t>(value.data()[0]) : 0;
+            visited++;
+            value_bytes += value.size();
+
+            if (version > kRecordVersion) {
+                return Result<void>::Error(std::string(table.name) + " record has layout v" +
+                                           std::to_string(version) + ", newer than this build");
+            }
+            if (version < kRecordVersion) {
+                stale++;
+            } else if (!rewrite_all) {
+                continue;
             }
-        }
 
-        // Process each worker
-        for (const auto& [worker_id, worker] : workers_) {
-            // Find corresponding miner to get payout address
-            // For now, use worker_name as identifier (in real implementation,
-            // would look up miner_id and use actual payout address)
-            std::string address = worker.worker_name; // Simplified for stub
-
-            if (stats_map.find(address) == stats_map.end()) {
-                stats_map[address] = WorkerStats{};
-                stats_map[address].address = address;
-                stats_map[address].hashrate = 0;
-                stats_map[address].shares_24h = 0;
-                stats_map[address].balance = 0;
-                stats_map[address].total_paid = 0;
+            if (!table.reencode(value, upgraded)) {
+                return Result<void>::Error(std::string("Corrupt ") + table.name + " record");
             }
+            batch.Put(table.cf, it.key(), upgraded);
+            rewritten++;
+            if (batch.Count() >= 4096) {
+                auto result = impl_->BulkWrite(batch);
+                if (!result.IsOk()) return result;
+            }
+        }
+
+        records += visited;
+        written += rewritten;
+        outdated += stale;
+        bytes += value_bytes;
+        return impl_->BulkWrite(batch);
+    });
+    if (!scan.IsOk()) return Result<MaintenanceStats>::Error(scan.error);
+
+    auto flushed = impl_->FlushTables();
+    if (!flushed.IsOk()) return Result<MaintenanceStats>::Error(flushed.error);
+
+    // Tables added since the stamped schema are derived, so rebuilding
+    // them completes the upgrade
+    auto reindexed = RebuildIndexes();
+    if (!reindexed.IsOk()) return reindexed;
+
+    auto stamped = impl_->StampSchema(kSchemaVersion);
+    if (!stamped.IsOk()) return Result<MaintenanceStats>::Error(stamped.error);
+
+    MaintenanceStats stats;
+    stats.records = records;
+    stats.written = written;
+    stats.outdated = outdated;
+    stats.bytes = bytes;
+    return Result<MaintenanceStats>::Ok(stats);
+}
 
-            WorkerStats& stats = stats_map[address];
-
-            // Add shares from this worker
-            stats.shares_24h += worker_shares_24h[worker_id];
-
-            // Calculate hashrate from recent shares
-            // Hashrate = (shares * difficulty * 2^32) / time_period
-            const auto& share_times = worker_share_times[worker_id];
-            if (share_times.size() >= 2) {
-                auto time_span = std::chrono::duration_cast<std::chrono::seconds>(
-                    share_times.back() - share_times.front()).count();
-
-                if (time_span > 0) {
-                    // Estimate: each share at difficulty 1 = ~4.3 billion hashes
-                    // For now, use simplified calculation
-                    double estimated_hashrate = (double)share_times.size() *
-                                               worker.current_difficulty *
-                                               4294967296.0 / time_span;
-                    stats.hashrate += static_cast<uint64_t>(estimated_hashrate);
+Result<PoolDatabase::MaintenanceStats> PoolDatabase::VerifyRecords(unsigned threads) {
+    if (!impl_->db_) return Result<MaintenanceStats>::Error("Database not open");
+
+    rocksdb::Status status = impl_->db_->VerifyChecksum();
+    if (!status.ok()) {
+        return Result<MaintenanceStats>::Error("Table checksum mismatch: " + status.ToString());
+    }
+
+    std::atomic<uint64_t> records{0}, outdated{0}, bytes{0}, corrupt{0};
+    std::mutex first_mutex;
+    std::string first_corrupt;
+    auto scan = impl_->ParallelScan(impl_->VersionedTables(), threads,
+                                    [&](const VersionedTable& table, rocksdb::Iterator& it) -> Result<void> {
+        std::string scratch;
+        uint64_t visited = 0, stale = 0, value_bytes = 0, bad = 0;
+
+        for (; it.Valid(); it.Next()) {
+            rocksdb::Slice value = it.value();
+            visited++;
+            value_bytes += value.size();
+            if (value.size() > 0 && static_cast<uint8_t>(value.data()[0]) < kRecordVersion) {
+                stale++;
+            }
+            if (!table.reencode(value, scratch)) {
+                if (bad++ == 0) {
+                    std::lock_guard<std::mutex> lock(first_mutex);
+                    if (first_corrupt.empty()) first_corrupt = table.name;
                 }
             }
         }
 
-        // Calculate balances and payments by address
-        for (const auto& payment : payments_) {
-            if (stats_map.find(payment.address) != stats_map.end()) {
-                stats_map[payment.address].total_paid += payment.amount;
+        records += visited;
+        outdated += stale;
+        bytes += value_bytes;
+        corrupt += bad;
+        return Result<void>::Ok();
+    });
+    if (!scan.IsOk()) return Result<MaintenanceStats>::Error(scan.error);
+
+    if (corrupt > 0) {
+        return Result<MaintenanceStats>::Error(std::to_string(corrupt.load()) + " corrupt records (first in " +
+                                               first_corrupt + ")");
+    }
+
+    auto ledger = VerifyLedger();
+    if (!ledger.IsOk()) return Result<MaintenanceStats>::Error(ledger.error);
+
+    // Every miner with an address is indexed, and every index entry points
+    // at a miner with that address (duplicates resolve to one of them)
+    if (impl_->cf_miner_addresses_ && impl_->schema_version_ >= 2) {
+        std::unordered_map<std::string, std::unordered_set<uint64_t>> owners;
+        std::unique_ptr<rocksdb::Iterator> it(
+            impl_->db_->NewIterator(rocksdb::ReadOptions(), impl_->cf_miners_));
+        for (it->SeekToFirst(); it->Valid(); it->Next()) {
+            Miner miner;
+            if (DecodeMiner(it->value(), miner) && !miner.payout_address.empty()) {
+                owners[miner.payout_address].insert(miner.miner_id);
             }
         }
 
-        // Convert map to vector
-        std::vector<WorkerStats> result;
-        for (const auto& [addr, stats] : stats_map) {
-            result.push_back(stats);
+        size_t indexed = 0;
+        std::unique_ptr<rocksdb::Iterator> ait(
+            impl_->db_->NewIterator(rocksdb::ReadOptions(), impl_->cf_miner_addresses_));
+        for (ait->SeekToFirst(); ait->Valid(); ait->Next()) {
+            auto owner = owners.find(ait->key().ToString());
+            if (owner == owners.end() || ait->value().size() != 8 ||
+                !owner->second.count(GetBE64(ait->value().data()))) {
+                return Result<MaintenanceStats>::Error("Address index entry for " + ait->key().ToString() +
+                                                       " is stale; run intcoin-pool-db reindex");
+            }
+            indexed++;
+        }
+        if (indexed != owners.size()) {
+            return Result<MaintenanceStats>::Error("Address index covers " + std::to_string(indexed) + " of " +
+                                                   std::to_string(owners.size()) +
+                                                   " addresses; run intcoin-pool-db reindex");
         }
+    }
 
-        // Sort by hashrate (descending)
-        std::sort(result.begin(), result.end(),
-                  [](const WorkerStats& a, const WorkerStats& b) {
-                      return a.hashrate > b.hashrate;
-                  });
+    MaintenanceStats stats;
+    stats.records = records;
+    stats.outdated = outdated;
+    stats.bytes = bytes;
+    return Result<MaintenanceStats>::Ok(stats);
+}
 
-        // Limit results
-        if (result.size() > static_cast<size_t>(limit)) {
-            result.resize(limit);
-        }
+Result<PoolDatabase::MaintenanceStats> PoolDatabase::RebuildIndexes() {
+    if (!impl_->db_ || impl_->options_.read_only) {
+        return Result<MaintenanceStats>::Error("Database not open for writing");
+    }
 
-        return result;
+    MaintenanceStats stats;
+    rocksdb::WriteBatch batch;
+    auto commit_full = [&]() {
+        return batch.Count() >= 4096 ? impl_->BulkWrite(batch) : Result<void>::Ok();
+    };
+    auto fail = [](const Result<void>& result) {
+        return Result<MaintenanceStats>::Error(result.error);
+    };
+
+    // Address -> miner (on duplicates the highest miner_id wins)
+    auto cleared = impl_->ClearTable(impl_->cf_miner_addresses_);
+    if (!cleared.IsOk()) return fail(cleared);
+
+    std::unique_ptr<rocksdb::Iterator> it(
+        impl_->db_->NewIterator(rocksdb::ReadOptions(), impl_->cf_miners_));
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        Miner miner;
+        if (!DecodeMiner(it->value(), miner)) {
+            return Result<MaintenanceStats>::Error("Corrupt miner record");
+        }
+        stats.records++;
+        if (miner.payout_address.empty()) continue;
+        batch.Put(impl_->cf_miner_addresses_, miner.payout_address, Key64(miner.miner_id));
+        stats.written++;
+        auto result = commit_full();
+        if (!result.IsOk()) return fail(result);
     }
+    auto result = impl_->BulkWrite(batch);
+    if (!result.IsOk()) return fail(result);
 
-private:
-    std::string db_path_;
-    std::mutex mutex_;
+    // Idempotency keys, reference high-water marks and balances from the ledger
+    std::lock_guard<std::mutex> lock(impl_->ledger_mutex_);
+    cleared = impl_->ClearTable(impl_->cf_ledger_keys_);
+    if (cleared.IsOk()) cleared = impl_->ClearTable(impl_->cf_balances_);
+    if (!cleared.IsOk()) return fail(cleared);
 
-    // In-memory storage (would be replaced with RocksDB/SQLite)
-    std::map<uint64_t, Worker> workers_;
-    std::vector<Share> shares_;
-    std::vector<BlockRecord> blocks_;
-    std::vector<Payment> payments_;
+    std::unordered_map<std::string, LedgerBalance> balances;
+    std::array<uint64_t, kLedgerTypes> last_reference{};
+    uint64_t next_seq = 1;
+    std::unique_ptr<rocksdb::Iterator> lit(
+        impl_->db_->NewIterator(rocksdb::ReadOptions(), impl_->cf_ledger_));
+    for (lit->SeekToFirst(); lit->Valid(); lit->Next()) {
+        LedgerEntry entry;
+        size_t type = 0;
+        if (DecodeLedgerEntry(lit->value(), entry)) type = static_cast<size_t>(entry.type);
+        if (type == 0 || type >= kLedgerTypes) {
+            return Result<MaintenanceStats>::Error("Corrupt ledger entry at seq " +
+                                                   std::to_string(GetBE64(lit->key().data())));
+        }
 
-    std::atomic<uint64_t> next_share_id_;
-    std::atomic<uint64_t> next_payment_id_;
-};
+        auto [debit_account, credit_account] = LedgerLegs(entry);
+        ApplyLegs(entry, balances[debit_account], balances[credit_account]);
+        last_reference[type] = std::max(last_reference[type], entry.reference);
+        next_seq = entry.seq + 1;
+
+        batch.Put(impl_->cf_ledger_keys_, entry.key, Key64(entry.seq));
+        stats.records++;
+        stats.written++;
+        result = commit_full();
+        if (!result.IsOk()) return fail(result);
+    }
+
+    for (const auto& [account, balance] : balances) {
+        batch.Put(impl_->cf_balances_, account, EncodeBalance(balance));
+        stats.written++;
+    }
+    for (size_t type = 1; type < kLedgerTypes; type++) {
+        if (last_reference[type] != 0) {
+            batch.Put(impl_->cf_ledger_keys_, LastReferenceKey(static_cast<LedgerType>(type)),
+                      Key64(last_reference[type]));
+        }
+    }
+    result = impl_->BulkWrite(batch);
+    if (result.IsOk()) result = impl_->FlushTables();
+    if (!result.IsOk()) return fail(result);
+
+    impl_->balances_ = std::move(balances);
+    impl_->last_reference_ = last_reference;
+    impl_->next_ledger_seq_ = next_seq;
+    return Result<MaintenanceStats>::Ok(stats);
+}
 
 } // namespace pool
 } // namespace intcoin
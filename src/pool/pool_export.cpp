@@ -0,0 +1,620 @@
+/*
+ * Copyright (c) 2025 INTcoin Team (Neil Adamson)
+ * MIT License
+ * Mining Pool History Export
+ */
+
+#include "intcoin/pool_storage.h"
+#include "file_util.h"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+
+namespace intcoin {
+namespace pool {
+
+// Archive columns are written in host order and exported without copying
+static_assert(std::endian::native == std::endian::little, "export format assumes a little-endian host");
+
+namespace {
+
+constexpr uint64_t kExportMagic = 0x545250584E434923ull;  // "#INCXPRT"
+constexpr uint32_t kExportVersion = 2;          // 2: rounds carry network_difficulty
+constexpr size_t kExportHeaderBytes = 32;
+constexpr size_t kChunkHeaderBytes = 24;
+constexpr size_t kCsvFlushBytes = 256 * 1024;
+constexpr size_t kLedgerPage = 4096;
+
+template <typename T>
+void AppendColumn(std::string& out, const std::vector<T>& column) {
+    out.append(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+}
+
+/// Strings as (rows + 1) u32 offsets followed by the concatenated bytes
+void AppendStrings(std::string& out, const std::vector<std::string>& column) {
+    uint8_t offset[4];
+    uint32_t pos = 0;
+    PutLE32(offset, pos);
+    out.append(reinterpret_cast<const char*>(offset), 4);
+    for (const auto& value : column) {
+        pos += static_cast<uint32_t>(value.size());
+        PutLE32(offset, pos);
+        out.append(reinterpret_cast<const char*>(offset), 4);
+    }
+    for (const auto& value : column) out += value;
+}
+
+/// A run of bytes making up part of a chunk payload
+struct Piece {
+    const uint8_t* data;
+    size_t len;
+};
+
+/// Writes the export stream through a byte-counting sink
+class ExportWriter {
+public:
+    ExportWriter(const ExportSink& sink, ExportStats& stats) : sink_(sink), stats_(stats) {}
+
+    Result<void> Write(const uint8_t* data, size_t len) {
+        if (len == 0) return Result<void>::Ok();
+        stats_.bytes += len;
+        return sink_(data, len);
+    }
+
+    Result<void> WriteHeader(uint32_t tables, int64_t from_ms, int64_t to_ms) {
+        uint8_t header[kExportHeaderBytes];
+        PutLE64(header, kExportMagic);
+        PutLE32(header + 8, kExportVersion);
+        PutLE32(header + 12, tables);
+        PutLE64(header + 16, static_cast<uint64_t>(from_ms));
+        PutLE64(header + 24, static_cast<uint64_t>(to_ms));
+        return Write(header, sizeof(header));
+    }
+
+    /// Frame a chunk whose payload is the given pieces, in order
+    Result<void> WriteChunk(uint32_t table, uint32_t rows, std::initializer_list<Piece> pieces) {
+        uint64_t payload_bytes = 0;
+        uint32_t crc = 0;
+        for (const auto& piece : pieces) {
+            payload_bytes += piece.len;
+            crc = Crc32c(piece.data, piece.len, crc);
+        }
+
+        uint8_t header[kChunkHeaderBytes];
+        PutLE32(header, table);
+        PutLE32(header + 4, rows);
+        PutLE64(header + 8, payload_bytes);
+        PutLE32(header + 16, crc);
+        PutLE32(header + 20, 0);
+        auto result = Write(header, sizeof(header));
+        for (const auto& piece : pieces) {
+            if (!result.IsOk()) break;
+            result = Write(piece.data, piece.len);
+        }
+        if (result.IsOk() && table != 0) stats_.chunks++;
+        return result;
+    }
+
+private:
+    const ExportSink& sink_;
+    ExportStats& stats_;
+};
+
+/// Accumulates CSV text and hands it to the writer in large blocks
+class CsvBuffer {
+public:
+    explicit CsvBuffer(ExportWriter& writer) : writer_(writer) { buf_.reserve(kCsvFlushBytes + 4096); }
+
+    void Line(const std::string& text) {
+        buf_ += text;
+        buf_ += '\n';
+    }
+
+    template <typename T>
+    void Field(T value, bool last = false) {
+        char tmp[24];
+        auto end = std::to_chars(tmp, tmp + sizeof(tmp), value).ptr;
+        buf_.append(tmp, end);
+        buf_ += last ? '\n' : ',';
+    }
+
+    void Text(const std::string& value, bool last = false) {
+        if (value.find_first_of(",\"\n\r") == std::string::npos) {
+            buf_ += value;
+        } else {
+            buf_ += '"';
+            for (char c : value) {
+                if (c == '"') buf_ += '"';
+                buf_ += c;
+            }
+            buf_ += '"';
+        }
+        buf_ += last ? '\n' : ',';
+    }
+
+    Result<void> MaybeFlush() {
+        return buf_.size() >= kCsvFlushBytes ? Flush() : Result<void>::Ok();
+    }
+
+    Result<void> Flush() {
+        auto result = writer_.Write(reinterpret_cast<const uint8_t*>(buf_.data()), buf_.size());
+        buf_.clear();
+        return result;
+    }
+
+private:
+    ExportWriter& writer_;
+    std::string buf_;
+};
+
+bool SingleTable(uint32_t tables) {
+    return tables != 0 && (tables & (tables - 1)) == 0;
+}
+
+/// Expected work recorded for a round, 0 if the database has none
+uint64_t RoundNetworkDifficulty(PoolDatabase* database, uint64_t round_id) {
+    if (!database) return 0;
+    auto round = database->LoadRound(round_id);
+    return round.IsOk() ? round.GetValue().network_difficulty : 0;
+}
+
+/// Walk PAYMENT ledger entries timestamped in [from_ms, to_ms)
+Result<void> ForEachPayment(PoolDatabase& database, int64_t from_ms, int64_t to_ms,
+                            const std::function<Result<void>(const PoolDatabase::LedgerEntry&)>& fn) {
+    uint64_t after = 0;
+    while (true) {
+        auto page = database.GetLedgerEntries(after, kLedgerPage);
+        for (const auto& entry : page) {
+            after = entry.seq;
+            if (entry.type != PoolDatabase::LedgerType::PAYMENT) continue;
+            int64_t ts = ToMillis(entry.timestamp);
+            if (ts < from_ms || ts >= to_ms) continue;
+            auto result = fn(entry);
+            if (!result.IsOk()) return result;
+        }
+        if (page.size() < kLedgerPage) return Result<void>::Ok();
+    }
+}
+
+// ============================================================================
+// Columnar Tables
+// ============================================================================
+
+Result<void> ExportSharesColumnar(const ShareArchive& archive, const ExportOptions& options,
+                                  ExportWriter& writer, ExportStats& stats) {
+    return archive.ForEachShareChunk(options.from, options.to, options.chunk_rows, [&](const ShareColumns& c) {
+        size_t wide = c.rows * sizeof(uint64_t);
+        stats.shares += c.rows;
+        return writer.WriteChunk(EXPORT_SHARES, static_cast<uint32_t>(c.rows), {
+            {reinterpret_cast<const uint8_t*>(c.timestamp_ms), wide},
+            {reinterpret_cast<const uint8_t*>(c.round_id), wide},
+            {reinterpret_cast<const uint8_t*>(c.miner_id), wide},
+            {reinterpret_cast<const uint8_t*>(c.worker_id), wide},
+            {reinterpret_cast<const uint8_t*>(c.difficulty), wide},
+            {c.flags, c.rows},
+        });
+    });
+}
+
+/// Column buffers for one rounds chunk
+struct RoundRows {
+    std::vector<uint64_t> round_id, miner_id, shares, work;
+    std::vector<int64_t> first_ms, last_ms;
+    std::vector<uint64_t> network_difficulty;
+
+    size_t size() const { return round_id.size(); }
+
+    void Add(const RoundSummary& summary, uint64_t difficulty) {
+        for (const auto& miner : summary.miners) {
+            round_id.push_back(summary.round_id);
+            miner_id.push_back(miner.miner_id);
+            shares.push_back(miner.shares);
+            work.push_back(miner.work);
+            first_ms.push_back(summary.first_ms);
+            last_ms.push_back(summary.last_ms);
+            network_difficulty.push_back(difficulty);
+        }
+    }
+
+    Result<void> Flush(ExportWriter& writer) {
+        if (round_id.empty()) return Result<void>::Ok();
+        std::string payload;
+        AppendColumn(payload, round_id);
+        AppendColumn(payload, miner_id);
+        AppendColumn(payload, shares);
+        AppendColumn(payload, work);
+        AppendColumn(payload, first_ms);
+        AppendColumn(payload, last_ms);
+        AppendColumn(payload, network_difficulty);
+        auto result = writer.WriteChunk(EXPORT_ROUNDS, static_cast<uint32_t>(size()),
+                                        {{reinterpret_cast<const uint8_t*>(payload.data()), payload.size()}});
+        *this = RoundRows();
+        return result;
+    }
+};
+
+Result<void> ExportRoundsColumnar(const ShareArchive& archive, PoolDatabase* database,
+                                  const ExportOptions& options, ExportWriter& writer, ExportStats& stats) {
+    int64_t from_ms = ToMillis(options.from);
+    int64_t to_ms = ToMillis(options.to);
+    RoundRows rows;
+
+    auto result = archive.ForEachRoundSummary([&](const RoundSummary& summary) {
+        if (summary.last_ms < from_ms || summary.last_ms >= to_ms) return Result<void>::Ok();
+        // Flush before a round would push the chunk past chunk_rows
+        if (rows.size() > 0 && rows.size() + summary.miners.size() > options.chunk_rows) {
+            auto flushed = rows.Flush(writer);
+            if (!flushed.IsOk()) return flushed;
+        }
+        rows.Add(summary, RoundNetworkDifficulty(database, summary.round_id));
+        stats.round_rows += summary.miners.size();
+        return Result<void>::Ok();
+    });
+    return result.IsOk() ? rows.Flush(writer) : result;
+}
+
+/// Column buffers for one payments chunk
+struct PaymentRows {
+    std::vector<uint64_t> seq, payment_id, miner_id, amount;
+    std::vector<int64_t> timestamp_ms;
+    std::vector<std::string> key, memo;
+
+    size_t size() const { return seq.size(); }
+
+    void Add(const PoolDatabase::LedgerEntry& entry) {
+        seq.push_back(entry.seq);
+        payment_id.push_back(entry.reference);
+        miner_id.push_back(entry.miner_id);
+        amount.push_back(entry.amount);
+        timestamp_ms.push_back(ToMillis(entry.timestamp));
+        key.push_back(entry.key);
+        memo.push_back(entry.memo);
+    }
+
+    Result<void> Flush(ExportWriter& writer) {
+        if (seq.empty()) return Result<void>::Ok();
+        std::string payload;
+        AppendColumn(payload, seq);
+        AppendColumn(payload, payment_id);
+        AppendColumn(payload, miner_id);
+        AppendColumn(payload, amount);
+        AppendColumn(payload, timestamp_ms);
+        AppendStrings(payload, key);
+        AppendStrings(payload, memo);
+        auto result = writer.WriteChunk(EXPORT_PAYMENTS, static_cast<uint32_t>(size()),
+                                        {{reinterpret_cast<const uint8_t*>(payload.data()), payload.size()}});
+        *this = PaymentRows();
+        return result;
+    }
+};
+
+Result<void> ExportPaymentsColumnar(PoolDatabase& database, const ExportOptions& options,
+                                    ExportWriter& writer, ExportStats& stats) {
+    PaymentRows rows;
+    auto result = ForEachPayment(database, ToMillis(options.from), ToMillis(options.to),
+                                 [&](const PoolDatabase::LedgerEntry& entry) {
+        rows.Add(entry);
+        stats.payments++;
+        return rows.size() >= options.chunk_rows ? rows.Flush(writer) : Result<void>::Ok();
+    });
+    return result.IsOk() ? rows.Flush(writer) : result;
+}
+
+// ============================================================================
+// CSV Tables
+// ============================================================================
+
+Result<void> ExportSharesCsv(const ShareArchive& archive, const ExportOptions& options,
+                             CsvBuffer& csv, ExportStats& stats) {
+    csv.Line("timestamp_ms,round_id,miner_id,worker_id,difficulty,valid,block");
+    return archive.ForEachShareChunk(options.from, options.to, options.chunk_rows, [&](const ShareColumns& c) {
+        for (size_t i = 0; i < c.rows; i++) {
+            csv.Field(c.timestamp_ms[i]);
+            csv.Field(c.round_id[i]);
+            csv.Field(c.miner_id[i]);
+            csv.Field(c.worker_id[i]);
+            csv.Field(c.difficulty[i]);
+            csv.Field((c.flags[i] & JOURNAL_SHARE_VALID) ? 1 : 0);
+            csv.Field((c.flags[i] & JOURNAL_SHARE_BLOCK) ? 1 : 0, true);
+        }
+        stats.shares += c.rows;
+        return csv.MaybeFlush();
+    });
+}
+
+Result<void> ExportRoundsCsv(const ShareArchive& archive, PoolDatabase* database,
+                             const ExportOptions& options, CsvBuffer& csv, ExportStats& stats) {
+    int64_t from_ms = ToMillis(options.from);
+    int64_t to_ms = ToMillis(options.to);
+    csv.Line("round_id,miner_id,shares,work,first_ms,last_ms,network_difficulty");
+    return archive.ForEachRoundSummary([&](const RoundSummary& summary) {
+        if (summary.last_ms < from_ms || summary.last_ms >= to_ms) return Result<void>::Ok();
+        uint64_t difficulty = RoundNetworkDifficulty(database, summary.round_id);
+        for (const auto& miner : summary.miners) {
+            csv.Field(summary.round_id);
+            csv.Field(miner.miner_id);
+            csv.Field(miner.shares);
+            csv.Field(miner.work);
+            csv.Field(summary.first_ms);
+            csv.Field(summary.last_ms);
+            csv.Field(difficulty, true);
+        }
+        stats.round_rows += summary.miners.size();
+        return csv.MaybeFlush();
+    });
+}
+
+Result<void> ExportPaymentsCsv(PoolDatabase& database, const ExportOptions& options,
+                               CsvBuffer& csv, ExportStats& stats) {
+    csv.Line("seq,payment_id,miner_id,amount,timestamp_ms,key,memo");
+    return ForEachPayment(database, ToMillis(options.from), ToMillis(options.to),
+                          [&](const PoolDatabase::LedgerEntry& entry) {
+        csv.Field(entry.seq);
+        csv.Field(entry.reference);
+        csv.Field(entry.miner_id);
+        csv.Field(entry.amount);
+        csv.Field(ToMillis(entry.timestamp));
+        csv.Text(entry.key);
+        csv.Text(entry.memo, true);
+        stats.payments++;
+        return csv.MaybeFlush();
+    });
+}
+
+// ============================================================================
+// Reading
+// ============================================================================
+
+/// Bounds-checked cursor over a chunk payload
+class PayloadReader {
+public:
+    PayloadReader(const uint8_t* data, size_t len) : data_(data), len_(len) {}
+
+    template <typename T>
+    const T* Column(size_t rows) {
+        size_t bytes = rows * sizeof(T);
+        if (bytes > len_ - pos_) return nullptr;
+        const T* column = reinterpret_cast<const T*>(data_ + pos_);
+        pos_ += bytes;
+        return column;
+    }
+
+    bool Strings(size_t rows, std::vector<std::string>& out) {
+        const uint8_t* offsets = Column<uint8_t>((rows + 1) * 4);
+        if (!offsets) return false;
+        uint32_t total = GetLE32(offsets + rows * 4);
+        const uint8_t* bytes = Column<uint8_t>(total);
+        if (!bytes) return false;
+
+        out.resize(rows);
+        for (size_t i = 0; i < rows; i++) {
+            uint32_t begin = GetLE32(offsets + i * 4);
+            uint32_t end = GetLE32(offsets + (i + 1) * 4);
+            if (begin > end || end > total) return false;
+            out[i].assign(reinterpret_cast<const char*>(bytes + begin), end - begin);
+        }
+        return true;
+    }
+
+    bool AtEnd() const { return pos_ == len_; }
+
+private:
+    const uint8_t* data_;
+    size_t len_;
+    size_t pos_ = 0;
+};
+
+Result<void> ReadSharesChunk(PayloadReader& reader, uint32_t rows, const ExportVisitor& visitor) {
+    ShareColumns columns;
+    columns.rows = rows;
+    columns.timestamp_ms = reader.Column<int64_t>(rows);
+    columns.round_id = reader.Column<uint64_t>(rows);
+    columns.miner_id = reader.Column<uint64_t>(rows);
+    columns.worker_id = reader.Column<uint64_t>(rows);
+    columns.difficulty = reader.Column<uint64_t>(rows);
+    columns.flags = reader.Column<uint8_t>(rows);
+    if (!columns.flags || !reader.AtEnd()) {
+        return Result<void>::Error("Malformed shares chunk");
+    }
+    return visitor.shares ? visitor.shares(columns) : Result<void>::Ok();
+}
+
+Result<void> ReadRoundsChunk(PayloadReader& reader, uint32_t rows, uint32_t version,
+                             const ExportVisitor& visitor) {
+    const uint64_t* round_id = reader.Column<uint64_t>(rows);
+    const uint64_t* miner_id = reader.Column<uint64_t>(rows);
+    const uint64_t* shares = reader.Column<uint64_t>(rows);
+    const uint64_t* work = reader.Column<uint64_t>(rows);
+    const int64_t* first_ms = reader.Column<int64_t>(rows);
+    const int64_t* last_ms = reader.Column<int64_t>(rows);
+    const uint64_t* network_difficulty = version >= 2 ? reader.Column<uint64_t>(rows) : nullptr;
+    if (!last_ms || (version >= 2 && !network_difficulty) || !reader.AtEnd()) {
+        return Result<void>::Error("Malformed rounds chunk");
+    }
+    if (!visitor.rounds) return Result<void>::Ok();
+
+    // Consecutive rows of one round make up its summary
+    for (uint32_t i = 0; i < rows;) {
+        RoundSummary summary;
+        summary.round_id = round_id[i];
+        summary.first_ms = first_ms[i];
+        summary.last_ms = last_ms[i];
+        summary.network_difficulty = network_difficulty ? network_difficulty[i] : 0;
+        for (; i < rows && round_id[i] == summary.round_id; i++) {
+            summary.miners.push_back({miner_id[i], shares[i], work[i]});
+            summary.shares += shares[i];
+            summary.work += work[i];
+        }
+        summary.merkle_root = RoundMerkleRoot(summary);
+        auto result = visitor.rounds(summary);
+        if (!result.IsOk()) return result;
+    }
+    return Result<void>::Ok();
+}
+
+Result<void> ReadPaymentsChunk(PayloadReader& reader, uint32_t rows, const ExportVisitor& visitor) {
+    const uint64_t* seq = reader.Column<uint64_t>(rows);
+    const uint64_t* payment_id = reader.Column<uint64_t>(rows);
+    const uint64_t* miner_id = reader.Column<uint64_t>(rows);
+    const uint64_t* amount = reader.Column<uint64_t>(rows);
+    const int64_t* timestamp_ms = reader.Column<int64_t>(rows);
+    std::vector<std::string> keys, memos;
+    if (!timestamp_ms || !reader.Strings(rows, keys) || !reader.Strings(rows, memos) || !reader.AtEnd()) {
+        return Result<void>::Error("Malformed payments chunk");
+    }
+    if (!visitor.payments) return Result<void>::Ok();
+
+    for (uint32_t i = 0; i < rows; i++) {
+        PoolDatabase::LedgerEntry entry;
+        entry.key = std::move(keys[i]);
+        entry.type = PoolDatabase::LedgerType::PAYMENT;
+        entry.miner_id = miner_id[i];
+        entry.amount = amount[i];
+        entry.reference = payment_id[i];
+        entry.memo = std::move(memos[i]);
+        entry.timestamp = FromMillis(timestamp_ms[i]);
+        entry.seq = seq[i];
+        auto result = visitor.payments(entry);
+        if (!result.IsOk()) return result;
+    }
+    return Result<void>::Ok();
+}
+
+} // namespace
+
+// ============================================================================
+// Export
+// ============================================================================
+
+Result<ExportStats> ExportHistory(const ShareArchive* archive, PoolDatabase* database,
+                                  const ExportOptions& options, const ExportSink& sink) {
+    ExportStats stats;
+    if (options.to <= options.from) {
+        return Result<ExportStats>::Error("Export range is empty");
+    }
+    if ((options.tables & ~static_cast<uint32_t>(EXPORT_ALL)) != 0 || options.tables == 0) {
+        return Result<ExportStats>::Error("Invalid export tables");
+    }
+    if ((options.tables & (EXPORT_SHARES | EXPORT_ROUNDS)) && !archive) {
+        return Result<ExportStats>::Error("Share archive not available");
+    }
+    if ((options.tables & EXPORT_PAYMENTS) && !database) {
+        return Result<ExportStats>::Error("Pool database not available");
+    }
+
+    ExportWriter writer(sink, stats);
+    Result<void> result = Result<void>::Ok();
+
+    if (options.format == ExportFormat::CSV) {
+        if (!SingleTable(options.tables)) {
+            return Result<ExportStats>::Error("CSV export needs exactly one table");
+        }
+        CsvBuffer csv(writer);
+        if (options.tables == EXPORT_SHARES) {
+            result = ExportSharesCsv(*archive, options, csv, stats);
+        } else if (options.tables == EXPORT_ROUNDS) {
+            result = ExportRoundsCsv(*archive, database, options, csv, stats);
+        } else {
+            result = ExportPaymentsCsv(*database, options, csv, stats);
+        }
+        if (result.IsOk()) result = csv.Flush();
+    } else {
+        result = writer.WriteHeader(options.tables, ToMillis(options.from), ToMillis(options.to));
+        if (result.IsOk() && (options.tables & EXPORT_SHARES)) {
+            result = ExportSharesColumnar(*archive, options, writer, stats);
+        }
+        if (result.IsOk() && (options.tables & EXPORT_ROUNDS)) {
+            result = ExportRoundsColumnar(*archive, database, options, writer, stats);
+        }
+        if (result.IsOk() && (options.tables & EXPORT_PAYMENTS)) {
+            result = ExportPaymentsColumnar(*database, options, writer, stats);
+        }
+        if (result.IsOk()) result = writer.WriteChunk(0, 0, {});
+    }
+
+    if (!result.IsOk()) {
+        return Result<ExportStats>::Error("Export failed: " + result.error);
+    }
+    return Result<ExportStats>::Ok(stats);
+}
+
+Result<ExportStats> ReadExport(std::istream& in, const ExportVisitor& visitor) {
+    ExportStats stats;
+
+    uint8_t header[kExportHeaderBytes];
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) || GetLE64(header) != kExportMagic) {
+        return Result<ExportStats>::Error("Not a pool export");
+    }
+    uint32_t version = GetLE32(header + 8);
+    if (version == 0 || version > kExportVersion) {
+        return Result<ExportStats>::Error("Unsupported export version " + std::to_string(version));
+    }
+    stats.bytes += sizeof(header);
+
+    std::vector<uint8_t> payload;
+    while (true) {
+        uint8_t chunk[kChunkHeaderBytes];
+        if (!in.read(reinterpret_cast<char*>(chunk), sizeof(chunk))) {
+            return Result<ExportStats>::Error("Export truncated after " + std::to_string(stats.chunks) + " chunks");
+        }
+        uint32_t table = GetLE32(chunk);
+        uint32_t rows = GetLE32(chunk + 4);
+        uint64_t payload_bytes = GetLE64(chunk + 8);
+        uint32_t crc = GetLE32(chunk + 16);
+        stats.bytes += sizeof(chunk) + payload_bytes;
+        if (table == 0) break;
+
+        // Keep column reads 8-byte aligned
+        payload.resize((payload_bytes + 7) & ~uint64_t{7});
+        if (!in.read(reinterpret_cast<char*>(payload.data()), static_cast<std::streamsize>(payload_bytes))) {
+            return Result<ExportStats>::Error("Export truncated in chunk " + std::to_string(stats.chunks));
+        }
+        if (Crc32c(payload.data(), payload_bytes) != crc) {
+            return Result<ExportStats>::Error("Checksum mismatch in chunk " + std::to_string(stats.chunks));
+        }
+
+        PayloadReader reader(payload.data(), payload_bytes);
+        Result<void> result = Result<void>::Ok();
+        switch (table) {
+            case EXPORT_SHARES:
+                result = ReadSharesChunk(reader, rows, visitor);
+                stats.shares += rows;
+                break;
+            case EXPORT_ROUNDS:
+                result = ReadRoundsChunk(reader, rows, version, visitor);
+                stats.round_rows += rows;
+                break;
+            case EXPORT_PAYMENTS:
+                result = ReadPaymentsChunk(reader, rows, visitor);
+                stats.payments += rows;
+                break;
+            default:
+                result = Result<void>::Error("Unknown export table " + std::to_string(table));
+        }
+        if (!result.IsOk()) {
+            return Result<ExportStats>::Error(result.error);
+        }
+        stats.chunks++;
+    }
+
+    return Result<ExportStats>::Ok(stats);
+}
+
+RoundStatistics RoundFromSummary(const RoundSummary& summary) {
+    RoundStatistics round{};
+    round.round_id = summary.round_id;
+    round.started_at = FromMillis(summary.first_ms);
+    round.ended_at = FromMillis(summary.last_ms);
+    round.shares_submitted = summary.shares;
+    round.total_work = summary.work;
+    round.network_difficulty = summary.network_difficulty;
+    for (const auto& work : summary.miners) {
+        round.miner_shares[work.miner_id] = work.shares;
+    }
+    round.is_complete = true;
+    return round;
+}
+
+} // namespace pool
+} // namespace intcoin
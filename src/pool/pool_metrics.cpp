@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2025 INTcoin Team (Neil Adamson)
+ * MIT License
+ * Mining Pool Metrics (Prometheus)
+ */
+
+#include "intcoin/pool_metrics.h"
+#include <charconv>
+#include <cmath>
+
+namespace intcoin {
+namespace pool {
+
+namespace {
+
+void AppendU64(std::string& out, uint64_t value) {
+    char buf[24];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, static_cast<size_t>(result.ptr - buf));
+}
+
+void AppendDouble(std::string& out, double value) {
+    if (std::isnan(value)) {
+        out += "NaN";
+        return;
+    }
+    if (std::isinf(value)) {
+        out += value > 0 ? "+Inf" : "-Inf";
+        return;
+    }
+    char buf[32];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, static_cast<size_t>(result.ptr - buf));
+}
+
+} // namespace
+
+size_t MetricShard() {
+    static std::atomic<size_t> next{0};
+    thread_local size_t shard = next.fetch_add(1, std::memory_order_relaxed) % kMetricShards;
+    return shard;
+}
+
+// ============================================================================
+// Metric Types
+// ============================================================================
+
+uint64_t Counter::Value() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t Histogram::UpperBound(size_t bucket) {
+    size_t octave = bucket / kSubBuckets;
+    size_t sub = bucket % kSubBuckets;
+    uint64_t quarter = uint64_t{1} << (kMinExponent + octave - 2);
+    return quarter * (kSubBuckets + sub + 1);
+}
+
+void Histogram::Collect(std::array<uint64_t, kBuckets + 1>& counts, uint64_t& sum) const {
+    counts.fill(0);
+    sum = 0;
+    for (const auto& shard : shards_) {
+        for (size_t b = 0; b <= kBuckets; b++) {
+            counts[b] += shard.buckets[b].load(std::memory_order_relaxed);
+        }
+        sum += shard.sum.load(std::memory_order_relaxed);
+    }
+}
+
+// ============================================================================
+// Metrics Registry
+// ============================================================================
+
+MetricsRegistry::Family& MetricsRegistry::FamilyFor(const std::string& name, const std::string& help,
+                                                    Type type) {
+    for (auto& family : families_) {
+        if (family.name == name) return family;
+    }
+
+    static const char* const kTypeNames[] = {"counter", "gauge", "histogram"};
+    Family family;
+    family.name = name;
+    family.header = "# HELP " + name + " " + help + "\n# TYPE " + name + " " +
+                    kTypeNames[static_cast<int>(type)] + "\n";
+    family.type = type;
+    families_.push_back(std::move(family));
+    return families_.back();
+}
+
+Counter& MetricsRegistry::AddCounter(const std::string& name, const std::string& help,
+                                     const std::string& labels) {
+    Counter& counter = counters_.emplace_back();
+    Series series;
+    series.name = labels.empty() ? name : name + "{" + labels + "}";
+    series.metric = &counter;
+    FamilyFor(name, help, Type::COUNTER).series.push_back(std::move(series));
+    return counter;
+}
+
+Gauge& MetricsRegistry::AddGauge(const std::string& name, const std::string& help,
+                                 const std::string& labels) {
+    Gauge& gauge = gauges_.emplace_back();
+    Series series;
+    series.name = labels.empty() ? name : name + "{" + labels + "}";
+    series.metric = &gauge;
+    FamilyFor(name, help, Type::GAUGE).series.push_back(std::move(series));
+    return gauge;
+}
+
+Histogram& MetricsRegistry::AddHistogram(const std::string& name, const std::string& help,
+                                         const std::string& labels) {
+    Histogram& histogram = histograms_.emplace_back();
+    std::string braced = labels.empty() ? "" : "{" + labels + "}";
+    Series series;
+    series.name = name + braced;
+    series.bucket_prefix = name + "_bucket{" + (labels.empty() ? "" : labels + ",") + "le=\"";
+    series.sum_name = name + "_sum" + braced;
+    series.count_name = name + "_count" + braced;
+    series.metric = &histogram;
+    FamilyFor(name, help, Type::HISTOGRAM).series.push_back(std::move(series));
+    return histogram;
+}
+
+void MetricsRegistry::Render(std::string& out) const {
+    size_t start = out.size();
+    out.reserve(start + last_size_.load(std::memory_order_relaxed));
+
+    for (const auto& family : families_) {
+        out += family.header;
+        for (const auto& series : family.series) {
+            switch (family.type) {
+                case Type::COUNTER:
+                    out += series.name;
+                    out += ' ';
+                    AppendU64(out, static_cast<const Counter*>(series.metric)->Value());
+                    out += '\n';
+                    break;
+                case Type::GAUGE:
+                    out += series.name;
+                    out += ' ';
+                    AppendDouble(out, static_cast<const Gauge*>(series.metric)->Value());
+                    out += '\n';
+                    break;
+                case Type::HISTOGRAM: {
+                    std::array<uint64_t, Histogram::kBuckets + 1> counts;
+                    uint64_t sum = 0;
+                    static_cast<const Histogram*>(series.metric)->Collect(counts, sum);
+
+                    // Cumulative from one copy of the counts, so the
+                    // buckets never decrease within a scrape
+                    uint64_t cumulative = 0;
+                    for (size_t b = 0; b < Histogram::kBuckets; b++) {
+                        cumulative += counts[b];
+                        out += series.bucket_prefix;
+                        AppendDouble(out, static_cast<double>(Histogram::UpperBound(b)) / 1e9);
+                        out += "\"} ";
+                        AppendU64(out, cumulative);
+                        out += '\n';
+                    }
+                    cumulative += counts[Histogram::kBuckets];
+                    out += series.bucket_prefix;
+                    out += "+Inf\"} ";
+                    AppendU64(out, cumulative);
+                    out += '\n';
+
+                    out += series.sum_name;
+                    out += ' ';
+                    AppendDouble(out, static_cast<double>(sum) / 1e9);
+                    out += '\n';
+                    out += series.count_name;
+                    out += ' ';
+                    AppendU64(out, cumulative);
+                    out += '\n';
+                    break;
+                }
+            }
+        }
+    }
+
+    // Room for the next scrape to grow a little without reallocating
+    size_t rendered = out.size() - start;
+    last_size_.store(rendered + rendered / 8, std::memory_order_relaxed);
+}
+
+// ============================================================================
+// Pool Metrics
+// ============================================================================
+
+PoolMetrics::PoolMetrics()
+    : shares_accepted(registry.AddCounter("intcoin_pool_shares_total", "Shares submitted over Stratum",
+                                          "result=\"accepted\""))
+    , shares_rejected(registry.AddCounter("intcoin_pool_shares_total", "Shares submitted over Stratum",
+                                          "result=\"rejected\""))
+    , blocks_found(registry.AddCounter("intcoin_pool_blocks_found_total", "Blocks found by the pool"))
+    , connections_total(registry.AddCounter("intcoin_pool_connections_total", "Stratum connections accepted"))
+    , connections(registry.AddGauge("intcoin_pool_connections", "Open Stratum connections"))
+    , pool_hashrate(registry.AddGauge("intcoin_pool_hashrate", "Pool hashrate over 10 minutes (H/s)"))
+    , network_height(registry.AddGauge("intcoin_pool_network_height", "Best block height"))
+    , network_difficulty(registry.AddGauge("intcoin_pool_network_difficulty", "Difficulty of the next block"))
+    , network_hashrate(registry.AddGauge("intcoin_pool_network_hashrate",
+                                         "Network hashrate from recent block times (H/s)"))
+    , pps_fund(registry.AddGauge("intcoin_pool_pps_fund",
+                                 "PPS fund balance; negative while prepaid shares await matured blocks"))
+    , share_validation(registry.AddHistogram("intcoin_pool_share_validation_seconds",
+                                             "Time to validate one share"))
+    , submit_to_ack(registry.AddHistogram("intcoin_pool_submit_ack_seconds",
+                                          "mining.submit received to reply sent"))
+    , notify_fanout(registry.AddHistogram("intcoin_pool_notify_fanout_seconds",
+                                          "Time to send one job to every connection of a port"))
+    , template_build(registry.AddHistogram("intcoin_pool_template_build_seconds",
+                                           "Time to turn a block template into work"))
+    , lock_wait(registry.AddHistogram("intcoin_pool_lock_wait_seconds",
+                                      "Time a share submit waited for the pool lock"))
+{}
+
+} // namespace pool
+} // namespace intcoin
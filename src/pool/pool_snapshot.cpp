@@ -0,0 +1,381 @@
+/*
+ * Copyright (c) 2025 INTcoin Team (Neil Adamson)
+ * MIT License
+ * Mining Pool State Snapshots
+ */
+
+#include "intcoin/pool_storage.h"
+#include "intcoin/util.h"
+#include "file_util.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace intcoin {
+namespace pool {
+
+namespace {
+
+constexpr uint64_t kSnapshotMagic = 0x50414E5350544E49ull;  // "INTPSNAP"
+// Readers accept older versions; 2 added round work and network difficulty
+constexpr uint32_t kSnapshotVersion = 2;
+constexpr size_t kWriteBufferSize = 1 << 20;
+
+std::string SnapshotName(uint64_t journal_seq) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "snapshot-%020llu.snap",
+                  static_cast<unsigned long long>(journal_seq));
+    return name;
+}
+
+/// Snapshot files in dir, newest (highest journal seq) first
+std::vector<std::filesystem::path> ListSnapshots(const std::string& dir) {
+    std::vector<std::filesystem::path> result;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("snapshot-", 0) == 0 && entry.path().extension() == ".snap") {
+            result.push_back(entry.path());
+        }
+    }
+    // Zero-padded names sort numerically
+    std::sort(result.rbegin(), result.rend());
+    return result;
+}
+
+/// Buffered little-endian writer with a running CRC32C
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(int fd) : fd_(fd) { buf_.reserve(kWriteBufferSize); }
+
+    void U8(uint8_t v) { Put(&v, 1); }
+    void U32(uint32_t v) { uint8_t b[4]; PutLE32(b, v); Put(b, 4); }
+    void U64(uint64_t v) { uint8_t b[8]; PutLE64(b, v); Put(b, 8); }
+    void I64(int64_t v) { U64(static_cast<uint64_t>(v)); }
+    void F64(double v) { uint64_t bits; std::memcpy(&bits, &v, 8); U64(bits); }
+    void Str(const std::string& s) { U64(s.size()); Put(s.data(), s.size()); }
+    void Hash(const uint256& h) { Put(h.data(), h.size()); }
+    void Time(std::chrono::system_clock::time_point tp) { I64(ToMillis(tp)); }
+
+    /// Flush the body and append the CRC trailer
+    Result<void> Finish() {
+        Flush();
+        buf_.clear();
+        PutLE32(buf_, crc_);
+        WriteOut();
+        if (!error_.empty()) {
+            return Result<void>::Error(error_);
+        }
+        return Result<void>::Ok();
+    }
+
+private:
+    void Put(const void* data, size_t len) {
+        if (buf_.size() + len > kWriteBufferSize) Flush();
+        buf_.append(static_cast<const char*>(data), len);
+    }
+
+    void Flush() {
+        crc_ = Crc32c(reinterpret_cast<const uint8_t*>(buf_.data()), buf_.size(), crc_);
+        WriteOut();
+    }
+
+    void WriteOut() {
+        if (error_.empty()) {
+            auto result = WriteAll(fd_, buf_.data(), buf_.size());
+            if (!result.IsOk()) error_ = "Snapshot " + result.error;
+        }
+        buf_.clear();
+    }
+
+    int fd_;
+    std::string buf_;
+    uint32_t crc_ = 0;
+    std::string error_;
+};
+
+/// Bounds-checked reader over a mapped snapshot body
+class SnapshotReader {
+public:
+    SnapshotReader(const uint8_t* data, size_t size) : p_(data), end_(data + size) {}
+
+    bool ok() const { return ok_; }
+
+    uint8_t U8() { return Need(1) ? *p_++ : 0; }
+    uint32_t U32() {
+        if (!Need(4)) return 0;
+        uint32_t v = GetLE32(p_);
+        p_ += 4;
+        return v;
+    }
+    uint64_t U64() {
+        if (!Need(8)) return 0;
+        uint64_t v = GetLE64(p_);
+        p_ += 8;
+        return v;
+    }
+    int64_t I64() { return static_cast<int64_t>(U64()); }
+    double F64() { uint64_t bits = U64(); double v; std::memcpy(&v, &bits, 8); return v; }
+    std::string Str() {
+        uint64_t len = U64();
+        if (!Need(len)) return {};
+        std::string s(reinterpret_cast<const char*>(p_), len);
+        p_ += len;
+        return s;
+    }
+    uint256 Hash() {
+        uint256 h{};
+        if (!Need(h.size())) return h;
+        std::memcpy(h.data(), p_, h.size());
+        p_ += h.size();
+        return h;
+    }
+    std::chrono::system_clock::time_point Time() { return FromMillis(I64()); }
+
+private:
+    bool Need(uint64_t n) {
+        if (!ok_ || static_cast<uint64_t>(end_ - p_) < n) ok_ = false;
+        return ok_;
+    }
+
+    const uint8_t* p_;
+    const uint8_t* end_;
+    bool ok_ = true;
+};
+
+void WriteRound(SnapshotWriter& w, const RoundStatistics& round) {
+    w.U64(round.round_id);
+    w.Time(round.started_at);
+    w.Time(round.ended_at);
+    w.U64(round.shares_submitted);
+    w.U64(round.block_height);
+    w.Hash(round.block_hash);
+    w.U64(round.block_reward);
+    w.U64(round.miner_shares.size());
+    for (const auto& [miner_id, count] : round.miner_shares) {
+        w.U64(miner_id);
+        w.U64(count);
+    }
+    w.U8(round.is_complete ? 1 : 0);
+    w.U64(round.total_work);
+    w.U64(round.network_difficulty);
+}
+
+void ReadRound(SnapshotReader& r, uint32_t version, RoundStatistics& round) {
+    round.round_id = r.U64();
+    round.started_at = r.Time();
+    round.ended_at = r.Time();
+    round.shares_submitted = r.U64();
+    round.block_height = r.U64();
+    round.block_hash = r.Hash();
+    round.block_reward = r.U64();
+    uint64_t entries = r.U64();
+    round.miner_shares.clear();
+    for (uint64_t i = 0; i < entries && r.ok(); i++) {
+        uint64_t miner_id = r.U64();
+        round.miner_shares.emplace_hint(round.miner_shares.end(), miner_id, r.U64());
+    }
+    round.is_complete = r.U8() != 0;
+    if (version >= 2) {
+        round.total_work = r.U64();
+        round.network_difficulty = r.U64();
+    }
+}
+
+void WriteMiner(SnapshotWriter& w, const Miner& miner) {
+    w.U64(miner.miner_id);
+    w.Str(miner.username);
+    w.Str(miner.payout_address);
+    w.Str(miner.email);
+    w.U64(miner.total_shares_submitted);
+    w.U64(miner.total_shares_accepted);
+    w.U64(miner.total_shares_rejected);
+    w.U64(miner.total_blocks_found);
+    w.F64(miner.total_hashrate);
+    w.U64(miner.unpaid_balance);
+    w.U64(miner.paid_balance);
+    w.U64(miner.estimated_earnings);
+    w.Time(miner.last_payout);
+    w.U64(miner.invalid_share_count);
+    w.U8(miner.is_banned ? 1 : 0);
+    w.Time(miner.ban_expires);
+    w.Time(miner.registered_at);
+    w.Time(miner.last_seen);
+}
+
+void ReadMiner(SnapshotReader& r, Miner& miner) {
+    miner.miner_id = r.U64();
+    miner.username = r.Str();
+    miner.payout_address = r.Str();
+    miner.email = r.Str();
+    miner.total_shares_submitted = r.U64();
+    miner.total_shares_accepted = r.U64();
+    miner.total_shares_rejected = r.U64();
+    miner.total_blocks_found = r.U64();
+    miner.total_hashrate = r.F64();
+    miner.unpaid_balance = r.U64();
+    miner.paid_balance = r.U64();
+    miner.estimated_earnings = r.U64();
+    miner.last_payout = r.Time();
+    miner.invalid_share_count = r.U64();
+    miner.is_banned = r.U8() != 0;
+    miner.ban_expires = r.Time();
+    miner.registered_at = r.Time();
+    miner.last_seen = r.Time();
+}
+
+/// Parse one snapshot file; fails on any checksum or framing error
+Result<PoolSnapshot> LoadSnapshotFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return Result<PoolSnapshot>::Error("Failed to open " + path);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < 4) {
+        ::close(fd);
+        return Result<PoolSnapshot>::Error("Snapshot truncated: " + path);
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return Result<PoolSnapshot>::Error("Failed to map " + path);
+    }
+    ::madvise(addr, size, MADV_SEQUENTIAL);
+
+    const uint8_t* data = static_cast<const uint8_t*>(addr);
+    size_t body = size - 4;
+    uint32_t stored_crc = 0;
+    for (int i = 3; i >= 0; i--) stored_crc = (stored_crc << 8) | data[body + i];
+
+    // Verify the checksum alongside parsing; the parse is discarded on mismatch
+    auto crc_ok = std::async(std::launch::async, [data, body, stored_crc]() {
+        return Crc32c(data, body) == stored_crc;
+    });
+
+    Result<PoolSnapshot> result = Result<PoolSnapshot>::Error("Snapshot malformed: " + path);
+    {
+        SnapshotReader r(data, body);
+        PoolSnapshot snapshot;
+
+        bool header_ok = r.U64() == kSnapshotMagic;
+        uint32_t version = r.U32();
+        header_ok = header_ok && version >= 1 && version <= kSnapshotVersion;
+        r.U32();  // reserved
+        snapshot.journal_seq = r.U64();
+        snapshot.created_at = r.Time();
+        snapshot.next_miner_id = r.U64();
+        snapshot.next_worker_id = r.U64();
+        snapshot.next_share_id = r.U64();
+        snapshot.next_round_id = r.U64();
+        snapshot.next_payment_id = r.U64();
+        ReadRound(r, version, snapshot.current_round);
+
+        // Miners are written in id order, so every insert lands at the end
+        uint64_t miner_count = r.U64();
+        for (uint64_t i = 0; i < miner_count && r.ok(); i++) {
+            Miner miner;
+            ReadMiner(r, miner);
+            uint64_t id = miner.miner_id;
+            snapshot.miners.emplace_hint(snapshot.miners.end(), id, std::move(miner));
+        }
+
+        if (!crc_ok.get()) {
+            result = Result<PoolSnapshot>::Error("Snapshot checksum mismatch: " + path);
+        } else if (header_ok && r.ok()) {
+            result = Result<PoolSnapshot>::Ok(std::move(snapshot));
+        }
+    }
+
+    ::munmap(addr, size);
+    return result;
+}
+
+} // namespace
+
+// ============================================================================
+// Snapshot Store
+// ============================================================================
+
+SnapshotStore::SnapshotStore(const std::string& dir, size_t keep)
+    : dir_(dir), keep_(std::max<size_t>(keep, 1)) {}
+
+Result<void> SnapshotStore::Write(const PoolSnapshot& snapshot) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    if (ec) {
+        return Result<void>::Error("Failed to create snapshot directory: " + ec.message());
+    }
+
+    std::string final_path = (std::filesystem::path(dir_) / SnapshotName(snapshot.journal_seq)).string();
+    std::string tmp_path = final_path + ".tmp";
+
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return Result<void>::Error("Failed to create " + tmp_path + ": " + std::strerror(errno));
+    }
+
+    SnapshotWriter w(fd);
+    w.U64(kSnapshotMagic);
+    w.U32(kSnapshotVersion);
+    w.U32(0);
+    w.U64(snapshot.journal_seq);
+    w.Time(snapshot.created_at);
+    w.U64(snapshot.next_miner_id);
+    w.U64(snapshot.next_worker_id);
+    w.U64(snapshot.next_share_id);
+    w.U64(snapshot.next_round_id);
+    w.U64(snapshot.next_payment_id);
+    WriteRound(w, snapshot.current_round);
+
+    w.U64(snapshot.miners.size());
+    for (const auto& [miner_id, miner] : snapshot.miners) {
+        WriteMiner(w, miner);
+    }
+
+    auto result = w.Finish();
+    if (result.IsOk() && ::fsync(fd) != 0) {
+        result = Result<void>::Error(std::string("Snapshot fsync failed: ") + std::strerror(errno));
+    }
+    ::close(fd);
+
+    if (!result.IsOk()) {
+        std::filesystem::remove(tmp_path, ec);
+        return result;
+    }
+
+    std::filesystem::rename(tmp_path, final_path, ec);
+    if (ec) {
+        return Result<void>::Error("Failed to publish snapshot: " + ec.message());
+    }
+    SyncDirectory(dir_);
+
+    // Prune older snapshots
+    auto snapshots = ListSnapshots(dir_);
+    for (size_t i = keep_; i < snapshots.size(); i++) {
+        std::filesystem::remove(snapshots[i], ec);
+    }
+
+    return Result<void>::Ok();
+}
+
+Result<PoolSnapshot> SnapshotStore::LoadLatest() const {
+    for (const auto& path : ListSnapshots(dir_)) {
+        auto result = LoadSnapshotFile(path.string());
+        if (result.IsOk()) {
+            return result;
+        }
+        LogF(LogLevel::WARNING, "Skipping snapshot: %s", result.error.c_str());
+    }
+    return Result<PoolSnapshot>::Error("No usable snapshot in " + dir_);
+}
+
+} // namespace pool
+} // namespace intcoin
@@ -0,0 +1,1468 @@
+/*
+ * Copyright (c) 2025 INTcoin Team (Neil Adamson)
+ * MIT License
+ * Mining Pool Columnar Share Archive
+ */
+
+#include "intcoin/pool_storage.h"
+#include "intcoin/crypto.h"
+#include "intcoin/util.h"
+#include "file_util.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <shared_mutex>
+#include <unordered_map>
+#include <zstd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace intcoin {
+namespace pool {
+
+namespace {
+
+constexpr uint64_t kArchiveMagic = 0x56435241484E4923ull;  // "#INHARCV"
+constexpr uint32_t kArchiveVersion = 1;
+
+/// Segment metadata, stored in its own 64-byte file
+struct SegmentHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t capacity;
+    int64_t bucket_ms;        // Start of the time bucket this segment covers
+    int64_t min_ts_ms;
+    int64_t max_ts_ms;
+    uint64_t last_seq;        // Journal sequence of the last record
+    uint64_t count;           // Published last, with release ordering
+};
+static_assert(sizeof(SegmentHeader) == 64, "segment header must be 64 bytes");
+
+/// Read-write shared mapping of a fixed-size file
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Unmap(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    Result<void> Map(const std::string& path, size_t bytes, bool create, bool writable = true) {
+        int flags = create ? (O_RDWR | O_CREAT | O_EXCL) : (writable ? O_RDWR : O_RDONLY);
+        fd_ = ::open(path.c_str(), flags, 0644);
+        if (fd_ < 0) {
+            return Result<void>::Error("Failed to open " + path + ": " + std::strerror(errno));
+        }
+
+        // Columns are sized up front; the file stays sparse until written
+        if (create && ::ftruncate(fd_, static_cast<off_t>(bytes)) != 0) {
+            return Result<void>::Error("Failed to size " + path + ": " + std::strerror(errno));
+        }
+
+        int prot = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+        void* addr = ::mmap(nullptr, bytes, prot, MAP_SHARED, fd_, 0);
+        if (addr == MAP_FAILED) {
+            return Result<void>::Error("Failed to map " + path + ": " + std::strerror(errno));
+        }
+
+        data_ = static_cast<uint8_t*>(addr);
+        size_ = bytes;
+        return Result<void>::Ok();
+    }
+
+    bool Sync(size_t bytes) {
+        return !data_ || ::msync(data_, std::min(bytes, size_), MS_SYNC) == 0;
+    }
+
+    void Unmap() {
+        if (data_) {
+            ::munmap(data_, size_);
+            data_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    uint8_t* data() const { return data_; }
+
+private:
+    int fd_ = -1;
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/// Read-only view of one segment's columns, whichever tier holds them
+struct ColumnView {
+    uint64_t n = 0;
+    const int64_t* ts = nullptr;
+    const uint64_t* round = nullptr;
+    const uint64_t* miner = nullptr;
+    const uint64_t* worker = nullptr;
+    const uint64_t* diff = nullptr;
+    const uint8_t* flags = nullptr;
+};
+
+/// Bounds used to skip a segment without reading its columns
+struct SegmentBounds {
+    uint64_t count = 0;
+    uint64_t valid = 0;
+    int64_t min_ts_ms = 0;
+    int64_t max_ts_ms = 0;
+    uint64_t min_round = 0;
+    uint64_t max_round = 0;
+    uint64_t last_seq = 0;
+};
+
+/// One time bucket of shares, one mapped file per column
+struct ArchiveSegment {
+    std::string path;
+    uint64_t index = 0;
+    MappedFile meta;
+    MappedFile ts;
+    MappedFile round;
+    MappedFile miner;
+    MappedFile worker;
+    MappedFile diff;
+    MappedFile flags;
+
+    SegmentHeader* header() const { return reinterpret_cast<SegmentHeader*>(meta.data()); }
+    int64_t* ts_col() const { return reinterpret_cast<int64_t*>(ts.data()); }
+    uint64_t* round_col() const { return reinterpret_cast<uint64_t*>(round.data()); }
+    uint64_t* miner_col() const { return reinterpret_cast<uint64_t*>(miner.data()); }
+    uint64_t* worker_col() const { return reinterpret_cast<uint64_t*>(worker.data()); }
+    uint64_t* diff_col() const { return reinterpret_cast<uint64_t*>(diff.data()); }
+    uint8_t* flags_col() const { return flags.data(); }
+
+    uint64_t Count() const {
+        return std::atomic_ref<uint64_t>(header()->count).load(std::memory_order_acquire);
+    }
+    int64_t MinTs() const {
+        return std::atomic_ref<int64_t>(header()->min_ts_ms).load(std::memory_order_relaxed);
+    }
+    int64_t MaxTs() const {
+        return std::atomic_ref<int64_t>(header()->max_ts_ms).load(std::memory_order_relaxed);
+    }
+
+    // Round range and valid share count, kept in memory for compaction
+    // (rebuilt from the columns on open)
+    std::atomic<uint64_t> min_round{0};
+    std::atomic<uint64_t> max_round{0};
+    std::atomic<uint64_t> valid{0};
+
+    void Track(uint64_t i, uint64_t round_id, uint8_t flag_bits) {
+        if (i == 0 || round_id < min_round.load(std::memory_order_relaxed)) {
+            min_round.store(round_id, std::memory_order_relaxed);
+        }
+        if (i == 0 || round_id > max_round.load(std::memory_order_relaxed)) {
+            max_round.store(round_id, std::memory_order_relaxed);
+        }
+        if (flag_bits & JOURNAL_SHARE_VALID) {
+            valid.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    ColumnView View() const {
+        return {Count(), ts_col(), round_col(), miner_col(), worker_col(), diff_col(), flags_col()};
+    }
+
+    SegmentBounds Bounds() const {
+        SegmentBounds bounds;
+        bounds.count = Count();
+        bounds.valid = valid.load(std::memory_order_relaxed);
+        bounds.min_ts_ms = MinTs();
+        bounds.max_ts_ms = MaxTs();
+        bounds.min_round = min_round.load(std::memory_order_relaxed);
+        bounds.max_round = max_round.load(std::memory_order_relaxed);
+        bounds.last_seq = std::atomic_ref<uint64_t>(header()->last_seq).load(std::memory_order_relaxed);
+        return bounds;
+    }
+
+    bool SyncAll() {
+        uint64_t n = Count();
+        bool ok = ts.Sync(n * sizeof(int64_t));
+        ok &= round.Sync(n * sizeof(uint64_t));
+        ok &= miner.Sync(n * sizeof(uint64_t));
+        ok &= worker.Sync(n * sizeof(uint64_t));
+        ok &= diff.Sync(n * sizeof(uint64_t));
+        ok &= flags.Sync(n);
+        ok &= meta.Sync(sizeof(SegmentHeader));
+        return ok;
+    }
+};
+
+std::string SegmentDirName(uint64_t index) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "segment-%08llu", static_cast<unsigned long long>(index));
+    return name;
+}
+
+void Accumulate(ShareTotals& totals, int64_t ts, uint64_t difficulty) {
+    if (totals.shares == 0 || ts < totals.first_ms) totals.first_ms = ts;
+    if (totals.shares == 0 || ts > totals.last_ms) totals.last_ms = ts;
+    totals.shares++;
+    totals.work += difficulty;
+}
+
+// ============================================================================
+// Cold Segments (cold-<index>.zst)
+// ============================================================================
+
+constexpr uint64_t kColdMagic = 0x444C4F43484E4923ull;  // "#INHCOLD"
+constexpr uint32_t kColdVersion = 1;
+
+// Bytes per record once the columns are laid end to end
+constexpr size_t kColdRecordBytes = 5 * sizeof(uint64_t) + sizeof(uint8_t);
+
+/// Cold file header; the payload that follows is one zstd frame holding the
+/// ts (delta-encoded), round, miner, worker, diff and flags columns in turn
+struct ColdHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t crc;             // CRC32C of the compressed payload
+    uint64_t count;
+    uint64_t valid;
+    int64_t min_ts_ms;
+    int64_t max_ts_ms;
+    uint64_t min_round;
+    uint64_t max_round;
+    uint64_t last_seq;
+    uint64_t payload_bytes;
+};
+static_assert(sizeof(ColdHeader) == 80, "cold header must be 80 bytes");
+
+/// A compressed segment; only the header is held in memory
+struct ColdSegment {
+    std::string path;
+    uint64_t index = 0;
+    uint64_t file_bytes = 0;
+    SegmentBounds bounds;
+};
+
+/// Columns of a cold segment, decompressed for one scan
+struct ColdColumns {
+    std::vector<int64_t> ts;
+    std::vector<uint64_t> round;
+    std::vector<uint64_t> miner;
+    std::vector<uint64_t> worker;
+    std::vector<uint64_t> diff;
+    std::vector<uint8_t> flags;
+
+    void Clear() {
+        ts.clear();
+        round.clear();
+        miner.clear();
+        worker.clear();
+        diff.clear();
+        flags.clear();
+    }
+
+    ColumnView View() const {
+        return {ts.size(), ts.data(), round.data(), miner.data(), worker.data(), diff.data(), flags.data()};
+    }
+};
+
+std::string ColdFileName(uint64_t index) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "cold-%08llu.zst", static_cast<unsigned long long>(index));
+    return name;
+}
+
+/// Compress a sealed segment to path (tmp -> fsync -> rename -> dir sync)
+Result<void> WriteColdSegment(const std::string& path, const ColumnView& view,
+                              const SegmentBounds& bounds, int level, uint64_t& file_bytes) {
+    // Timestamps are near-monotonic, so deltas compress to a byte or two
+    std::vector<uint8_t> raw(view.n * kColdRecordBytes);
+    uint8_t* out = raw.data();
+    int64_t prev = 0;
+    for (uint64_t i = 0; i < view.n; i++) {
+        int64_t delta = view.ts[i] - prev;
+        prev = view.ts[i];
+        std::memcpy(out, &delta, sizeof(delta));
+        out += sizeof(delta);
+    }
+    for (const uint64_t* column : {view.round, view.miner, view.worker, view.diff}) {
+        std::memcpy(out, column, view.n * sizeof(uint64_t));
+        out += view.n * sizeof(uint64_t);
+    }
+    std::memcpy(out, view.flags, view.n);
+
+    std::vector<uint8_t> payload(ZSTD_compressBound(raw.size()));
+    size_t compressed = ZSTD_compress(payload.data(), payload.size(), raw.data(), raw.size(), level);
+    if (ZSTD_isError(compressed)) {
+        return Result<void>::Error(std::string("zstd compression failed: ") + ZSTD_getErrorName(compressed));
+    }
+
+    ColdHeader header{};
+    header.magic = kColdMagic;
+    header.version = kColdVersion;
+    header.crc = Crc32c(payload.data(), compressed);
+    header.count = view.n;
+    header.valid = bounds.valid;
+    header.min_ts_ms = bounds.min_ts_ms;
+    header.max_ts_ms = bounds.max_ts_ms;
+    header.min_round = bounds.min_round;
+    header.max_round = bounds.max_round;
+    header.last_seq = bounds.last_seq;
+    header.payload_bytes = compressed;
+
+    std::string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return Result<void>::Error("Failed to create " + tmp + ": " + std::strerror(errno));
+    }
+    auto written = WriteAll(fd, &header, sizeof(header));
+    if (written.IsOk()) written = WriteAll(fd, payload.data(), compressed);
+    if (written.IsOk() && ::fsync(fd) != 0) {
+        written = Result<void>::Error(std::string("fsync failed: ") + std::strerror(errno));
+    }
+    ::close(fd);
+    if (!written.IsOk()) {
+        ::unlink(tmp.c_str());
+        return Result<void>::Error("Failed to write " + tmp + ": " + written.error);
+    }
+
+    if (::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::string error = "Failed to rename " + tmp + ": " + std::strerror(errno);
+        ::unlink(tmp.c_str());
+        return Result<void>::Error(error);
+    }
+
+    SyncDirectory(std::filesystem::path(path).parent_path().string());
+
+    file_bytes = sizeof(header) + compressed;
+    return Result<void>::Ok();
+}
+
+/// Read a cold file's header into the in-memory index
+Result<void> ReadColdHeader(const std::string& path, ColdSegment& out) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return Result<void>::Error("Failed to open " + path + ": " + std::strerror(errno));
+    }
+    ColdHeader header{};
+    ssize_t n = ::pread(fd, &header, sizeof(header), 0);
+    off_t size = ::lseek(fd, 0, SEEK_END);
+    ::close(fd);
+
+    if (n != static_cast<ssize_t>(sizeof(header)) || header.magic != kColdMagic ||
+        header.version != kColdVersion ||
+        static_cast<uint64_t>(size) != sizeof(header) + header.payload_bytes) {
+        return Result<void>::Error("Bad cold segment: " + path);
+    }
+
+    out.path = path;
+    out.file_bytes = static_cast<uint64_t>(size);
+    out.bounds.count = header.count;
+    out.bounds.valid = header.valid;
+    out.bounds.min_ts_ms = header.min_ts_ms;
+    out.bounds.max_ts_ms = header.max_ts_ms;
+    out.bounds.min_round = header.min_round;
+    out.bounds.max_round = header.max_round;
+    out.bounds.last_seq = header.last_seq;
+    return Result<void>::Ok();
+}
+
+/// Decompress a cold file's columns
+Result<void> LoadColdColumns(const std::string& path, ColdColumns& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return Result<void>::Error("Failed to open " + path);
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < sizeof(ColdHeader)) {
+        return Result<void>::Error("Truncated cold segment: " + path);
+    }
+
+    ColdHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    const uint8_t* payload = reinterpret_cast<const uint8_t*>(data.data()) + sizeof(header);
+    size_t payload_bytes = data.size() - sizeof(header);
+    if (header.magic != kColdMagic || header.payload_bytes != payload_bytes ||
+        Crc32c(payload, payload_bytes) != header.crc) {
+        return Result<void>::Error("Corrupt cold segment: " + path);
+    }
+
+    uint64_t n = header.count;
+    std::vector<uint8_t> raw(n * kColdRecordBytes);
+    size_t got = ZSTD_decompress(raw.data(), raw.size(), payload, payload_bytes);
+    if (ZSTD_isError(got) || got != raw.size()) {
+        return Result<void>::Error("Failed to decompress cold segment: " + path);
+    }
+
+    const uint8_t* in = raw.data();
+    out.ts.resize(n);
+    int64_t ts = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        int64_t delta;
+        std::memcpy(&delta, in, sizeof(delta));
+        in += sizeof(delta);
+        ts += delta;
+        out.ts[i] = ts;
+    }
+    for (auto* column : {&out.round, &out.miner, &out.worker, &out.diff}) {
+        column->resize(n);
+        std::memcpy(column->data(), in, n * sizeof(uint64_t));
+        in += n * sizeof(uint64_t);
+    }
+    out.flags.assign(in, in + n);
+    return Result<void>::Ok();
+}
+
+// ============================================================================
+// Round Summaries (rounds.dat)
+// ============================================================================
+
+// Record: | crc32c(4) | body_len(4) | body |, crc over body
+// Body:   round_id | shares | work | first_ms | last_ms | root(32) | count |
+//         count x (miner_id | shares | work), all little-endian
+constexpr size_t kSummaryFrame = 8;
+
+std::string EncodeSummary(const RoundSummary& summary) {
+    std::string body;
+    body.reserve(80 + summary.miners.size() * 24);
+    PutLE64(body, summary.round_id);
+    PutLE64(body, summary.shares);
+    PutLE64(body, summary.work);
+    PutLE64(body, static_cast<uint64_t>(summary.first_ms));
+    PutLE64(body, static_cast<uint64_t>(summary.last_ms));
+    body.append(reinterpret_cast<const char*>(summary.merkle_root.data()), summary.merkle_root.size());
+    PutLE64(body, summary.miners.size());
+    for (const auto& miner : summary.miners) {
+        PutLE64(body, miner.miner_id);
+        PutLE64(body, miner.shares);
+        PutLE64(body, miner.work);
+    }
+
+    uint32_t crc = Crc32c(reinterpret_cast<const uint8_t*>(body.data()), body.size());
+    uint32_t len = static_cast<uint32_t>(body.size());
+    std::string record;
+    record.reserve(kSummaryFrame + body.size());
+    PutLE32(record, crc);
+    PutLE32(record, len);
+    record += body;
+    return record;
+}
+
+bool DecodeSummary(const uint8_t* body, size_t len, RoundSummary& summary) {
+    constexpr size_t kFixed = 5 * 8 + 32 + 8;
+    if (len < kFixed) return false;
+    summary.round_id = GetLE64(body);
+    summary.shares = GetLE64(body + 8);
+    summary.work = GetLE64(body + 16);
+    summary.first_ms = static_cast<int64_t>(GetLE64(body + 24));
+    summary.last_ms = static_cast<int64_t>(GetLE64(body + 32));
+    std::memcpy(summary.merkle_root.data(), body + 40, 32);
+    uint64_t count = GetLE64(body + 72);
+    if (count > (len - kFixed) / 24 || len != kFixed + count * 24) return false;
+
+    summary.miners.resize(count);
+    const uint8_t* p = body + kFixed;
+    for (auto& miner : summary.miners) {
+        miner.miner_id = GetLE64(p);
+        miner.shares = GetLE64(p + 8);
+        miner.work = GetLE64(p + 16);
+        p += 24;
+    }
+    return true;
+}
+
+uint256 HashPair(const uint256& left, const uint256& right) {
+    std::vector<uint8_t> buf(left.begin(), left.end());
+    buf.insert(buf.end(), right.begin(), right.end());
+    return SHA3::Hash(buf);
+}
+
+/// Commit the tree to its leaf count. An odd level pairs its last node
+/// with itself, so without this [a,b,c] and [a,b,c,c] share a root.
+uint256 BindLeafCount(const uint256& tree_root, uint64_t leaf_count) {
+    std::string buf;
+    PutLE64(buf, leaf_count);
+    buf.append(reinterpret_cast<const char*>(tree_root.data()), tree_root.size());
+    return SHA3::Hash(std::vector<uint8_t>(buf.begin(), buf.end()));
+}
+
+std::vector<uint256> MerkleLeaves(const RoundSummary& summary) {
+    std::vector<uint256> leaves;
+    leaves.reserve(summary.miners.size());
+    for (const auto& miner : summary.miners) {
+        leaves.push_back(RoundWorkLeaf(summary.round_id, miner));
+    }
+    return leaves;
+}
+
+} // namespace
+
+// ============================================================================
+// Round Merkle Commitment
+// ============================================================================
+
+uint256 RoundWorkLeaf(uint64_t round_id, const RoundWork& work) {
+    std::string buf;
+    PutLE64(buf, round_id);
+    PutLE64(buf, work.miner_id);
+    PutLE64(buf, work.shares);
+    PutLE64(buf, work.work);
+    return SHA3::Hash(std::vector<uint8_t>(buf.begin(), buf.end()));
+}
+
+uint256 RoundMerkleRoot(const RoundSummary& summary) {
+    std::vector<uint256> level = MerkleLeaves(summary);
+    if (level.empty()) return uint256{};
+
+    while (level.size() > 1) {
+        std::vector<uint256> next;
+        next.reserve((level.size() + 1) / 2);
+        for (size_t i = 0; i < level.size(); i += 2) {
+            next.push_back(HashPair(level[i], level[std::min(i + 1, level.size() - 1)]));
+        }
+        level = std::move(next);
+    }
+    return BindLeafCount(level[0], summary.miners.size());
+}
+
+std::vector<uint256> RoundMerkleProof(const RoundSummary& summary, size_t index) {
+    std::vector<uint256> proof;
+    std::vector<uint256> level = MerkleLeaves(summary);
+    if (index >= level.size()) return proof;
+
+    while (level.size() > 1) {
+        size_t sibling = (index % 2 == 0) ? std::min(index + 1, level.size() - 1) : index - 1;
+        proof.push_back(level[sibling]);
+
+        std::vector<uint256> next;
+        next.reserve((level.size() + 1) / 2);
+        for (size_t i = 0; i < level.size(); i += 2) {
+            next.push_back(HashPair(level[i], level[std::min(i + 1, level.size() - 1)]));
+        }
+        level = std::move(next);
+        index /= 2;
+    }
+    return proof;
+}
+
+bool VerifyRoundMerkleProof(uint64_t round_id, const RoundWork& work, size_t index, size_t leaf_count,
+                            const std::vector<uint256>& proof, const uint256& root) {
+    if (index >= leaf_count) return false;
+    uint256 hash = RoundWorkLeaf(round_id, work);
+    for (const auto& sibling : proof) {
+        hash = (index % 2 == 0) ? HashPair(hash, sibling) : HashPair(sibling, hash);
+        index /= 2;
+    }
+    return BindLeafCount(hash, leaf_count) == root;
+}
+
+// ============================================================================
+// Share Archive Implementation
+// ============================================================================
+
+class ShareArchive::Impl {
+public:
+    explicit Impl(const ShareArchiveOptions& options) : options_(options) {}
+
+    ShareArchiveOptions options_;
+
+    // Readers take a snapshot of the segment lists and scan without holding
+    // the lock; compaction or migration can drop a segment while a scan
+    // still maps it.
+    mutable std::shared_mutex segments_mutex_;
+    std::vector<std::shared_ptr<ArchiveSegment>> segments_;
+    std::vector<std::shared_ptr<const ColdSegment>> cold_;   // Older than segments_
+    uint64_t next_segment_index_ = 0;
+    bool seal_failed_ = false;   // A sealed segment failed to msync; Sync() retries all
+
+    std::mutex write_mutex_;
+
+    // Hot tier: the newest records, in archive order, as a ring
+    struct HotRecord {
+        int64_t ts;
+        uint64_t round;
+        uint64_t miner;
+        uint64_t worker;
+        uint64_t diff;
+        uint8_t flags;
+    };
+    mutable std::shared_mutex hot_mutex_;
+    std::vector<HotRecord> hot_;
+    size_t hot_next_ = 0;         // Slot the next record goes into
+    size_t hot_count_ = 0;
+    uint64_t hot_valid_ = 0;
+
+    // Compacted rounds: offset of each record in rounds.dat
+    mutable std::mutex rounds_mutex_;
+    std::map<uint64_t, std::pair<uint64_t, uint32_t>> round_index_;
+    uint64_t rounds_size_ = 0;
+    std::atomic<uint64_t> compacted_round_{0};
+
+    // Serializes Compact() and MigrateCold()
+    std::mutex maintenance_mutex_;
+
+    struct Tiers {
+        std::vector<std::shared_ptr<const ColdSegment>> cold;
+        std::vector<std::shared_ptr<ArchiveSegment>> warm;
+    };
+
+    std::string RoundsPath() const {
+        return (std::filesystem::path(options_.dir) / "rounds.dat").string();
+    }
+
+    Tiers Snapshot() const {
+        std::shared_lock<std::shared_mutex> lock(segments_mutex_);
+        return {cold_, segments_};
+    }
+
+    /// Visit every segment whose bounds pass want(), oldest first or newest
+    /// first, until fn() returns false. Cold segments are decompressed only
+    /// when visited; one that fails to load is logged and skipped.
+    template <typename Want, typename Fn>
+    void Visit(const Tiers& tiers, bool newest_first, Want want, Fn fn) const {
+        auto visit_cold = [&](const ColdSegment& cold) {
+            if (cold.bounds.count == 0 || !want(cold.bounds)) return true;
+            ColdColumns columns;
+            auto loaded = LoadColdColumns(cold.path, columns);
+            if (!loaded.IsOk()) {
+                LogF(LogLevel::WARNING, "Share archive: skipping %s (%s)", cold.path.c_str(),
+                     loaded.error.c_str());
+                return true;
+            }
+            return fn(columns.View(), cold.bounds);
+        };
+        auto visit_warm = [&](const ArchiveSegment& segment) {
+            SegmentBounds bounds = segment.Bounds();
+            if (bounds.count == 0 || !want(bounds)) return true;
+            ColumnView view = segment.View();
+            view.n = bounds.count;
+            return fn(view, bounds);
+        };
+
+        if (newest_first) {
+            for (auto it = tiers.warm.rbegin(); it != tiers.warm.rend(); ++it) {
+                if (!visit_warm(**it)) return;
+            }
+            for (auto it = tiers.cold.rbegin(); it != tiers.cold.rend(); ++it) {
+                if (!visit_cold(**it)) return;
+            }
+        } else {
+            for (const auto& cold : tiers.cold) {
+                if (!visit_cold(*cold)) return;
+            }
+            for (const auto& segment : tiers.warm) {
+                if (!visit_warm(*segment)) return;
+            }
+        }
+    }
+
+    /// Add a record to the hot ring (caller holds hot_mutex_ exclusively)
+    void HotPush(const HotRecord& rec) {
+        if (hot_.empty()) return;
+        if (hot_count_ == hot_.size()) {
+            if (hot_[hot_next_].flags & JOURNAL_SHARE_VALID) hot_valid_--;
+        } else {
+            hot_count_++;
+        }
+        hot_[hot_next_] = rec;
+        if (rec.flags & JOURNAL_SHARE_VALID) hot_valid_++;
+        hot_next_ = (hot_next_ + 1) % hot_.size();
+    }
+
+    /// Refill the hot ring from the newest archived records, whichever
+    /// tier they are in
+    void LoadHot() {
+        std::unique_lock<std::shared_mutex> lock(hot_mutex_);
+        hot_.assign(options_.hot_shares, HotRecord{});
+        hot_next_ = hot_count_ = 0;
+        hot_valid_ = 0;
+        if (hot_.empty()) return;
+
+        // Gather newest first, then push oldest first to keep archive order
+        std::vector<HotRecord> newest;
+        newest.reserve(hot_.size());
+        Visit(Snapshot(), true, [](const SegmentBounds&) { return true; },
+              [&](const ColumnView& view, const SegmentBounds&) {
+                  for (uint64_t i = view.n; i > 0 && newest.size() < hot_.size(); i--) {
+                      newest.push_back({view.ts[i - 1], view.round[i - 1], view.miner[i - 1],
+                                        view.worker[i - 1], view.diff[i - 1], view.flags[i - 1]});
+                  }
+                  return newest.size() < hot_.size();
+              });
+        for (auto it = newest.rbegin(); it != newest.rend(); ++it) {
+            HotPush(*it);
+        }
+    }
+
+    /// Index rounds.dat, truncating a torn final record
+    Result<void> LoadRoundIndex() {
+        std::string path = RoundsPath();
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return Result<void>::Ok();
+
+        std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        const uint8_t* base = reinterpret_cast<const uint8_t*>(data.data());
+
+        std::lock_guard<std::mutex> lock(rounds_mutex_);
+        uint64_t offset = 0;
+        while (offset + kSummaryFrame <= data.size()) {
+            uint32_t crc = GetLE32(base + offset);
+            uint32_t len = GetLE32(base + offset + 4);
+            if (offset + kSummaryFrame + len > data.size() ||
+                Crc32c(base + offset + kSummaryFrame, len) != crc) {
+                break;
+            }
+            uint64_t round_id = GetLE64(base + offset + kSummaryFrame);
+            round_index_[round_id] = {offset, len};
+            compacted_round_ = std::max(compacted_round_.load(), round_id);
+            offset += kSummaryFrame + len;
+        }
+
+        // A live writer may be mid-append; readers just stop at the tail
+        if (offset < data.size() && !options_.read_only) {
+            LogF(LogLevel::WARNING, "Share archive: truncating torn tail of %s (%zu -> %llu bytes)",
+                 path.c_str(), data.size(), static_cast<unsigned long long>(offset));
+            std::error_code ec;
+            std::filesystem::resize_file(path, offset, ec);
+            if (ec) {
+                return Result<void>::Error("Failed to truncate " + path + ": " + ec.message());
+            }
+        }
+        rounds_size_ = offset;
+        return Result<void>::Ok();
+    }
+
+    /// Append summaries to rounds.dat and make them durable
+    Result<void> WriteSummaries(const std::vector<RoundSummary>& summaries) {
+        std::string path = RoundsPath();
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) {
+            return Result<void>::Error("Failed to open " + path + ": " + std::strerror(errno));
+        }
+
+        std::string buf;
+        std::vector<std::pair<uint64_t, std::pair<uint64_t, uint32_t>>> entries;
+        uint64_t offset = rounds_size_;
+        for (const auto& summary : summaries) {
+            std::string record = EncodeSummary(summary);
+            entries.push_back({summary.round_id,
+                               {offset + buf.size(), static_cast<uint32_t>(record.size() - kSummaryFrame)}});
+            buf += record;
+        }
+
+        const char* p = buf.data();
+        size_t left = buf.size();
+        while (left > 0) {
+            ssize_t n = ::write(fd, p, left);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                std::string error = std::string("Failed to write round summaries: ") + std::strerror(errno);
+                ::ftruncate(fd, static_cast<off_t>(rounds_size_));
+                ::close(fd);
+                return Result<void>::Error(error);
+            }
+            p += n;
+            left -= static_cast<size_t>(n);
+        }
+        if (::fdatasync(fd) != 0) {
+            std::string error = std::string("Failed to sync round summaries: ") + std::strerror(errno);
+            ::close(fd);
+            return Result<void>::Error(error);
+        }
+        ::close(fd);
+
+        std::lock_guard<std::mutex> lock(rounds_mutex_);
+        for (const auto& [round_id, location] : entries) {
+            round_index_[round_id] = location;
+        }
+        rounds_size_ = offset + buf.size();
+        return Result<void>::Ok();
+    }
+
+    Result<void> MapSegment(const std::string& path, uint64_t capacity, bool create,
+                            std::shared_ptr<ArchiveSegment>& out) {
+        auto segment = std::make_shared<ArchiveSegment>();
+        segment->path = path;
+
+        struct Column { MappedFile* file; const char* name; size_t width; };
+        Column columns[] = {
+            {&segment->ts, "ts", sizeof(int64_t)},
+            {&segment->round, "round", sizeof(uint64_t)},
+            {&segment->miner, "miner", sizeof(uint64_t)},
+            {&segment->worker, "worker", sizeof(uint64_t)},
+            {&segment->diff, "diff", sizeof(uint64_t)},
+            {&segment->flags, "flags", sizeof(uint8_t)},
+        };
+
+        bool writable = !options_.read_only;
+        auto meta_result = segment->meta.Map(path + "/meta", sizeof(SegmentHeader), create, writable);
+        if (!meta_result.IsOk()) {
+            return meta_result;
+        }
+
+        if (!create) {
+            const SegmentHeader* header = segment->header();
+            if (header->magic != kArchiveMagic || header->version != kArchiveVersion) {
+                return Result<void>::Error("Bad archive segment header: " + path);
+            }
+            capacity = header->capacity;
+        }
+
+        for (const auto& column : columns) {
+            auto result = column.file->Map(path + "/" + column.name + ".col",
+                                           capacity * column.width, create, writable);
+            if (!result.IsOk()) {
+                return result;
+            }
+        }
+
+        if (!create) {
+            const uint64_t* rounds = segment->round_col();
+            const uint8_t* flags = segment->flags_col();
+            uint64_t n = segment->Count();
+            for (uint64_t i = 0; i < n; i++) {
+                segment->Track(i, rounds[i], flags[i]);
+            }
+        }
+
+        out = std::move(segment);
+        return Result<void>::Ok();
+    }
+
+    Result<ArchiveSegment*> CreateSegment(int64_t bucket_ms) {
+        std::string path = (std::filesystem::path(options_.dir) /
+                            SegmentDirName(next_segment_index_)).string();
+
+        std::error_code ec;
+        std::filesystem::create_directories(path, ec);
+        if (ec) {
+            return Result<ArchiveSegment*>::Error("Failed to create archive segment: " + ec.message());
+        }
+
+        std::shared_ptr<ArchiveSegment> segment;
+        auto mapped = MapSegment(path, options_.segment_capacity, true, segment);
+        if (!mapped.IsOk()) {
+            return Result<ArchiveSegment*>::Error(mapped.error);
+        }
+
+        SegmentHeader* header = segment->header();
+        header->capacity = options_.segment_capacity;
+        header->bucket_ms = bucket_ms;
+        header->min_ts_ms = 0;
+        header->max_ts_ms = 0;
+        header->last_seq = 0;
+        header->count = 0;
+        header->version = kArchiveVersion;
+        header->magic = kArchiveMagic;
+        segment->meta.Sync(sizeof(SegmentHeader));
+
+        segment->index = next_segment_index_;
+        ArchiveSegment* raw = segment.get();
+        std::unique_lock<std::shared_mutex> lock(segments_mutex_);
+
+        // Seal the previous segment before the new one becomes active
+        if (!segments_.empty() && !segments_.back()->SyncAll()) {
+            seal_failed_ = true;
+        }
+        segments_.push_back(std::move(segment));
+        next_segment_index_++;
+        return Result<ArchiveSegment*>::Ok(raw);
+    }
+
+    std::map<uint64_t, ShareTotals> ScanRange(int64_t from_ms, int64_t to_ms,
+                                              const uint64_t* ColumnView::*key_column) const {
+        std::unordered_map<uint64_t, ShareTotals> totals;
+
+        Visit(Snapshot(), false,
+              [&](const SegmentBounds& b) { return b.max_ts_ms >= from_ms && b.min_ts_ms < to_ms; },
+              [&](const ColumnView& view, const SegmentBounds& b) {
+                  const uint64_t* keys = view.*key_column;
+
+                  // Segments wholly inside the range never touch the timestamp test
+                  bool whole = b.min_ts_ms >= from_ms && b.max_ts_ms < to_ms;
+                  for (uint64_t i = 0; i < view.n; i++) {
+                      if (!(view.flags[i] & JOURNAL_SHARE_VALID)) continue;
+                      if (!whole && (view.ts[i] < from_ms || view.ts[i] >= to_ms)) continue;
+                      Accumulate(totals[keys[i]], view.ts[i], view.diff[i]);
+                  }
+                  return true;
+              });
+
+        return std::map<uint64_t, ShareTotals>(totals.begin(), totals.end());
+    }
+
+    /// Visit the last n valid shares newest first as fn(miner, ts, diff)
+    template <typename Fn>
+    void VisitLastShares(uint64_t n, Fn&& fn) const {
+        uint64_t remaining = n;
+
+        // The hot ring covers the usual PPLNS window on its own
+        {
+            std::shared_lock<std::shared_mutex> lock(hot_mutex_);
+            if (n <= hot_valid_) {
+                size_t size = hot_.size();
+                size_t slot = hot_next_;
+                for (size_t k = 0; k < hot_count_ && remaining > 0; k++) {
+                    slot = (slot + size - 1) % size;
+                    const auto& rec = hot_[slot];
+                    if (!(rec.flags & JOURNAL_SHARE_VALID)) continue;
+                    fn(rec.miner, rec.ts, rec.diff);
+                    remaining--;
+                }
+                return;
+            }
+        }
+
+        Visit(Snapshot(), true,
+              [](const SegmentBounds&) { return true; },
+              [&](const ColumnView& view, const SegmentBounds&) {
+                  for (uint64_t i = view.n; i > 0 && remaining > 0; i--) {
+                      if (!(view.flags[i - 1] & JOURNAL_SHARE_VALID)) continue;
+                      fn(view.miner[i - 1], view.ts[i - 1], view.diff[i - 1]);
+                      remaining--;
+                  }
+                  return remaining > 0;
+              });
+    }
+};
+
+ShareArchive::ShareArchive(const ShareArchiveOptions& options)
+    : impl_(std::make_unique<Impl>(options)) {}
+
+ShareArchive::~ShareArchive() {
+    Close();
+}
+
+Result<void> ShareArchive::Open() {
+    const bool read_only = impl_->options_.read_only;
+    std::error_code ec;
+    if (read_only) {
+        if (!std::filesystem::is_directory(impl_->options_.dir, ec)) {
+            return Result<void>::Error("Archive directory not found: " + impl_->options_.dir);
+        }
+    } else {
+        std::filesystem::create_directories(impl_->options_.dir, ec);
+        if (ec) {
+            return Result<void>::Error("Failed to create archive directory: " + ec.message());
+        }
+    }
+
+    // Cold index first: a crash after a migration's rename but before its
+    // warm segment was removed leaves both, and the cold copy wins
+    std::vector<std::shared_ptr<const ColdSegment>> cold;
+    if (!impl_->options_.cold_dir.empty() && !read_only) {
+        std::filesystem::create_directories(impl_->options_.cold_dir, ec);
+        if (ec) {
+            return Result<void>::Error("Failed to create cold archive directory: " + ec.message());
+        }
+    }
+    if (!impl_->options_.cold_dir.empty() && std::filesystem::is_directory(impl_->options_.cold_dir, ec)) {
+        for (const auto& entry : std::filesystem::directory_iterator(impl_->options_.cold_dir)) {
+            std::string name = entry.path().filename().string();
+            if (name.rfind("cold-", 0) != 0) continue;
+            if (entry.path().extension() == ".tmp") {
+                if (!read_only) std::filesystem::remove(entry.path(), ec);
+                continue;
+            }
+
+            auto segment = std::make_shared<ColdSegment>();
+            try {
+                segment->index = std::stoull(name.substr(5));
+            } catch (...) {
+                continue;
+            }
+            auto read = ReadColdHeader(entry.path().string(), *segment);
+            if (!read.IsOk()) {
+                LogF(LogLevel::WARNING, "Share archive: skipping %s", read.error.c_str());
+                continue;
+            }
+            cold.push_back(std::move(segment));
+        }
+        std::sort(cold.begin(), cold.end(), [](const auto& a, const auto& b) { return a->index < b->index; });
+    }
+
+    std::vector<std::pair<uint64_t, std::string>> found;
+    for (const auto& entry : std::filesystem::directory_iterator(impl_->options_.dir)) {
+        std::string name = entry.path().filename().string();
+        if (!entry.is_directory() || name.rfind("segment-", 0) != 0) continue;
+        try {
+            found.emplace_back(std::stoull(name.substr(8)), entry.path().string());
+        } catch (...) {
+            continue;
+        }
+    }
+    std::sort(found.begin(), found.end());
+
+    std::unique_lock<std::shared_mutex> lock(impl_->segments_mutex_);
+    impl_->cold_ = std::move(cold);
+    if (!impl_->cold_.empty()) {
+        impl_->next_segment_index_ = impl_->cold_.back()->index + 1;
+    }
+    for (const auto& [index, path] : found) {
+        impl_->next_segment_index_ = std::max(impl_->next_segment_index_, index + 1);
+
+        bool migrated = std::any_of(impl_->cold_.begin(), impl_->cold_.end(),
+                                    [index = index](const auto& c) { return c->index == index; });
+        if (migrated) {
+            if (!read_only) {
+                LogF(LogLevel::INFO, "Share archive: removing %s (already migrated)", path.c_str());
+                std::filesystem::remove_all(path, ec);
+            }
+            continue;
+        }
+
+        // A crash while creating a segment leaves it without a header;
+        // its records are still in the journal and will be re-archived.
+        std::shared_ptr<ArchiveSegment> segment;
+        auto mapped = impl_->MapSegment(path, 0, false, segment);
+        if (!mapped.IsOk()) {
+            LogF(LogLevel::WARNING, "Share archive: skipping %s (%s)", path.c_str(), mapped.error.c_str());
+            continue;
+        }
+        segment->index = index;
+        impl_->segments_.push_back(std::move(segment));
+    }
+    lock.unlock();
+
+    impl_->LoadHot();
+    return impl_->LoadRoundIndex();
+}
+
+void ShareArchive::Close() {
+    std::lock_guard<std::mutex> write_lock(impl_->write_mutex_);
+    {
+        std::unique_lock<std::shared_mutex> hot_lock(impl_->hot_mutex_);
+        impl_->hot_.clear();
+        impl_->hot_.shrink_to_fit();
+        impl_->hot_next_ = impl_->hot_count_ = 0;
+        impl_->hot_valid_ = 0;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(impl_->segments_mutex_);
+    if (!impl_->segments_.empty() && !impl_->options_.read_only) {
+        impl_->segments_.back()->SyncAll();
+    }
+    impl_->segments_.clear();
+    impl_->cold_.clear();
+
+    std::lock_guard<std::mutex> rounds_lock(impl_->rounds_mutex_);
+    impl_->round_index_.clear();
+    impl_->rounds_size_ = 0;
+    impl_->compacted_round_ = 0;
+}
+
+Result<void> ShareArchive::Append(const std::vector<JournalRecord>& records) {
+    if (impl_->options_.read_only) {
+        return Result<void>::Error("Share archive is read-only");
+    }
+    std::lock_guard<std::mutex> write_lock(impl_->write_mutex_);
+    std::unique_lock<std::shared_mutex> hot_lock(impl_->hot_mutex_);
+
+    int64_t span_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        impl_->options_.segment_span).count();
+    ArchiveSegment* active = nullptr;
+    uint64_t last_seq = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(impl_->segments_mutex_);
+        if (!impl_->segments_.empty()) {
+            active = impl_->segments_.back().get();
+            last_seq = active->header()->last_seq;
+        } else if (!impl_->cold_.empty()) {
+            last_seq = impl_->cold_.back()->bounds.last_seq;
+        }
+    }
+
+    for (const auto& rec : records) {
+        if (rec.flags & JOURNAL_ROUND_END) continue;
+        if (rec.seq <= last_seq) continue;  // Already archived
+
+        int64_t bucket_ms = span_ms > 0 ? (rec.timestamp_ms / span_ms) * span_ms : 0;
+        if (!active || active->Count() >= active->header()->capacity ||
+            bucket_ms > active->header()->bucket_ms) {
+            auto created = impl_->CreateSegment(bucket_ms);
+            if (!created.IsOk()) {
+                return Result<void>::Error(created.error);
+            }
+            active = created.GetValue();
+        }
+
+        SegmentHeader* header = active->header();
+        uint64_t i = header->count;
+        active->ts_col()[i] = rec.timestamp_ms;
+        active->round_col()[i] = rec.round_id;
+        active->miner_col()[i] = rec.miner_id;
+        active->worker_col()[i] = rec.worker_id;
+        active->diff_col()[i] = rec.difficulty;
+        active->flags_col()[i] = static_cast<uint8_t>(rec.flags);
+
+        if (i == 0 || rec.timestamp_ms < header->min_ts_ms) {
+            std::atomic_ref<int64_t>(header->min_ts_ms).store(rec.timestamp_ms, std::memory_order_relaxed);
+        }
+        if (i == 0 || rec.timestamp_ms > header->max_ts_ms) {
+            std::atomic_ref<int64_t>(header->max_ts_ms).store(rec.timestamp_ms, std::memory_order_relaxed);
+        }
+        active->Track(i, rec.round_id, static_cast<uint8_t>(rec.flags));
+        std::atomic_ref<uint64_t>(header->last_seq).store(rec.seq, std::memory_order_relaxed);
+        std::atomic_ref<uint64_t>(header->count).store(i + 1, std::memory_order_release);
+        last_seq = rec.seq;
+
+        impl_->HotPush({rec.timestamp_ms, rec.round_id, rec.miner_id, rec.worker_id, rec.difficulty,
+                        static_cast<uint8_t>(rec.flags)});
+    }
+
+    return Result<void>::Ok();
+}
+
+Result<void> ShareArchive::Sync() {
+    std::unique_lock<std::shared_mutex> lock(impl_->segments_mutex_);
+    if (impl_->segments_.empty() || impl_->options_.read_only) {
+        return Result<void>::Ok();
+    }
+
+    if (impl_->seal_failed_) {
+        for (const auto& segment : impl_->segments_) {
+            if (!segment->SyncAll()) {
+                return Result<void>::Error(std::string("Share archive msync failed: ") + std::strerror(errno));
+            }
+        }
+        impl_->seal_failed_ = false;
+        return Result<void>::Ok();
+    }
+
+    if (!impl_->segments_.back()->SyncAll()) {
+        return Result<void>::Error(std::string("Share archive msync failed: ") + std::strerror(errno));
+    }
+    return Result<void>::Ok();
+}
+
+uint64_t ShareArchive::GetLastSeq() const {
+    std::shared_lock<std::shared_mutex> lock(impl_->segments_mutex_);
+    for (auto it = impl_->segments_.rbegin(); it != impl_->segments_.rend(); ++it) {
+        if ((*it)->Count() > 0) {
+            return std::atomic_ref<uint64_t>((*it)->header()->last_seq).load(std::memory_order_relaxed);
+        }
+    }
+    return impl_->cold_.empty() ? 0 : impl_->cold_.back()->bounds.last_seq;
+}
+
+uint64_t ShareArchive::GetShareCount() const {
+    auto tiers = impl_->Snapshot();
+    uint64_t total = 0;
+    for (const auto& cold : tiers.cold) {
+        total += cold->bounds.count;
+    }
+    for (const auto& segment : tiers.warm) {
+        total += segment->Count();
+    }
+    return total;
+}
+
+std::map<uint64_t, ShareTotals> ShareArchive::ScanLastShares(uint64_t n) const {
+    std::unordered_map<uint64_t, ShareTotals> totals;
+    impl_->VisitLastShares(n, [&](uint64_t miner, int64_t ts, uint64_t diff) {
+        Accumulate(totals[miner], ts, diff);
+    });
+    return std::map<uint64_t, ShareTotals>(totals.begin(), totals.end());
+}
+
+void ShareArchive::ForEachLastShare(uint64_t n,
+                                    const std::function<void(uint64_t miner_id, int64_t timestamp_ms,
+                                                             uint64_t difficulty)>& fn) const {
+    impl_->VisitLastShares(n, fn);
+}
+
+std::map<uint64_t, ShareTotals> ShareArchive::ScanMiners(std::chrono::system_clock::time_point from,
+                                                         std::chrono::system_clock::time_point to) const {
+    return impl_->ScanRange(ToMillis(from), ToMillis(to), &ColumnView::miner);
+}
+
+std::map<uint64_t, ShareTotals> ShareArchive::ScanWorkers(std::chrono::system_clock::time_point from,
+                                                          std::chrono::system_clock::time_point to) const {
+    return impl_->ScanRange(ToMillis(from), ToMillis(to), &ColumnView::worker);
+}
+
+Result<void> ShareArchive::ForEachShareChunk(std::chrono::system_clock::time_point from,
+                                             std::chrono::system_clock::time_point to, size_t chunk_rows,
+                                             const std::function<Result<void>(const ShareColumns&)>& fn) const {
+    int64_t from_ms = ToMillis(from);
+    int64_t to_ms = ToMillis(to);
+    chunk_rows = std::max<size_t>(chunk_rows, 1);
+    Result<void> result = Result<void>::Ok();
+
+    // Rows are copied only for segments straddling the range boundary
+    ColdColumns scratch;
+    impl_->Visit(impl_->Snapshot(), false,
+                 [&](const SegmentBounds& b) { return b.max_ts_ms >= from_ms && b.min_ts_ms < to_ms; },
+                 [&](const ColumnView& view, const SegmentBounds& b) {
+                     const ColumnView* source = &view;
+                     ColumnView filtered;
+                     if (b.min_ts_ms < from_ms || b.max_ts_ms >= to_ms) {
+                         scratch.Clear();
+                         for (uint64_t i = 0; i < view.n; i++) {
+                             if (view.ts[i] < from_ms || view.ts[i] >= to_ms) continue;
+                             scratch.ts.push_back(view.ts[i]);
+                             scratch.round.push_back(view.round[i]);
+                             scratch.miner.push_back(view.miner[i]);
+                             scratch.worker.push_back(view.worker[i]);
+                             scratch.diff.push_back(view.diff[i]);
+                             scratch.flags.push_back(view.flags[i]);
+                         }
+                         filtered = scratch.View();
+                         source = &filtered;
+                     }
+
+                     for (uint64_t offset = 0; offset < source->n; offset += chunk_rows) {
+                         ShareColumns chunk;
+                         chunk.rows = static_cast<size_t>(std::min<uint64_t>(chunk_rows, source->n - offset));
+                         chunk.timestamp_ms = source->ts + offset;
+                         chunk.round_id = source->round + offset;
+                         chunk.miner_id = source->miner + offset;
+                         chunk.worker_id = source->worker + offset;
+                         chunk.difficulty = source->diff + offset;
+                         chunk.flags = source->flags + offset;
+                         result = fn(chunk);
+                         if (!result.IsOk()) return false;
+                     }
+                     return true;
+                 });
+
+    return result;
+}
+
+Result<void> ShareArchive::ForEachRoundSummary(
+    const std::function<Result<void>(const RoundSummary&)>& fn) const {
+    std::vector<uint64_t> rounds;
+    {
+        std::lock_guard<std::mutex> lock(impl_->rounds_mutex_);
+        rounds.reserve(impl_->round_index_.size());
+        for (const auto& [round_id, location] : impl_->round_index_) {
+            rounds.push_back(round_id);
+        }
+    }
+
+    for (uint64_t round_id : rounds) {
+        auto summary = GetRoundSummary(round_id);
+        if (!summary.IsOk()) {
+            return Result<void>::Error(summary.error);
+        }
+        auto result = fn(summary.GetValue());
+        if (!result.IsOk()) {
+            return result;
+        }
+    }
+    return Result<void>::Ok();
+}
+
+Result<size_t> ShareArchive::Compact(uint64_t through_round, uint64_t keep_last_shares) {
+    if (impl_->options_.read_only) {
+        return Result<size_t>::Error("Share archive is read-only");
+    }
+    std::lock_guard<std::mutex> maintenance_lock(impl_->maintenance_mutex_);
+    auto tiers = impl_->Snapshot();
+
+    // Roll up every round in (compacted, through_round] from the raw columns
+    uint64_t from_round = impl_->compacted_round_ + 1;
+    if (through_round >= from_round) {
+        std::map<uint64_t, std::unordered_map<uint64_t, ShareTotals>> rounds;
+        impl_->Visit(tiers, false,
+                     [&](const SegmentBounds& b) {
+                         return b.max_round >= from_round && b.min_round <= through_round;
+                     },
+                     [&](const ColumnView& view, const SegmentBounds&) {
+                         for (uint64_t i = 0; i < view.n; i++) {
+                             if (!(view.flags[i] & JOURNAL_SHARE_VALID)) continue;
+                             if (view.round[i] < from_round || view.round[i] > through_round) continue;
+                             Accumulate(rounds[view.round[i]][view.miner[i]], view.ts[i], view.diff[i]);
+                         }
+                         return true;
+                     });
+
+        std::vector<RoundSummary> summaries;
+        summaries.reserve(rounds.size());
+        for (const auto& [round_id, miners] : rounds) {
+            RoundSummary summary;
+            summary.round_id = round_id;
+            summary.miners.reserve(miners.size());
+            for (const auto& [miner_id, totals] : miners) {
+                summary.miners.push_back({miner_id, totals.shares, totals.work});
+                if (summary.shares == 0 || totals.first_ms < summary.first_ms) summary.first_ms = totals.first_ms;
+                if (summary.shares == 0 || totals.last_ms > summary.last_ms) summary.last_ms = totals.last_ms;
+                summary.shares += totals.shares;
+                summary.work += totals.work;
+            }
+            std::sort(summary.miners.begin(), summary.miners.end(),
+                      [](const RoundWork& a, const RoundWork& b) { return a.miner_id < b.miner_id; });
+            summary.merkle_root = RoundMerkleRoot(summary);
+            summaries.push_back(std::move(summary));
+        }
+
+        if (!summaries.empty()) {
+            auto written = impl_->WriteSummaries(summaries);
+            if (!written.IsOk()) {
+                return Result<size_t>::Error(written.error);
+            }
+        }
+        impl_->compacted_round_ = through_round;
+    }
+
+    // Drop sealed segments (either tier) that are summarized, outside the
+    // PPLNS window and older than the raw retention period
+    int64_t retain_from_ms = ToMillis(std::chrono::system_clock::now() - impl_->options_.raw_retention);
+    uint64_t compacted = impl_->compacted_round_;
+    auto droppable = [&](const SegmentBounds& b, uint64_t newer_valid) {
+        return newer_valid >= keep_last_shares && b.max_round <= compacted && b.max_ts_ms < retain_from_ms;
+    };
+
+    uint64_t newer_valid = 0;
+    std::vector<std::shared_ptr<ArchiveSegment>> drop;
+    for (size_t i = tiers.warm.size(); i-- > 0;) {
+        SegmentBounds bounds = tiers.warm[i]->Bounds();
+        if (i + 1 < tiers.warm.size() && droppable(bounds, newer_valid)) {
+            drop.push_back(tiers.warm[i]);
+        }
+        newer_valid += bounds.valid;
+    }
+    std::vector<std::shared_ptr<const ColdSegment>> drop_cold;
+    for (size_t i = tiers.cold.size(); i-- > 0;) {
+        if (droppable(tiers.cold[i]->bounds, newer_valid)) {
+            drop_cold.push_back(tiers.cold[i]);
+        }
+        newer_valid += tiers.cold[i]->bounds.valid;
+    }
+    if (drop.empty() && drop_cold.empty()) {
+        return Result<size_t>::Ok(0);
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lock(impl_->segments_mutex_);
+        std::erase_if(impl_->segments_, [&drop](const std::shared_ptr<ArchiveSegment>& segment) {
+            return std::find(drop.begin(), drop.end(), segment) != drop.end();
+        });
+        std::erase_if(impl_->cold_, [&drop_cold](const std::shared_ptr<const ColdSegment>& segment) {
+            return std::find(drop_cold.begin(), drop_cold.end(), segment) != drop_cold.end();
+        });
+    }
+
+    // Scans still holding a segment keep its mappings alive after unlink
+    std::vector<std::string> paths;
+    for (const auto& segment : drop) paths.push_back(segment->path);
+    for (const auto& segment : drop_cold) paths.push_back(segment->path);
+    for (const auto& path : paths) {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+        if (ec) {
+            LogF(LogLevel::WARNING, "Share archive: failed to remove %s (%s)", path.c_str(), ec.message().c_str());
+        }
+    }
+
+    return Result<size_t>::Ok(paths.size());
+}
+
+Result<size_t> ShareArchive::MigrateCold() {
+    if (impl_->options_.cold_dir.empty() || impl_->options_.read_only) {
+        return Result<size_t>::Ok(0);
+    }
+
+    std::lock_guard<std::mutex> maintenance_lock(impl_->maintenance_mutex_);
+    auto tiers = impl_->Snapshot();
+    int64_t warm_from_ms = ToMillis(std::chrono::system_clock::now() - impl_->options_.warm_retention);
+
+    size_t migrated = 0;
+    // Never the active (last) segment: it is still being written
+    for (size_t i = 0; i + 1 < tiers.warm.size(); i++) {
+        const auto& segment = tiers.warm[i];
+        SegmentBounds bounds = segment->Bounds();
+        if (bounds.max_ts_ms >= warm_from_ms) break;  // Cold must stay older than warm
+
+        auto cold = std::make_shared<ColdSegment>();
+        cold->index = segment->index;
+        cold->path = (std::filesystem::path(impl_->options_.cold_dir) / ColdFileName(segment->index)).string();
+        cold->bounds = bounds;
+
+        ColumnView view = segment->View();
+        view.n = bounds.count;
+        auto written = WriteColdSegment(cold->path, view, bounds, impl_->options_.cold_compression_level,
+                                        cold->file_bytes);
+        if (!written.IsOk()) {
+            return Result<size_t>::Error(written.error);
+        }
+
+        {
+            std::unique_lock<std::shared_mutex> lock(impl_->segments_mutex_);
+            std::erase(impl_->segments_, segment);
+            auto pos = std::upper_bound(impl_->cold_.begin(), impl_->cold_.end(), cold->index,
+                                        [](uint64_t index, const auto& c) { return index < c->index; });
+            impl_->cold_.insert(pos, cold);
+        }
+
+        std::error_code ec;
+        std::filesystem::remove_all(segment->path, ec);
+        if (ec) {
+            LogF(LogLevel::WARNING, "Share archive: failed to remove %s (%s)",
+                 segment->path.c_str(), ec.message().c_str());
+        }
+        migrated++;
+    }
+
+    if (migrated > 0) {
+        LogF(LogLevel::INFO, "Share archive: migrated %zu segments to cold storage", migrated);
+    }
+    return Result<size_t>::Ok(migrated);
+}
+
+ShareArchive::TierStats ShareArchive::GetTierStats() const {
+    TierStats stats;
+    {
+        std::shared_lock<std::shared_mutex> lock(impl_->hot_mutex_);
+        stats.hot_shares = impl_->hot_count_;
+    }
+
+    auto tiers = impl_->Snapshot();
+    stats.warm_segments = tiers.warm.size();
+    for (const auto& segment : tiers.warm) {
+        stats.warm_shares += segment->Count();
+    }
+    stats.cold_segments = tiers.cold.size();
+    for (const auto& cold : tiers.cold) {
+        stats.cold_shares += cold->bounds.count;
+        stats.cold_bytes += cold->file_bytes;
+    }
+    return stats;
+}
+
+uint64_t ShareArchive::GetCompactedRound() const {
+    return impl_->compacted_round_;
+}
+
+Result<RoundSummary> ShareArchive::GetRoundSummary(uint64_t round_id) const {
+    std::pair<uint64_t, uint32_t> location;
+    {
+        std::lock_guard<std::mutex> lock(impl_->rounds_mutex_);
+        auto it = impl_->round_index_.find(round_id);
+        if (it == impl_->round_index_.end()) {
+            return Result<RoundSummary>::Error("Round not compacted: " + std::to_string(round_id));
+        }
+        location = it->second;
+    }
+
+    std::string path = impl_->RoundsPath();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return Result<RoundSummary>::Error("Failed to open " + path + ": " + std::strerror(errno));
+    }
+    std::vector<uint8_t> buf(kSummaryFrame + location.second);
+    ssize_t n = ::pread(fd, buf.data(), buf.size(), static_cast<off_t>(location.first));
+    ::close(fd);
+
+    RoundSummary summary;
+    if (n != static_cast<ssize_t>(buf.size()) ||
+        Crc32c(buf.data() + kSummaryFrame, location.second) != GetLE32(buf.data()) ||
+        !DecodeSummary(buf.data() + kSummaryFrame, location.second, summary)) {
+        return Result<RoundSummary>::Error("Corrupt round summary: " + std::to_string(round_id));
+    }
+    return Result<RoundSummary>::Ok(std::move(summary));
+}
+
+} // namespace pool
+} // namespace intcoin
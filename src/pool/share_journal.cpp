@@ -0,0 +1,485 @@
+/*
+ * Copyright (c) 2025 INTcoin Team (Neil Adamson)
+ * MIT License
+ * Mining Pool Share Journal (group-commit write-ahead log)
+ */
+
+#include "intcoin/pool_storage.h"
+#include "intcoin/util.h"
+#include "file_util.h"
+#include <array>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace intcoin {
+namespace pool {
+
+namespace {
+
+// ============================================================================
+// Record Encoding
+// ============================================================================
+
+/// Slicing-by-8 tables: table[k][b] is the CRC of byte b followed by k zero bytes
+constexpr std::array<std::array<uint32_t, 256>, 8> MakeCrc32cTable() {
+    std::array<std::array<uint32_t, 256>, 8> table{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78u : crc >> 1;
+        }
+        table[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        for (size_t k = 1; k < 8; k++) {
+            table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+        }
+    }
+    return table;
+}
+
+constexpr auto kCrc32cTable = MakeCrc32cTable();
+
+void EncodeRecord(const JournalRecord& rec, uint8_t* out) {
+    PutLE32(out + 4, rec.flags);
+    PutLE64(out + 8, rec.seq);
+    PutLE64(out + 16, rec.share_id);
+    PutLE64(out + 24, rec.round_id);
+    PutLE64(out + 32, rec.miner_id);
+    PutLE64(out + 40, rec.worker_id);
+    PutLE64(out + 48, rec.difficulty);
+    PutLE64(out + 56, static_cast<uint64_t>(rec.timestamp_ms));
+    PutLE32(out, Crc32c(out + 4, JournalRecord::kSize - 4));
+}
+
+bool DecodeRecord(const uint8_t* in, JournalRecord& rec) {
+    if (GetLE32(in) != Crc32c(in + 4, JournalRecord::kSize - 4)) {
+        return false;
+    }
+    rec.flags = GetLE32(in + 4);
+    rec.seq = GetLE64(in + 8);
+    rec.share_id = GetLE64(in + 16);
+    rec.round_id = GetLE64(in + 24);
+    rec.miner_id = GetLE64(in + 32);
+    rec.worker_id = GetLE64(in + 40);
+    rec.difficulty = GetLE64(in + 48);
+    rec.timestamp_ms = static_cast<int64_t>(GetLE64(in + 56));
+    return rec.seq != 0;
+}
+
+std::string SegmentName(uint64_t first_seq) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "journal-%020llu.log",
+                  static_cast<unsigned long long>(first_seq));
+    return name;
+}
+
+bool ParseSegmentName(const std::string& name, uint64_t& first_seq) {
+    if (name.size() != 32 || name.rfind("journal-", 0) != 0 ||
+        name.substr(28) != ".log") {
+        return false;
+    }
+    try {
+        first_seq = std::stoull(name.substr(8, 20));
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+uint32_t Crc32c(const uint8_t* data, size_t len, uint32_t crc) {
+    const auto& t = kCrc32cTable;
+    crc = ~crc;
+
+    // Eight bytes per step; snapshots checksum hundreds of MB at startup
+    for (; len >= 8; data += 8, len -= 8) {
+        uint32_t lo = crc ^ GetLE32(data);
+        uint32_t hi = GetLE32(data + 4);
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^
+              t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^
+              t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+    }
+    for (; len > 0; data++, len--) {
+        crc = t[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// ============================================================================
+// Share Journal Implementation
+// ============================================================================
+
+class ShareJournal::Impl {
+public:
+    explicit Impl(const ShareJournalOptions& options) : options_(options) {}
+
+    struct Segment {
+        uint64_t first_seq;
+        std::string path;
+    };
+
+    ShareJournalOptions options_;
+
+    // Segments (oldest first); the last one is open for append
+    mutable std::mutex segments_mutex_;
+    std::vector<Segment> segments_;
+    int fd_ = -1;
+    size_t segment_size_ = 0;
+
+    // Submit-side queue
+    mutable std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::condition_variable durable_cv_;
+    std::vector<JournalRecord> pending_;
+    uint64_t next_seq_ = 1;
+    uint64_t durable_seq_ = 0;
+    bool flush_requested_ = false;
+    bool stop_ = false;
+    bool running_ = false;
+    std::string last_error_;
+    std::thread writer_;
+
+    DurableCallback callback_;
+    Stats stats_;
+
+    Result<void> OpenSegment(uint64_t first_seq) {
+        Segment segment{first_seq, (std::filesystem::path(options_.dir) / SegmentName(first_seq)).string()};
+
+        int fd = ::open(segment.path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) {
+            return Result<void>::Error("Failed to open journal segment " + segment.path +
+                                       ": " + std::strerror(errno));
+        }
+        SyncDirectory(options_.dir);
+
+        std::lock_guard<std::mutex> lock(segments_mutex_);
+        if (fd_ >= 0) {
+            ::fdatasync(fd_);
+            ::close(fd_);
+        }
+        fd_ = fd;
+        segment_size_ = 0;
+        segments_.push_back(std::move(segment));
+        return Result<void>::Ok();
+    }
+
+    /// Scan a segment; returns the byte offset just past the last valid record
+    size_t ScanSegment(const std::string& path, uint64_t& last_seq) const {
+        std::ifstream file(path, std::ios::binary);
+        uint8_t buf[JournalRecord::kSize];
+        size_t valid_bytes = 0;
+
+        while (file.read(reinterpret_cast<char*>(buf), sizeof(buf))) {
+            JournalRecord rec;
+            if (!DecodeRecord(buf, rec) || rec.seq <= last_seq) break;
+            last_seq = rec.seq;
+            valid_bytes += JournalRecord::kSize;
+        }
+        return valid_bytes;
+    }
+
+    Result<void> CommitBatch(const std::vector<JournalRecord>& batch) {
+        std::vector<uint8_t> buf(batch.size() * JournalRecord::kSize);
+        for (size_t i = 0; i < batch.size(); i++) {
+            EncodeRecord(batch[i], buf.data() + i * JournalRecord::kSize);
+        }
+
+        if (segment_size_ > 0 && segment_size_ + buf.size() > options_.segment_bytes) {
+            auto result = OpenSegment(batch.front().seq);
+            if (!result.IsOk()) return result;
+        }
+
+        auto result = WriteAll(fd_, buf.data(), buf.size());
+        if (!result.IsOk()) {
+            result = Result<void>::Error("Journal " + result.error);
+        } else if (options_.durable && ::fdatasync(fd_) != 0) {
+            result = Result<void>::Error(std::string("Journal fdatasync failed: ") + std::strerror(errno));
+        }
+        if (!result.IsOk()) {
+            // Drop any partial write so the retry lands on a record boundary
+            if (::ftruncate(fd_, static_cast<off_t>(segment_size_)) != 0) {
+                LogF(LogLevel::ERROR, "Journal: failed to roll back partial write");
+            }
+            return result;
+        }
+
+        segment_size_ += buf.size();
+        return Result<void>::Ok();
+    }
+
+    void WriterLoop() {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        while (true) {
+            queue_cv_.wait_for(lock, options_.commit_interval, [this]() {
+                return stop_ || flush_requested_ || pending_.size() >= options_.commit_records;
+            });
+            flush_requested_ = false;
+
+            if (pending_.empty()) {
+                if (stop_) break;
+                continue;
+            }
+
+            std::vector<JournalRecord> batch;
+            batch.swap(pending_);
+            lock.unlock();
+
+            auto result = CommitBatch(batch);
+            if (result.IsOk() && callback_) {
+                callback_(batch);
+            }
+
+            lock.lock();
+            if (result.IsOk()) {
+                durable_seq_ = batch.back().seq;
+                last_error_.clear();
+                stats_.records_written += batch.size();
+                stats_.group_commits++;
+                stats_.bytes_written += batch.size() * JournalRecord::kSize;
+            } else {
+                LogF(LogLevel::ERROR, "Journal: %s (retrying)", result.error.c_str());
+                last_error_ = result.error;
+                pending_.insert(pending_.begin(), batch.begin(), batch.end());
+                if (stop_) break;
+                queue_cv_.wait_for(lock, options_.commit_interval);
+            }
+            durable_cv_.notify_all();
+        }
+
+        running_ = false;
+        durable_cv_.notify_all();
+    }
+};
+
+ShareJournal::ShareJournal(const ShareJournalOptions& options)
+    : impl_(std::make_unique<Impl>(options)) {}
+
+ShareJournal::~ShareJournal() {
+    Close();
+}
+
+Result<void> ShareJournal::Open() {
+    if (impl_->running_) {
+        return Result<void>::Error("Journal already open");
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(impl_->options_.dir, ec);
+    if (ec) {
+        return Result<void>::Error("Failed to create journal directory: " + ec.message());
+    }
+
+    // Discover existing segments
+    std::vector<Impl::Segment> segments;
+    for (const auto& entry : std::filesystem::directory_iterator(impl_->options_.dir)) {
+        uint64_t first_seq = 0;
+        if (entry.is_regular_file() && ParseSegmentName(entry.path().filename().string(), first_seq)) {
+            segments.push_back({first_seq, entry.path().string()});
+        }
+    }
+    std::sort(segments.begin(), segments.end(),
+              [](const Impl::Segment& a, const Impl::Segment& b) { return a.first_seq < b.first_seq; });
+
+    // Find the last durable record; a torn tail is only legal in the last segment
+    uint64_t last_seq = 0;
+    for (size_t i = 0; i < segments.size(); i++) {
+        size_t valid_bytes = impl_->ScanSegment(segments[i].path, last_seq);
+        size_t file_bytes = std::filesystem::file_size(segments[i].path);
+
+        if (valid_bytes != file_bytes) {
+            if (i + 1 != segments.size()) {
+                return Result<void>::Error("Journal segment corrupt: " + segments[i].path);
+            }
+            LogF(LogLevel::WARNING, "Journal: truncating torn tail of %s (%zu -> %zu bytes)",
+                 segments[i].path.c_str(), file_bytes, valid_bytes);
+            std::filesystem::resize_file(segments[i].path, valid_bytes);
+        }
+    }
+
+    impl_->next_seq_ = std::max<uint64_t>({last_seq + 1, impl_->options_.first_seq,
+                                           segments.empty() ? 1 : segments.back().first_seq});
+    impl_->durable_seq_ = impl_->next_seq_ - 1;
+
+    // Reopen the last segment for append, or start a fresh one
+    if (!segments.empty()) {
+        Impl::Segment active = segments.back();
+        segments.pop_back();
+        impl_->segments_ = std::move(segments);
+
+        int fd = ::open(active.path.c_str(), O_WRONLY | O_APPEND);
+        if (fd < 0) {
+            return Result<void>::Error("Failed to reopen journal segment " + active.path);
+        }
+        impl_->fd_ = fd;
+        impl_->segment_size_ = std::filesystem::file_size(active.path);
+        impl_->segments_.push_back(std::move(active));
+    } else {
+        auto result = impl_->OpenSegment(impl_->next_seq_);
+        if (!result.IsOk()) return result;
+    }
+
+    impl_->stop_ = false;
+    impl_->running_ = true;
+    impl_->writer_ = std::thread([this]() { impl_->WriterLoop(); });
+
+    return Result<void>::Ok();
+}
+
+void ShareJournal::Close() {
+    {
+        std::lock_guard<std::mutex> lock(impl_->queue_mutex_);
+        impl_->stop_ = true;
+    }
+    impl_->queue_cv_.notify_all();
+    if (impl_->writer_.joinable()) {
+        impl_->writer_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(impl_->segments_mutex_);
+    if (impl_->fd_ >= 0) {
+        ::fdatasync(impl_->fd_);
+        ::close(impl_->fd_);
+        impl_->fd_ = -1;
+    }
+}
+
+void ShareJournal::SetDurableCallback(DurableCallback callback) {
+    impl_->callback_ = std::move(callback);
+}
+
+uint64_t ShareJournal::Append(const Share& share, uint64_t round_id) {
+    JournalRecord rec;
+    if (share.valid) rec.flags |= JOURNAL_SHARE_VALID;
+    if (share.is_block) rec.flags |= JOURNAL_SHARE_BLOCK;
+    rec.share_id = share.share_id;
+    rec.round_id = round_id;
+    rec.miner_id = share.miner_id;
+    rec.worker_id = share.worker_id;
+    rec.difficulty = share.difficulty;
+    rec.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        share.timestamp.time_since_epoch()).count();
+
+    std::lock_guard<std::mutex> lock(impl_->queue_mutex_);
+    rec.seq = impl_->next_seq_++;
+    impl_->pending_.push_back(rec);
+    if (impl_->pending_.size() >= impl_->options_.commit_records) {
+        impl_->queue_cv_.notify_one();
+    }
+    return rec.seq;
+}
+
+uint64_t ShareJournal::AppendRoundEnd(uint64_t round_id) {
+    JournalRecord rec;
+    rec.flags = JOURNAL_ROUND_END;
+    rec.round_id = round_id;
+    rec.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    std::lock_guard<std::mutex> lock(impl_->queue_mutex_);
+    rec.seq = impl_->next_seq_++;
+    impl_->pending_.push_back(rec);
+    return rec.seq;
+}
+
+Result<void> ShareJournal::Sync() {
+    std::unique_lock<std::mutex> lock(impl_->queue_mutex_);
+    uint64_t target = impl_->next_seq_ - 1;
+    impl_->flush_requested_ = true;
+    impl_->queue_cv_.notify_one();
+
+    impl_->durable_cv_.wait(lock, [this, target]() {
+        return impl_->durable_seq_ >= target || !impl_->running_ || !impl_->last_error_.empty();
+    });
+
+    if (impl_->durable_seq_ < target) {
+        return Result<void>::Error(impl_->last_error_.empty() ? "Journal closed"
+                                                              : impl_->last_error_);
+    }
+    return Result<void>::Ok();
+}
+
+Result<void> ShareJournal::Replay(uint64_t after_seq,
+                                  const std::function<void(const JournalRecord&)>& fn) const {
+    std::vector<Impl::Segment> segments;
+    {
+        std::lock_guard<std::mutex> lock(impl_->segments_mutex_);
+        segments = impl_->segments_;
+    }
+    uint64_t durable_seq = GetDurableSeq();
+
+    uint64_t last_seq = 0;
+    for (size_t i = 0; i < segments.size(); i++) {
+        // Skip segments that end at or before after_seq
+        if (i + 1 < segments.size() && segments[i + 1].first_seq <= after_seq + 1) {
+            continue;
+        }
+
+        std::ifstream file(segments[i].path, std::ios::binary);
+        if (!file.is_open()) {
+            return Result<void>::Error("Failed to open journal segment " + segments[i].path);
+        }
+
+        uint8_t buf[JournalRecord::kSize];
+        while (file.read(reinterpret_cast<char*>(buf), sizeof(buf))) {
+            JournalRecord rec;
+            if (!DecodeRecord(buf, rec)) {
+                if (i + 1 == segments.size()) break;
+                return Result<void>::Error("Journal segment corrupt: " + segments[i].path);
+            }
+            if (rec.seq > durable_seq) break;
+            if (rec.seq <= last_seq) continue;
+            last_seq = rec.seq;
+
+            if (rec.seq > after_seq) {
+                fn(rec);
+            }
+        }
+    }
+
+    return Result<void>::Ok();
+}
+
+Result<void> ShareJournal::TruncateBefore(uint64_t seq) {
+    std::lock_guard<std::mutex> lock(impl_->segments_mutex_);
+
+    // Never remove the active segment
+    size_t removable = 0;
+    while (removable + 1 < impl_->segments_.size() &&
+           impl_->segments_[removable + 1].first_seq <= seq + 1) {
+        removable++;
+    }
+
+    for (size_t i = 0; i < removable; i++) {
+        std::error_code ec;
+        std::filesystem::remove(impl_->segments_[i].path, ec);
+        if (ec) {
+            impl_->segments_.erase(impl_->segments_.begin(), impl_->segments_.begin() + i);
+            return Result<void>::Error("Failed to remove journal segment: " + ec.message());
+        }
+    }
+    impl_->segments_.erase(impl_->segments_.begin(), impl_->segments_.begin() + removable);
+
+    return Result<void>::Ok();
+}
+
+uint64_t ShareJournal::GetDurableSeq() const {
+    std::lock_guard<std::mutex> lock(impl_->queue_mutex_);
+    return impl_->durable_seq_;
+}
+
+ShareJournal::Stats ShareJournal::GetStats() const {
+    std::lock_guard<std::mutex> lock(impl_->queue_mutex_);
+    return impl_->stats_;
+}
+
+} // namespace pool
+} // namespace intcoin
@@ -5,6 +5,7 @@
  */
 
 #include "intcoin/pool.h"
+#include "intcoin/pool_metrics.h"
 #include "intcoin/util.h"
 #include <thread>
 #include <map>
@@ -212,10 +213,7 @@ public:
         , ssl_cert_file_(cert_file)
         , ssl_key_file_(key_file)
 #endif
-        , total_connections_(0)
-        , total_shares_(0)
-        , total_valid_shares_(0)
-        , total_invalid_shares_(0)
+        , metrics_(pool.GetMetrics())
         , server_start_time_(std::chrono::system_clock::now())
 #ifdef STRATUM_USE_SSL
         , ssl_ctx_(nullptr)
@@ -315,13 +313,27 @@ public:
     }
 
     void BroadcastWork(const Work& work) {
-        std::lock_guard<std::mutex> lock(connections_mutex_);
+        // Only work for the chain this port is mining goes out
+        if (JobScheduler::ChainOf(work.job_id) != pool_.GetChainForPort(port_)) {
+            return;
+        }
 
-        for (auto& [conn_id, conn] : connections_) {
-            if (conn.authorized) {
-                SendNotify(conn_id, work);
+        pool::MetricTimer timer(metrics_.notify_fanout);
+
+        // SendNotify takes the connection lock itself
+        std::vector<uint64_t> authorized;
+        {
+            std::lock_guard<std::mutex> lock(connections_mutex_);
+            for (const auto& [conn_id, conn] : connections_) {
+                if (conn.authorized) {
+                    authorized.push_back(conn_id);
+                }
             }
         }
+
+        for (uint64_t conn_id : authorized) {
+            SendNotify(conn_id, work);
+        }
     }
 
     void SendDifficulty(uint64_t conn_id, uint64_t difficulty) {
@@ -374,11 +386,8 @@ private:
     std::string ssl_key_file_;
 #endif
 
-    // Metrics
-    std::atomic<uint64_t> total_connections_;
-    std::atomic<uint64_t> total_shares_;
-    std::atomic<uint64_t> total_valid_shares_;
-    std::atomic<uint64_t> total_invalid_shares_;
+    // Metrics (shared with the pool and served at /metrics)
+    pool::PoolMetrics& metrics_;
     std::chrono::system_clock::time_point server_start_time_;
 
 #ifdef STRATUM_USE_SSL
@@ -533,6 +542,7 @@ private:
                 std::lock_guard<std::mutex> lock(connections_mutex_);
                 connections_[conn_id] = conn;
             }
+            metrics_.connections.Add(1);
 
             // Check connection limit per IP
             uint32_t ip_conn_count = CountConnectionsFromIP(conn.ip_address);
@@ -544,7 +554,7 @@ private:
             }
 
             LogInfo("New connection from " + conn.ip_address + " (ID: " + std::to_string(conn_id) + ")");
-            total_connections_++;
+            metrics_.connections_total.Inc();
 
             // Start client handler thread
             std::thread(&StratumServer::HandleClient, this, conn_id).detach();
@@ -585,9 +595,10 @@ private:
             // Log statistics every 30 seconds
             if (timeout_connections.empty()) {
                 LogDebug("Active connections: " + std::to_string(GetConnectionCount()) +
-                        ", Total shares: " + std::to_string(total_shares_.load()) +
-                        " (Valid: " + std::to_string(total_valid_shares_.load()) +
-                        ", Invalid: " + std::to_string(total_invalid_shares_.load()) + ")");
+                        ", Total shares: " + std::to_string(metrics_.shares_accepted.Value() +
+                                                            metrics_.shares_rejected.Value()) +
+                        " (Valid: " + std::to_string(metrics_.shares_accepted.Value()) +
+                        ", Invalid: " + std::to_string(metrics_.shares_rejected.Value()) + ")");
             }
         }
     }
@@ -820,13 +831,15 @@ private:
         }
 
         // Send current work
-        auto work_opt = pool_.GetCurrentWork();
+        auto work_opt = pool_.GetWorkForPort(port_);
         if (work_opt.has_value()) {
             SendNotify(conn_id, work_opt.value());
         }
     }
 
     void HandleSubmit(uint64_t conn_id, const Message& msg) {
+        pool::MetricTimer timer(metrics_.submit_to_ack);
+
         if (msg.params.size() < 5) {
             SendError(conn_id, 20, "Invalid params");
             return;
@@ -887,13 +900,10 @@ private:
         // Submit share to pool
         auto submit_result = pool_.SubmitShare(worker_id, job_id, nonce, hash);
 
-        // Update metrics
-        total_shares_++;
-
         std::string ip = GetIP(conn_id);
 
         if (submit_result.IsOk()) {
-            total_valid_shares_++;
+            metrics_.shares_accepted.Inc();
             LogInfo("Valid share from worker " + std::to_string(worker_id) +
                    " (" + ip + ") - Job: " + job_id_str.substr(0, 16) + "...");
 
@@ -901,7 +911,7 @@ private:
                                   ",\"result\":true,\"error\":null}\n";
             SendRaw(conn_id, response);
         } else {
-            total_invalid_shares_++;
+            metrics_.shares_rejected.Inc();
             LogWarning("Invalid share from worker " + std::to_string(worker_id) +
                       " (" + ip + ") - Reason: " + submit_result.error);
 
@@ -910,6 +920,12 @@ private:
     }
 
     void SendNotify(uint64_t conn_id, const Work& work) {
+        if (pool_.GetConfig().payout_method == PoolConfig::PayoutMethod::SOLO &&
+            JobScheduler::ChainOf(work.job_id) == JobScheduler::kPrimaryChain) {
+            SendSoloNotify(conn_id, work);
+            return;
+        }
+
         // Build coinbase transaction parts (coinb1 and coinb2)
         // The extranonce goes between coinb1 and coinb2
         auto coinbase_serialized = work.coinbase_tx.Serialize();
@@ -983,6 +999,44 @@ private:
         SendRaw(conn_id, msg);
     }
 
+    // Solo: the miner's cached coinbase, with the branch shared by all jobs
+    void SendSoloNotify(uint64_t conn_id, const Work& work) {
+        uint64_t worker_id;
+        {
+            std::lock_guard<std::mutex> lock(connections_mutex_);
+            auto it = connections_.find(conn_id);
+            if (it == connections_.end()) return;
+            worker_id = it->second.worker_id;
+        }
+
+        auto job_result = pool_.GetSoloJob(worker_id);
+        if (job_result.IsError()) {
+            LogWarning("No solo job for worker " + std::to_string(worker_id) + ": " + job_result.error);
+            return;
+        }
+        const SoloJob& job = *job_result.GetValue();
+
+        std::string merkle_array = "[";
+        for (size_t i = 0; i < job.merkle_branch->size(); i++) {
+            if (i > 0) merkle_array += ",";
+            merkle_array += "\"" + (*job.merkle_branch)[i] + "\"";
+        }
+        merkle_array += "]";
+
+        std::string msg = "{\"id\":null,\"method\":\"mining.notify\",\"params\":[\"" +
+                         ToHex(job.job_id) + "\",\"" +
+                         ToHex(work.header.prev_block_hash) + "\",\"" +
+                         job.coinbase1 + "\",\"" +
+                         job.coinbase2 + "\"," +
+                         merkle_array + ",\"" +
+                         ToHex(work.header.version) + "\",\"" +
+                         ToHex(work.header.bits) + "\",\"" +
+                         ToHex(static_cast<uint32_t>(work.header.timestamp)) + "\"," +
+                         (work.clean_jobs ? "true" : "false") + "]}\n";
+
+        SendRaw(conn_id, msg);
+    }
+
     void SendError(uint64_t conn_id, int code, const std::string& message) {
         std::string response = "{\"id\":null,\"result\":null,\"error\":[" +
                               std::to_string(code) + ",\"" + message + "\",null]}\n";
@@ -1055,6 +1109,7 @@ private:
 
             close(it->second.socket_fd);
             connections_.erase(it);
+            metrics_.connections.Add(-1);
         }
     }
 
@@ -0,0 +1,966 @@
+/*
+ * Copyright (c) 2025 INTcoin Team (Neil Adamson)
+ * MIT License
+ * Mining Pool Benchmarks
+ */
+
+#include <gtest/gtest.h>
+#include "intcoin/pool.h"
+#include "intcoin/pool_storage.h"
+#include "intcoin/blockchain.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <random>
+
+using namespace intcoin;
+using namespace intcoin::pool;
+
+namespace {
+
+Share MakeShare(uint64_t i) {
+    Share share{};
+    share.share_id = i + 1;
+    share.miner_id = i % 64;
+    share.worker_id = i % 256;
+    share.difficulty = 1000 + (i % 7);
+    share.timestamp = std::chrono::system_clock::now();
+    share.valid = true;
+    return share;
+}
+
+double ElapsedSeconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+// ============================================================================
+// Share Journal Benchmarks
+// ============================================================================
+
+namespace {
+
+/// Shares/sec through the journal until the last record is durable
+double JournalThroughput(bool durable, size_t count) {
+    std::string dir = "/tmp/intcoin-pool-bench-journal";
+    std::filesystem::remove_all(dir);
+
+    ShareJournalOptions options;
+    options.dir = dir;
+    options.durable = durable;
+
+    ShareJournal journal(options);
+    EXPECT_TRUE(journal.Open().IsOk());
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        journal.Append(MakeShare(i), 1);
+    }
+    EXPECT_TRUE(journal.Sync().IsOk());
+    double seconds = ElapsedSeconds(start);
+
+    auto stats = journal.GetStats();
+    std::cout << "  durable=" << (durable ? "on " : "off")
+              << "  group commits=" << stats.group_commits
+              << "  avg batch=" << (stats.group_commits ? stats.records_written / stats.group_commits : 0)
+              << "\n";
+
+    journal.Close();
+    std::filesystem::remove_all(dir);
+    return count / seconds;
+}
+
+/// Shares/sec when each share waits for its own fdatasync
+double PerWriteSyncThroughput(size_t count) {
+    std::string dir = "/tmp/intcoin-pool-bench-journal-sync";
+    std::filesystem::remove_all(dir);
+
+    ShareJournalOptions options;
+    options.dir = dir;
+    options.durable = true;
+
+    ShareJournal journal(options);
+    EXPECT_TRUE(journal.Open().IsOk());
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        journal.Append(MakeShare(i), 1);
+        EXPECT_TRUE(journal.Sync().IsOk());
+    }
+    double seconds = ElapsedSeconds(start);
+
+    EXPECT_EQ(journal.GetStats().group_commits, count);
+
+    journal.Close();
+    std::filesystem::remove_all(dir);
+    return count / seconds;
+}
+
+} // namespace
+
+TEST(ShareJournalBench, DurableVsNonDurable) {
+    constexpr size_t kShares = 500000;
+    constexpr size_t kSyncedShares = 2000;
+
+    double fast = JournalThroughput(false, kShares);
+    double durable = JournalThroughput(true, kShares);
+    double per_write = PerWriteSyncThroughput(kSyncedShares);
+
+    std::cout << "Share journal throughput (" << kShares << " shares):\n"
+              << "  durability off:       " << static_cast<uint64_t>(fast) << " shares/sec\n"
+              << "  group commit:         " << static_cast<uint64_t>(durable) << " shares/sec\n"
+              << "  fdatasync per share:  " << static_cast<uint64_t>(per_write) << " shares/sec\n"
+              << "  group commit speedup: " << durable / per_write << "x\n";
+
+    // Group commit amortizes one fdatasync over many shares, so durable
+    // throughput must stay far above paying for a sync on every share
+    EXPECT_GT(durable, 10 * per_write);
+}
+
+// ============================================================================
+// Share Archive Benchmarks
+// ============================================================================
+
+TEST(ShareArchiveBench, PPLNSWindowScan) {
+    constexpr uint64_t kShares = 8000000;
+    constexpr uint64_t kWindow = 5000000;
+
+    std::string dir = "/tmp/intcoin-pool-bench-archive";
+    std::filesystem::remove_all(dir);
+
+    ShareArchiveOptions options;
+    options.dir = dir;
+    options.segment_span = std::chrono::hours(1000);
+    options.segment_capacity = 1 << 21;
+
+    ShareArchive archive(options);
+    ASSERT_TRUE(archive.Open().IsOk());
+
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    std::vector<JournalRecord> batch;
+    batch.reserve(65536);
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < kShares; i++) {
+        JournalRecord rec;
+        rec.seq = i + 1;
+        rec.flags = JOURNAL_SHARE_VALID;
+        rec.miner_id = i % 10000;
+        rec.worker_id = i % 40000;
+        rec.difficulty = 1000 + (i % 13);
+        rec.timestamp_ms = now_ms - static_cast<int64_t>(kShares - i);
+        batch.push_back(rec);
+        if (batch.size() == batch.capacity()) {
+            ASSERT_TRUE(archive.Append(batch).IsOk());
+            batch.clear();
+        }
+    }
+    ASSERT_TRUE(archive.Append(batch).IsOk());
+    double append_seconds = ElapsedSeconds(start);
+
+    start = std::chrono::steady_clock::now();
+    auto window = archive.ScanLastShares(kWindow);
+    double window_seconds = ElapsedSeconds(start);
+
+    start = std::chrono::steady_clock::now();
+    auto workers = archive.ScanWorkers(std::chrono::system_clock::now() - std::chrono::hours(24),
+                                       std::chrono::system_clock::now());
+    double range_seconds = ElapsedSeconds(start);
+
+    std::cout << "Share archive (" << kShares << " shares):\n"
+              << "  append:          " << static_cast<uint64_t>(kShares / append_seconds) << " shares/sec\n"
+              << "  PPLNS window " << kWindow << ": " << window_seconds * 1000 << " ms ("
+              << window.size() << " miners)\n"
+              << "  24h worker scan: " << range_seconds * 1000 << " ms ("
+              << workers.size() << " workers)\n";
+
+    EXPECT_EQ(window.size(), 10000);
+    EXPECT_EQ(workers.size(), 40000);
+
+    archive.Close();
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ShareArchiveBench, TieredStorage) {
+    constexpr uint64_t kShares = 4000000;
+    constexpr uint64_t kHot = 1000000;
+
+    std::string dir = "/tmp/intcoin-pool-bench-tiers";
+    std::filesystem::remove_all(dir);
+
+    ShareArchiveOptions options;
+    options.dir = dir + "/warm";
+    options.cold_dir = dir + "/cold";
+    options.segment_span = std::chrono::hours(1000);
+    options.segment_capacity = 1 << 19;
+    options.hot_shares = kHot;
+    options.warm_retention = std::chrono::hours(1);
+
+    ShareArchive archive(options);
+    ASSERT_TRUE(archive.Open().IsOk());
+
+    // One share every 2ms over the last ~2.2 hours; the older half goes cold
+    auto now = std::chrono::system_clock::now();
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+    std::vector<JournalRecord> batch;
+    batch.reserve(65536);
+    for (uint64_t i = 0; i < kShares; i++) {
+        JournalRecord rec;
+        rec.seq = i + 1;
+        rec.flags = JOURNAL_SHARE_VALID;
+        rec.round_id = 1 + i / 500000;
+        rec.miner_id = i % 10000;
+        rec.worker_id = i % 40000;
+        rec.difficulty = 1000 + (i % 13);
+        rec.timestamp_ms = now_ms - static_cast<int64_t>(kShares - i) * 2;
+        batch.push_back(rec);
+        if (batch.size() == batch.capacity()) {
+            ASSERT_TRUE(archive.Append(batch).IsOk());
+            batch.clear();
+        }
+    }
+    ASSERT_TRUE(archive.Append(batch).IsOk());
+
+    auto start = std::chrono::steady_clock::now();
+    auto migrated = archive.MigrateCold();
+    double migrate_seconds = ElapsedSeconds(start);
+    ASSERT_TRUE(migrated.IsOk());
+    auto stats = archive.GetTierStats();
+
+    start = std::chrono::steady_clock::now();
+    auto hot = archive.ScanLastShares(kHot);
+    double hot_seconds = ElapsedSeconds(start);
+
+    start = std::chrono::steady_clock::now();
+    auto warm = archive.ScanMiners(now - std::chrono::minutes(30), now);
+    double warm_seconds = ElapsedSeconds(start);
+
+    start = std::chrono::steady_clock::now();
+    auto cold = archive.ScanMiners(now - std::chrono::hours(3), now - std::chrono::minutes(90));
+    double cold_seconds = ElapsedSeconds(start);
+
+    uint64_t raw_bytes = stats.cold_shares * (5 * sizeof(uint64_t) + 1);
+    std::cout << "Tiered share archive (" << kShares << " shares):\n"
+              << "  migrate:    " << migrate_seconds * 1000 << " ms (" << migrated.GetValue() << " segments, "
+              << stats.cold_shares << " shares)\n"
+              << "  cold ratio: " << (stats.cold_bytes ? static_cast<double>(raw_bytes) / stats.cold_bytes : 0.0)
+              << "x (" << stats.cold_bytes / 1024 << " KiB)\n"
+              << "  hot window " << kHot << ": " << hot_seconds * 1000 << " ms\n"
+              << "  warm 30m scan:   " << warm_seconds * 1000 << " ms (" << warm.size() << " miners)\n"
+              << "  cold range scan: " << cold_seconds * 1000 << " ms (" << cold.size() << " miners)\n";
+
+    EXPECT_GT(stats.cold_segments, 0);
+    EXPECT_EQ(hot.size(), 10000);
+    EXPECT_EQ(cold.size(), 10000);
+
+    archive.Close();
+    std::filesystem::remove_all(dir);
+}
+
+// ============================================================================
+// PPLNS Window Benchmarks
+// ============================================================================
+
+TEST(PPLNSWindowBench, IncrementalVsRescan) {
+    constexpr uint64_t kWindow = 1000000;
+    constexpr uint64_t kShares = 20000000;
+    constexpr uint64_t kMiners = 10000;
+
+    PPLNSWindow pplns(kWindow);
+    std::vector<Share> history;
+    history.reserve(kWindow);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < kShares; i++) {
+        pplns.Add(i % kMiners, 1000 + (i % 13) * 100);
+    }
+    double add_seconds = ElapsedSeconds(start);
+
+    for (uint64_t i = kShares - kWindow; i < kShares; i++) {
+        Share share = MakeShare(i);
+        share.miner_id = i % kMiners;
+        share.difficulty = 1000 + (i % 13) * 100;
+        history.push_back(share);
+    }
+
+    start = std::chrono::steady_clock::now();
+    auto incremental = PayoutCalculator::DistributeReward(pplns.GetMinerWork(), 5000000000ULL, 0.01);
+    double window_seconds = ElapsedSeconds(start);
+
+    start = std::chrono::steady_clock::now();
+    auto rescan = PayoutCalculator::CalculatePPLNS(history, kWindow, 5000000000ULL, 0.01);
+    double rescan_seconds = ElapsedSeconds(start);
+
+    start = std::chrono::steady_clock::now();
+    size_t half = pplns.SharesForWork(pplns.GetTotalWork() / 2);
+    double search_us = ElapsedSeconds(start) * 1e6;
+
+    std::cout << "PPLNS window (N=" << kWindow << ", " << kMiners << " miners):\n"
+              << "  add:             " << add_seconds * 1e9 / kShares << " ns/share\n"
+              << "  window payout:   " << window_seconds * 1000 << " ms\n"
+              << "  rescan payout:   " << rescan_seconds * 1000 << " ms\n"
+              << "  half-work search: " << search_us << " us (" << half << " shares)\n";
+
+    EXPECT_EQ(incremental, rescan);
+}
+
+TEST(PPLNSWindowBench, DecayedScoreVsPPLNS) {
+    constexpr uint64_t kWindow = 1000000;
+    constexpr uint64_t kShares = 20000000;
+    constexpr uint64_t kMiners = 10000;
+    constexpr uint64_t kReward = 5000000000ULL;
+
+    // 200 shares/sec over ~28 hours, so a 900s half-life moves the base time
+    int64_t start_ms = 1700000000000;
+    auto timestamp = [&](uint64_t i) { return start_ms + static_cast<int64_t>(i * 5); };
+
+    PPLNSWindow pplns(kWindow);
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < kShares; i++) {
+        pplns.Add(i % kMiners, 1000 + (i % 13) * 100);
+    }
+    double pplns_add = ElapsedSeconds(start);
+
+    DecayedScore decayed(900);
+    start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < kShares; i++) {
+        decayed.Add(i % kMiners, 1000 + (i % 13) * 100, timestamp(i));
+    }
+    double decayed_add = ElapsedSeconds(start);
+
+    std::vector<Share> history;
+    history.reserve(kWindow);
+    for (uint64_t i = kShares - kWindow; i < kShares; i++) {
+        Share share = MakeShare(i);
+        share.miner_id = i % kMiners;
+        share.difficulty = 1000 + (i % 13) * 100;
+        history.push_back(share);
+    }
+
+    start = std::chrono::steady_clock::now();
+    auto rescan = PayoutCalculator::CalculatePPLNS(history, kWindow, kReward, 1.0);
+    double rescan_payout = ElapsedSeconds(start);
+
+    start = std::chrono::steady_clock::now();
+    auto window = PayoutCalculator::DistributeReward(pplns.GetMinerWork(), kReward, 1.0);
+    double window_payout = ElapsedSeconds(start);
+
+    start = std::chrono::steady_clock::now();
+    auto scored = PayoutCalculator::DistributeReward(decayed.GetMinerWeights(), kReward, 1.0);
+    double decayed_payout = ElapsedSeconds(start);
+
+    std::cout << "Payout scoring (" << kShares << " shares, " << kMiners << " miners):\n"
+              << "  PPLNS window add:  " << pplns_add * 1e9 / kShares << " ns/share\n"
+              << "  decayed add:       " << decayed_add * 1e9 / kShares << " ns/share\n"
+              << "  PPLNS rescan:      " << rescan_payout * 1000 << " ms/block\n"
+              << "  PPLNS window:      " << window_payout * 1000 << " ms/block\n"
+              << "  decayed:           " << decayed_payout * 1000 << " ms/block\n";
+
+    uint64_t paid = 0;
+    for (const auto& [miner, amount] : scored) paid += amount;
+    EXPECT_EQ(scored.size(), kMiners);
+    // Rounding leaves under one base unit per miner with the pool
+    uint64_t net = kReward - PayoutCalculator::CalculateFee(kReward, 1.0);
+    EXPECT_LE(paid, net);
+    EXPECT_GE(paid + kMiners, net);
+    EXPECT_EQ(window, rescan);
+}
+
+// ============================================================================
+// Payout Benchmarks
+// ============================================================================
+
+TEST(PayoutBench, ExactSplitHundredThousandMiners) {
+    constexpr size_t kMiners = 100000;
+    constexpr int kRounds = 50;
+
+    std::mt19937_64 rng(7);
+    std::map<uint64_t, uint64_t> weights;
+    for (uint64_t id = 1; id <= kMiners; id++) {
+        weights.emplace_hint(weights.end(), id, 1 + rng() % 100000000000ULL);
+    }
+
+    uint64_t reward = 5000000000ULL + rng() % 100000000ULL;
+    uint64_t fee = PayoutCalculator::CalculateFee(reward, 1.0);
+
+    // Full path, map in and map out
+    auto start = std::chrono::steady_clock::now();
+    uint64_t paid = 0;
+    for (int round = 0; round < kRounds; round++) {
+        paid = 0;
+        for (const auto& [id, amount] : PayoutCalculator::DistributeReward(weights, reward, 1.0)) {
+            paid += amount;
+        }
+    }
+    double map_seconds = ElapsedSeconds(start) / kRounds;
+    EXPECT_EQ(paid + fee, reward);
+
+    // Kernel alone, over flat arrays
+    std::vector<uint64_t> flat;
+    for (const auto& [id, weight] : weights) flat.push_back(weight);
+    std::vector<uint64_t> out(flat.size());
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; round++) {
+        PayoutCalculator::SplitExact(flat.data(), flat.size(), reward - fee, out.data());
+    }
+    double kernel_seconds = ElapsedSeconds(start) / kRounds;
+
+    uint64_t kernel_paid = 0;
+    for (uint64_t amount : out) kernel_paid += amount;
+    EXPECT_EQ(kernel_paid + fee, reward);
+
+    std::cout << "Exact payout split (" << kMiners << " miners):\n"
+              << "  DistributeReward: " << map_seconds * 1000 << " ms/round\n"
+              << "  SplitExact:       " << kernel_seconds * 1000 << " ms/round ("
+              << static_cast<uint64_t>(kMiners / kernel_seconds) << " miners/sec)\n";
+}
+
+TEST(PayoutBench, BlockFoundCreditsOneMillionShares) {
+    constexpr size_t kWindow = 1000000;
+    constexpr int kRounds = 10;
+
+    for (size_t miners : {100000ul, 1000000ul}) {
+        std::mt19937_64 rng(68);
+        PPLNSWindow window(kWindow);
+        for (size_t i = 0; i < kWindow; i++) {
+            window.Add(1 + rng() % miners, 1000 + rng() % 100000);
+        }
+        uint64_t reward = 5000000000ULL;
+        uint64_t fee = PayoutCalculator::CalculateFee(reward, 1.0);
+
+        // Incremental per-miner sums through the map path
+        auto start = std::chrono::steady_clock::now();
+        uint64_t map_paid = 0;
+        for (int round = 0; round < kRounds; round++) {
+            map_paid = 0;
+            auto payouts = PayoutCalculator::DistributeReward(window.GetMinerWork(), reward, 1.0);
+            for (const auto& [id, amount] : payouts) map_paid += amount;
+        }
+        double map_seconds = ElapsedSeconds(start) / kRounds;
+
+        // Dense arrays from the same per-miner sums, split by the 128-bit kernel
+        start = std::chrono::steady_clock::now();
+        uint64_t dense_paid = 0;
+        size_t credited = 0;
+        for (int round = 0; round < kRounds; round++) {
+            dense_paid = 0;
+            auto credits = PayoutCalculator::DistributeDense(window.GetDenseMinerWork(), reward, 1.0);
+            for (const auto& [id, amount] : credits) dense_paid += amount;
+            credited = credits.size();
+        }
+        double dense_seconds = ElapsedSeconds(start) / kRounds;
+
+        EXPECT_EQ(map_paid + fee, reward);
+        EXPECT_EQ(dense_paid + fee, reward);
+
+        std::cout << "Block-found credits (" << kWindow << " shares, " << miners << " miners, "
+                  << credited << " credited, " << std::thread::hardware_concurrency() << " threads):\n"
+                  << "  Map:   " << map_seconds * 1000 << " ms\n"
+                  << "  Dense: " << dense_seconds * 1000 << " ms (target < 50 ms)\n";
+    }
+}
+
+namespace {
+
+// Wallet double that confirms everything it sends
+class CountingSender : public PayoutSender {
+public:
+    Result<uint256> Send(const std::vector<PayoutOutput>& outputs) override {
+        transactions++;
+        bytes += PayoutEngine::EstimateTxSize(outputs.size());
+        uint256 tx_hash{};
+        std::memcpy(tx_hash.data(), &transactions, sizeof(transactions));
+        return Result<uint256>::Ok(tx_hash);
+    }
+
+    Result<int64_t> GetConfirmations(const uint256&) override {
+        return Result<int64_t>::Ok(6);
+    }
+
+    uint64_t transactions = 0;
+    uint64_t bytes = 0;
+};
+
+} // namespace
+
+TEST(PayoutBench, HundredThousandBalances) {
+    constexpr uint64_t kMiners = 100000;
+
+    auto run = [&](size_t max_tx_bytes, CountingSender& sender) {
+        std::vector<uint64_t> balances(kMiners, 50000000);
+        size_t updates = 0;
+
+        PayoutEngineOptions options;
+        options.max_tx_bytes = max_tx_bytes;
+        PayoutEngine engine(
+            options,
+            [&]() {
+                std::vector<PayoutOutput> due;
+                due.reserve(kMiners);
+                for (uint64_t id = 0; id < kMiners; id++) {
+                    if (balances[id] == 0) continue;
+                    due.push_back({0, id, "int1qminerpayoutaddress" + std::to_string(id), balances[id]});
+                }
+                return due;
+            },
+            [&](std::vector<PayoutOutput> due) {
+                for (auto& output : due) {
+                    output.payment_id = output.miner_id + 1;
+                    balances[output.miner_id] = 0;
+                }
+                return Result<std::vector<PayoutOutput>>::Ok(std::move(due));
+            },
+            [&](const std::vector<Payment>& payments) {
+                updates += payments.size();
+                return Result<void>::Ok();
+            });
+        engine.SetSender(std::shared_ptr<PayoutSender>(&sender, [](PayoutSender*) {}));
+
+        auto start = std::chrono::steady_clock::now();
+        EXPECT_TRUE(engine.RunOnce().IsOk());   // Debit and send
+        EXPECT_TRUE(engine.RunOnce().IsOk());   // Confirm
+        double seconds = ElapsedSeconds(start);
+        EXPECT_EQ(updates, 2 * kMiners);
+        EXPECT_TRUE(engine.GetOutstanding().empty());
+        return seconds;
+    };
+
+    CountingSender single;
+    double single_seconds = run(0, single);     // One output per transaction
+    CountingSender batched;
+    double batched_seconds = run(100000, batched);
+
+    std::cout << "Payouts (" << kMiners << " balances):\n"
+              << "  one per tx: " << single.transactions << " txs, "
+              << single.bytes / 1000000.0 << " MB, " << single_seconds * 1000 << " ms\n"
+              << "  batched:    " << batched.transactions << " txs, "
+              << batched.bytes / 1000000.0 << " MB, " << batched_seconds * 1000 << " ms\n";
+
+    EXPECT_EQ(single.transactions, kMiners);
+    EXPECT_LT(batched.transactions * 100, kMiners);
+    EXPECT_LT(batched.bytes * 10, single.bytes);
+}
+
+// ============================================================================
+// Export Benchmarks
+// ============================================================================
+
+TEST(SoloBench, TenThousandMinerTemplates) {
+    constexpr size_t kMiners = 10000;
+    constexpr size_t kTransactions = 2000;
+
+    auto make_tx = [](uint64_t value, uint64_t tag) {
+        Transaction tx{};
+        tx.version = 1;
+        TxOut out{};
+        out.value = value;
+        out.script_pubkey.bytes.assign(25, static_cast<uint8_t>(tag));
+        std::memcpy(out.script_pubkey.bytes.data(), &tag, sizeof(tag));
+        tx.outputs.push_back(out);
+        return tx;
+    };
+    Transaction coinbase = make_tx(5000000000ULL, 0);
+    std::vector<Transaction> txs;
+    for (uint64_t i = 1; i <= kTransactions; i++) {
+        txs.push_back(make_tx(1000 + i, i));
+    }
+    auto script_for = [](const std::string& address) {
+        Script script;
+        script.bytes.assign(address.begin(), address.end());
+        return Result<Script>::Ok(script);
+    };
+    std::vector<std::string> addresses;
+    for (size_t i = 0; i < kMiners; i++) {
+        addresses.push_back("solo-miner-address-" + std::to_string(i));
+    }
+
+    // Cached: the branch is hashed once, each miner folds it
+    SoloJobCache cache(script_for);
+    uint256 job_id{};
+    auto start = std::chrono::steady_clock::now();
+    cache.SetWork(job_id, coinbase, txs, 1.0);
+    for (size_t i = 0; i < kMiners; i++) {
+        ASSERT_TRUE(cache.GetJob(i, addresses[i]).IsOk());
+    }
+    double cached_seconds = ElapsedSeconds(start);
+
+    // A second template reuses the resolved payout scripts
+    job_id[0] = 1;
+    start = std::chrono::steady_clock::now();
+    cache.SetWork(job_id, coinbase, txs, 1.0);
+    for (size_t i = 0; i < kMiners; i++) {
+        ASSERT_TRUE(cache.GetJob(i, addresses[i]).IsOk());
+    }
+    double warm_seconds = ElapsedSeconds(start);
+
+    // Rebuilding the whole tree per miner, for a sample
+    constexpr size_t kSample = 100;
+    Block block;
+    block.transactions.push_back(coinbase);
+    block.transactions.insert(block.transactions.end(), txs.begin(), txs.end());
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kSample; i++) {
+        block.transactions[0] = cache.GetJob(i, addresses[i]).GetValue()->coinbase;
+        EXPECT_EQ(block.CalculateMerkleRoot(), cache.GetJob(i, addresses[i]).GetValue()->merkle_root);
+    }
+    double full_seconds = ElapsedSeconds(start) * kMiners / kSample;
+
+    std::cout << "Solo templates (" << kMiners << " miners, " << kTransactions << " transactions):\n"
+              << "  Cached branch:    " << cached_seconds * 1000 << " ms per template\n"
+              << "  Scripts resolved: " << warm_seconds * 1000 << " ms per template\n"
+              << "  Full tree/miner:  " << full_seconds * 1000 << " ms per template (extrapolated)\n";
+}
+
+TEST(ExportBench, ColumnarSharesWhileAppending) {
+    constexpr uint64_t kShares = 8000000;
+
+    std::string dir = "/tmp/intcoin-pool-bench-export";
+    std::filesystem::remove_all(dir);
+
+    ShareArchiveOptions options;
+    options.dir = dir;
+    options.segment_span = std::chrono::hours(1000);
+    options.segment_capacity = 1 << 21;
+
+    ShareArchive archive(options);
+    ASSERT_TRUE(archive.Open().IsOk());
+
+    auto now = std::chrono::system_clock::now();
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+    auto make_record = [&](uint64_t i) {
+        JournalRecord rec;
+        rec.seq = i + 1;
+        rec.flags = JOURNAL_SHARE_VALID;
+        rec.round_id = 1 + i / 100000;
+        rec.miner_id = i % 10000;
+        rec.worker_id = i % 40000;
+        rec.difficulty = 1000 + (i % 13);
+        rec.timestamp_ms = now_ms - static_cast<int64_t>(kShares - i);
+        return rec;
+    };
+
+    std::vector<JournalRecord> batch;
+    batch.reserve(65536);
+    for (uint64_t i = 0; i < kShares; i++) {
+        batch.push_back(make_record(i));
+        if (batch.size() == batch.capacity()) {
+            ASSERT_TRUE(archive.Append(batch).IsOk());
+            batch.clear();
+        }
+    }
+    ASSERT_TRUE(archive.Append(batch).IsOk());
+
+    // Live appends of 256-share batches while the export runs
+    std::atomic<bool> exporting{true};
+    double worst_append_ms = 0;
+    std::thread appender([&]() {
+        uint64_t next = kShares;
+        while (exporting) {
+            std::vector<JournalRecord> live;
+            for (int i = 0; i < 256; i++) live.push_back(make_record(next++));
+            auto start = std::chrono::steady_clock::now();
+            archive.Append(live);
+            worst_append_ms = std::max(worst_append_ms, ElapsedSeconds(start) * 1000);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    ExportOptions export_options;
+    export_options.from = now - std::chrono::hours(24);
+    export_options.to = now;
+    export_options.tables = EXPORT_SHARES;
+
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto result = ExportHistory(&archive, nullptr, export_options, [&](const uint8_t* data, size_t len) {
+        checksum += data[len - 1];  // Touch the data like a writer would
+        return Result<void>::Ok();
+    });
+    double export_seconds = ElapsedSeconds(start);
+    exporting = false;
+    appender.join();
+    ASSERT_TRUE(result.IsOk());
+
+    const auto& stats = result.GetValue();
+    std::cout << "Columnar export (" << stats.shares << " shares, " << stats.bytes / (1024 * 1024) << " MiB):\n"
+              << "  export:  " << export_seconds * 1000 << " ms ("
+              << static_cast<uint64_t>(stats.shares / export_seconds) << " shares/sec)\n"
+              << "  worst concurrent append (256 shares): " << worst_append_ms << " ms\n";
+
+    EXPECT_EQ(stats.shares, kShares);
+    EXPECT_GT(checksum, 0);
+
+    archive.Close();
+    std::filesystem::remove_all(dir);
+}
+
+// ============================================================================
+// Pool Database Maintenance Benchmarks
+// ============================================================================
+
+TEST(PoolDatabaseBench, MigrateAndVerify) {
+    constexpr uint64_t kShares = 2000000;
+
+    std::string path = "/tmp/intcoin-pool-bench-migrate";
+    std::filesystem::remove_all(path);
+
+    PoolDatabase db(path);
+    ASSERT_TRUE(db.Open().IsOk());
+    for (uint64_t i = 0; i < kShares; i++) {
+        db.RecordShare(MakeShare(i), 1 + i / 10000);
+    }
+    ASSERT_TRUE(db.Flush().IsOk());
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "Pool database migration (" << kShares << " shares, full rewrite):\n";
+    for (unsigned threads : {1u, cores}) {
+        auto start = std::chrono::steady_clock::now();
+        auto result = db.MigrateRecords(threads, true);
+        double seconds = ElapsedSeconds(start);
+        ASSERT_TRUE(result.IsOk());
+
+        double rate = result.GetValue().records / seconds;
+        std::cout << "  migrate, " << threads << " threads: " << static_cast<uint64_t>(rate)
+                  << " records/sec (1B shares: ~" << static_cast<uint64_t>(1e9 / rate / 60) << " min)\n";
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto verified = db.VerifyRecords(cores);
+    double seconds = ElapsedSeconds(start);
+    ASSERT_TRUE(verified.IsOk());
+    std::cout << "  verify, " << cores << " threads: "
+              << static_cast<uint64_t>(verified.GetValue().records / seconds) << " records/sec\n";
+
+    EXPECT_GE(verified.GetValue().records, kShares);
+
+    db.Close();
+    std::filesystem::remove_all(path);
+}
+
+// ============================================================================
+// Snapshot Benchmarks
+// ============================================================================
+
+TEST(SnapshotBench, WarmStartOneMillionMiners) {
+    constexpr uint64_t kMiners = 1000000;
+    constexpr uint64_t kArchived = 1000000;     // A full default PPLNS window
+    constexpr uint64_t kJournalTail = 100000;   // Shares after the last snapshot
+    constexpr uint64_t kRound = 2;
+
+    std::string dir = "/tmp/intcoin-pool-bench-warmstart";
+    std::filesystem::remove_all(dir);
+    auto data_dir = std::filesystem::path(dir);
+
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // Snapshot covering every archived share
+    PoolSnapshot snapshot;
+    snapshot.journal_seq = kArchived;
+    snapshot.next_miner_id = kMiners + 1;
+    snapshot.next_share_id = kArchived + 1;
+    snapshot.next_round_id = kRound + 1;
+    snapshot.current_round.round_id = kRound;
+    for (uint64_t id = 1; id <= kMiners; id++) {
+        Miner miner{};
+        miner.miner_id = id;
+        miner.username = "miner" + std::to_string(id);
+        miner.payout_address = "int1qminerpayoutaddress" + std::to_string(id);
+        miner.unpaid_balance = id;
+        miner.total_shares_submitted = id * 10;
+        snapshot.miners.emplace_hint(snapshot.miners.end(), id, miner);
+        snapshot.current_round.miner_shares[id] = 1;
+    }
+
+    SnapshotStore store((data_dir / "snapshots").string());
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(store.Write(snapshot).IsOk());
+    double write_seconds = ElapsedSeconds(start);
+
+    start = std::chrono::steady_clock::now();
+    auto loaded = store.LoadLatest();
+    double load_seconds = ElapsedSeconds(start);
+    ASSERT_TRUE(loaded.IsOk());
+    EXPECT_EQ(loaded.GetValue().miners.size(), kMiners);
+
+    // Archive holding the PPLNS window the pool seeds from
+    {
+        ShareArchiveOptions options;
+        options.dir = (data_dir / "archive").string();
+        options.cold_dir = (data_dir / "cold").string();
+        ShareArchive archive(options);
+        ASSERT_TRUE(archive.Open().IsOk());
+
+        std::vector<JournalRecord> batch;
+        batch.reserve(65536);
+        for (uint64_t i = 0; i < kArchived; i++) {
+            JournalRecord rec;
+            rec.seq = i + 1;
+            rec.flags = JOURNAL_SHARE_VALID;
+            rec.share_id = i + 1;
+            rec.round_id = kRound;
+            rec.miner_id = 1 + i % kMiners;
+            rec.worker_id = i % 40000;
+            rec.difficulty = 1000 + (i % 13);
+            rec.timestamp_ms = now_ms - static_cast<int64_t>(kArchived + kJournalTail - i);
+            batch.push_back(rec);
+            if (batch.size() == batch.capacity()) {
+                ASSERT_TRUE(archive.Append(batch).IsOk());
+                batch.clear();
+            }
+        }
+        ASSERT_TRUE(archive.Append(batch).IsOk());
+        archive.Close();
+    }
+
+    // Journal tail to replay on top of the snapshot
+    {
+        ShareJournalOptions options;
+        options.dir = (data_dir / "journal").string();
+        options.durable = false;
+        options.first_seq = kArchived + 1;
+        ShareJournal journal(options);
+        ASSERT_TRUE(journal.Open().IsOk());
+        for (uint64_t i = 0; i < kJournalTail; i++) {
+            Share share = MakeShare(kArchived + i);
+            share.miner_id = 1 + (kArchived + i) % kMiners;
+            journal.Append(share, kRound);
+        }
+        journal.Close();
+    }
+
+    // Ledger the balances are reconciled against, one credit per miner
+    {
+        PoolDatabase db((data_dir / "db").string());
+        ASSERT_TRUE(db.Open().IsOk());
+        std::vector<PoolDatabase::LedgerEntry> entries;
+        entries.reserve(10000);
+        for (uint64_t id = 1; id <= kMiners; id++) {
+            PoolDatabase::LedgerEntry entry;
+            entry.key = "round/1/" + std::to_string(id);
+            entry.type = PoolDatabase::LedgerType::ROUND_CREDIT;
+            entry.miner_id = id;
+            entry.amount = id;
+            entry.reference = 1;
+            entry.timestamp = std::chrono::system_clock::now();
+            entries.push_back(std::move(entry));
+            if (entries.size() == entries.capacity() || id == kMiners) {
+                ASSERT_TRUE(db.PostLedgerEntries(entries).IsOk());
+                entries.clear();
+            }
+        }
+        db.Close();
+    }
+
+    BlockchainConfig chain_config;
+    chain_config.network = NetworkType::TESTNET;
+    chain_config.data_dir = dir + "-chain";
+    auto blockchain = std::make_shared<Blockchain>(chain_config);
+
+    PoolConfig config;
+    config.data_dir = dir;
+    config.stratum_port = 23334;
+    config.http_port = 28081;
+
+    // Snapshot load, journal replay, archive catch-up, PPLNS seeding and
+    // ledger reconciliation, through to accepting connections
+    MiningPoolServer pool(config, blockchain, nullptr);
+    start = std::chrono::steady_clock::now();
+    auto started = pool.Start();
+    double start_seconds = ElapsedSeconds(start);
+    ASSERT_TRUE(started.IsOk()) << started.error;
+
+    std::cout << "Warm start (" << kMiners << " miners, " << kArchived << " archived shares, "
+              << kJournalTail << " journal tail):\n"
+              << "  snapshot write: " << write_seconds * 1000 << " ms\n"
+              << "  snapshot load:  " << load_seconds * 1000 << " ms\n"
+              << "  Start():        " << start_seconds * 1000 << " ms (target < 1000 ms)\n";
+
+    auto miner = pool.GetMiner(kMiners);
+    ASSERT_TRUE(miner.has_value());
+    EXPECT_EQ(miner->unpaid_balance, kMiners);
+    EXPECT_LT(start_seconds, 1.0);
+
+    pool.Stop();
+    std::filesystem::remove_all(dir);
+    std::filesystem::remove_all(chain_config.data_dir);
+}
+
+// ============================================================================
+// Hashrate Benchmarks
+// ============================================================================
+
+TEST(HashrateBench, MetersVersusShareScan) {
+    constexpr uint64_t kWorkers = 100000;
+    constexpr uint64_t kShares = 2000000;
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<std::unique_ptr<HashrateMeter>> meters;
+    meters.reserve(kWorkers);
+    for (uint64_t i = 0; i < kWorkers; i++) {
+        meters.push_back(std::make_unique<HashrateMeter>());
+    }
+    HashrateMeter pool_meter;
+
+    // Shares spread over ten minutes, credited to worker and pool
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < kShares; i++) {
+        auto at = t0 + std::chrono::milliseconds(i * 600000 / kShares);
+        meters[i % kWorkers]->Add(1000 + (i % 7), at);
+        pool_meter.Add(1000 + (i % 7), at);
+    }
+    double add_seconds = ElapsedSeconds(start);
+
+    auto now = t0 + std::chrono::minutes(10);
+    start = std::chrono::steady_clock::now();
+    double total = 0;
+    uint64_t work = 0;
+    for (const auto& meter : meters) {
+        total += meter->GetHashrate(now);
+        work += meter->GetWork(now);
+    }
+    double read_all_seconds = ElapsedSeconds(start);
+
+    start = std::chrono::steady_clock::now();
+    double pool_rate = pool_meter.GetHashrate(now);
+    double pool_read_ns = ElapsedSeconds(start) * 1e9;
+
+    // The scan the meters replace: every worker's recent shares
+    std::vector<Share> shares;
+    shares.reserve(kShares);
+    for (uint64_t i = 0; i < kShares; i++) {
+        Share share = MakeShare(i);
+        share.worker_id = i % kWorkers;
+        shares.push_back(share);
+    }
+    start = std::chrono::steady_clock::now();
+    double scanned = HashrateCalculator::CalculateHashrate(shares, std::chrono::minutes(10));
+    double scan_seconds = ElapsedSeconds(start);
+
+    std::cout << "Hashrate (" << kWorkers << " workers, " << kShares << " shares):\n"
+              << "  add:            " << add_seconds * 1e9 / (2 * kShares) << " ns/meter\n"
+              << "  read all workers: " << read_all_seconds * 1000 << " ms\n"
+              << "  pool read:      " << pool_read_ns << " ns\n"
+              << "  share scan:     " << scan_seconds * 1000 << " ms\n"
+              << "  memory:         " << sizeof(HashrateMeter) << " bytes/meter (1m/5m/10m/1h/24h)\n";
+
+    // Workers that started later average over less time, so compare work
+    EXPECT_EQ(work, pool_meter.GetWork(now));
+    EXPECT_GT(total, 0);
+    EXPECT_GT(pool_rate, 0);
+    EXPECT_GT(scanned, 0);
+}
+
+// ============================================================================
+// Main Benchmark Runner
+// ============================================================================
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
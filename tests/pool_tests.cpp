@@ -6,12 +6,22 @@
 
 #include <gtest/gtest.h>
 #include "intcoin/pool.h"
+#include "intcoin/pool_storage.h"
+#include "intcoin/pool_metrics.h"
 #include "intcoin/blockchain.h"
 #include "intcoin/crypto.h"
 #include "intcoin/util.h"
 #include <memory>
 #include <thread>
+#include <atomic>
 #include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
 
 using namespace intcoin;
 using namespace intcoin::pool;
@@ -147,6 +157,48 @@ TEST_F(PoolTestFixture, VarDiffAdjustment_RespectsMaxDifficulty) {
     EXPECT_LE(new_diff, config.max_difficulty);
 }
 
+TEST_F(PoolTestFixture, VarDiffAdjustment_RetargetsThroughSubmitShare) {
+    PoolConfig pool_config;
+    pool_config.stratum_port = 13333;
+    pool_config.http_port = 18080;
+    pool_config.initial_difficulty = 1;
+    pool_config.target_share_time = 10.0;
+    pool_config.vardiff_retarget_time = 0.0;
+    pool_config.vardiff_variance = 0.3;
+
+    MiningPoolServer pool(pool_config, *blockchain_);
+
+    auto miner_result = pool.RegisterMiner(test_address_.ToString(), test_address_.ToString(), "");
+    ASSERT_TRUE(miner_result.IsOk());
+    auto worker_result = pool.AddWorker(miner_result.GetValue(), "worker1", "127.0.0.1", 10000);
+    ASSERT_TRUE(worker_result.IsOk());
+    uint64_t worker_id = worker_result.GetValue();
+
+    auto work = pool.CreateWork();
+    ASSERT_TRUE(work.IsOk());
+
+    // Difficulty-1 shares far faster than one per 10 s; the third crosses
+    // the retarget threshold while SubmitShare holds the pool lock
+    uint256 hash;
+    hash.fill(0);
+    hash[31] = 0xff;
+    for (uint8_t i = 0; i < 3; i++) {
+        uint256 nonce;
+        nonce.fill(i);
+        ASSERT_TRUE(pool.SubmitShare(worker_id, work.GetValue().job_id, nonce, hash).IsOk());
+    }
+
+    auto worker = pool.GetWorker(worker_id);
+    ASSERT_TRUE(worker.has_value());
+    EXPECT_GT(worker->current_difficulty, 1u);
+    EXPECT_EQ(worker->shares_accepted, 3u);
+
+    // The next share is held to the raised difficulty
+    uint256 nonce;
+    nonce.fill(3);
+    EXPECT_TRUE(pool.SubmitShare(worker_id, work.GetValue().job_id, nonce, hash).IsError());
+}
+
 // ============================================================================
 // Share Validation Tests
 // ============================================================================
@@ -346,6 +398,958 @@ TEST_F(PoolTestFixture, PayoutCalculation_Proportional) {
     EXPECT_NEAR(payouts[2], payout_amount * 0.4, 1000);  // 40%
 }
 
+TEST(PayoutCalculatorTest, PayoutMethodValuesAreStable) {
+    // Configured and persisted values must keep their meaning
+    EXPECT_EQ(static_cast<int>(PoolConfig::PayoutMethod::PPLNS), 0);
+    EXPECT_EQ(static_cast<int>(PoolConfig::PayoutMethod::PPS), 1);
+    EXPECT_EQ(static_cast<int>(PoolConfig::PayoutMethod::PROP), 2);
+    EXPECT_EQ(static_cast<int>(PoolConfig::PayoutMethod::SOLO), 3);
+
+    EXPECT_EQ(ParsePayoutMethod("pplns-decayed"), PoolConfig::PayoutMethod::PPLNS_DECAYED);
+    EXPECT_EQ(ParsePayoutMethod("FPPS"), PoolConfig::PayoutMethod::FPPS);
+    EXPECT_EQ(ParsePayoutMethod("pps-plus"), PoolConfig::PayoutMethod::PPS_PLUS);
+    EXPECT_EQ(ParsePayoutMethod("proportional"), PoolConfig::PayoutMethod::PROP);
+    EXPECT_FALSE(ParsePayoutMethod("pplns2").has_value());
+}
+
+TEST(PayoutCalculatorTest, ExactSplitProperties) {
+    std::mt19937_64 rng(42);
+
+    for (int trial = 0; trial < 500; trial++) {
+        // Mix of dust, typical and near-2^64 weights, with some zeros
+        size_t miners = 1 + rng() % 300;
+        std::map<uint64_t, uint64_t> weights;
+        for (size_t i = 0; i < miners; i++) {
+            uint64_t weight;
+            switch (rng() % 4) {
+                case 0: weight = 0; break;
+                case 1: weight = rng() % 10; break;
+                case 2: weight = rng() % 1000000000ULL; break;
+                default: weight = rng() | (1ULL << 63); break;
+            }
+            weights[rng() % 100000] = weight;
+        }
+
+        uint64_t reward = trial % 5 == 0 ? rng() : rng() % 10000000000ULL;
+        double fee_percent = static_cast<double>(rng() % 1001) / 100.0;
+        uint64_t fee = PayoutCalculator::CalculateFee(reward, fee_percent);
+        ASSERT_LE(fee, reward);
+
+        auto payouts = PayoutCalculator::DistributeReward(weights, reward, fee_percent);
+
+        unsigned __int128 total_weight = 0;
+        for (const auto& [id, weight] : weights) total_weight += weight;
+        if (total_weight == 0) {
+            EXPECT_TRUE(payouts.empty());
+            continue;
+        }
+
+        // Every unit is accounted for: payouts plus fee is the reward
+        unsigned __int128 paid = 0;
+        for (const auto& [id, amount] : payouts) paid += amount;
+        ASSERT_EQ(paid + fee, static_cast<unsigned __int128>(reward));
+
+        // Each payout is its exact share rounded down, or one more
+        uint64_t net = reward - fee;
+        for (const auto& [id, weight] : weights) {
+            auto floor_share = static_cast<uint64_t>(
+                static_cast<unsigned __int128>(net) * weight / total_weight);
+            ASSERT_GE(payouts[id], floor_share);
+            ASSERT_LE(payouts[id], floor_share + 1);
+            if (weight == 0) ASSERT_EQ(payouts[id], 0u);
+        }
+
+        // Deterministic
+        ASSERT_EQ(PayoutCalculator::DistributeReward(weights, reward, fee_percent), payouts);
+    }
+
+    // Three equal miners split 100: the two lowest ids get the spare units
+    std::map<uint64_t, uint64_t> equal = {{7, 1}, {3, 1}, {5, 1}};
+    auto split = PayoutCalculator::DistributeReward(equal, 101, 1.0);
+    EXPECT_EQ(split[3], 34u);
+    EXPECT_EQ(split[5], 33u);
+    EXPECT_EQ(split[7], 33u);
+
+    // Fee is fixed point: 1.5% of 5 INT is exact
+    EXPECT_EQ(PayoutCalculator::CalculateFee(500000000ULL, 1.5), 7500000u);
+    EXPECT_EQ(PayoutCalculator::CalculateFee(UINT64_MAX, 100.0), UINT64_MAX);
+}
+
+TEST(PayoutCalculatorTest, DenseAggregationMatchesMap) {
+    std::mt19937_64 rng(68);
+
+    // Small and parallel-sized inputs; compact and sparse id ranges
+    for (size_t n : {0ul, 1ul, 1000ul, 300000ul}) {
+        for (uint64_t id_range : {50ull, 100000ull, 1ull << 40}) {
+            std::vector<std::pair<uint64_t, uint64_t>> shares(n);
+            std::map<uint64_t, uint64_t> expected;
+            for (auto& [miner_id, work] : shares) {
+                miner_id = 1000 + rng() % id_range;
+                work = rng() % 8 == 0 ? 0 : 1 + rng() % 100000;
+                if (work != 0) expected[miner_id] += work;
+            }
+
+            DenseMinerWork dense = PayoutCalculator::AggregateWork(shares);
+            ASSERT_EQ(dense.miner_ids.size(), expected.size());
+            ASSERT_EQ(dense.work.size(), expected.size());
+            size_t i = 0;
+            for (const auto& [miner_id, work] : expected) {
+                ASSERT_EQ(dense.miner_ids[i], miner_id);
+                ASSERT_EQ(dense.work[i], work);
+                i++;
+            }
+
+            // Same credits as the map path, less the zero payouts
+            MinerCredits credits = PayoutCalculator::DistributeDense(dense, 5000000000ULL, 1.0);
+            std::map<uint64_t, uint64_t> payouts =
+                PayoutCalculator::DistributeReward(expected, 5000000000ULL, 1.0);
+            std::erase_if(payouts, [](const auto& payout) { return payout.second == 0; });
+            ASSERT_EQ(credits, MinerCredits(payouts.begin(), payouts.end()));
+        }
+    }
+
+    // Dense arrays carry the same sums the window maintains per miner
+    PPLNSWindow window(200000);
+    for (size_t i = 0; i < 500000; i++) {
+        window.Add(rng() % 20000, 1 + rng() % 1000);
+    }
+    DenseMinerWork dense = window.GetDenseMinerWork();
+    auto work = window.GetMinerWork();
+    ASSERT_EQ(dense.miner_ids.size(), work.size());
+    for (size_t i = 0; i < dense.miner_ids.size(); i++) {
+        EXPECT_EQ(work.at(dense.miner_ids[i]), dense.work[i]);
+    }
+}
+
+TEST(PPLNSWindowTest, DifficultyWeightedSlidingWindow) {
+    const size_t window = 64;
+    PPLNSWindow pplns(window);
+    std::vector<std::pair<uint64_t, uint64_t>> added;  // (miner_id, difficulty)
+
+    // Brute-force reference over the last `window` shares
+    auto reference = [&](size_t newest) {
+        std::map<uint64_t, uint64_t> work;
+        uint64_t total = 0;
+        size_t start = added.size() > window ? added.size() - window : 0;
+        for (size_t i = start; i < added.size(); i++) {
+            work[added[i].first] += added[i].second;
+        }
+        for (size_t i = 0; i < std::min(newest, added.size() - start); i++) {
+            total += added[added.size() - 1 - i].second;
+        }
+        return std::make_pair(work, total);
+    };
+
+    // Wrap the ring several times with mixed difficulties
+    for (uint64_t i = 0; i < window * 5 + 7; i++) {
+        uint64_t miner = 1 + (i * 7) % 5;
+        uint64_t diff = 1 + (i * 31) % 1000;
+        pplns.Add(miner, diff);
+        added.emplace_back(miner, diff);
+
+        if (i % 17 == 0) {
+            auto [work, total] = reference(window);
+            EXPECT_EQ(pplns.GetMinerWork(), work);
+            EXPECT_EQ(pplns.GetTotalWork(), total);
+        }
+    }
+    EXPECT_EQ(pplns.Size(), window);
+
+    for (size_t n : {0, 1, 10, 33, 63, 64, 100}) {
+        EXPECT_EQ(pplns.GetRecentWork(n), reference(n).second) << "n=" << n;
+    }
+
+    // SharesForWork returns the fewest newest shares covering the work
+    uint64_t target = pplns.GetRecentWork(20);
+    EXPECT_EQ(pplns.SharesForWork(target), 20u);
+    EXPECT_EQ(pplns.SharesForWork(target - 1), 20u);
+    EXPECT_EQ(pplns.SharesForWork(pplns.GetTotalWork() + 1), window);
+
+    // A miner whose shares all slide out disappears from the payout set
+    PPLNSWindow small(3);
+    small.Add(1, 1000);
+    small.Add(2, 10);
+    small.Add(2, 10);
+    small.Add(2, 10);
+    EXPECT_EQ(small.GetMinerWork(), (std::map<uint64_t, uint64_t>{{2, 30}}));
+
+    // One high-difficulty share outweighs many easy ones
+    PPLNSWindow weighted(10);
+    weighted.Add(1, 900);
+    for (int i = 0; i < 9; i++) weighted.Add(2, 100);
+    auto work = weighted.GetMinerWork();
+    EXPECT_EQ(work[1], 900u);
+    EXPECT_EQ(work[2], 900u);
+
+    weighted.Clear();
+    EXPECT_EQ(weighted.Size(), 0u);
+    EXPECT_EQ(weighted.GetTotalWork(), 0u);
+    EXPECT_TRUE(weighted.GetMinerWork().empty());
+}
+
+TEST(DecayedScoreTest, ExponentialWeightsSurviveRebase) {
+    const double half_life_secs = 60;
+    const int64_t half_life_ms = 60000;
+    DecayedScore scores(half_life_secs);
+
+    // A share one half-life newer is worth twice as much
+    scores.Add(1, 1000, 0);
+    scores.Add(2, 1000, half_life_ms);
+    auto weights = scores.GetMinerWeights();
+    EXPECT_NEAR(static_cast<double>(weights[2]) / weights[1], 2.0, 1e-9);
+    EXPECT_NEAR(scores.GetTotalWork(), 1500.0, 1e-6);
+
+    // Run across ~200 half-lives so the base time is moved several times
+    scores.Clear();
+    struct Added { uint64_t miner; uint64_t diff; int64_t ts; };
+    std::vector<Added> added;
+    int64_t ts = 1700000000000;
+    for (uint64_t i = 0; i < 20000; i++) {
+        ts += 600 + (i * 37) % 500;
+        uint64_t miner = 1 + (i * 11) % 7;
+        uint64_t diff = 100 + (i * 131) % 5000;
+        scores.Add(miner, diff, ts);
+        added.push_back({miner, diff, ts});
+    }
+
+    // Reference scores relative to the newest share
+    std::map<uint64_t, double> reference;
+    double reference_total = 0;
+    double lambda = std::log(2.0) / half_life_ms;
+    for (const auto& a : added) {
+        double score = a.diff * std::exp(-lambda * static_cast<double>(ts - a.ts));
+        reference[a.miner] += score;
+        reference_total += score;
+    }
+    EXPECT_NEAR(scores.GetTotalWork() / reference_total, 1.0, 1e-9);
+
+    weights = scores.GetMinerWeights();
+    uint64_t weight_total = 0;
+    for (const auto& [miner, weight] : weights) weight_total += weight;
+    for (const auto& [miner, score] : reference) {
+        EXPECT_NEAR(static_cast<double>(weights[miner]) / weight_total, score / reference_total, 1e-9)
+            << "miner " << miner;
+    }
+
+    // A miner that stops submitting decays out at the next rebase
+    EXPECT_EQ(scores.GetMinerCount(), 7u);
+    for (int i = 0; i < 200; i++) {
+        ts += half_life_ms;
+        scores.Add(1, 1000, ts);
+    }
+    EXPECT_EQ(scores.GetMinerCount(), 1u);
+    EXPECT_EQ(scores.GetMinerWeights().size(), 1u);
+
+    // Payouts flow through the common distribution path
+    auto payouts = PayoutCalculator::DistributeReward(scores.GetMinerWeights(), 5000000000ULL, 1.0);
+    EXPECT_EQ(payouts[1], 5000000000ULL - PayoutCalculator::CalculateFee(5000000000ULL, 1.0));
+}
+
+TEST(PPSLedgerTest, FixedPointCreditAndCheckpoint) {
+    PPSLedger ledger;
+
+    // 50 INT reward, 1% fee, network difficulty 1,000,000:
+    // a difficulty-1000 share earns 4,950,000,000 / 1000 = 4,950,000 units
+    ledger.SetRate(5000000000ULL, 1000000.0, 1.0);
+    uint64_t credit = ledger.Credit(1, 1000);
+    EXPECT_EQ(credit >> PPSLedger::kCreditBits, 4950000u);
+    EXPECT_EQ(ledger.GetPending(1), 4950000u);
+
+    // Checkpoints drain whole units exactly once
+    auto drained = ledger.Checkpoint();
+    EXPECT_EQ(drained[1], 4950000u);
+    EXPECT_TRUE(ledger.Checkpoint().empty());
+    EXPECT_EQ(ledger.GetPending(1), 0u);
+
+    // Sub-unit credits carry over until they add up to whole units
+    ledger.SetRate(3, 7.0, 0.0);  // 3/7 of a unit per difficulty
+    for (int i = 0; i < 7; i++) ledger.Credit(2, 1);
+    EXPECT_EQ(ledger.GetPending(2), 2u);  // 2.999.. units, truncated
+    ledger.Credit(2, 7);
+    EXPECT_EQ(ledger.Checkpoint()[2], 5u);  // 5.999.. units total
+
+    // A failed post puts the credit back
+    ledger.SetRate(5000000000ULL, 1000000.0, 1.0);
+    ledger.Credit(3, 1000);
+    auto failed = ledger.Checkpoint();
+    ledger.Restore(failed);
+    EXPECT_EQ(ledger.GetPending(3), 4950000u);
+    ledger.Checkpoint();
+
+    // Concurrent crediting and checkpointing neither loses nor repeats credit
+    ledger.SetRate(5000000000ULL, 1000000.0, 1.0);
+    std::atomic<bool> done{false};
+    std::map<uint64_t, uint64_t> checkpointed;
+    std::thread checkpointer([&]() {
+        while (!done) {
+            for (const auto& [miner_id, amount] : ledger.Checkpoint()) checkpointed[miner_id] += amount;
+        }
+    });
+    std::vector<std::thread> workers;
+    for (uint64_t t = 0; t < 4; t++) {
+        workers.emplace_back([&ledger, t]() {
+            for (int i = 0; i < 20000; i++) ledger.Credit(10 + t, 1000);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    done = true;
+    checkpointer.join();
+    for (const auto& [miner_id, amount] : ledger.Checkpoint()) checkpointed[miner_id] += amount;
+
+    for (uint64_t t = 0; t < 4; t++) {
+        EXPECT_EQ(checkpointed[10 + t], 20000ULL * 4950000ULL);
+    }
+}
+
+TEST(FeeAverageTest, TimeWeightedTemplateFees) {
+    FeeAverage fees(3600);
+    auto t0 = std::chrono::steady_clock::now();
+
+    fees.Update(1000, t0);
+    EXPECT_EQ(fees.Get(), 1000u);
+
+    // A template that was live for one window moves the average 1 - 1/e
+    fees.Update(5000, t0 + std::chrono::seconds(1));
+    EXPECT_NEAR(static_cast<double>(fees.Get()), 1000.0, 2.0);
+    fees.Update(5000, t0 + std::chrono::seconds(3601));
+    EXPECT_NEAR(static_cast<double>(fees.Get()), 1000.0 + 4000.0 * (1.0 - std::exp(-1.0)), 2.0);
+
+    // A burst of short-lived refreshes barely registers
+    uint64_t before = fees.Get();
+    auto t = t0 + std::chrono::seconds(3601);
+    for (int i = 0; i < 100; i++) {
+        t += std::chrono::milliseconds(10);
+        fees.Update(i % 2 ? 1000000 : 5000, t);
+    }
+    EXPECT_LT(fees.Get(), before + 2000);
+
+    // FPPS credits the smoothed fees on top of the subsidy
+    PPSLedger pps;
+    PPSLedger fpps;
+    pps.SetRate(5000000000ULL, 1000000.0, 0.0);
+    fpps.SetRate(5000000000ULL + fees.Get(), 1000000.0, 0.0);
+    uint64_t extra = (fpps.Credit(1, 1000000) - pps.Credit(1, 1000000)) >> PPSLedger::kCreditBits;
+    EXPECT_NEAR(static_cast<double>(extra), static_cast<double>(fees.Get()), 1.0);
+}
+
+// Wallet double: fails the first send, then reports whatever depth is set
+class FakePayoutSender : public PayoutSender {
+public:
+    Result<uint256> Send(const std::vector<PayoutOutput>& outputs) override {
+        if (fail_next) {
+            fail_next = false;
+            return Result<uint256>::Error("wallet locked");
+        }
+        uint256 tx_hash{};
+        tx_hash[0] = static_cast<uint8_t>(++sends);
+        batch_sizes.push_back(outputs.size());
+        return Result<uint256>::Ok(tx_hash);
+    }
+
+    Result<int64_t> GetConfirmations(const uint256&) override {
+        return Result<int64_t>::Ok(depth);
+    }
+
+    bool fail_next = true;
+    int64_t depth = 0;
+    int sends = 0;
+    std::vector<size_t> batch_sizes;
+};
+
+TEST(PayoutEngineTest, BatchesHoldsAndConfirms) {
+    // Transactions stay under the size limit and fill it
+    EXPECT_GT(PayoutEngine::EstimateTxSize(1), 10000u);  // Two Dilithium3 inputs
+    std::vector<PayoutOutput> outputs(5000);
+    auto batches = PayoutEngine::Pack(outputs, 100000);
+    size_t packed = 0;
+    for (const auto& batch : batches) {
+        EXPECT_LE(PayoutEngine::EstimateTxSize(batch.size()), 100000u);
+        packed += batch.size();
+    }
+    EXPECT_EQ(packed, outputs.size());
+    EXPECT_GT(PayoutEngine::EstimateTxSize(batches[0].size() + 1), 100000u);
+
+    // Three balances due; the engine debits them once
+    std::map<uint64_t, uint64_t> balances = {{1, 500}, {2, 700}, {3, 900}};
+    std::map<uint64_t, std::string> status;
+    uint64_t next_id = 1;
+
+    PayoutEngineOptions options;
+    options.confirmations = 6;
+    PayoutEngine engine(
+        options,
+        [&]() {
+            std::vector<PayoutOutput> due;
+            for (const auto& [miner_id, amount] : balances) {
+                if (amount > 0) due.push_back({0, miner_id, "addr" + std::to_string(miner_id), amount});
+            }
+            return due;
+        },
+        [&](std::vector<PayoutOutput> due) {
+            for (auto& output : due) {
+                output.payment_id = next_id++;
+                balances[output.miner_id] = 0;
+                status[output.payment_id] = "pending";
+            }
+            return Result<std::vector<PayoutOutput>>::Ok(std::move(due));
+        },
+        [&](const std::vector<Payment>& payments) {
+            for (const auto& payment : payments) status[payment.payment_id] = payment.status;
+            return Result<void>::Ok();
+        });
+
+    // No wallet: debited and left pending
+    auto run = engine.RunOnce();
+    ASSERT_TRUE(run.IsOk());
+    EXPECT_EQ(run.GetValue(), 3u);
+    EXPECT_EQ(engine.GetOutstanding().size(), 0u);
+    EXPECT_EQ(status[1], "pending");
+
+    // New balances; the first send fails and, since it may have been
+    // broadcast anyway, the payments are held rather than sent again
+    balances = {{1, 100}, {2, 200}};
+    auto sender = std::make_shared<FakePayoutSender>();
+    engine.SetSender(sender);
+    run = engine.RunOnce();
+    ASSERT_TRUE(run.IsOk());
+    EXPECT_EQ(run.GetValue(), 2u);
+    EXPECT_EQ(status[4], "unknown");
+    EXPECT_EQ(engine.GetOutstanding().size(), 2u);
+
+    run = engine.RunOnce();
+    ASSERT_TRUE(run.IsOk());
+    EXPECT_EQ(run.GetValue(), 0u);
+    EXPECT_EQ(sender->sends, 0);
+
+    // Sent as one transaction; a dropped one is held, never resent
+    balances = {{1, 100}, {2, 200}};
+    run = engine.RunOnce();
+    EXPECT_EQ(sender->batch_sizes, std::vector<size_t>{2});
+    EXPECT_EQ(status[6], "sent");
+    sender->depth = -1;
+    engine.RunOnce();
+    EXPECT_EQ(sender->sends, 1);
+    EXPECT_EQ(status[6], "unknown");
+    EXPECT_EQ(status[7], "unknown");
+
+    // Deep enough transactions are final
+    balances = {{3, 300}};
+    sender->depth = 0;
+    engine.RunOnce();
+    EXPECT_EQ(status[8], "sent");
+    sender->depth = 6;
+    engine.RunOnce();
+    EXPECT_EQ(status[8], "confirmed");
+    EXPECT_EQ(sender->sends, 2);
+    EXPECT_EQ(engine.GetOutstanding().size(), 4u);  // The held payments
+}
+
+TEST(PayoutEngineTest, RestoresUnfinishedPayments) {
+    std::map<uint64_t, std::string> status;
+    PayoutEngine engine(
+        PayoutEngineOptions{},
+        []() { return std::vector<PayoutOutput>{}; },
+        [](std::vector<PayoutOutput> due) { return Result<std::vector<PayoutOutput>>::Ok(std::move(due)); },
+        [&](const std::vector<Payment>& payments) {
+            for (const auto& payment : payments) status[payment.payment_id] = payment.status;
+            return Result<void>::Ok();
+        });
+
+    auto payment = [](uint64_t id, const std::string& state, uint8_t tx) {
+        Payment p{};
+        p.payment_id = id;
+        p.miner_id = id;
+        p.payout_address = "addr" + std::to_string(id);
+        p.amount = 1000;
+        p.tx_hash[0] = tx;
+        p.status = state;
+        return p;
+    };
+
+    // Debited before a crash: one never sent, one mid-send, one broadcast
+    engine.Restore({payment(1, "pending", 0), payment(2, "sending", 0), payment(3, "sent", 9)});
+    EXPECT_EQ(status[2], "unknown");
+
+    auto sender = std::make_shared<FakePayoutSender>();
+    sender->fail_next = false;
+    sender->depth = 6;
+    engine.SetSender(sender);
+    ASSERT_TRUE(engine.RunOnce().IsOk());
+
+    EXPECT_EQ(status[1], "sent");
+    EXPECT_EQ(status[3], "confirmed");
+    EXPECT_EQ(sender->batch_sizes, std::vector<size_t>{1});
+}
+
+TEST(PayoutEngineTest, NeverSendsWhatItCouldNotMarkSending) {
+    std::map<uint64_t, std::string> status;
+    bool fail_updates = true;
+    PayoutEngine engine(
+        PayoutEngineOptions{},
+        []() { return std::vector<PayoutOutput>{}; },
+        [](std::vector<PayoutOutput> due) { return Result<std::vector<PayoutOutput>>::Ok(std::move(due)); },
+        [&](const std::vector<Payment>& payments) {
+            if (fail_updates) return Result<void>::Error("disk full");
+            for (const auto& payment : payments) status[payment.payment_id] = payment.status;
+            return Result<void>::Ok();
+        });
+
+    Payment pending{};
+    pending.payment_id = 1;
+    pending.miner_id = 1;
+    pending.payout_address = "addr1";
+    pending.amount = 1000;
+    pending.status = "pending";
+    engine.Restore({pending});
+
+    auto sender = std::make_shared<FakePayoutSender>();
+    sender->fail_next = false;
+    engine.SetSender(sender);
+
+    // The "sending" row could not be written: nothing is broadcast and the
+    // payment stays queued
+    EXPECT_FALSE(engine.RunOnce().IsOk());
+    EXPECT_EQ(sender->sends, 0);
+    auto outstanding = engine.GetOutstanding();
+    ASSERT_EQ(outstanding.size(), 1u);
+    EXPECT_EQ(outstanding[0].status, "pending");
+
+    // Once the database recovers it is sent exactly once
+    fail_updates = false;
+    ASSERT_TRUE(engine.RunOnce().IsOk());
+    EXPECT_EQ(sender->sends, 1);
+    EXPECT_EQ(status[1], "sent");
+}
+
+TEST(BlockTrackerTest, MaturesAndDetectsOrphans) {
+    // Chain of block hashes by height; a reorg rewrites entries
+    std::map<uint64_t, uint256> chain;
+    auto hash_for = [](uint64_t height, uint8_t fork) {
+        uint256 hash{};
+        std::memcpy(hash.data(), &height, sizeof(height));
+        hash[31] = fork;
+        return hash;
+    };
+    uint64_t tip = 0;
+    size_t lookups = 0;
+    auto extend = [&](uint64_t to) {
+        for (uint64_t h = tip + 1; h <= to; h++) chain[h] = hash_for(h, 0);
+        tip = to;
+    };
+    BlockTracker::HashAtFn hash_at = [&](uint64_t height) -> std::optional<uint256> {
+        lookups++;
+        auto it = chain.find(height);
+        if (it == chain.end()) return std::nullopt;
+        return it->second;
+    };
+
+    BlockTracker tracker(10);
+    extend(100);
+    for (uint64_t height : {95, 100}) {
+        FoundBlock block;
+        block.round_id = height;
+        block.height = height;
+        block.hash = hash_for(height, 0);
+        block.credits.push_back({1, 1000});
+        tracker.Add(block);
+    }
+
+    // Immature: both still pending, with their depth
+    EXPECT_TRUE(tracker.OnTip(tip, hash_at).empty());
+    ASSERT_EQ(tracker.GetPending().size(), 2u);
+    EXPECT_EQ(tracker.GetPending()[0].confirmations, 6u);
+
+    // The same tip again costs one lookup
+    lookups = 0;
+    EXPECT_TRUE(tracker.OnTip(tip, hash_at).empty());
+    EXPECT_EQ(lookups, 1u);
+
+    // A reorg replaces block 100; block 95 matures later
+    chain[100] = hash_for(100, 1);
+    extend(104);
+    auto settled = tracker.OnTip(tip, hash_at);
+    ASSERT_EQ(settled.size(), 2u);
+    EXPECT_EQ(settled[0].height, 95u);
+    EXPECT_EQ(settled[0].status, FoundBlock::Status::CONFIRMED);
+    ASSERT_EQ(settled[0].credits.size(), 1u);
+    EXPECT_EQ(settled[0].credits[0].second, 1000u);
+    EXPECT_EQ(settled[1].height, 100u);
+    EXPECT_EQ(settled[1].status, FoundBlock::Status::ORPHANED);
+    EXPECT_TRUE(tracker.GetPending().empty());
+    EXPECT_EQ(tracker.GetConfirmedCount(), 1u);
+    EXPECT_EQ(tracker.GetOrphanedCount(), 1u);
+
+    // Settled blocks are no longer checked; history keeps them for the API
+    lookups = 0;
+    extend(110);
+    EXPECT_TRUE(tracker.OnTip(tip, hash_at).empty());
+    EXPECT_EQ(lookups, 1u);
+    auto recent = tracker.GetRecent(10);
+    ASSERT_EQ(recent.size(), 2u);
+    EXPECT_EQ(recent[0].height, 100u);
+    EXPECT_EQ(ToString(recent[0].status), "orphaned");
+}
+
+namespace {
+
+Transaction MakeTransaction(uint64_t value, uint8_t tag) {
+    Transaction tx{};
+    tx.version = 1;
+    TxOut out{};
+    out.value = value;
+    out.script_pubkey.bytes.assign(25, tag);
+    tx.outputs.push_back(out);
+    return tx;
+}
+
+// Addresses map to scripts holding their own bytes; "bad" never resolves
+Result<Script> FakeScriptFor(const std::string& address) {
+    if (address == "bad") {
+        return Result<Script>::Error("undecodable");
+    }
+    Script script;
+    script.bytes.assign(address.begin(), address.end());
+    return Result<Script>::Ok(script);
+}
+
+} // namespace
+
+TEST(SoloJobCacheTest, PerMinerCoinbasesShareTheBranch) {
+    const uint64_t value = 5000000000ULL;
+    const uint64_t fee = PayoutCalculator::CalculateFee(value, 1.0);
+    Transaction coinbase = MakeTransaction(value, 0xcb);
+
+    // Odd and even levels, down to a coinbase-only template
+    for (size_t count = 0; count < 12; count++) {
+        std::vector<Transaction> txs;
+        for (size_t i = 0; i < count; i++) {
+            txs.push_back(MakeTransaction(1000 + i, static_cast<uint8_t>(i)));
+        }
+
+        SoloJobCache cache(FakeScriptFor);
+        uint256 job_id{};
+        job_id[0] = static_cast<uint8_t>(count);
+        cache.SetWork(job_id, coinbase, txs, 1.0);
+
+        auto first = cache.GetJob(1, "miner-one-address");
+        auto second = cache.GetJob(2, "miner-two-address");
+        ASSERT_TRUE(first.IsOk());
+        ASSERT_TRUE(second.IsOk());
+        const SoloJob& job = *first.GetValue();
+
+        // The miner takes the reward less the fee; the fee keeps the template's script
+        EXPECT_EQ(job.job_id, job_id);
+        ASSERT_EQ(job.coinbase.outputs.size(), 2u);
+        EXPECT_EQ(job.coinbase.outputs[0].value, value - fee);
+        EXPECT_EQ(job.coinbase.outputs[0].script_pubkey.bytes, FakeScriptFor("miner-one-address").GetValue().bytes);
+        EXPECT_EQ(job.coinbase.outputs[1].value, fee);
+        EXPECT_EQ(job.coinbase.outputs[1].script_pubkey.bytes, coinbase.outputs[0].script_pubkey.bytes);
+
+        // The root matches a full rebuild of the block with this coinbase
+        Block block;
+        block.transactions.push_back(job.coinbase);
+        block.transactions.insert(block.transactions.end(), txs.begin(), txs.end());
+        EXPECT_EQ(job.merkle_root, block.CalculateMerkleRoot()) << count << " transactions";
+
+        // One branch for every miner, but each has their own root
+        EXPECT_EQ(job.merkle_branch, second.GetValue()->merkle_branch);
+        EXPECT_NE(job.merkle_root, second.GetValue()->merkle_root);
+
+        // The split leaves the extranonce's 8 bytes out
+        std::vector<uint8_t> bytes = job.coinbase.Serialize();
+        EXPECT_EQ((job.coinbase1.size() + job.coinbase2.size()) / 2, bytes.size() - 8);
+    }
+
+    SoloJobCache cache(FakeScriptFor);
+    EXPECT_TRUE(cache.GetJob(1, "miner-one-address").IsError());  // No work yet
+
+    uint256 job_id{};
+    cache.SetWork(job_id, coinbase, {}, 0.0);
+    auto job = cache.GetJob(1, "miner-one-address").GetValue();
+    EXPECT_EQ(job->coinbase.outputs.size(), 1u);  // No fee, no fee output
+    EXPECT_EQ(job->coinbase.outputs[0].value, value);
+
+    // Cached per job; rebuilt when the address or the template changes
+    EXPECT_EQ(cache.GetJob(1, "miner-one-address").GetValue(), job);
+    EXPECT_NE(cache.GetJob(1, "miner-one-moved").GetValue(), job);
+    EXPECT_TRUE(cache.GetJob(3, "bad").IsError());
+    EXPECT_EQ(cache.GetJobCount(), 1u);
+
+    job_id[0] = 1;
+    cache.SetWork(job_id, coinbase, {}, 0.0);
+    EXPECT_EQ(cache.GetJobCount(), 0u);
+    EXPECT_EQ(cache.GetJob(1, "miner-one-moved").GetValue()->job_id, job_id);
+}
+
+// ============================================================================
+// Job Scheduler Tests
+// ============================================================================
+
+namespace {
+
+class FakeChainBackend : public ChainBackend {
+public:
+    FakeChainBackend(uint64_t difficulty, uint64_t value) : difficulty_(difficulty), value_(value) {}
+
+    Result<Work> CreateWork() override {
+        Work work{};
+        work.job_id[31] = static_cast<uint8_t>(++templates);
+        work.height = 100 + templates;
+        work.difficulty = difficulty_;
+        work.coinbase_value = value_;
+        work.created_at = std::chrono::system_clock::now();
+        return Result<Work>::Ok(work);
+    }
+
+    Result<void> SubmitBlock(const Block& block) override {
+        blocks++;
+        chain[100 + templates] = block.GetHash();
+        return Result<void>::Ok();
+    }
+
+    Result<uint256> GetBlockHash(uint64_t height) override {
+        auto it = chain.find(height);
+        if (it == chain.end()) {
+            uint256 other{};
+            other[0] = 0xee;
+            return Result<uint256>::Ok(other);
+        }
+        return Result<uint256>::Ok(it->second);
+    }
+
+    void SetDifficulty(uint64_t difficulty) { difficulty_ = difficulty; }
+
+    int templates = 0;
+    int blocks = 0;
+    std::map<uint64_t, uint256> chain;          // Blocks accepted, by height
+
+private:
+    uint64_t difficulty_;
+    uint64_t value_;
+};
+
+Share SchedulerShare(const Work& work, uint64_t miner_id, bool is_block) {
+    Share share{};
+    share.job_id = work.job_id;
+    share.miner_id = miner_id;
+    share.difficulty = 1;
+    share.share_hash.fill(0);
+    if (!is_block) {
+        share.share_hash[31] = 0xff;  // Difficulty 1: a share, never a block
+    }
+    return share;
+}
+
+} // namespace
+
+TEST(JobSchedulerTest, SwitchesOnProfitWithHysteresis) {
+    JobScheduler scheduler(0.10);
+    ChainConfig primary;
+    primary.name = "intcoin";
+    scheduler.AddChain(primary, nullptr);
+
+    ChainConfig aux_config;
+    aux_config.name = "aux";
+    auto aux_backend = std::make_shared<FakeChainBackend>(1000, 1000);
+    ChainId aux = scheduler.AddChain(aux_config, aux_backend);
+    EXPECT_EQ(aux, 1);
+    EXPECT_EQ(scheduler.GetChainCount(), 2u);
+
+    // Templates carry their chain in the job id
+    Work primary_work{};
+    primary_work.difficulty = 1000;
+    primary_work.coinbase_value = 1000;
+    auto stamped = scheduler.SetWork(JobScheduler::kPrimaryChain, primary_work);
+    ASSERT_TRUE(stamped.IsOk());
+    EXPECT_EQ(JobScheduler::ChainOf(stamped.GetValue().job_id), JobScheduler::kPrimaryChain);
+    EXPECT_TRUE(scheduler.SetWork(7, primary_work).IsError());
+
+    // Equal profit, then 5% better: neither clears the 10% margin
+    ASSERT_TRUE(scheduler.Refresh(aux).IsOk());
+    EXPECT_EQ(JobScheduler::ChainOf(scheduler.GetWork(aux)->job_id), aux);
+    EXPECT_FALSE(scheduler.Rebalance());
+    aux_backend->SetDifficulty(950);
+    ASSERT_TRUE(scheduler.Refresh(aux).IsOk());
+    EXPECT_FALSE(scheduler.Rebalance());
+    EXPECT_EQ(scheduler.GetActiveChain(), JobScheduler::kPrimaryChain);
+
+    // 25% better switches, and switching back needs the margin too
+    aux_backend->SetDifficulty(800);
+    ASSERT_TRUE(scheduler.Refresh(aux).IsOk());
+    EXPECT_TRUE(scheduler.Rebalance());
+    EXPECT_EQ(scheduler.GetActiveChain(), aux);
+    EXPECT_EQ(scheduler.GetChainForPort(0), aux);
+    EXPECT_FALSE(scheduler.Rebalance());
+
+    primary_work.difficulty = 780;
+    scheduler.SetWork(JobScheduler::kPrimaryChain, primary_work);
+    EXPECT_FALSE(scheduler.Rebalance());
+    primary_work.difficulty = 600;
+    scheduler.SetWork(JobScheduler::kPrimaryChain, primary_work);
+    EXPECT_TRUE(scheduler.Rebalance());
+    EXPECT_EQ(scheduler.GetActiveChain(), JobScheduler::kPrimaryChain);
+
+    // A pinned chain keeps its port and never takes switchable hashrate
+    ChainConfig pinned_config;
+    pinned_config.name = "pinned";
+    pinned_config.port = 3334;
+    ChainId pinned = scheduler.AddChain(pinned_config, std::make_shared<FakeChainBackend>(1, 1000000));
+    ASSERT_TRUE(scheduler.Refresh(pinned).IsOk());
+    EXPECT_FALSE(scheduler.Rebalance());
+    EXPECT_EQ(scheduler.GetChainForPort(3334), pinned);
+    EXPECT_EQ(scheduler.GetChainForPort(3333), JobScheduler::kPrimaryChain);
+}
+
+TEST(JobSchedulerTest, SharesAndBlocksCreditTheirChainAtMaturity) {
+    JobScheduler scheduler;
+    scheduler.AddChain(ChainConfig{}, nullptr);
+
+    ChainConfig aux_config;
+    aux_config.name = "aux";
+    aux_config.pplns_window = 100;
+    aux_config.pool_fee_percent = 1.0;
+    aux_config.block_maturity = 3;
+    aux_config.price = 2.0;
+    auto backend = std::make_shared<FakeChainBackend>(1000, 100000);
+    ChainId aux = scheduler.AddChain(aux_config, backend);
+    ASSERT_TRUE(scheduler.Refresh(aux).IsOk());
+    Work work = *scheduler.GetWork(aux);
+
+    // The primary chain's shares belong to the pool, not the scheduler
+    Work primary = scheduler.SetWork(JobScheduler::kPrimaryChain, work).GetValue();
+    EXPECT_TRUE(scheduler.SubmitShare(SchedulerShare(primary, 1, false)).IsError());
+    Work unknown = work;
+    unknown.job_id[1] = 9;
+    EXPECT_TRUE(scheduler.SubmitShare(SchedulerShare(unknown, 1, false)).IsError());
+
+    // Three shares from miner 1, one from miner 2
+    for (int i = 0; i < 3; i++) {
+        auto accepted = scheduler.SubmitShare(SchedulerShare(work, 1, false));
+        ASSERT_TRUE(accepted.IsOk());
+        EXPECT_FALSE(accepted.GetValue());
+    }
+    Share weak = SchedulerShare(work, 2, false);
+    weak.difficulty = 2;
+    EXPECT_TRUE(scheduler.SubmitShare(weak).IsError());
+
+    auto found = scheduler.SubmitShare(SchedulerShare(work, 2, true));
+    ASSERT_TRUE(found.IsOk());
+    EXPECT_TRUE(found.GetValue());
+    EXPECT_EQ(backend->blocks, 1);
+
+    // The reward is split now but held until the block matures
+    uint64_t distributable = 100000 - PayoutCalculator::CalculateFee(100000, 1.0);
+    auto stats = scheduler.GetStatistics();
+    ASSERT_EQ(stats.size(), 2u);
+    EXPECT_EQ(stats[aux].blocks_found, 1u);
+    EXPECT_EQ(stats[aux].round_id, 2u);
+    EXPECT_EQ(stats[aux].round_shares, 0u);
+    EXPECT_EQ(stats[aux].immature, distributable);
+    EXPECT_TRUE(scheduler.CheckMaturity().empty());
+
+    // A new template makes the old one stale
+    ASSERT_TRUE(scheduler.Refresh(aux).IsOk());
+    EXPECT_TRUE(scheduler.SubmitShare(SchedulerShare(work, 1, false)).IsError());
+    EXPECT_TRUE(scheduler.SubmitShare(SchedulerShare(*scheduler.GetWork(aux), 1, false)).IsOk());
+
+    // Three deep: the window's 3:1 split, in the pool's unit at the chain's price
+    ASSERT_TRUE(scheduler.Refresh(aux).IsOk());
+    EXPECT_TRUE(scheduler.CheckMaturity().empty());
+    ASSERT_TRUE(scheduler.Refresh(aux).IsOk());
+    auto matured = scheduler.CheckMaturity();
+    ASSERT_EQ(matured.size(), 1u);
+    EXPECT_EQ(matured[0].chain, aux);
+    EXPECT_EQ(matured[0].chain_name, "aux");
+    const auto& credits = matured[0].block.credits;
+    ASSERT_EQ(credits.size(), 2u);
+    EXPECT_EQ(credits[0].second + credits[1].second, 2 * distributable);
+    EXPECT_EQ(credits[0].second, 2 * (distributable * 3 / 4));
+    EXPECT_EQ(matured[0].block.pool_fee, 2 * (100000 - distributable));
+    EXPECT_EQ(scheduler.GetStatistics()[aux].immature, 0u);
+    EXPECT_TRUE(scheduler.CheckMaturity().empty());
+}
+
+TEST(JobSchedulerTest, OrphanedChainBlockIsNeverCredited) {
+    JobScheduler scheduler;
+    scheduler.AddChain(ChainConfig{}, nullptr);
+
+    ChainConfig aux_config;
+    aux_config.name = "aux";
+    aux_config.block_maturity = 2;
+    auto backend = std::make_shared<FakeChainBackend>(1000, 100000);
+    ChainId aux = scheduler.AddChain(aux_config, backend);
+    std::vector<FoundBlock::Status> reported;
+    scheduler.SetBlockCallback([&reported](const std::string&, const FoundBlock& block) {
+        reported.push_back(block.status);
+    });
+    ASSERT_TRUE(scheduler.Refresh(aux).IsOk());
+
+    ASSERT_TRUE(scheduler.SubmitShare(SchedulerShare(*scheduler.GetWork(aux), 1, true)).IsOk());
+    backend->chain.clear();  // Reorged out
+    ASSERT_TRUE(scheduler.Refresh(aux).IsOk());
+    ASSERT_TRUE(scheduler.Refresh(aux).IsOk());
+    EXPECT_TRUE(scheduler.CheckMaturity().empty());
+    EXPECT_EQ(scheduler.GetStatistics()[aux].immature, 0u);
+
+    // Persisted as pending when found, then marked orphaned
+    EXPECT_EQ(reported, (std::vector<FoundBlock::Status>{FoundBlock::Status::PENDING,
+                                                          FoundBlock::Status::ORPHANED}));
+}
+
+TEST(JobSchedulerTest, RestoredChainBlockMaturesAtExactPrice) {
+    ChainConfig aux_config;
+    aux_config.name = "aux";
+    aux_config.block_maturity = 2;
+    aux_config.price = 0.375;
+    auto backend = std::make_shared<FakeChainBackend>(1000, 100007);
+
+    // Found before a restart; the callback is what gets persisted
+    std::vector<std::pair<std::string, FoundBlock>> reported;
+    {
+        JobScheduler scheduler;
+        scheduler.AddChain(ChainConfig{}, nullptr);
+        ChainId aux = scheduler.AddChain(aux_config, backend);
+        scheduler.SetBlockCallback([&reported](const std::string& chain_name, const FoundBlock& block) {
+            reported.emplace_back(chain_name, block);
+        });
+        ASSERT_TRUE(scheduler.Refresh(aux).IsOk());
+        Work work = *scheduler.GetWork(aux);
+        ASSERT_TRUE(scheduler.SubmitShare(SchedulerShare(work, 1, false)).IsOk());
+        ASSERT_TRUE(scheduler.SubmitShare(SchedulerShare(work, 2, false)).IsOk());
+        ASSERT_TRUE(scheduler.SubmitShare(SchedulerShare(work, 3, true)).IsOk());
+    }
+    ASSERT_EQ(reported.size(), 1u);
+    EXPECT_EQ(reported[0].first, "aux");
+    const FoundBlock& native = reported[0].second;
+    EXPECT_EQ(native.status, FoundBlock::Status::PENDING);
+    ASSERT_EQ(native.credits.size(), 3u);
+
+    // Restored once its chain is back; the chain's rounds continue after it
+    JobScheduler scheduler;
+    scheduler.AddChain(ChainConfig{}, nullptr);
+    EXPECT_FALSE(scheduler.RestoreBlock("aux", native));
+    ChainId aux = scheduler.AddChain(aux_config, backend);
+    ASSERT_TRUE(scheduler.RestoreBlock("aux", native));
+    EXPECT_EQ(scheduler.GetStatistics()[aux].round_id, native.round_id + 1);
+
+    ASSERT_TRUE(scheduler.Refresh(aux).IsOk());
+    EXPECT_TRUE(scheduler.CheckMaturity().empty());
+    ASSERT_TRUE(scheduler.Refresh(aux).IsOk());
+    auto matured = scheduler.CheckMaturity();
+    ASSERT_EQ(matured.size(), 1u);
+
+    // The block's total converts once; credits and fee still add up to it
+    uint64_t total = native.pool_fee;
+    uint64_t converted = matured[0].block.pool_fee;
+    for (size_t i = 0; i < native.credits.size(); i++) {
+        total += native.credits[i].second;
+        converted += matured[0].block.credits[i].second;
+        EXPECT_NEAR(static_cast<double>(matured[0].block.credits[i].second),
+                    static_cast<double>(native.credits[i].second) * 0.375, 1.0);
+    }
+    EXPECT_EQ(converted, total * 3 / 8);
+}
+
 // ============================================================================
 // Worker Management Tests
 // ============================================================================
@@ -463,25 +1467,25 @@ TEST_F(PoolTestFixture, HashrateCalculation_WorkerHashrate) {
     ASSERT_TRUE(worker_result.IsOk());
     uint64_t worker_id = worker_result.GetValue();
 
-    // Simulate shares submitted over time
-    auto worker_opt = pool.GetWorker(worker_id);
-    ASSERT_TRUE(worker_opt.has_value());
-
-    // Add 10 shares over 100 seconds
-    auto now = std::chrono::system_clock::now();
+    // Accept 10 shares at difficulty 10000; they land in the meter's
+    // current window, since hashrate comes from accepted shares' difficulty
+    // rather than share timestamps
     for (int i = 0; i < 10; i++) {
-        worker_opt->recent_shares.push_back(now + std::chrono::seconds(i * 10));
+        Share share{};
+        share.miner_id = miner_id;
+        share.worker_id = worker_id;
+        share.difficulty = 10000;
+        share.valid = true;
+        share.timestamp = std::chrono::system_clock::now();
+        pool.ProcessValidShare(share);
     }
 
-    // Update worker
-    pool.UpdateWorker(*worker_opt);
-
     // Calculate hashrate
     double hashrate = pool.CalculateWorkerHashrate(worker_id);
 
-    // Hashrate = (shares * difficulty * 2^32) / time
-    // Expected: (10 * 10000 * 4294967296) / 100 ≈ 429 MH/s
+    // Hashrate = (shares * difficulty * 2^32) / window span
     EXPECT_GT(hashrate, 0);
+    EXPECT_DOUBLE_EQ(pool.CalculateMinerHashrate(miner_id), hashrate);
 }
 
 TEST_F(PoolTestFixture, HashrateCalculation_PoolHashrate) {
@@ -507,6 +1511,204 @@ TEST_F(PoolTestFixture, HashrateCalculation_PoolHashrate) {
     EXPECT_GE(pool_hashrate, 0);
 }
 
+TEST(HashrateMeterTest, SlidingWindowByDifficulty) {
+    using namespace std::chrono_literals;
+    const double hashes = 4294967296.0;
+    auto t0 = std::chrono::steady_clock::time_point(1080000s);  // On an hour boundary
+
+    HashrateMeter meter;
+    EXPECT_EQ(meter.GetHashrate(t0), 0.0);
+    EXPECT_EQ(meter.Get(StatsWindow::DAY, t0).shares, 0u);
+
+    // Weighted by each share's difficulty, so a retarget does not skew it
+    meter.Add(1000, t0);
+    meter.Add(4000, t0 + 5s);
+    EXPECT_EQ(meter.GetWork(t0 + 5s), 5000u);
+    auto first = meter.Get(StatsWindow::MINUTE, t0 + 5s);
+    EXPECT_EQ(first.shares, 2u);
+    EXPECT_EQ(first.span, 15s);  // One bucket so far
+    EXPECT_DOUBLE_EQ(first.hashrate, 5000 * hashes / 15);
+
+    // One share every 15 s for two hours; each window ends in a bucket
+    // holding only the latest share
+    for (int i = 1; i <= 480; i++) {
+        meter.Add(100, t0 + std::chrono::seconds(i * 15));
+    }
+    auto t1 = t0 + 7200s;
+    EXPECT_EQ(meter.Get(StatsWindow::MINUTE, t1).shares, 4u);
+    EXPECT_EQ(meter.Get(StatsWindow::FIVE_MINUTES, t1).shares, 17u);
+    EXPECT_EQ(meter.Get(StatsWindow::TEN_MINUTES, t1).work, 3700u);
+    EXPECT_EQ(meter.Get(StatsWindow::HOUR, t1).shares, 221u);
+    auto day = meter.Get(StatsWindow::DAY, t1);
+    EXPECT_EQ(day.shares, 482u);
+    EXPECT_EQ(day.work, 53000u);
+    EXPECT_EQ(day.span, 3h);
+    EXPECT_DOUBLE_EQ(meter.GetHashrate(t1, StatsWindow::DAY), 53000 * hashes / 10800);
+
+    // Work ages out while idle, one bucket at a time
+    EXPECT_EQ(meter.Get(StatsWindow::HOUR, t1 + 1h).shares, 0u);
+    EXPECT_EQ(meter.Get(StatsWindow::DAY, t1 + 21h).shares, 482u);
+    EXPECT_EQ(meter.Get(StatsWindow::DAY, t1 + 22h).shares, 241u);
+    EXPECT_EQ(meter.Get(StatsWindow::DAY, t1 + 24h).shares, 0u);
+
+    // A gap longer than every ring leaves only the new share
+    meter.Add(700, t1 + 48h);
+    EXPECT_EQ(meter.Get(StatsWindow::MINUTE, t1 + 48h).work, 700u);
+    EXPECT_EQ(meter.Get(StatsWindow::DAY, t1 + 48h).shares, 1u);
+    EXPECT_LT(sizeof(HashrateMeter), 768u);
+}
+
+TEST(HashrateMeterTest, ConcurrentReadersSeeConsistentWindows) {
+    using namespace std::chrono_literals;
+    auto t0 = std::chrono::steady_clock::time_point(1080000s);
+    HashrateMeter meter;
+
+    // Two writers crediting inside one window; every read is a whole sum
+    std::atomic<bool> done{false};
+    std::atomic<bool> torn{false};
+    std::thread reader([&]() {
+        uint64_t last = 0;
+        while (!done.load()) {
+            auto totals = meter.Get(StatsWindow::TEN_MINUTES, t0 + 300s);
+            if (totals.shares < last || totals.work != totals.shares * 3) torn = true;
+            last = totals.shares;
+        }
+    });
+
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 2; w++) {
+        writers.emplace_back([&, w]() {
+            for (int i = 0; i < 100000; i++) {
+                meter.Add(3, t0 + std::chrono::seconds((i + w) % 300));
+            }
+        });
+    }
+    for (auto& writer : writers) writer.join();
+    done = true;
+    reader.join();
+
+    EXPECT_FALSE(torn.load());
+    EXPECT_EQ(meter.GetWork(t0 + 300s), 600000u);
+    EXPECT_EQ(meter.Get(StatsWindow::DAY, t0 + 300s).shares, 200000u);
+}
+
+// ============================================================================
+// Chain State Cache Tests
+// ============================================================================
+
+TEST(ChainStateCacheTest, ReadsNewBlocksOnlyAndTracksRewardSchedule) {
+    // Blocks every 60 s at difficulty 1000; the subsidy halves every 500
+    uint64_t height = 100;
+    uint64_t node_calls = 0;
+    std::map<uint64_t, uint64_t> times;
+    for (uint64_t h = 0; h <= 1000; h++) times[h] = 1700000000 + h * 60;
+
+    ChainStateCache::Source source;
+    source.best_height = [&]() { node_calls++; return height; };
+    source.difficulty = [&]() { node_calls++; return uint64_t{1000}; };
+    source.time_at = [&](uint64_t h) -> std::optional<uint64_t> {
+        node_calls++;
+        if (h > height) return std::nullopt;
+        return times[h];
+    };
+    source.reward_at = [](uint64_t h) { return uint64_t{5000000000} >> (h / 500); };
+
+    ChainStateCache cache(source, 10);
+    EXPECT_EQ(cache.Get().height, 0);
+
+    EXPECT_TRUE(cache.Refresh());
+    auto state = cache.Get();
+    EXPECT_EQ(state.height, 100);
+    EXPECT_EQ(state.difficulty, 1000);
+    EXPECT_DOUBLE_EQ(state.network_hashrate, 1000 * 4294967296.0 / 60);
+    EXPECT_EQ(state.block_reward, 5000000000);
+    EXPECT_EQ(state.next_reward_height, 500);
+    EXPECT_EQ(state.next_block_reward, 2500000000);
+
+    // Same tip: height and difficulty only, no block reads
+    node_calls = 0;
+    EXPECT_FALSE(cache.Refresh());
+    EXPECT_EQ(node_calls, 2);
+
+    // One new block: one block read; blocks arriving twice as fast
+    // double the hashrate once they fill the window
+    height = 101;
+    node_calls = 0;
+    EXPECT_TRUE(cache.Refresh());
+    EXPECT_EQ(node_calls, 3);
+    for (uint64_t h = 102; h <= 111; h++) times[h] = times[101] + (h - 101) * 30;
+    height = 111;
+    cache.Refresh();
+    EXPECT_DOUBLE_EQ(cache.Get().network_hashrate, 1000 * 4294967296.0 / 30);
+
+    // A reorg to a lower tip drops the blocks above it
+    height = 105;
+    EXPECT_TRUE(cache.Refresh());
+    EXPECT_EQ(cache.Get().height, 105);
+
+    // Reaching the halving moves the schedule to the next one
+    height = 499;
+    cache.Refresh();
+    state = cache.Get();
+    EXPECT_EQ(state.block_reward, 2500000000);
+    EXPECT_EQ(state.next_reward_height, 1000);
+    EXPECT_EQ(state.next_block_reward, 1250000000);
+}
+
+// ============================================================================
+// Luck Tracker Tests
+// ============================================================================
+
+TEST(LuckTrackerTest, EffortAndRollingLuckFromWork) {
+    auto round_of = [](uint64_t id, uint64_t work, uint64_t network_difficulty) {
+        RoundStatistics round;
+        round.round_id = id;
+        round.total_work = work;
+        round.network_difficulty = network_difficulty;
+        return round;
+    };
+
+    // Effort is work against the difficulty the round opened at
+    EXPECT_DOUBLE_EQ(LuckTracker::Effort(round_of(1, 500, 1000)), 50.0);
+    EXPECT_DOUBLE_EQ(LuckTracker::Effort(round_of(1, 500, 0)), 0.0);
+
+    LuckTracker luck(3);
+    EXPECT_DOUBLE_EQ(luck.GetRollingLuck(), 0.0);
+
+    luck.Close(round_of(1, 2000, 1000));   // Unlucky: twice the work
+    luck.Close(round_of(2, 0, 1000));      // No work: skipped
+    luck.Close(round_of(3, 500, 1000));    // Lucky: half the work
+    ASSERT_EQ(luck.GetRoundCount(), 2);
+
+    auto recent = luck.GetRecent(10);
+    ASSERT_EQ(recent.size(), 2);
+    EXPECT_EQ(recent[0].round_id, 3);
+    EXPECT_DOUBLE_EQ(recent[0].effort, 50.0);
+    EXPECT_DOUBLE_EQ(recent[0].luck, 200.0);
+    EXPECT_DOUBLE_EQ(recent[1].luck, 50.0);
+
+    // Rolling luck is by total work, not the mean of per-round luck
+    EXPECT_DOUBLE_EQ(luck.GetRollingLuck(), 100.0 * 2000 / 2500);
+
+    // A share durable after its round closed still counts for it
+    luck.AddWork(3, 500);
+    EXPECT_DOUBLE_EQ(luck.GetRecent(1)[0].effort, 100.0);
+    EXPECT_DOUBLE_EQ(luck.GetRollingLuck(), 100.0 * 2000 / 3000);
+
+    // The oldest round leaves the window
+    luck.Close(round_of(4, 1000, 1000));
+    luck.Close(round_of(5, 1000, 1000));
+    ASSERT_EQ(luck.GetRoundCount(), 3);
+    EXPECT_DOUBLE_EQ(luck.GetRollingLuck(), 100.0 * 3000 / 3000);
+
+    // Restoring persisted rounds gives the same window
+    LuckTracker restored(3);
+    restored.Restore({round_of(1, 2000, 1000), round_of(3, 1000, 1000),
+                      round_of(4, 1000, 1000), round_of(5, 1000, 1000)});
+    EXPECT_EQ(restored.GetRoundCount(), 3);
+    EXPECT_DOUBLE_EQ(restored.GetRollingLuck(), luck.GetRollingLuck());
+}
+
 // ============================================================================
 // Block Detection Tests
 // ============================================================================
@@ -586,6 +1788,1004 @@ TEST_F(PoolTestFixture, Statistics_MinerStats) {
     EXPECT_EQ(miner_opt->unpaid_balance, 0);
 }
 
+// ============================================================================
+// Pool Database Tests
+// ============================================================================
+
+TEST(PoolDatabaseTest, SharesRoundTripByRound) {
+    std::string path = "/tmp/intcoin-pool-db-test";
+    std::filesystem::remove_all(path);
+
+    {
+        PoolDatabase db(path);
+        ASSERT_TRUE(db.Open().IsOk());
+
+        for (uint64_t i = 0; i < 10; i++) {
+            Share share{};
+            share.miner_id = i % 3;
+            share.worker_name = "worker" + std::to_string(i);
+            share.difficulty = 1000 + i;
+            share.valid = true;
+            share.timestamp = std::chrono::system_clock::now();
+            ASSERT_TRUE(db.RecordShare(share, i < 6 ? 1 : 2).IsOk());
+        }
+
+        auto round1 = db.GetRoundShares(1);
+        auto round2 = db.GetRoundShares(2);
+        EXPECT_EQ(round1.size(), 6);
+        EXPECT_EQ(round2.size(), 4);
+        EXPECT_EQ(round2.front().difficulty, 1006);
+        EXPECT_EQ(db.GetTotalShares24h(), 10);
+
+        // A late share for round 1 takes the highest id (11) under a lower key
+        Share late{};
+        late.difficulty = 1000;
+        late.valid = true;
+        late.timestamp = std::chrono::system_clock::now();
+        ASSERT_TRUE(db.RecordShare(late, 1).IsOk());
+
+        ASSERT_TRUE(db.RecordPayment("int1qtest", 5000, "txid").IsOk());
+    }
+
+    // Reopen: records survive, ID counters resume after the highest id
+    PoolDatabase db(path);
+    ASSERT_TRUE(db.Open().IsOk());
+    EXPECT_EQ(db.GetRoundShares(1).size(), 7);
+
+    Share next{};
+    next.difficulty = 1000;
+    next.valid = true;
+    next.timestamp = std::chrono::system_clock::now();
+    ASSERT_TRUE(db.RecordShare(next, 3).IsOk());
+    auto round3 = db.GetRoundShares(3);
+    ASSERT_EQ(round3.size(), 1);
+    EXPECT_EQ(round3.front().share_id, 12);
+
+    ASSERT_TRUE(db.RecordPayment("int1qtest", 7000, "txid2").IsOk());
+    auto payments = db.GetRecentPayments(10);
+    ASSERT_EQ(payments.size(), 2);
+    EXPECT_EQ(payments[0].payment_id, 1);
+    EXPECT_EQ(payments[1].payment_id, 2);
+    EXPECT_EQ(payments[1].amount, 7000);
+
+    db.Close();
+    std::filesystem::remove_all(path);
+}
+
+TEST(PoolDatabaseTest, DirtyStatsCoalesceAndPersist) {
+    std::string path = "/tmp/intcoin-pool-db-stats-test";
+    std::filesystem::remove_all(path);
+
+    PoolDatabaseOptions options;
+    options.stats_flush_interval = std::chrono::hours(1);  // Only explicit flushes
+
+    Worker worker{};
+    worker.worker_id = 7;
+    worker.miner_id = 1;
+    worker.worker_name = "rig1";
+
+    {
+        PoolDatabase db(path, options);
+        ASSERT_TRUE(db.Open().IsOk());
+        ASSERT_TRUE(db.SaveWorker(worker).IsOk());
+
+        // Per-share updates only touch the dirty map
+        for (int i = 0; i < 1000; i++) {
+            worker.shares_submitted++;
+            worker.shares_accepted++;
+            db.MarkWorkerDirty(worker);
+        }
+
+        // Reads see queued counters before they are flushed
+        auto loaded = db.LoadWorker(7);
+        ASSERT_TRUE(loaded.IsOk());
+        EXPECT_EQ(loaded.GetValue().shares_accepted, 1000);
+        EXPECT_EQ(loaded.GetValue().worker_name, "rig1");
+
+        ASSERT_TRUE(db.FlushStats().IsOk());
+    }
+
+    PoolDatabase db(path, options);
+    ASSERT_TRUE(db.Open().IsOk());
+    auto loaded = db.LoadWorker(7);
+    ASSERT_TRUE(loaded.IsOk());
+    EXPECT_EQ(loaded.GetValue().shares_submitted, 1000);
+
+    db.Close();
+    std::filesystem::remove_all(path);
+}
+
+TEST(PoolDatabaseTest, LedgerIsIdempotentAndBalanced) {
+    std::string path = "/tmp/intcoin-pool-db-ledger-test";
+    std::filesystem::remove_all(path);
+
+    using Ledger = PoolDatabase;
+    auto entry = [](const std::string& key, Ledger::LedgerType type, uint64_t miner_id,
+                    uint64_t amount, uint64_t reference) {
+        Ledger::LedgerEntry e;
+        e.key = key;
+        e.type = type;
+        e.miner_id = miner_id;
+        e.amount = amount;
+        e.reference = reference;
+        e.timestamp = std::chrono::system_clock::now();
+        return e;
+    };
+
+    std::vector<Ledger::LedgerEntry> round = {
+        entry("round/1/1", Ledger::LedgerType::ROUND_CREDIT, 1, 600, 1),
+        entry("round/1/2", Ledger::LedgerType::ROUND_CREDIT, 2, 390, 1),
+        entry("round/1/fee", Ledger::LedgerType::POOL_FEE, 0, 10, 1),
+    };
+
+    {
+        PoolDatabase db(path);
+        ASSERT_TRUE(db.Open().IsOk());
+
+        auto posted = db.PostLedgerEntries(round);
+        ASSERT_TRUE(posted.IsOk());
+        EXPECT_EQ(posted.GetValue(), 3);
+
+        // Replaying the same round is a no-op
+        posted = db.PostLedgerEntries(round);
+        ASSERT_TRUE(posted.IsOk());
+        EXPECT_EQ(posted.GetValue(), 0);
+        EXPECT_EQ(db.GetBalance(Ledger::LedgerAccount::MINER, 1).balance, 600);
+
+        // Overdraft rejects the whole batch
+        std::vector<Ledger::LedgerEntry> payments = {
+            entry("payment/1", Ledger::LedgerType::PAYMENT, 1, 500, 1),
+            entry("payment/2", Ledger::LedgerType::PAYMENT, 2, 400, 2),
+        };
+        Ledger::Payment row;
+        row.payment_id = 1;
+        row.miner_id = 1;
+        row.address = "int1qaaa";
+        row.amount = 500;
+        row.status = "pending";
+        EXPECT_FALSE(db.PostLedgerEntries(payments, {row}).IsOk());
+        EXPECT_EQ(db.GetBalance(Ledger::LedgerAccount::MINER, 1).balance, 600);
+        EXPECT_TRUE(db.GetPaymentsByStatus("pending").empty());
+
+        // The debit and its pending payment row land together
+        payments.pop_back();
+        ASSERT_TRUE(db.PostLedgerEntries(payments, {row}).IsOk());
+    }
+
+    // Balances and allocator high-water marks survive a reopen
+    PoolDatabase db(path);
+    ASSERT_TRUE(db.Open().IsOk());
+
+    auto miner1 = db.GetBalance(Ledger::LedgerAccount::MINER, 1);
+    EXPECT_EQ(miner1.balance, 100);
+    EXPECT_EQ(miner1.credited, 600);
+    EXPECT_EQ(miner1.debited, 500);
+    EXPECT_EQ(db.GetBalance(Ledger::LedgerAccount::POOL_FEES).balance, 10);
+    EXPECT_EQ(db.GetBalance(Ledger::LedgerAccount::BLOCK_REWARDS).balance, -1000);
+    EXPECT_EQ(db.GetLastLedgerReference(Ledger::LedgerType::PAYMENT), 1);
+    EXPECT_EQ(db.GetLastLedgerReference(Ledger::LedgerType::ROUND_CREDIT), 1);
+
+    auto entries = db.GetLedgerEntries(0, 100);
+    ASSERT_EQ(entries.size(), 4);
+    EXPECT_EQ(entries.back().key, "payment/1");
+    EXPECT_TRUE(db.VerifyLedger().IsOk());
+
+    // The payment row keeps its ledger id through status updates
+    auto pending = db.GetPaymentsByStatus("pending");
+    ASSERT_EQ(pending.size(), 1);
+    EXPECT_EQ(pending[0].payment_id, 1);
+    EXPECT_EQ(pending[0].miner_id, 1);
+    pending[0].status = "sent";
+    pending[0].txid = "ab";
+    ASSERT_TRUE(db.RecordPayments(pending).IsOk());
+    EXPECT_TRUE(db.GetPaymentsByStatus("pending").empty());
+    ASSERT_EQ(db.GetPaymentsByStatus("sent").size(), 1);
+    EXPECT_EQ(db.GetRecentPayments(10).size(), 1);
+
+    db.Close();
+    std::filesystem::remove_all(path);
+}
+
+TEST(PoolDatabaseTest, MaturedBlockBalancesUnderEachMethod) {
+    using Ledger = PoolDatabase;
+    constexpr uint64_t kSubsidy = 5000000000ULL;
+    constexpr uint64_t kFees = 30000000ULL;
+    constexpr uint64_t kReward = kSubsidy + kFees;
+    constexpr double kFeePercent = 1.0;
+    const std::map<uint64_t, uint64_t> work = {{1, 300}, {2, 700}};
+
+    // What miners were paid per share before the block, and what is split at maturity
+    struct Method {
+        const char* name;
+        uint64_t prepaid;
+    };
+    for (const Method& method : {Method{"pplns", 0}, Method{"pps", kReward}, Method{"pps-plus", kSubsidy}}) {
+        SCOPED_TRACE(method.name);
+        std::string path = "/tmp/intcoin-pool-db-settle-test";
+        std::filesystem::remove_all(path);
+        PoolDatabase db(path);
+        ASSERT_TRUE(db.Open().IsOk());
+
+        auto now = std::chrono::system_clock::now();
+        if (method.prepaid > 0) {
+            std::vector<Ledger::LedgerEntry> shares;
+            auto paid = PayoutCalculator::DistributeReward(work, method.prepaid, kFeePercent);
+            for (const auto& [miner_id, amount] : paid) {
+                shares.push_back({"pps/1/" + std::to_string(miner_id), Ledger::LedgerType::PPS_CREDIT,
+                                  miner_id, amount, 1, "", now});
+            }
+            ASSERT_TRUE(db.PostLedgerEntries(shares).IsOk());
+        }
+
+        FoundBlock block;
+        block.round_id = 1;
+        block.reward = kReward;
+        if (kReward > method.prepaid) {
+            auto credits = PayoutCalculator::DistributeReward(work, kReward - method.prepaid, kFeePercent);
+            block.credits.assign(credits.begin(), credits.end());
+        }
+        PayoutCalculator::SettleBlockValue(block, method.prepaid, kFeePercent);
+
+        // Posted the way the server settles a matured block
+        std::vector<Ledger::LedgerEntry> entries;
+        for (const auto& [miner_id, amount] : block.credits) {
+            entries.push_back({"round/1/" + std::to_string(miner_id), Ledger::LedgerType::ROUND_CREDIT,
+                               miner_id, amount, 1, "", now});
+        }
+        entries.push_back({"round/1/fee", Ledger::LedgerType::POOL_FEE, 0, block.pool_fee, 1, "", now});
+        if (block.pps_funding > 0) {
+            entries.push_back({"round/1/pps", Ledger::LedgerType::PPS_FUNDING, 0, block.pps_funding, 1, "", now});
+        }
+        ASSERT_TRUE(db.PostLedgerEntries(entries).IsOk());
+
+        // The whole reward is accounted for, the fee is only the configured
+        // fee, and the PPS fund got back exactly what it paid out
+        EXPECT_EQ(db.GetBalance(Ledger::LedgerAccount::BLOCK_REWARDS).balance, -static_cast<int64_t>(kReward));
+        EXPECT_EQ(db.GetBalance(Ledger::LedgerAccount::POOL_FEES).balance,
+                  static_cast<int64_t>(PayoutCalculator::CalculateFee(kReward, kFeePercent)));
+        EXPECT_EQ(db.GetBalance(Ledger::LedgerAccount::PPS_FUND).balance, 0);
+        EXPECT_EQ(db.GetBalance(Ledger::LedgerAccount::MINER, 1).balance +
+                  db.GetBalance(Ledger::LedgerAccount::MINER, 2).balance,
+                  static_cast<int64_t>(kReward - PayoutCalculator::CalculateFee(kReward, kFeePercent)));
+        EXPECT_TRUE(db.VerifyLedger().IsOk());
+
+        db.Close();
+        std::filesystem::remove_all(path);
+    }
+}
+
+TEST(PoolDatabaseTest, MaintenanceMigrateVerifyReindex) {
+    std::string path = "/tmp/intcoin-pool-db-maint-test";
+    std::filesystem::remove_all(path);
+
+    auto make_miner = [](uint64_t miner_id, const std::string& address) {
+        Miner miner{};
+        miner.miner_id = miner_id;
+        miner.username = "miner" + std::to_string(miner_id);
+        miner.payout_address = address;
+        return miner;
+    };
+
+    {
+        PoolDatabase db(path);
+        ASSERT_TRUE(db.Open().IsOk());
+        EXPECT_EQ(db.GetSchemaVersion(), 2);
+
+        ASSERT_TRUE(db.SaveMiner(make_miner(1, "int1qaaa")).IsOk());
+        ASSERT_TRUE(db.SaveMiner(make_miner(2, "int1qbbb")).IsOk());
+        for (uint64_t i = 0; i < 1000; i++) {
+            Share share{};
+            share.miner_id = 1 + i % 2;
+            share.difficulty = 1000;
+            share.valid = true;
+            share.timestamp = std::chrono::system_clock::now();
+            ASSERT_TRUE(db.RecordShare(share, 1 + i / 100).IsOk());
+        }
+
+        PoolDatabase::LedgerEntry credit;
+        credit.key = "round/1/1";
+        credit.type = PoolDatabase::LedgerType::ROUND_CREDIT;
+        credit.miner_id = 1;
+        credit.amount = 5000;
+        credit.reference = 1;
+        ASSERT_TRUE(db.PostLedgerEntries({credit}).IsOk());
+
+        // Changing an address moves its index entry
+        ASSERT_TRUE(db.SaveMiner(make_miner(2, "int1qccc")).IsOk());
+        EXPECT_FALSE(db.LoadMinerByAddress("int1qbbb").IsOk());
+        auto found = db.LoadMinerByAddress("int1qccc");
+        ASSERT_TRUE(found.IsOk());
+        EXPECT_EQ(found.GetValue().miner_id, 2);
+
+        // Bulk import assigns ids to payments without one
+        RoundStatistics round{};
+        round.round_id = 1;
+        round.shares_submitted = 100;
+        round.total_work = 100000;
+        round.network_difficulty = 250000;
+        round.miner_shares[1] = 100;
+        PoolDatabase::Payment payment;
+        payment.payment_id = 0;
+        payment.address = "int1qaaa";
+        payment.amount = 2500;
+        auto imported = db.ImportRecords({round}, {payment});
+        ASSERT_TRUE(imported.IsOk());
+        EXPECT_EQ(imported.GetValue().written, 2);
+        auto loaded_round = db.LoadRound(1);
+        ASSERT_TRUE(loaded_round.IsOk());
+        EXPECT_EQ(loaded_round.GetValue().total_work, 100000);
+        EXPECT_EQ(loaded_round.GetValue().network_difficulty, 250000);
+        ASSERT_EQ(db.GetRecentPayments(10).size(), 1);
+
+        auto verified = db.VerifyRecords(4);
+        ASSERT_TRUE(verified.IsOk());
+        EXPECT_EQ(verified.GetValue().outdated, 0);
+        EXPECT_GT(verified.GetValue().records, 1000);
+
+        // Forced rewrite visits every record across parallel key ranges
+        auto migrated = db.MigrateRecords(4, true);
+        ASSERT_TRUE(migrated.IsOk());
+        EXPECT_EQ(migrated.GetValue().written, migrated.GetValue().records);
+        EXPECT_EQ(migrated.GetValue().records, verified.GetValue().records);
+
+        // Rebuilt derived tables match what was maintained incrementally
+        auto reindexed = db.RebuildIndexes();
+        ASSERT_TRUE(reindexed.IsOk());
+        EXPECT_EQ(db.GetBalance(PoolDatabase::LedgerAccount::MINER, 1).balance, 5000);
+        EXPECT_EQ(db.GetLastLedgerReference(PoolDatabase::LedgerType::ROUND_CREDIT), 1);
+        EXPECT_TRUE(db.VerifyRecords(2).IsOk());
+    }
+
+    PoolDatabase db(path);
+    ASSERT_TRUE(db.Open().IsOk());
+    EXPECT_EQ(db.GetRoundShares(3).size(), 100);
+    auto found = db.LoadMinerByAddress("int1qaaa");
+    ASSERT_TRUE(found.IsOk());
+    EXPECT_EQ(found.GetValue().username, "miner1");
+
+    db.Close();
+    std::filesystem::remove_all(path);
+}
+
+// ============================================================================
+// Share Journal Tests
+// ============================================================================
+
+TEST(ShareJournalTest, ReplayAfterTornTail) {
+    std::string dir = "/tmp/intcoin-pool-journal-test";
+    std::filesystem::remove_all(dir);
+
+    ShareJournalOptions options;
+    options.dir = dir;
+
+    {
+        ShareJournal journal(options);
+        ASSERT_TRUE(journal.Open().IsOk());
+
+        std::vector<JournalRecord> durable;
+        journal.SetDurableCallback([&](const std::vector<JournalRecord>& records) {
+            durable.insert(durable.end(), records.begin(), records.end());
+        });
+
+        for (uint64_t i = 1; i <= 100; i++) {
+            Share share{};
+            share.share_id = i;
+            share.miner_id = i % 4;
+            share.difficulty = 500;
+            share.valid = true;
+            share.timestamp = std::chrono::system_clock::now();
+            journal.Append(share, 7);
+        }
+        journal.AppendRoundEnd(7);
+        ASSERT_TRUE(journal.Sync().IsOk());
+        EXPECT_EQ(durable.size(), 101);
+        EXPECT_EQ(journal.GetDurableSeq(), 101);
+    }
+
+    // Simulate a crash mid-write: half a record at the tail
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        std::ofstream(entry.path(), std::ios::binary | std::ios::app) << std::string(20, 'x');
+    }
+
+    ShareJournal journal(options);
+    ASSERT_TRUE(journal.Open().IsOk());
+
+    uint64_t shares = 0;
+    uint64_t round_ends = 0;
+    ASSERT_TRUE(journal.Replay(0, [&](const JournalRecord& rec) {
+        if (rec.flags & JOURNAL_ROUND_END) round_ends++;
+        if (rec.flags & JOURNAL_SHARE_VALID) shares++;
+        EXPECT_EQ(rec.round_id, 7);
+    }).IsOk());
+    EXPECT_EQ(shares, 100);
+    EXPECT_EQ(round_ends, 1);
+
+    // Sequence numbers continue after the recovered tail
+    Share share{};
+    share.valid = true;
+    EXPECT_EQ(journal.Append(share, 8), 102);
+    journal.Close();
+
+    // Numbering skips ahead to first_seq (shares imported into the archive)
+    options.first_seq = 1000;
+    ShareJournal resumed(options);
+    ASSERT_TRUE(resumed.Open().IsOk());
+    EXPECT_EQ(resumed.Append(share, 8), 1000);
+
+    resumed.Close();
+    std::filesystem::remove_all(dir);
+}
+
+// ============================================================================
+// Share Archive Tests
+// ============================================================================
+
+TEST(ShareArchiveTest, WindowAndRangeScans) {
+    std::string dir = "/tmp/intcoin-pool-archive-test";
+    std::filesystem::remove_all(dir);
+
+    ShareArchiveOptions options;
+    options.dir = dir;
+    options.segment_span = std::chrono::seconds(60);
+    options.segment_capacity = 64;
+
+    auto base = std::chrono::system_clock::now() - std::chrono::hours(1);
+    int64_t base_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        base.time_since_epoch()).count();
+
+    {
+        ShareArchive archive(options);
+        ASSERT_TRUE(archive.Open().IsOk());
+
+        // 300 shares, one per second, across several segments
+        std::vector<JournalRecord> records;
+        for (uint64_t i = 0; i < 300; i++) {
+            JournalRecord rec;
+            rec.seq = i + 1;
+            rec.flags = (i % 10 == 9) ? 0 : JOURNAL_SHARE_VALID;  // every 10th rejected
+            rec.miner_id = i % 3;
+            rec.worker_id = 100 + (i % 5);
+            rec.difficulty = 10;
+            rec.timestamp_ms = base_ms + static_cast<int64_t>(i) * 1000;
+            records.push_back(rec);
+        }
+        ASSERT_TRUE(archive.Append(records).IsOk());
+        EXPECT_EQ(archive.GetShareCount(), 300);
+        EXPECT_EQ(archive.GetLastSeq(), 300);
+    }
+
+    ShareArchive archive(options);
+    ASSERT_TRUE(archive.Open().IsOk());
+    EXPECT_EQ(archive.GetLastSeq(), 300);
+
+    // Last 30 valid shares span the newest records only
+    auto window = archive.ScanLastShares(30);
+    uint64_t window_shares = 0;
+    for (const auto& [miner_id, totals] : window) window_shares += totals.shares;
+    EXPECT_EQ(window_shares, 30);
+
+    // First two minutes: 120 shares, 12 rejected
+    auto miners = archive.ScanMiners(base, base + std::chrono::seconds(120));
+    uint64_t range_shares = 0;
+    uint64_t range_work = 0;
+    for (const auto& [miner_id, totals] : miners) {
+        range_shares += totals.shares;
+        range_work += totals.work;
+    }
+    EXPECT_EQ(range_shares, 108);
+    EXPECT_EQ(range_work, 1080);
+
+    auto workers = archive.ScanWorkers(base, base + std::chrono::hours(1));
+    EXPECT_EQ(workers.size(), 5);
+
+    archive.Close();
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ShareArchiveTest, CompactRoundsWithMerkleCommitment) {
+    std::string dir = "/tmp/intcoin-pool-compact-test";
+    std::filesystem::remove_all(dir);
+
+    ShareArchiveOptions options;
+    options.dir = dir;
+    options.segment_span = std::chrono::seconds(60);
+    options.segment_capacity = 64;
+    options.raw_retention = std::chrono::seconds(0);
+
+    auto base = std::chrono::system_clock::now() - std::chrono::hours(2);
+    int64_t base_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        base.time_since_epoch()).count();
+
+    {
+        ShareArchive archive(options);
+        ASSERT_TRUE(archive.Open().IsOk());
+
+        // Rounds 1-3, 100 shares each, one per second
+        std::vector<JournalRecord> records;
+        for (uint64_t i = 0; i < 300; i++) {
+            JournalRecord rec;
+            rec.seq = i + 1;
+            rec.flags = JOURNAL_SHARE_VALID;
+            rec.round_id = 1 + i / 100;
+            rec.miner_id = 1 + i % 4;
+            rec.worker_id = 10 + i % 4;
+            rec.difficulty = 1 + i % 4;
+            rec.timestamp_ms = base_ms + static_cast<int64_t>(i) * 1000;
+            records.push_back(rec);
+        }
+        ASSERT_TRUE(archive.Append(records).IsOk());
+
+        // Rounds 1-2 summarized; the window keeps the newest 100 shares raw
+        auto dropped = archive.Compact(2, 100);
+        ASSERT_TRUE(dropped.IsOk());
+        EXPECT_GT(dropped.GetValue(), 0);
+        EXPECT_EQ(archive.GetCompactedRound(), 2);
+        EXPECT_LT(archive.GetShareCount(), 300);
+
+        uint64_t window_shares = 0;
+        for (const auto& [miner_id, totals] : archive.ScanLastShares(100)) {
+            window_shares += totals.shares;
+        }
+        EXPECT_EQ(window_shares, 100);
+    }
+
+    // Summaries survive a reopen
+    ShareArchive archive(options);
+    ASSERT_TRUE(archive.Open().IsOk());
+    EXPECT_EQ(archive.GetCompactedRound(), 2);
+    EXPECT_FALSE(archive.GetRoundSummary(3).IsOk());
+
+    auto loaded = archive.GetRoundSummary(2);
+    ASSERT_TRUE(loaded.IsOk());
+    auto summary = loaded.GetValue();
+    EXPECT_EQ(summary.shares, 100);
+    EXPECT_EQ(summary.work, 250);
+    ASSERT_EQ(summary.miners.size(), 4);
+    EXPECT_EQ(summary.miners[3].miner_id, 4);
+    EXPECT_EQ(summary.miners[3].work, 100);
+    EXPECT_EQ(summary.merkle_root, RoundMerkleRoot(summary));
+
+    // Each miner's work verifies against the root; altered work does not
+    for (size_t i = 0; i < summary.miners.size(); i++) {
+        auto proof = RoundMerkleProof(summary, i);
+        EXPECT_TRUE(VerifyRoundMerkleProof(2, summary.miners[i], i, summary.miners.size(), proof,
+                                           summary.merkle_root));
+    }
+    RoundWork forged = summary.miners[0];
+    forged.work++;
+    EXPECT_FALSE(VerifyRoundMerkleProof(2, forged, 0, summary.miners.size(), RoundMerkleProof(summary, 0),
+                                        summary.merkle_root));
+
+    archive.Close();
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ShareArchiveTest, MerkleRootBindsMinerCount) {
+    RoundSummary three;
+    three.round_id = 7;
+    for (uint64_t m = 1; m <= 3; m++) {
+        three.miners.push_back(RoundWork{m, m * 10, m * 100});
+    }
+
+    // The last miner repeated would rebuild the same tree without the count
+    RoundSummary four = three;
+    four.miners.push_back(three.miners.back());
+    EXPECT_NE(RoundMerkleRoot(three), RoundMerkleRoot(four));
+
+    // A proof for the padding slot does not verify against either root
+    uint256 root = RoundMerkleRoot(three);
+    auto proof = RoundMerkleProof(three, 2);
+    EXPECT_TRUE(VerifyRoundMerkleProof(7, three.miners[2], 2, 3, proof, root));
+    EXPECT_FALSE(VerifyRoundMerkleProof(7, three.miners[2], 2, 4, proof, root));
+    EXPECT_FALSE(VerifyRoundMerkleProof(7, three.miners[2], 3, 3, RoundMerkleProof(four, 3), root));
+}
+
+TEST(ShareArchiveTest, ColdMigrationPreservesScans) {
+    std::string dir = "/tmp/intcoin-pool-tier-test";
+    std::filesystem::remove_all(dir);
+
+    ShareArchiveOptions options;
+    options.dir = dir + "/warm";
+    options.cold_dir = dir + "/cold";
+    options.segment_span = std::chrono::seconds(60);
+    options.segment_capacity = 64;
+    options.hot_shares = 50;
+    options.warm_retention = std::chrono::seconds(0);
+
+    auto base = std::chrono::system_clock::now() - std::chrono::hours(1);
+    int64_t base_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        base.time_since_epoch()).count();
+
+    using Window = std::map<uint64_t, std::pair<uint64_t, uint64_t>>;
+    auto window_of = [](const std::map<uint64_t, ShareTotals>& totals) {
+        Window out;
+        for (const auto& [id, t] : totals) out[id] = {t.shares, t.work};
+        return out;
+    };
+
+    Window hot_window, deep_window, range;
+    {
+        ShareArchive archive(options);
+        ASSERT_TRUE(archive.Open().IsOk());
+
+        std::vector<JournalRecord> records;
+        for (uint64_t i = 0; i < 300; i++) {
+            JournalRecord rec;
+            rec.seq = i + 1;
+            rec.flags = (i % 10 == 9) ? 0 : JOURNAL_SHARE_VALID;
+            rec.round_id = 1;
+            rec.miner_id = i % 7;
+            rec.worker_id = i % 11;
+            rec.difficulty = 1 + i % 5;
+            rec.timestamp_ms = base_ms + static_cast<int64_t>(i) * 1000;
+            records.push_back(rec);
+        }
+        ASSERT_TRUE(archive.Append(records).IsOk());
+
+        hot_window = window_of(archive.ScanLastShares(40));
+        deep_window = window_of(archive.ScanLastShares(250));
+        range = window_of(archive.ScanMiners(base + std::chrono::seconds(30), base + std::chrono::seconds(200)));
+
+        // Every sealed segment goes cold; the active one stays warm
+        auto migrated = archive.MigrateCold();
+        ASSERT_TRUE(migrated.IsOk());
+        EXPECT_GT(migrated.GetValue(), 0);
+
+        auto stats = archive.GetTierStats();
+        EXPECT_EQ(stats.warm_segments, 1);
+        EXPECT_EQ(stats.cold_segments, migrated.GetValue());
+        EXPECT_EQ(stats.cold_shares + stats.warm_shares, 300);
+        EXPECT_EQ(stats.hot_shares, 50);
+        EXPECT_GT(stats.cold_bytes, 0);
+
+        EXPECT_EQ(window_of(archive.ScanLastShares(40)), hot_window);
+        EXPECT_EQ(window_of(archive.ScanLastShares(250)), deep_window);
+        EXPECT_EQ(window_of(archive.ScanMiners(base + std::chrono::seconds(30),
+                                               base + std::chrono::seconds(200))), range);
+    }
+
+    // Reopen rebuilds the cold index and the hot ring
+    ShareArchive archive(options);
+    ASSERT_TRUE(archive.Open().IsOk());
+    EXPECT_EQ(archive.GetShareCount(), 300);
+    EXPECT_EQ(archive.GetLastSeq(), 300);
+    EXPECT_EQ(archive.GetTierStats().hot_shares, 50);
+    EXPECT_EQ(window_of(archive.ScanLastShares(40)), hot_window);
+    EXPECT_EQ(window_of(archive.ScanLastShares(250)), deep_window);
+    EXPECT_EQ(window_of(archive.ScanMiners(base + std::chrono::seconds(30),
+                                           base + std::chrono::seconds(200))), range);
+
+    archive.Close();
+    std::filesystem::remove_all(dir);
+}
+
+// ============================================================================
+// History Export Tests
+// ============================================================================
+
+TEST(PoolExportTest, ColumnarRoundTripAndCsv) {
+    std::string dir = "/tmp/intcoin-pool-export-test";
+    std::filesystem::remove_all(dir);
+
+    ShareArchiveOptions options;
+    options.dir = dir;
+    options.segment_span = std::chrono::seconds(60);
+    options.segment_capacity = 64;
+
+    auto base = std::chrono::system_clock::now() - std::chrono::hours(1);
+    int64_t base_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        base.time_since_epoch()).count();
+
+    ShareArchive archive(options);
+    ASSERT_TRUE(archive.Open().IsOk());
+
+    // Rounds 1-3, 100 shares each, one per second
+    std::vector<JournalRecord> records;
+    for (uint64_t i = 0; i < 300; i++) {
+        JournalRecord rec;
+        rec.seq = i + 1;
+        rec.flags = (i % 10 == 9) ? 0 : JOURNAL_SHARE_VALID;
+        rec.round_id = 1 + i / 100;
+        rec.miner_id = 1 + i % 3;
+        rec.worker_id = 10 + i % 6;
+        rec.difficulty = 1 + i % 4;
+        rec.timestamp_ms = base_ms + static_cast<int64_t>(i) * 1000;
+        records.push_back(rec);
+    }
+    ASSERT_TRUE(archive.Append(records).IsOk());
+    ASSERT_TRUE(archive.Compact(2, 1000).IsOk());
+
+    // Seconds [50, 250): the first and last segments are cut mid-way
+    ExportOptions export_options;
+    export_options.from = base + std::chrono::seconds(50);
+    export_options.to = base + std::chrono::seconds(250);
+    export_options.tables = EXPORT_SHARES | EXPORT_ROUNDS;
+    export_options.chunk_rows = 40;
+
+    std::string stream;
+    auto exported = ExportHistory(&archive, nullptr, export_options, [&](const uint8_t* data, size_t len) {
+        stream.append(reinterpret_cast<const char*>(data), len);
+        return Result<void>::Ok();
+    });
+    ASSERT_TRUE(exported.IsOk());
+    EXPECT_EQ(exported.GetValue().shares, 200);
+    EXPECT_EQ(exported.GetValue().round_rows, 6);
+    EXPECT_EQ(exported.GetValue().bytes, stream.size());
+
+    uint64_t shares = 0;
+    uint64_t valid_work = 0;
+    int64_t first_ms = INT64_MAX;
+    int64_t last_ms = INT64_MIN;
+    std::vector<RoundSummary> rounds;
+    ExportVisitor visitor;
+    visitor.shares = [&](const ShareColumns& chunk) {
+        EXPECT_LE(chunk.rows, 40);
+        for (size_t i = 0; i < chunk.rows; i++) {
+            first_ms = std::min(first_ms, chunk.timestamp_ms[i]);
+            last_ms = std::max(last_ms, chunk.timestamp_ms[i]);
+            if (chunk.flags[i] & JOURNAL_SHARE_VALID) valid_work += chunk.difficulty[i];
+        }
+        shares += chunk.rows;
+        return Result<void>::Ok();
+    };
+    visitor.rounds = [&](const RoundSummary& summary) {
+        rounds.push_back(summary);
+        return Result<void>::Ok();
+    };
+
+    std::istringstream in(stream);
+    auto read = ReadExport(in, visitor);
+    ASSERT_TRUE(read.IsOk());
+    EXPECT_EQ(shares, 200);
+    EXPECT_EQ(first_ms, base_ms + 50000);
+    EXPECT_EQ(last_ms, base_ms + 249000);
+
+    uint64_t scanned_work = 0;
+    for (const auto& [miner_id, totals] : archive.ScanMiners(export_options.from, export_options.to)) {
+        scanned_work += totals.work;
+    }
+    EXPECT_EQ(valid_work, scanned_work);
+
+    // Both compacted rounds ended inside the range and keep their commitment
+    ASSERT_EQ(rounds.size(), 2);
+    EXPECT_EQ(rounds[1].round_id, 2);
+    EXPECT_EQ(rounds[1].merkle_root, archive.GetRoundSummary(2).GetValue().merkle_root);
+
+    // A flipped payload byte fails the chunk checksum
+    std::string corrupt = stream;
+    corrupt[32 + 24 + 5] ^= 0x01;
+    std::istringstream bad(corrupt);
+    EXPECT_FALSE(ReadExport(bad, ExportVisitor()).IsOk());
+
+    // CSV: header plus one line per share
+    export_options.tables = EXPORT_SHARES;
+    export_options.format = ExportFormat::CSV;
+    std::string csv;
+    ASSERT_TRUE(ExportHistory(&archive, nullptr, export_options, [&](const uint8_t* data, size_t len) {
+        csv.append(reinterpret_cast<const char*>(data), len);
+        return Result<void>::Ok();
+    }).IsOk());
+    EXPECT_EQ(std::count(csv.begin(), csv.end(), '\n'), 201);
+    EXPECT_EQ(csv.rfind("timestamp_ms,round_id,", 0), 0);
+
+    // CSV carries one table only
+    export_options.tables = EXPORT_SHARES | EXPORT_ROUNDS;
+    EXPECT_FALSE(ExportHistory(&archive, nullptr, export_options,
+                               [](const uint8_t*, size_t) { return Result<void>::Ok(); }).IsOk());
+
+    archive.Close();
+    std::filesystem::remove_all(dir);
+}
+
+TEST(PoolExportTest, RoundsSurviveExportAndImport) {
+    std::string dir = "/tmp/intcoin-pool-export-rounds-test";
+    std::filesystem::remove_all(dir);
+
+    ShareArchiveOptions options;
+    options.dir = dir + "/archive";
+    ShareArchive archive(options);
+    ASSERT_TRUE(archive.Open().IsOk());
+
+    PoolDatabase source(dir + "/source");
+    ASSERT_TRUE(source.Open().IsOk());
+
+    auto base = std::chrono::system_clock::now() - std::chrono::hours(1);
+    int64_t base_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        base.time_since_epoch()).count();
+
+    // Round 1: 30 shares from 3 miners; the database knows its expected work
+    std::vector<JournalRecord> records;
+    for (uint64_t i = 0; i < 30; i++) {
+        JournalRecord rec;
+        rec.seq = i + 1;
+        rec.flags = JOURNAL_SHARE_VALID;
+        rec.round_id = 1;
+        rec.miner_id = 1 + i % 3;
+        rec.difficulty = 100 + i;
+        rec.timestamp_ms = base_ms + static_cast<int64_t>(i) * 1000;
+        records.push_back(rec);
+    }
+    ASSERT_TRUE(archive.Append(records).IsOk());
+    ASSERT_TRUE(archive.Compact(1, 0).IsOk());
+
+    RoundStatistics closed{};
+    closed.round_id = 1;
+    closed.shares_submitted = 30;
+    closed.total_work = archive.GetRoundSummary(1).GetValue().work;
+    closed.network_difficulty = 5000;
+    closed.is_complete = true;
+    ASSERT_TRUE(source.SaveRound(closed).IsOk());
+
+    ExportOptions export_options;
+    export_options.from = base;
+    export_options.to = std::chrono::system_clock::now() + std::chrono::minutes(1);
+    export_options.tables = EXPORT_ROUNDS;
+    std::string stream;
+    ASSERT_TRUE(ExportHistory(&archive, &source, export_options, [&](const uint8_t* data, size_t len) {
+        stream.append(reinterpret_cast<const char*>(data), len);
+        return Result<void>::Ok();
+    }).IsOk());
+
+    // Import into a fresh database, as intcoin-pool-db import does
+    std::vector<RoundStatistics> rounds;
+    ExportVisitor visitor;
+    visitor.rounds = [&](const RoundSummary& summary) {
+        rounds.push_back(RoundFromSummary(summary));
+        return Result<void>::Ok();
+    };
+    std::istringstream in(stream);
+    ASSERT_TRUE(ReadExport(in, visitor).IsOk());
+    ASSERT_EQ(rounds.size(), 1);
+
+    PoolDatabase target(dir + "/target");
+    ASSERT_TRUE(target.Open().IsOk());
+    ASSERT_TRUE(target.ImportRecords(rounds, {}).IsOk());
+
+    auto imported = target.LoadRound(1);
+    ASSERT_TRUE(imported.IsOk());
+    EXPECT_EQ(imported.GetValue().shares_submitted, 30);
+    EXPECT_EQ(imported.GetValue().total_work, closed.total_work);
+    EXPECT_EQ(imported.GetValue().network_difficulty, 5000);
+    EXPECT_EQ(imported.GetValue().miner_shares.size(), 3);
+    EXPECT_EQ(imported.GetValue().started_at, std::chrono::system_clock::time_point(std::chrono::milliseconds(base_ms)));
+
+    target.Close();
+    source.Close();
+    archive.Close();
+    std::filesystem::remove_all(dir);
+}
+
+// ============================================================================
+// Snapshot Tests
+// ============================================================================
+
+TEST(SnapshotStoreTest, RoundTripAndFallback) {
+    std::string dir = "/tmp/intcoin-pool-snapshot-test";
+    std::filesystem::remove_all(dir);
+
+    SnapshotStore store(dir, 2);
+    EXPECT_FALSE(store.LoadLatest().IsOk());
+
+    PoolSnapshot snapshot;
+    snapshot.next_miner_id = 3;
+    snapshot.next_round_id = 8;
+    snapshot.current_round.round_id = 7;
+    snapshot.current_round.shares_submitted = 42;
+    snapshot.current_round.total_work = 420000;
+    snapshot.current_round.network_difficulty = 1000000;
+    snapshot.current_round.miner_shares[1] = 40;
+    snapshot.current_round.miner_shares[2] = 2;
+    for (uint64_t id = 1; id <= 2; id++) {
+        Miner miner{};
+        miner.miner_id = id;
+        miner.username = "miner" + std::to_string(id);
+        miner.payout_address = "int1addr" + std::to_string(id);
+        miner.unpaid_balance = id * 1000;
+        snapshot.miners[id] = miner;
+    }
+
+    snapshot.journal_seq = 100;
+    ASSERT_TRUE(store.Write(snapshot).IsOk());
+    snapshot.journal_seq = 200;
+    snapshot.miners[1].unpaid_balance = 5000;
+    ASSERT_TRUE(store.Write(snapshot).IsOk());
+
+    auto loaded = store.LoadLatest();
+    ASSERT_TRUE(loaded.IsOk());
+    auto latest = loaded.GetValue();
+    EXPECT_EQ(latest.journal_seq, 200);
+    EXPECT_EQ(latest.next_round_id, 8);
+    EXPECT_EQ(latest.current_round.round_id, 7);
+    EXPECT_EQ(latest.current_round.shares_submitted, 42);
+    EXPECT_EQ(latest.current_round.total_work, 420000);
+    EXPECT_EQ(latest.current_round.network_difficulty, 1000000);
+    EXPECT_EQ(latest.current_round.miner_shares[1], 40);
+    ASSERT_EQ(latest.miners.size(), 2);
+    EXPECT_EQ(latest.miners[1].unpaid_balance, 5000);
+    EXPECT_EQ(latest.miners[2].payout_address, "int1addr2");
+
+    // Corrupt the newest snapshot: load falls back to the older one
+    std::filesystem::path newest;
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        if (newest.empty() || entry.path() > newest) newest = entry.path();
+    }
+    {
+        std::fstream file(newest, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(40);
+        file.put('\xff');
+    }
+
+    loaded = store.LoadLatest();
+    ASSERT_TRUE(loaded.IsOk());
+    EXPECT_EQ(loaded.GetValue().journal_seq, 100);
+    EXPECT_EQ(loaded.GetValue().miners[1].unpaid_balance, 1000);
+
+    std::filesystem::remove_all(dir);
+}
+
+// ============================================================================
+// Metrics Tests
+// ============================================================================
+
+TEST(MetricsTest, ShardedCountersAndPrometheusText) {
+    // Four linear buckets per power of two; values past the range are +Inf
+    EXPECT_EQ(Histogram::BucketOf(0), 0);
+    EXPECT_EQ(Histogram::BucketOf(1024), 0);
+    EXPECT_EQ(Histogram::BucketOf(1280), 1);
+    EXPECT_EQ(Histogram::BucketOf(2048), 4);
+    EXPECT_EQ(Histogram::BucketOf(uint64_t{1} << 40), Histogram::kBuckets);
+    for (size_t b = 0; b < Histogram::kBuckets; b++) {
+        EXPECT_EQ(Histogram::BucketOf(Histogram::UpperBound(b) - 1), b);
+    }
+
+    MetricsRegistry registry;
+    Counter& accepted = registry.AddCounter("pool_shares_total", "Shares", "result=\"accepted\"");
+    Counter& rejected = registry.AddCounter("pool_shares_total", "Shares", "result=\"rejected\"");
+    Gauge& connections = registry.AddGauge("pool_connections", "Connections");
+    Histogram& latency = registry.AddHistogram("pool_latency_seconds", "Latency");
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 16; t++) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 10000; i++) {
+                accepted.Inc();
+                latency.Record(uint64_t{1500});
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    rejected.Inc(3);
+    connections.Add(2);
+    connections.Add(-1);
+    latency.Record(uint64_t{1} << 40);
+
+    EXPECT_EQ(accepted.Value(), 160000);
+    EXPECT_DOUBLE_EQ(connections.Value(), 1.0);
+
+    std::string text;
+    registry.Render(text);
+
+    // One header per family, a line per series
+    size_t first = text.find("# TYPE pool_shares_total counter\n");
+    ASSERT_NE(first, std::string::npos);
+    EXPECT_EQ(text.find("# TYPE pool_shares_total", first + 1), std::string::npos);
+    EXPECT_NE(text.find("pool_shares_total{result=\"accepted\"} 160000\n"), std::string::npos);
+    EXPECT_NE(text.find("pool_shares_total{result=\"rejected\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("pool_connections 1\n"), std::string::npos);
+
+    // Cumulative buckets in seconds; the slow value only counts in +Inf
+    EXPECT_NE(text.find("pool_latency_seconds_bucket{le=\"1.28e-06\"} 0\n"), std::string::npos);
+    EXPECT_NE(text.find("pool_latency_seconds_bucket{le=\"1.536e-06\"} 160000\n"), std::string::npos);
+    EXPECT_NE(text.find("pool_latency_seconds_bucket{le=\"+Inf\"} 160001\n"), std::string::npos);
+    EXPECT_NE(text.find("pool_latency_seconds_count 160001\n"), std::string::npos);
+
+    // The next scrape is reserved up front from this one's size
+    std::string again;
+    registry.Render(again);
+    EXPECT_EQ(again.size(), text.size());
+    EXPECT_GE(again.capacity(), text.size() + text.size() / 8);
+}
+
 // ============================================================================
 // Main Test Runner
 // ============================================================================